@@ -112,6 +112,32 @@ ATOMIC_INLINE unsigned int atomic_cas_u(unsigned int *v, unsigned int old, unsig
  *          working on the same pointer at the same time is very low). */
 ATOMIC_INLINE float atomic_add_and_fetch_fl(float *p, const float x);
 
+/* Loads have acquire and stores release semantic, so data written before a store
+ * is visible to the thread which loaded the stored value. Unlike the operations
+ * above these are not full barriers, use atomic_fence() for that. */
+#if (LG_SIZEOF_PTR == 8 || LG_SIZEOF_INT == 8)
+ATOMIC_INLINE uint64_t atomic_load_uint64(const uint64_t *v);
+ATOMIC_INLINE void atomic_store_uint64(uint64_t *p, uint64_t v);
+#endif
+
+ATOMIC_INLINE uint32_t atomic_load_uint32(const uint32_t *v);
+ATOMIC_INLINE void atomic_store_uint32(uint32_t *p, uint32_t v);
+
+ATOMIC_INLINE uint8_t atomic_load_uint8(const uint8_t *v);
+ATOMIC_INLINE void atomic_store_uint8(uint8_t *p, uint8_t v);
+
+ATOMIC_INLINE size_t atomic_load_z(const size_t *v);
+ATOMIC_INLINE void atomic_store_z(size_t *p, size_t v);
+
+ATOMIC_INLINE unsigned int atomic_load_u(const unsigned int *v);
+ATOMIC_INLINE void atomic_store_u(unsigned int *p, unsigned int v);
+
+ATOMIC_INLINE void *atomic_load_ptr(void *const *v);
+ATOMIC_INLINE void atomic_store_ptr(void **p, void *v);
+
+/* Sequentially consistent fence. */
+ATOMIC_INLINE void atomic_fence(void);
+
 /******************************************************************************/
 /* Include system-dependent implementations. */
 
@@ -111,6 +111,28 @@ ATOMIC_INLINE size_t atomic_cas_z(size_t *v, size_t old, size_t _new)
 #endif
 }
 
+ATOMIC_INLINE size_t atomic_load_z(const size_t *v)
+{
+	assert(sizeof(size_t) == LG_SIZEOF_PTR);
+
+#if (LG_SIZEOF_PTR == 8)
+	return (size_t)atomic_load_uint64((const uint64_t *)v);
+#elif (LG_SIZEOF_PTR == 4)
+	return (size_t)atomic_load_uint32((const uint32_t *)v);
+#endif
+}
+
+ATOMIC_INLINE void atomic_store_z(size_t *p, size_t v)
+{
+	assert(sizeof(size_t) == LG_SIZEOF_PTR);
+
+#if (LG_SIZEOF_PTR == 8)
+	atomic_store_uint64((uint64_t *)p, (uint64_t)v);
+#elif (LG_SIZEOF_PTR == 4)
+	atomic_store_uint32((uint32_t *)p, (uint32_t)v);
+#endif
+}
+
 /******************************************************************************/
 /* unsigned operations. */
 ATOMIC_INLINE unsigned int atomic_add_and_fetch_u(unsigned int *p, unsigned int x)
@@ -168,6 +190,52 @@ ATOMIC_INLINE unsigned int atomic_cas_u(unsigned int *v, unsigned int old, unsig
 #endif
 }
 
+ATOMIC_INLINE unsigned int atomic_load_u(const unsigned int *v)
+{
+	assert(sizeof(unsigned int) == LG_SIZEOF_INT);
+
+#if (LG_SIZEOF_INT == 8)
+	return (unsigned int)atomic_load_uint64((const uint64_t *)v);
+#elif (LG_SIZEOF_INT == 4)
+	return (unsigned int)atomic_load_uint32((const uint32_t *)v);
+#endif
+}
+
+ATOMIC_INLINE void atomic_store_u(unsigned int *p, unsigned int v)
+{
+	assert(sizeof(unsigned int) == LG_SIZEOF_INT);
+
+#if (LG_SIZEOF_INT == 8)
+	atomic_store_uint64((uint64_t *)p, (uint64_t)v);
+#elif (LG_SIZEOF_INT == 4)
+	atomic_store_uint32((uint32_t *)p, (uint32_t)v);
+#endif
+}
+
+/******************************************************************************/
+/* pointer operations. */
+ATOMIC_INLINE void *atomic_load_ptr(void *const *v)
+{
+	assert(sizeof(void *) == LG_SIZEOF_PTR);
+
+#if (LG_SIZEOF_PTR == 8)
+	return (void *)(uintptr_t)atomic_load_uint64((const uint64_t *)v);
+#elif (LG_SIZEOF_PTR == 4)
+	return (void *)(uintptr_t)atomic_load_uint32((const uint32_t *)v);
+#endif
+}
+
+ATOMIC_INLINE void atomic_store_ptr(void **p, void *v)
+{
+	assert(sizeof(void *) == LG_SIZEOF_PTR);
+
+#if (LG_SIZEOF_PTR == 8)
+	atomic_store_uint64((uint64_t *)p, (uint64_t)(uintptr_t)v);
+#elif (LG_SIZEOF_PTR == 4)
+	atomic_store_uint32((uint32_t *)p, (uint32_t)(uintptr_t)v);
+#endif
+}
+
 /******************************************************************************/
 /* float operations. */
 
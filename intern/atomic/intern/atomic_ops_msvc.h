@@ -124,4 +124,55 @@ ATOMIC_INLINE uint8_t atomic_fetch_and_or_uint8(uint8_t *p, uint8_t b)
 #endif
 }
 
+/******************************************************************************/
+/* Loads, stores and fences. */
+
+/* Volatile accesses have acquire/release semantic with MSVC on x86,
+ * the compiler barrier keeps other accesses from being moved across them. */
+#if (LG_SIZEOF_PTR == 8 || LG_SIZEOF_INT == 8)
+ATOMIC_INLINE uint64_t atomic_load_uint64(const uint64_t *v)
+{
+	uint64_t ret = *(volatile const uint64_t *)v;
+	_ReadWriteBarrier();
+	return ret;
+}
+
+ATOMIC_INLINE void atomic_store_uint64(uint64_t *p, uint64_t v)
+{
+	_ReadWriteBarrier();
+	*(volatile uint64_t *)p = v;
+}
+#endif
+
+ATOMIC_INLINE uint32_t atomic_load_uint32(const uint32_t *v)
+{
+	uint32_t ret = *(volatile const uint32_t *)v;
+	_ReadWriteBarrier();
+	return ret;
+}
+
+ATOMIC_INLINE void atomic_store_uint32(uint32_t *p, uint32_t v)
+{
+	_ReadWriteBarrier();
+	*(volatile uint32_t *)p = v;
+}
+
+ATOMIC_INLINE uint8_t atomic_load_uint8(const uint8_t *v)
+{
+	uint8_t ret = *(volatile const uint8_t *)v;
+	_ReadWriteBarrier();
+	return ret;
+}
+
+ATOMIC_INLINE void atomic_store_uint8(uint8_t *p, uint8_t v)
+{
+	_ReadWriteBarrier();
+	*(volatile uint8_t *)p = v;
+}
+
+ATOMIC_INLINE void atomic_fence(void)
+{
+	MemoryBarrier();
+}
+
 #endif /* __ATOMIC_OPS_MSVC_H__ */
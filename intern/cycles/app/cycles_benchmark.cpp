@@ -0,0 +1,1330 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Headless benchmark
+ *
+ * Renders a set of procedurally generated XML scenes with fixed seeds and
+ * prints timings and memory usage as JSON. Results can be compared against
+ * a previously saved JSON file to catch performance regressions.
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "render/buffers.h"
+#include "render/camera.h"
+#include "render/mesh.h"
+#include "render/object.h"
+#include "device/device.h"
+#include "render/scene.h"
+#include "render/session.h"
+
+#include "util/util_args.h"
+#include "util/util_debug.h"
+#include "util/util_foreach.h"
+#include "util/util_function.h"
+#include "util/util_guarded_allocator.h"
+#include "util/util_hash.h"
+#include "util/util_image.h"
+#include "util/util_logging.h"
+#include "util/util_map.h"
+#include "util/util_math.h"
+#include "util/util_path.h"
+#include "util/util_stats.h"
+#include "util/util_string.h"
+#include "util/util_system.h"
+#include "util/util_time.h"
+#include "util/util_transform.h"
+#include "util/util_version.h"
+
+#include "app/cycles_xml.h"
+
+CCL_NAMESPACE_BEGIN
+
+struct Options {
+	string scene_dir;
+	string output_path;
+	string baseline_path;
+	string bvh_layout;
+	string bvh_type;
+	vector<string> scene_names;
+	int width, height;
+	int samples;
+	int frames;
+	int seed;
+	int repeat;
+	float threshold;
+	bool compare_packet_traversal;
+	bool quiet;
+	SceneParams scene_params;
+	SessionParams session_params;
+} options;
+
+/* Random Numbers
+ *
+ * Hash based, so generated scenes are identical on every platform. */
+
+class BenchmarkRandom {
+public:
+	explicit BenchmarkRandom(uint seed) : seed(hash_int(seed)), index(0) {}
+
+	float get()
+	{
+		return hash_int_2d(seed, index++) * (1.0f/4294967296.0f);
+	}
+
+	float get(float a, float b)
+	{
+		return a + (b - a)*get();
+	}
+
+	float3 get_float3(float a, float b)
+	{
+		float x = get(a, b);
+		float y = get(a, b);
+		return make_float3(x, y, get(a, b));
+	}
+
+protected:
+	uint seed;
+	uint index;
+};
+
+/* XML Writing */
+
+static string xml_float3(float3 f)
+{
+	return string_printf("%g %g %g", (double)f.x, (double)f.y, (double)f.z);
+}
+
+static string xml_matrix(const Transform& tfm)
+{
+	/* XML matrices are stored column by column */
+	string str;
+	for(int i = 0; i < 4; i++) {
+		for(int j = 0; j < 4; j++) {
+			str += string_printf((i == 0 && j == 0)? "%g": " %g", (double)tfm[j][i]);
+		}
+	}
+	return str;
+}
+
+static void xml_write_header(string& xml)
+{
+	xml += "<cycles>\n";
+	xml += string_printf("<integrator seed=\"%d\" />\n", options.seed);
+}
+
+static void xml_write_camera(string& xml, float3 from, float3 to, float fov)
+{
+	float3 forward = normalize(to - from);
+	float3 right = normalize(cross(forward, make_float3(0.0f, 0.0f, 1.0f)));
+	float3 up = cross(right, forward);
+
+	Transform tfm = make_transform(right.x, up.x, forward.x, from.x,
+	                               right.y, up.y, forward.y, from.y,
+	                               right.z, up.z, forward.z, from.z,
+	                               0.0f, 0.0f, 0.0f, 1.0f);
+
+	xml += string_printf("<transform matrix=\"%s\">\n", xml_matrix(tfm).c_str());
+	xml += string_printf("\t<camera type=\"perspective\" fov=\"%g\" width=\"%d\" height=\"%d\" />\n",
+	                     (double)fov, options.width, options.height);
+	xml += "</transform>\n";
+}
+
+static void xml_write_background(string& xml, float3 color, float strength)
+{
+	xml += "<background>\n";
+	xml += string_printf("\t<background name=\"bg\" color=\"%s\" strength=\"%g\" />\n",
+	                     xml_float3(color).c_str(), (double)strength);
+	xml += "\t<connect from=\"bg background\" to=\"output surface\" />\n";
+	xml += "</background>\n";
+}
+
+static void xml_write_diffuse_shader(string& xml, const char *name, float3 color)
+{
+	xml += string_printf("<shader name=\"%s\">\n", name);
+	xml += string_printf("\t<diffuse_bsdf name=\"diffuse\" color=\"%s\" />\n", xml_float3(color).c_str());
+	xml += "\t<connect from=\"diffuse bsdf\" to=\"output surface\" />\n";
+	xml += "</shader>\n";
+}
+
+static void xml_write_emission_shader(string& xml, const char *name, float3 color, float strength)
+{
+	xml += string_printf("<shader name=\"%s\">\n", name);
+	xml += string_printf("\t<emission name=\"emission\" color=\"%s\" strength=\"%g\" />\n",
+	                     xml_float3(color).c_str(), (double)strength);
+	xml += "\t<connect from=\"emission emission\" to=\"output surface\" />\n";
+	xml += "</shader>\n";
+}
+
+static void xml_write_box(string& xml, float3 bmin, float3 bmax)
+{
+	string P;
+	for(int i = 0; i < 8; i++) {
+		float3 co = make_float3((i & 1)? bmax.x: bmin.x,
+		                        (i & 2)? bmax.y: bmin.y,
+		                        (i & 4)? bmax.z: bmin.z);
+		P += (i == 0)? xml_float3(co): "  " + xml_float3(co);
+	}
+
+	xml += string_printf("<mesh P=\"%s\" nverts=\"4 4 4 4 4 4\" "
+	                     "verts=\"0 2 3 1  4 5 7 6  0 1 5 4  2 6 7 3  0 4 6 2  1 3 7 5\" />\n",
+	                     P.c_str());
+}
+
+static void xml_write_ground(string& xml, float size)
+{
+	xml += string_printf("<mesh P=\"%g %g 0  %g %g 0  %g %g 0  %g %g 0\" nverts=\"4\" verts=\"0 1 2 3\" />\n",
+	                     (double)-size, (double)-size,
+	                     (double)size, (double)-size,
+	                     (double)size, (double)size,
+	                     (double)-size, (double)size);
+}
+
+/* UV sphere, with the radius of every vertex jittered by the given amount. */
+static void xml_write_sphere(string& xml,
+                             BenchmarkRandom& rnd,
+                             const char *name,
+                             int segments,
+                             int rings,
+                             float jitter)
+{
+	string P, nverts, verts;
+
+	/* poles first, then rings from top to bottom */
+	P += xml_float3(make_float3(0.0f, 0.0f, 1.0f + rnd.get(-jitter, jitter)));
+	P += "  " + xml_float3(make_float3(0.0f, 0.0f, -1.0f - rnd.get(-jitter, jitter)));
+
+	for(int r = 1; r < rings; r++) {
+		float theta = M_PI_F*r/rings;
+		for(int s = 0; s < segments; s++) {
+			float phi = M_2PI_F*s/segments;
+			float radius = 1.0f + rnd.get(-jitter, jitter);
+			float3 co = radius*make_float3(sinf(theta)*cosf(phi), sinf(theta)*sinf(phi), cosf(theta));
+			P += "  " + xml_float3(co);
+		}
+	}
+
+	for(int s = 0; s < segments; s++) {
+		int s1 = (s + 1) % segments;
+
+		/* top cap */
+		nverts += "3 ";
+		verts += string_printf("0 %d %d  ", 2 + s, 2 + s1);
+
+		/* quads between rings */
+		for(int r = 1; r < rings - 1; r++) {
+			int top = 2 + (r - 1)*segments;
+			int bottom = top + segments;
+			nverts += "4 ";
+			verts += string_printf("%d %d %d %d  ", top + s, bottom + s, bottom + s1, top + s1);
+		}
+
+		/* bottom cap */
+		int last = 2 + (rings - 2)*segments;
+		nverts += "3 ";
+		verts += string_printf("1 %d %d  ", last + s1, last + s);
+	}
+
+	xml += string_printf("<mesh%s%s%s P=\"%s\" nverts=\"%s\" verts=\"%s\" />\n",
+	                     name? " name=\"": "",
+	                     name? name: "",
+	                     name? "\"": "",
+	                     P.c_str(), nverts.c_str(), verts.c_str());
+}
+
+static void xml_write_sphere_at(string& xml,
+                                BenchmarkRandom& rnd,
+                                float3 co,
+                                float radius,
+                                int segments,
+                                int rings)
+{
+	xml += string_printf("<transform translate=\"%s\" scale=\"%g %g %g\">\n",
+	                     xml_float3(co).c_str(), (double)radius, (double)radius, (double)radius);
+	xml_write_sphere(xml, rnd, NULL, segments, rings, 0.0f);
+	xml += "</transform>\n";
+}
+
+/* Scenes
+ *
+ * Every scene exercises a different part of the renderer. Scenes are written
+ * as XML so they can also be rendered and inspected with the cycles app. */
+
+typedef bool (*BenchmarkSceneWriteFunc)(string& xml, BenchmarkRandom& rnd);
+
+struct BenchmarkScene {
+	const char *name;
+	int samples;
+	BenchmarkSceneWriteFunc write;
+};
+
+/* Thousands of instances of a single mesh. */
+static bool benchmark_scene_instancing(string& xml, BenchmarkRandom& rnd)
+{
+	const int grid = 64;
+
+	xml_write_header(xml);
+	xml_write_camera(xml, make_float3(0.0f, -40.0f, 14.0f), make_float3(0.0f, 0.0f, 0.0f), 0.8f);
+	xml_write_background(xml, make_float3(0.6f, 0.7f, 0.9f), 1.0f);
+
+	xml_write_diffuse_shader(xml, "ground", make_float3(0.5f, 0.5f, 0.5f));
+	xml_write_diffuse_shader(xml, "rock", make_float3(0.6f, 0.45f, 0.3f));
+	xml_write_emission_shader(xml, "sun", make_float3(1.0f, 0.95f, 0.9f), 3.0f);
+
+	xml += "<state shader=\"sun\">\n";
+	xml += "<light type=\"distant\" dir=\"-0.4 0.6 -0.7\" size=\"0.05\" />\n";
+	xml += "</state>\n";
+
+	xml += "<state shader=\"ground\">\n";
+	xml_write_ground(xml, 100.0f);
+	xml += "</state>\n";
+
+	xml += "<state shader=\"rock\" interpolation=\"smooth\">\n";
+	xml_write_sphere(xml, rnd, "rock", 48, 24, 0.15f);
+
+	for(int y = 0; y < grid; y++) {
+		for(int x = 0; x < grid; x++) {
+			float3 co = make_float3((x - grid*0.5f + rnd.get(0.0f, 1.0f))*1.5f,
+			                        (y - grid*0.5f + rnd.get(0.0f, 1.0f))*1.5f,
+			                        0.0f);
+			float scale = rnd.get(0.2f, 0.6f);
+			float angle = rnd.get(0.0f, 360.0f);
+
+			xml += string_printf("<transform translate=\"%s\" rotate=\"%g 0 0 1\" scale=\"%g %g %g\">"
+			                     "<instance mesh=\"rock\" /></transform>\n",
+			                     xml_float3(co).c_str(), (double)angle,
+			                     (double)scale, (double)scale, (double)scale*0.7);
+		}
+	}
+
+	xml += "</state>\n";
+	xml += "</cycles>\n";
+
+	return true;
+}
+
+/* Many thin curves around a sphere. */
+static bool benchmark_scene_hair(string& xml, BenchmarkRandom& rnd)
+{
+	const int num_curves = 20000;
+	const int num_keys = 5;
+
+	xml_write_header(xml);
+	xml_write_camera(xml, make_float3(0.0f, -5.0f, 1.5f), make_float3(0.0f, 0.0f, 0.6f), 0.7f);
+	xml_write_background(xml, make_float3(0.8f, 0.8f, 0.8f), 0.5f);
+
+	xml_write_diffuse_shader(xml, "ground", make_float3(0.5f, 0.5f, 0.5f));
+	xml_write_diffuse_shader(xml, "head", make_float3(0.8f, 0.6f, 0.5f));
+	xml_write_diffuse_shader(xml, "hair", make_float3(0.35f, 0.2f, 0.1f));
+	xml_write_emission_shader(xml, "lamp", make_float3(1.0f, 1.0f, 1.0f), 400.0f);
+
+	xml += "<state shader=\"lamp\">\n";
+	xml += "<light type=\"point\" co=\"3 -3 4\" size=\"0.5\" />\n";
+	xml += "<light type=\"point\" co=\"-3 -1 2\" size=\"0.5\" />\n";
+	xml += "</state>\n";
+
+	xml += "<state shader=\"ground\">\n";
+	xml_write_ground(xml, 20.0f);
+	xml += "</state>\n";
+
+	xml += "<transform translate=\"0 0 1\">\n";
+	xml += "<state shader=\"head\" interpolation=\"smooth\">\n";
+	xml_write_sphere(xml, rnd, NULL, 32, 16, 0.0f);
+	xml += "</state>\n";
+
+	/* strands grow along the normal of the upper half of the sphere and
+	 * droop down under gravity */
+	string P, nkeys;
+
+	for(int i = 0; i < num_curves; i++) {
+		float z = rnd.get(-0.2f, 1.0f);
+		float phi = rnd.get(0.0f, M_2PI_F);
+		float r = sqrtf(max(1.0f - z*z, 0.0f));
+		float3 normal = make_float3(r*cosf(phi), r*sinf(phi), z);
+		float length = rnd.get(0.6f, 1.0f);
+
+		float3 co = normal;
+		for(int k = 0; k < num_keys; k++) {
+			float t = (float)k/(num_keys - 1);
+			float3 key = co + normal*(length*t*0.5f) - make_float3(0.0f, 0.0f, length*t*t);
+			P += (P.empty())? xml_float3(key): "  " + xml_float3(key);
+		}
+
+		nkeys += (i == 0)? string_printf("%d", num_keys): string_printf(" %d", num_keys);
+	}
+
+	xml += "<state shader=\"hair\">\n";
+	xml += string_printf("<curves P=\"%s\" nkeys=\"%s\" radius=\"0.004\" />\n", P.c_str(), nkeys.c_str());
+	xml += "</state>\n";
+	xml += "</transform>\n";
+	xml += "</cycles>\n";
+
+	return true;
+}
+
+/* Heterogeneous volume with objects inside. */
+static bool benchmark_scene_volume(string& xml, BenchmarkRandom& rnd)
+{
+	xml_write_header(xml);
+	xml += "<integrator volume_step_size=\"0.05\" volume_max_steps=\"1024\" />\n";
+	xml_write_camera(xml, make_float3(0.0f, -7.0f, 2.5f), make_float3(0.0f, 0.0f, 1.0f), 0.8f);
+	xml_write_background(xml, make_float3(0.2f, 0.25f, 0.35f), 1.0f);
+
+	xml_write_diffuse_shader(xml, "ground", make_float3(0.5f, 0.5f, 0.5f));
+	xml_write_diffuse_shader(xml, "object", make_float3(0.8f, 0.2f, 0.2f));
+	xml_write_emission_shader(xml, "lamp", make_float3(1.0f, 0.9f, 0.7f), 200.0f);
+
+	xml += "<shader name=\"smoke\">\n";
+	xml += "\t<noise_texture name=\"noise\" scale=\"2\" detail=\"4\" />\n";
+	xml += "\t<scatter_volume name=\"scatter\" color=\"0.9 0.9 0.9\" anisotropy=\"0.3\" />\n";
+	xml += "\t<absorption_volume name=\"absorption\" color=\"0.8 0.7 0.6\" density=\"0.2\" />\n";
+	xml += "\t<add_closure name=\"add\" />\n";
+	xml += "\t<connect from=\"noise fac\" to=\"scatter density\" />\n";
+	xml += "\t<connect from=\"scatter volume\" to=\"add closure1\" />\n";
+	xml += "\t<connect from=\"absorption volume\" to=\"add closure2\" />\n";
+	xml += "\t<connect from=\"add closure\" to=\"output volume\" />\n";
+	xml += "</shader>\n";
+
+	xml += "<state shader=\"lamp\">\n";
+	xml += "<light type=\"point\" co=\"0 0 1.5\" size=\"0.2\" />\n";
+	xml += "<light type=\"point\" co=\"4 -4 5\" size=\"0.5\" />\n";
+	xml += "</state>\n";
+
+	xml += "<state shader=\"ground\">\n";
+	xml_write_ground(xml, 20.0f);
+	xml += "</state>\n";
+
+	xml += "<state shader=\"object\" interpolation=\"smooth\">\n";
+	for(int i = 0; i < 16; i++) {
+		float3 co = make_float3(rnd.get(-2.0f, 2.0f), rnd.get(-2.0f, 2.0f), rnd.get(0.3f, 2.5f));
+		xml_write_sphere_at(xml, rnd, co, rnd.get(0.1f, 0.4f), 24, 12);
+	}
+	xml += "</state>\n";
+
+	xml += "<state shader=\"smoke\">\n";
+	xml_write_box(xml, make_float3(-2.5f, -2.5f, 0.0f), make_float3(2.5f, 2.5f, 3.0f));
+	xml += "</state>\n";
+	xml += "</cycles>\n";
+
+	return true;
+}
+
+/* City of boxes lit by many small lamps. */
+static bool benchmark_scene_many_lights(string& xml, BenchmarkRandom& rnd)
+{
+	const int grid = 16;
+	const int num_lights = 1024;
+	const int num_colors = 8;
+
+	xml_write_header(xml);
+	xml_write_camera(xml, make_float3(0.0f, -22.0f, 12.0f), make_float3(0.0f, 0.0f, 0.0f), 0.8f);
+	xml_write_background(xml, make_float3(0.02f, 0.02f, 0.05f), 1.0f);
+
+	xml_write_diffuse_shader(xml, "ground", make_float3(0.4f, 0.4f, 0.4f));
+	xml_write_diffuse_shader(xml, "building", make_float3(0.7f, 0.7f, 0.7f));
+
+	for(int i = 0; i < num_colors; i++) {
+		string name = string_printf("lamp%d", i);
+		xml_write_emission_shader(xml, name.c_str(), rnd.get_float3(0.2f, 1.0f), 20.0f);
+	}
+
+	xml += "<state shader=\"ground\">\n";
+	xml_write_ground(xml, 50.0f);
+	xml += "</state>\n";
+
+	xml += "<state shader=\"building\">\n";
+	for(int y = 0; y < grid; y++) {
+		for(int x = 0; x < grid; x++) {
+			float3 bmin = make_float3((x - grid*0.5f)*1.5f, (y - grid*0.5f)*1.5f, 0.0f);
+			float3 bmax = bmin + make_float3(rnd.get(0.5f, 1.0f), rnd.get(0.5f, 1.0f), rnd.get(0.5f, 4.0f));
+			xml_write_box(xml, bmin, bmax);
+		}
+	}
+	xml += "</state>\n";
+
+	for(int i = 0; i < num_lights; i++) {
+		float3 co = make_float3(rnd.get(-grid*0.75f, grid*0.75f),
+		                        rnd.get(-grid*0.75f, grid*0.75f),
+		                        rnd.get(0.2f, 5.0f));
+		int color = min((int)(rnd.get()*num_colors), num_colors - 1);
+
+		xml += string_printf("<state shader=\"lamp%d\"><light type=\"point\" co=\"%s\" size=\"0.05\" /></state>\n",
+		                     color, xml_float3(co).c_str());
+	}
+
+	xml += "</cycles>\n";
+
+	return true;
+}
+
+static bool benchmark_write_texture(const string& filepath, BenchmarkRandom& rnd, int size)
+{
+	if(path_exists(filepath)) {
+		return true;
+	}
+
+	path_create_directories(filepath);
+
+	/* colored cells with a gradient, so neighbouring texels differ */
+	const int cell = 64;
+	vector<uchar> pixels(size*size*3);
+	float3 tint = rnd.get_float3(0.3f, 1.0f);
+	uint seed = hash_int(options.seed);
+
+	for(int y = 0; y < size; y++) {
+		for(int x = 0; x < size; x++) {
+			uint h = hash_int_2d(seed, (y/cell)*size + x/cell);
+			float value = 0.5f*(h & 0xFF)/255.0f + 0.5f*(float)(x + y)/(2*size);
+			uchar *pixel = &pixels[(y*size + x)*3];
+
+			pixel[0] = (uchar)(value*tint.x*255.0f);
+			pixel[1] = (uchar)(value*tint.y*255.0f);
+			pixel[2] = (uchar)(value*tint.z*255.0f);
+		}
+	}
+
+	ImageOutput *out = ImageOutput::create(filepath);
+
+	if(!out) {
+		fprintf(stderr, "Failed to create texture %s\n", filepath.c_str());
+		return false;
+	}
+
+	ImageSpec spec(size, size, 3, TypeDesc::UINT8);
+	bool ok = out->open(filepath, spec) && out->write_image(TypeDesc::UINT8, &pixels[0]);
+	out->close();
+	delete out;
+
+	if(!ok) {
+		fprintf(stderr, "Failed to write texture %s\n", filepath.c_str());
+	}
+
+	return ok;
+}
+
+/* Large image textures mixed with procedural textures. */
+static bool benchmark_scene_textures(string& xml, BenchmarkRandom& rnd)
+{
+	const int num_textures = 8;
+	const int texture_size = 2048;
+
+	xml_write_header(xml);
+	xml_write_camera(xml, make_float3(0.0f, -12.0f, 6.0f), make_float3(0.0f, 0.0f, 0.5f), 0.8f);
+	xml_write_background(xml, make_float3(0.8f, 0.8f, 0.8f), 1.0f);
+
+	xml_write_diffuse_shader(xml, "ground", make_float3(0.5f, 0.5f, 0.5f));
+	xml_write_emission_shader(xml, "sun", make_float3(1.0f, 0.95f, 0.9f), 3.0f);
+
+	for(int i = 0; i < num_textures; i++) {
+		string filename = string_printf("textures/benchmark_%d.png", i);
+
+		if(!benchmark_write_texture(path_join(options.scene_dir, filename), rnd, texture_size)) {
+			return false;
+		}
+
+		xml += string_printf("<shader name=\"textured%d\">\n", i);
+		xml += "\t<texture_coordinate name=\"coord\" />\n";
+		xml += string_printf("\t<image_texture name=\"image\" filename=\"%s\" />\n", filename.c_str());
+		xml += string_printf("\t<noise_texture name=\"noise\" scale=\"%g\" detail=\"8\" />\n", (double)rnd.get(2.0f, 8.0f));
+		xml += string_printf("\t<voronoi_texture name=\"voronoi\" scale=\"%g\" />\n", (double)rnd.get(4.0f, 16.0f));
+		xml += string_printf("\t<wave_texture name=\"wave\" scale=\"%g\" distortion=\"4\" detail=\"4\" />\n", (double)rnd.get(1.0f, 4.0f));
+		xml += "\t<mix name=\"mix1\" type=\"multiply\" fac=\"0.5\" />\n";
+		xml += "\t<mix name=\"mix2\" type=\"overlay\" />\n";
+		xml += "\t<diffuse_bsdf name=\"diffuse\" />\n";
+		xml += "\t<connect from=\"coord generated\" to=\"image vector\" />\n";
+		xml += "\t<connect from=\"image color\" to=\"mix1 color1\" />\n";
+		xml += "\t<connect from=\"noise color\" to=\"mix1 color2\" />\n";
+		xml += "\t<connect from=\"voronoi fac\" to=\"mix2 fac\" />\n";
+		xml += "\t<connect from=\"mix1 color\" to=\"mix2 color1\" />\n";
+		xml += "\t<connect from=\"wave color\" to=\"mix2 color2\" />\n";
+		xml += "\t<connect from=\"mix2 color\" to=\"diffuse color\" />\n";
+		xml += "\t<connect from=\"diffuse bsdf\" to=\"output surface\" />\n";
+		xml += "</shader>\n";
+	}
+
+	xml += "<state shader=\"sun\">\n";
+	xml += "<light type=\"distant\" dir=\"-0.3 0.5 -0.8\" size=\"0.05\" />\n";
+	xml += "</state>\n";
+
+	xml += "<state shader=\"ground\">\n";
+	xml_write_ground(xml, 30.0f);
+	xml += "</state>\n";
+
+	for(int i = 0; i < num_textures; i++) {
+		float3 co = make_float3((i % 4 - 1.5f)*2.5f, (i / 4 - 0.5f)*2.5f, 1.0f);
+
+		xml += string_printf("<state shader=\"textured%d\" interpolation=\"smooth\">\n", i);
+		if(i % 2 == 0) {
+			xml_write_sphere_at(xml, rnd, co, 1.0f, 64, 32);
+		}
+		else {
+			xml_write_box(xml, co - make_float3(1.0f, 1.0f, 1.0f), co + make_float3(1.0f, 1.0f, 1.0f));
+		}
+		xml += "</state>\n";
+	}
+
+	xml += "</cycles>\n";
+
+	return true;
+}
+
+static const BenchmarkScene benchmark_scenes[] = {
+	{"instancing", 16, benchmark_scene_instancing},
+	{"hair", 16, benchmark_scene_hair},
+	{"volume", 16, benchmark_scene_volume},
+	{"many_lights", 16, benchmark_scene_many_lights},
+	{"textures", 16, benchmark_scene_textures},
+};
+
+/* Rendering */
+
+struct BenchmarkResult {
+	string name;
+	int samples;
+	int frames;
+	/* Scene creation from XML. */
+	double sync_time;
+	/* Mesh and scene BVH builds and refits, part of the scene update. */
+	double bvh_time;
+	/* Path tracing, after kernels are loaded and the scene is updated. */
+	double render_time;
+	/* Everything from scene creation until the session finished. */
+	double total_time;
+	/* One camera ray is traced per pixel sample. */
+	double camera_rays_per_second;
+	size_t device_memory_peak;
+	map<string, double> stage_times;
+	/* Only with kernels built with WITH_CYCLES_KERNEL_STATS. */
+	map<string, uint64_t> kernel_counters;
+};
+
+static int benchmark_scene_samples(const BenchmarkScene& bscene)
+{
+	return (options.samples > 0)? options.samples: bscene.samples;
+}
+
+static bool benchmark_scene_write(const BenchmarkScene& bscene, string& filepath)
+{
+	BenchmarkRandom rnd(options.seed);
+	string xml;
+
+	if(!bscene.write(xml, rnd)) {
+		return false;
+	}
+
+	filepath = path_join(options.scene_dir, string(bscene.name) + ".xml");
+
+	if(!path_write_text(filepath, xml)) {
+		fprintf(stderr, "Failed to write scene %s\n", filepath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+/* Move every object a bit, like an animation rendered with persistent data.
+ * Meshes which have their transform applied get new vertices instead, as
+ * they would when synced again from Blender. */
+static void benchmark_scene_next_frame(Scene *scene)
+{
+	const float3 offset = make_float3(0.0f, 0.0f, 0.01f);
+
+	thread_scoped_lock scene_lock(scene->mutex);
+
+	foreach(Object *object, scene->objects) {
+		Mesh *mesh = object->mesh;
+
+		if(mesh->transform_applied) {
+			for(size_t i = 0; i < mesh->verts.size(); i++) {
+				mesh->verts[i] += offset;
+			}
+			for(size_t i = 0; i < mesh->curve_keys.size(); i++) {
+				mesh->curve_keys[i] += offset;
+			}
+			mesh->tag_update(scene, true);
+		}
+		else {
+			object->tfm = transform_translate(offset) * object->tfm;
+		}
+
+		object->tag_update(scene);
+	}
+}
+
+/* Render buffer of the whole image, assembled from the tiles. */
+struct BenchmarkPixels {
+	int pass_stride;
+	vector<float> buffer;
+};
+
+static void benchmark_tile_write(RenderTile& rtile, BenchmarkPixels *pixels)
+{
+	RenderBuffers *buffers = rtile.buffers;
+
+	if(!buffers->copy_from_device()) {
+		return;
+	}
+
+	const int pass_stride = buffers->params.get_passes_size();
+
+	if(pixels->buffer.empty()) {
+		pixels->pass_stride = pass_stride;
+		pixels->buffer.resize((size_t)options.width*options.height*pass_stride, 0.0f);
+	}
+
+	const float *tile_buffer = buffers->buffer.get_data();
+
+	for(int y = 0; y < rtile.h; y++) {
+		memcpy(&pixels->buffer[((size_t)(rtile.y + y)*options.width + rtile.x)*pass_stride],
+		       tile_buffer + (size_t)y*rtile.w*pass_stride,
+		       sizeof(float)*rtile.w*pass_stride);
+	}
+}
+
+static bool benchmark_scene_render(const BenchmarkScene& bscene,
+                                   const string& filepath,
+                                   BenchmarkResult *result,
+                                   BenchmarkPixels *pixels = NULL)
+{
+	const int samples = benchmark_scene_samples(bscene);
+	double time_start = time_dt();
+
+	/* Scene */
+	Scene *scene = new Scene(options.scene_params, options.session_params.device);
+	xml_read_file(scene, filepath.c_str());
+
+	scene->camera->width = options.width;
+	scene->camera->height = options.height;
+	scene->camera->compute_auto_viewplane();
+
+	double sync_time = time_dt() - time_start;
+
+	/* Session, it owns the scene from here on */
+	SessionParams session_params = options.session_params;
+	session_params.samples = samples;
+
+	Session *session = new Session(session_params);
+
+	if(pixels != NULL) {
+		session->write_render_tile_cb = function_bind(benchmark_tile_write, _1, pixels);
+	}
+
+	BufferParams buffer_params;
+	buffer_params.width = options.width;
+	buffer_params.height = options.height;
+	buffer_params.full_width = options.width;
+	buffer_params.full_height = options.height;
+
+	session->reset(buffer_params, samples);
+	session->scene = scene;
+	session->start();
+	session->wait();
+
+	for(int frame = 1; frame < options.frames && !session->progress.get_error(); frame++) {
+		benchmark_scene_next_frame(scene);
+
+		session->reset(buffer_params, samples);
+		session->start();
+		session->wait();
+	}
+
+	double total_time = time_dt() - time_start;
+
+	if(session->progress.get_error()) {
+		fprintf(stderr, "%s: %s\n", bscene.name, session->progress.get_error_message().c_str());
+		delete session;
+		return false;
+	}
+
+	map<string, double>& stage_times = session->stats.stage_times;
+
+	result->name = bscene.name;
+	result->samples = samples;
+	result->frames = options.frames;
+	result->sync_time = sync_time;
+	result->bvh_time = stage_times["mesh_bvh"] + stage_times["scene_bvh"];
+	result->render_time = max(total_time - sync_time - stage_times["load_kernels"] - stage_times["scene_update"], 0.0);
+	result->total_time = total_time;
+	result->camera_rays_per_second = (result->render_time > 0.0)?
+		(double)options.width*options.height*samples*options.frames/result->render_time: 0.0;
+	result->device_memory_peak = session->stats.mem_peak;
+	result->stage_times = stage_times;
+	result->kernel_counters = session->stats.kernel_counters;
+
+	delete session;
+
+	return true;
+}
+
+/* Render the scene with per pixel tracing and with packet traversal, the
+ * render buffers must be identical. */
+static bool benchmark_scene_compare_packet_traversal(const BenchmarkScene& bscene,
+                                                     const string& filepath)
+{
+	const bool packet_traversal = DebugFlags().cpu.packet_traversal;
+	BenchmarkPixels pixels[2];
+
+	for(int i = 0; i < 2; i++) {
+		DebugFlags().cpu.packet_traversal = (i == 1);
+
+		BenchmarkResult result;
+		if(!benchmark_scene_render(bscene, filepath, &result, &pixels[i])) {
+			DebugFlags().cpu.packet_traversal = packet_traversal;
+			return false;
+		}
+	}
+
+	DebugFlags().cpu.packet_traversal = packet_traversal;
+
+	if(pixels[0].buffer.empty() || pixels[0].buffer.size() != pixels[1].buffer.size()) {
+		fprintf(stderr, "%s: render buffers of packet traversal are missing\n", bscene.name);
+		return false;
+	}
+
+	const int pass_stride = pixels[0].pass_stride;
+	const size_t num_pixels = pixels[0].buffer.size()/pass_stride;
+	size_t num_different = 0;
+
+	for(size_t i = 0; i < num_pixels; i++) {
+		if(memcmp(&pixels[0].buffer[i*pass_stride],
+		          &pixels[1].buffer[i*pass_stride],
+		          sizeof(float)*pass_stride) != 0)
+		{
+			num_different++;
+		}
+	}
+
+	if(num_different != 0) {
+		fprintf(stderr, "%s: %d of %d pixels differ with packet traversal\n",
+		        bscene.name, (int)num_different, (int)num_pixels);
+		return false;
+	}
+
+	return true;
+}
+
+/* JSON */
+
+static string benchmark_json(const vector<BenchmarkResult>& results)
+{
+	string json = "{\n";
+
+	json += string_printf("\t\"version\": \"%s\",\n", CYCLES_VERSION_STRING);
+	json += string_printf("\t\"device\": \"%s\",\n", Device::string_from_type(options.session_params.device.type).c_str());
+	json += string_printf("\t\"threads\": %d,\n", options.session_params.threads);
+	json += string_printf("\t\"bvh_layout\": \"%s\",\n", options.bvh_layout.c_str());
+	json += string_printf("\t\"width\": %d,\n", options.width);
+	json += string_printf("\t\"height\": %d,\n", options.height);
+	json += string_printf("\t\"seed\": %d,\n", options.seed);
+	json += string_printf("\t\"host_memory_peak\": %zu,\n", util_guarded_get_mem_peak());
+	json += "\t\"scenes\": [\n";
+
+	for(size_t i = 0; i < results.size(); i++) {
+		const BenchmarkResult& result = results[i];
+
+		json += "\t\t{\n";
+		json += string_printf("\t\t\t\"name\": \"%s\",\n", result.name.c_str());
+		json += string_printf("\t\t\t\"samples\": %d,\n", result.samples);
+		json += string_printf("\t\t\t\"frames\": %d,\n", result.frames);
+		json += string_printf("\t\t\t\"sync_time\": %.6f,\n", result.sync_time);
+		json += string_printf("\t\t\t\"bvh_time\": %.6f,\n", result.bvh_time);
+		json += string_printf("\t\t\t\"render_time\": %.6f,\n", result.render_time);
+		json += string_printf("\t\t\t\"total_time\": %.6f,\n", result.total_time);
+		json += string_printf("\t\t\t\"camera_rays_per_second\": %.1f,\n", result.camera_rays_per_second);
+		json += string_printf("\t\t\t\"device_memory_peak\": %zu,\n", result.device_memory_peak);
+		json += "\t\t\t\"stages\": {";
+
+		for(map<string, double>::const_iterator it = result.stage_times.begin(); it != result.stage_times.end(); ++it) {
+			json += string_printf("%s\n\t\t\t\t\"%s\": %.6f",
+			                      (it == result.stage_times.begin())? "": ",",
+			                      it->first.c_str(), it->second);
+		}
+
+		json += "\n\t\t\t}";
+
+		if(!result.kernel_counters.empty()) {
+			json += ",\n\t\t\t\"kernel_counters\": {";
+
+			for(map<string, uint64_t>::const_iterator it = result.kernel_counters.begin(); it != result.kernel_counters.end(); ++it) {
+				json += string_printf("%s\n\t\t\t\t\"%s\": %llu",
+				                      (it == result.kernel_counters.begin())? "": ",",
+				                      it->first.c_str(), (unsigned long long)it->second);
+			}
+
+			json += "\n\t\t\t}";
+		}
+
+		json += "\n";
+		json += (i + 1 < results.size())? "\t\t},\n": "\t\t}\n";
+	}
+
+	json += "\t]\n";
+	json += "}\n";
+
+	return json;
+}
+
+/* Reads the numbers of every scene in JSON written by benchmark_json(),
+ * keys of nested objects are joined with a dot. This is not a general JSON
+ * parser, only enough to read back our own output. */
+typedef map<string, map<string, double> > BenchmarkBaseline;
+
+static bool benchmark_baseline_read(const string& filepath, BenchmarkBaseline& baseline)
+{
+	string text;
+
+	if(!path_read_text(filepath, text)) {
+		fprintf(stderr, "Failed to read baseline %s\n", filepath.c_str());
+		return false;
+	}
+
+	/* keys of the objects and arrays the parser is in */
+	vector<string> stack;
+	string key, scene;
+	size_t i = 0;
+
+	while(i < text.size()) {
+		char c = text[i];
+
+		if(c == '{' || c == '[') {
+			stack.push_back(key);
+			key = "";
+			i++;
+		}
+		else if(c == '}' || c == ']') {
+			if(stack.empty()) {
+				break;
+			}
+			stack.pop_back();
+			key = "";
+			i++;
+		}
+		else if(c == '"') {
+			size_t end = text.find('"', i + 1);
+			if(end == string::npos) {
+				break;
+			}
+
+			string str = text.substr(i + 1, end - i - 1);
+			i = end + 1;
+
+			while(i < text.size() && isspace(text[i])) {
+				i++;
+			}
+
+			if(i < text.size() && text[i] == ':') {
+				key = str;
+				i++;
+			}
+			else if(key == "name" && stack.size() == 3 && stack[1] == "scenes") {
+				scene = str;
+			}
+		}
+		else if(c == '-' || isdigit(c)) {
+			char *end;
+			double value = strtod(text.c_str() + i, &end);
+
+			if(end == text.c_str() + i) {
+				i++;
+				continue;
+			}
+
+			i = end - text.c_str();
+
+			if(stack.size() >= 3 && stack[1] == "scenes" && !scene.empty()) {
+				string path;
+				for(size_t j = 3; j < stack.size(); j++) {
+					path += stack[j] + ".";
+				}
+				baseline[scene][path + key] = value;
+			}
+		}
+		else {
+			i++;
+		}
+	}
+
+	if(baseline.empty()) {
+		fprintf(stderr, "No scenes found in baseline %s\n", filepath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+/* Compare results against the baseline, returns false if any metric got
+ * worse by more than the threshold. */
+static bool benchmark_baseline_compare(const vector<BenchmarkResult>& results,
+                                       const BenchmarkBaseline& baseline)
+{
+	/* Timings below this many seconds are too noisy to compare. */
+	const double min_time = 0.01;
+	bool ok = true;
+
+	foreach(const BenchmarkResult& result, results) {
+		BenchmarkBaseline::const_iterator it = baseline.find(result.name);
+
+		if(it == baseline.end()) {
+			fprintf(stderr, "%s: not in baseline\n", result.name.c_str());
+			continue;
+		}
+
+		const map<string, double>& base = it->second;
+
+		struct {
+			const char *name;
+			double value;
+			bool higher_is_better;
+			bool is_time;
+		} metrics[] = {
+			{"sync_time", result.sync_time, false, true},
+			{"bvh_time", result.bvh_time, false, true},
+			{"render_time", result.render_time, false, true},
+			{"total_time", result.total_time, false, true},
+			{"camera_rays_per_second", result.camera_rays_per_second, true, false},
+			{"device_memory_peak", (double)result.device_memory_peak, false, false},
+		};
+
+		for(size_t i = 0; i < sizeof(metrics)/sizeof(*metrics); i++) {
+			map<string, double>::const_iterator base_it = base.find(metrics[i].name);
+
+			if(base_it == base.end() || base_it->second <= 0.0) {
+				continue;
+			}
+
+			double old_value = base_it->second;
+			double new_value = metrics[i].value;
+
+			if(metrics[i].is_time && max(old_value, new_value) < min_time) {
+				continue;
+			}
+
+			double change = (new_value - old_value)/old_value;
+			double worse = metrics[i].higher_is_better? -change: change;
+			bool regression = worse*100.0 > options.threshold;
+
+			fprintf(stderr, "%-12s %-24s %14.4f -> %14.4f  %+6.1f%%%s\n",
+			        result.name.c_str(), metrics[i].name,
+			        old_value, new_value, change*100.0,
+			        regression? "  REGRESSION": "");
+
+			if(regression) {
+				ok = false;
+			}
+		}
+	}
+
+	return ok;
+}
+
+/* Options */
+
+static int files_parse(int argc, const char *argv[])
+{
+	for(int i = 0; i < argc; i++)
+		options.scene_names.push_back(argv[i]);
+
+	return 0;
+}
+
+static void options_parse(int argc, const char **argv)
+{
+	options.scene_dir = "cycles_benchmark";
+	options.width = 640;
+	options.height = 360;
+	options.samples = 0;
+	options.frames = 1;
+	options.bvh_type = "dynamic";
+	options.seed = 0;
+	options.repeat = 1;
+	options.threshold = 5.0f;
+	options.compare_packet_traversal = false;
+	options.quiet = false;
+
+	/* device names */
+	string device_names = "";
+	string devicename = "CPU";
+
+	vector<DeviceType>& types = Device::available_types();
+
+	foreach(DeviceType type, types) {
+		if(device_names != "")
+			device_names += ", ";
+
+		device_names += Device::string_from_type(type);
+	}
+
+	string scene_names = "";
+	for(size_t i = 0; i < sizeof(benchmark_scenes)/sizeof(*benchmark_scenes); i++) {
+		if(scene_names != "")
+			scene_names += ", ";
+
+		scene_names += benchmark_scenes[i].name;
+	}
+
+	/* parse options */
+	ArgParse ap;
+	bool help = false, debug = false, version = false;
+	bool packet_traversal = false;
+	int verbosity = 1;
+
+	ap.options ("Usage: cycles_benchmark [options] [scene ...]",
+		"%*", files_parse, "",
+		"--device %s", &devicename, ("Devices to use: " + device_names).c_str(),
+		"--threads %d", &options.session_params.threads, "CPU Rendering Threads",
+		"--samples %d", &options.samples, "Number of samples to render, overriding the scene default",
+		"--frames %d", &options.frames, "Number of frames to render per scene, moving all objects between frames",
+		"--width %d", &options.width, "Image width in pixels",
+		"--height %d", &options.height, "Image height in pixels",
+		"--tile-width %d", &options.session_params.tile_size.x, "Tile width in pixels",
+		"--tile-height %d", &options.session_params.tile_size.y, "Tile height in pixels",
+		"--seed %d", &options.seed, "Seed for scene generation and sampling",
+		"--repeat %d", &options.repeat, "Render every scene this many times and keep the fastest",
+		"--scene-dir %s", &options.scene_dir, "Directory to write the generated scenes to",
+		"--output %s", &options.output_path, "File path to write JSON results to, instead of stdout",
+		"--baseline %s", &options.baseline_path, "JSON results to compare against",
+		"--threshold %f", &options.threshold, "Percentage a metric may get worse before it counts as a regression",
+		"--texture-cache-size %d", &options.scene_params.texture_cache_size, "Read image textures through a cache of this size in megabytes (CPU only)",
+		"--bvh-type %s", &options.bvh_type, "BVH type: dynamic (two-level, refitted when objects move) or static (transforms applied to meshes)",
+		"--bvh-layout %s", &options.bvh_layout, "BVH layout: bvh2, qbvh or obvh, defaults to the widest one the device supports",
+		"--packet-traversal", &packet_traversal, "Trace camera rays of neighbour pixels and their shadow rays as packets (CPU only)",
+		"--compare-packet-traversal", &options.compare_packet_traversal, "Fail unless every scene renders the same with and without packet traversal (CPU only)",
+		"--quiet", &options.quiet, "Don't print progress messages",
+#ifdef WITH_CYCLES_LOGGING
+		"--debug", &debug, "Enable debug logging",
+		"--verbose %d", &verbosity, "Set verbosity of the logger",
+#endif
+		"--help", &help, ("Print help message, scenes: " + scene_names).c_str(),
+		"--version", &version, "Print version number",
+		NULL);
+
+	if(ap.parse(argc, argv) < 0) {
+		fprintf(stderr, "%s\n", ap.geterror().c_str());
+		ap.usage();
+		exit(EXIT_FAILURE);
+	}
+
+	if(debug) {
+		util_logging_start();
+		util_logging_verbosity_set(verbosity);
+	}
+
+	if(version) {
+		printf("%s\n", CYCLES_VERSION_STRING);
+		exit(EXIT_SUCCESS);
+	}
+	else if(help) {
+		ap.usage();
+		exit(EXIT_SUCCESS);
+	}
+
+	DebugFlags().cpu.packet_traversal = packet_traversal;
+
+	/* final frame rendering in tiles, like a background render */
+	options.session_params.background = true;
+	options.session_params.progressive = false;
+
+	/* find matching device */
+	DeviceType device_type = Device::type_from_string(devicename.c_str());
+	vector<DeviceInfo>& devices = Device::available_devices();
+	bool device_available = false;
+
+	foreach(DeviceInfo& device, devices) {
+		if(device_type == device.type) {
+			options.session_params.device = device;
+			device_available = true;
+			break;
+		}
+	}
+
+	/* use the same BVH layout as Blender does by default */
+	const bool is_cpu = (options.session_params.device.type == DEVICE_CPU);
+	bool support_obvh = false;
+#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_AVX2
+	support_obvh = is_cpu && system_cpu_support_avx2();
+#endif
+
+	if(options.bvh_layout == "" && (packet_traversal || options.compare_packet_traversal)) {
+		options.bvh_layout = "qbvh";
+	}
+	else if(options.bvh_layout == "") {
+		options.bvh_layout = support_obvh? "obvh": (is_cpu && system_cpu_support_sse2())? "qbvh": "bvh2";
+	}
+
+	options.scene_params.bvh_type = (options.bvh_type == "static")? SceneParams::BVH_STATIC: SceneParams::BVH_DYNAMIC;
+
+	/* QBVH stays enabled with OBVH, for scenes which need unaligned nodes */
+	options.scene_params.use_qbvh = (options.bvh_layout == "qbvh" || options.bvh_layout == "obvh");
+	options.scene_params.use_obvh = (options.bvh_layout == "obvh");
+
+	/* handle invalid configurations */
+	if(options.session_params.device.type == DEVICE_NONE || !device_available) {
+		fprintf(stderr, "Unknown device: %s\n", devicename.c_str());
+		exit(EXIT_FAILURE);
+	}
+	else if(options.bvh_layout != "bvh2" && options.bvh_layout != "qbvh" && options.bvh_layout != "obvh") {
+		fprintf(stderr, "Unknown BVH layout: %s, available layouts: bvh2, qbvh, obvh\n", options.bvh_layout.c_str());
+		exit(EXIT_FAILURE);
+	}
+	else if(!is_cpu && options.bvh_layout != "bvh2") {
+		fprintf(stderr, "BVH layout %s is only supported on the CPU\n", options.bvh_layout.c_str());
+		exit(EXIT_FAILURE);
+	}
+	else if(options.bvh_layout == "obvh" && !support_obvh) {
+		fprintf(stderr, "BVH layout obvh needs AVX2 support from the CPU and the kernel\n");
+		exit(EXIT_FAILURE);
+	}
+	else if((packet_traversal || options.compare_packet_traversal) && options.bvh_layout != "qbvh") {
+		fprintf(stderr, "Packet traversal needs BVH layout qbvh\n");
+		exit(EXIT_FAILURE);
+	}
+	else if(options.width <= 0 || options.height <= 0) {
+		fprintf(stderr, "Invalid resolution: %dx%d\n", options.width, options.height);
+		exit(EXIT_FAILURE);
+	}
+	else if(options.samples < 0) {
+		fprintf(stderr, "Invalid number of samples: %d\n", options.samples);
+		exit(EXIT_FAILURE);
+	}
+	else if(options.frames < 1) {
+		fprintf(stderr, "Invalid number of frames: %d\n", options.frames);
+		exit(EXIT_FAILURE);
+	}
+	else if(options.bvh_type != "dynamic" && options.bvh_type != "static") {
+		fprintf(stderr, "Unknown BVH type: %s, available types: dynamic, static\n", options.bvh_type.c_str());
+		exit(EXIT_FAILURE);
+	}
+	else if(options.repeat < 1) {
+		fprintf(stderr, "Invalid number of repeats: %d\n", options.repeat);
+		exit(EXIT_FAILURE);
+	}
+	else if(options.scene_params.texture_cache_size < 0) {
+		fprintf(stderr, "Invalid texture cache size: %d\n", options.scene_params.texture_cache_size);
+		exit(EXIT_FAILURE);
+	}
+
+	foreach(const string& name, options.scene_names) {
+		bool found = false;
+
+		for(size_t i = 0; i < sizeof(benchmark_scenes)/sizeof(*benchmark_scenes); i++) {
+			if(name == benchmark_scenes[i].name) {
+				found = true;
+			}
+		}
+
+		if(!found) {
+			fprintf(stderr, "Unknown scene: %s, available scenes: %s\n", name.c_str(), scene_names.c_str());
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+
+static bool benchmark_scene_enabled(const BenchmarkScene& bscene)
+{
+	if(options.scene_names.empty()) {
+		return true;
+	}
+
+	foreach(const string& name, options.scene_names) {
+		if(name == bscene.name) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+CCL_NAMESPACE_END
+
+using namespace ccl;
+
+int main(int argc, const char **argv)
+{
+	util_logging_init(argv[0]);
+	path_init();
+	options_parse(argc, argv);
+
+	/* read the baseline first, so a bad path fails before rendering */
+	BenchmarkBaseline baseline;
+	if(options.baseline_path != "" && !benchmark_baseline_read(options.baseline_path, baseline)) {
+		return EXIT_FAILURE;
+	}
+
+	vector<BenchmarkResult> results;
+
+	for(size_t i = 0; i < sizeof(benchmark_scenes)/sizeof(*benchmark_scenes); i++) {
+		const BenchmarkScene& bscene = benchmark_scenes[i];
+
+		if(!benchmark_scene_enabled(bscene)) {
+			continue;
+		}
+
+		string filepath;
+		if(!benchmark_scene_write(bscene, filepath)) {
+			return EXIT_FAILURE;
+		}
+
+		BenchmarkResult best;
+
+		for(int j = 0; j < options.repeat; j++) {
+			if(!options.quiet) {
+				fprintf(stderr, "Rendering %s (%d/%d)\n", bscene.name, j + 1, options.repeat);
+			}
+
+			BenchmarkResult result;
+			if(!benchmark_scene_render(bscene, filepath, &result)) {
+				return EXIT_FAILURE;
+			}
+
+			if(j == 0 || result.total_time < best.total_time) {
+				best = result;
+			}
+		}
+
+		results.push_back(best);
+
+		if(options.compare_packet_traversal) {
+			if(!options.quiet) {
+				fprintf(stderr, "Comparing %s with packet traversal\n", bscene.name);
+			}
+
+			if(!benchmark_scene_compare_packet_traversal(bscene, filepath)) {
+				return EXIT_FAILURE;
+			}
+		}
+	}
+
+	string json = benchmark_json(results);
+
+	if(options.output_path != "") {
+		if(!path_write_text(options.output_path, json)) {
+			fprintf(stderr, "Failed to write %s\n", options.output_path.c_str());
+			return EXIT_FAILURE;
+		}
+	}
+	else {
+		printf("%s", json.c_str());
+	}
+
+	if(options.baseline_path != "" && !benchmark_baseline_compare(results, baseline)) {
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -24,12 +24,14 @@
 #include "render/integrator.h"
 
 #include "util/util_args.h"
+#include "util/util_debug.h"
 #include "util/util_foreach.h"
 #include "util/util_function.h"
 #include "util/util_logging.h"
 #include "util/util_path.h"
 #include "util/util_progress.h"
 #include "util/util_string.h"
+#include "util/util_system.h"
 #include "util/util_time.h"
 #include "util/util_transform.h"
 #include "util/util_version.h"
@@ -139,6 +141,10 @@ static void scene_init()
 static void session_exit()
 {
 	if(options.session) {
+		const string kernel_report = options.session->stats.kernel_counters_report();
+		if(!kernel_report.empty() && !options.quiet) {
+			printf("\n%s", kernel_report.c_str());
+		}
 		delete options.session;
 		options.session = NULL;
 	}
@@ -356,6 +362,7 @@ static void options_parse(int argc, const char **argv)
 	/* parse options */
 	ArgParse ap;
 	bool help = false, debug = false, version = false;
+	bool packet_traversal = false;
 	int verbosity = 1;
 
 	ap.options ("Usage: cycles [options] file.xml",
@@ -374,6 +381,8 @@ static void options_parse(int argc, const char **argv)
 		"--tile-width %d", &options.session_params.tile_size.x, "Tile width in pixels",
 		"--tile-height %d", &options.session_params.tile_size.y, "Tile height in pixels",
 		"--list-devices", &list, "List information about all available devices",
+		"--packet-traversal", &packet_traversal, "Trace camera rays of neighbour pixels and their shadow rays as packets (CPU only)",
+		"--texture-cache-size %d", &options.scene_params.texture_cache_size, "Read image textures through a cache of this size in megabytes (CPU only)",
 #ifdef WITH_CYCLES_LOGGING
 		"--debug", &debug, "Enable debug logging",
 		"--verbose %d", &verbosity, "Set verbosity of the logger",
@@ -415,6 +424,8 @@ static void options_parse(int argc, const char **argv)
 		exit(EXIT_SUCCESS);
 	}
 
+	DebugFlags().cpu.packet_traversal = packet_traversal;
+
 	if(ssname == "osl")
 		options.scene_params.shadingsystem = SHADINGSYSTEM_OSL;
 	else if(ssname == "svm")
@@ -441,6 +452,11 @@ static void options_parse(int argc, const char **argv)
 		}
 	}
 
+	/* QBVH like Blender uses on the CPU, packet traversal depends on it */
+	if(options.session_params.device.type == DEVICE_CPU) {
+		options.scene_params.use_qbvh = DebugFlags().cpu.qbvh && system_cpu_support_sse2();
+	}
+
 	/* handle invalid configurations */
 	if(options.session_params.device.type == DEVICE_NONE || !device_available) {
 		fprintf(stderr, "Unknown device: %s\n", devicename.c_str());
@@ -456,6 +472,10 @@ static void options_parse(int argc, const char **argv)
 		exit(EXIT_FAILURE);
 	}
 #endif
+	else if(options.scene_params.texture_cache_size < 0) {
+		fprintf(stderr, "Invalid texture cache size: %d\n", options.scene_params.texture_cache_size);
+		exit(EXIT_FAILURE);
+	}
 	else if(options.session_params.samples < 0) {
 		fprintf(stderr, "Invalid number of samples: %d\n", options.session_params.samples);
 		exit(EXIT_FAILURE);
@@ -385,12 +385,19 @@ static Mesh *xml_add_mesh(Scene *scene, const Transform& tfm)
 	return mesh;
 }
 
-static void xml_read_mesh(const XMLReadState& state, pugi::xml_node node)
+static void xml_read_mesh(XMLReadState& state, pugi::xml_node node)
 {
 	/* add mesh */
 	Mesh *mesh = xml_add_mesh(state.scene, state.tfm);
 	mesh->used_shaders.push_back(state.shader);
 
+	/* named meshes can be instanced in the same scope */
+	string name;
+	if(xml_read_string(&name, node, "name")) {
+		mesh->name = ustring(name);
+		state.node_map[mesh->name] = mesh;
+	}
+
 	/* read state */
 	int shader = 0;
 	bool smooth = state.smooth;
@@ -529,6 +536,70 @@ static void xml_read_mesh(const XMLReadState& state, pugi::xml_node node)
 	}
 }
 
+/* Curves */
+
+static void xml_read_curves(const XMLReadState& state, pugi::xml_node node)
+{
+	/* read keys and number of keys per curve */
+	vector<float3> P;
+	vector<float> radius;
+	vector<int> nkeys;
+
+	xml_read_float3_array(P, node, "P");
+	xml_read_float_array(radius, node, "radius");
+	xml_read_int_array(nkeys, node, "nkeys");
+
+	size_t num_keys = 0;
+	for(size_t i = 0; i < nkeys.size(); i++)
+		num_keys += nkeys[i];
+
+	if(num_keys != P.size() || !(radius.size() == 1 || radius.size() == P.size())) {
+		fprintf(stderr, "Curves key count mismatch.\n");
+		return;
+	}
+
+	/* add mesh */
+	Mesh *mesh = xml_add_mesh(state.scene, state.tfm);
+	mesh->used_shaders.push_back(state.shader);
+
+	/* create curves, a single radius is used for all keys */
+	mesh->reserve_curves(nkeys.size(), P.size());
+
+	int key = 0;
+
+	for(size_t i = 0; i < nkeys.size(); i++) {
+		mesh->add_curve(key, 0);
+
+		for(int j = 0; j < nkeys[i]; j++, key++)
+			mesh->add_curve_key(P[key], (radius.size() == 1)? radius[0]: radius[key]);
+	}
+}
+
+/* Instance */
+
+static void xml_read_instance(const XMLReadState& state, pugi::xml_node node)
+{
+	string name;
+
+	if(!xml_read_string(&name, node, "mesh")) {
+		fprintf(stderr, "Instance without mesh.\n");
+		return;
+	}
+
+	map<ustring, Node*>::const_iterator it = state.node_map.find(ustring(name));
+
+	if(it == state.node_map.end() || it->second->type != Mesh::node_type) {
+		fprintf(stderr, "Unknown mesh \"%s\".\n", name.c_str());
+		return;
+	}
+
+	/* add object sharing the mesh */
+	Object *object = new Object();
+	object->mesh = (Mesh*)it->second;
+	object->tfm = state.tfm;
+	state.scene->objects.push_back(object);
+}
+
 /* Light */
 
 static void xml_read_light(XMLReadState& state, pugi::xml_node node)
@@ -626,6 +697,12 @@ static void xml_read_scene(XMLReadState& state, pugi::xml_node scene_node)
 		else if(string_iequals(node.name(), "mesh")) {
 			xml_read_mesh(state, node);
 		}
+		else if(string_iequals(node.name(), "curves")) {
+			xml_read_curves(state, node);
+		}
+		else if(string_iequals(node.name(), "instance")) {
+			xml_read_instance(state, node);
+		}
 		else if(string_iequals(node.name(), "light")) {
 			xml_read_light(state, node);
 		}
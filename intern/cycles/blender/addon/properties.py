@@ -284,6 +284,33 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 min=0.0, max=1.0,
                 default=0.01,
                 )
+        cls.use_light_tree = BoolProperty(
+                name="Light Tree",
+                description="Pick lights based on their distance and orientation to the shading point, "
+                            "instead of only their area. Faster convergence in scenes with many lights, "
+                            "not used when sampling all lights",
+                default=False,
+                )
+
+        cls.use_adaptive_sampling = BoolProperty(
+                name="Adaptive Sampling",
+                description="Stop sampling pixels once their noise is below the threshold, "
+                            "only for final renders on the CPU without progressive refine",
+                default=False,
+                )
+        cls.adaptive_threshold = FloatProperty(
+                name="Adaptive Threshold",
+                description="Noise level at which pixels stop taking samples, lower values give less noise",
+                min=0.0, max=1.0,
+                default=0.01,
+                precision=4,
+                )
+        cls.adaptive_min_samples = IntProperty(
+                name="Adaptive Min Samples",
+                description="Number of samples every pixel takes before adaptive sampling can stop it",
+                min=1, max=4096,
+                default=16,
+                )
 
         cls.caustics_reflective = BoolProperty(
                 name="Reflective Caustics",
@@ -535,6 +562,12 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 default='HILBERT_SPIRAL',
                 options=set(),  # Not animatable!
                 )
+        cls.use_split_tiles = BoolProperty(
+                name="Split Last Tiles",
+                description="Split the remaining tiles at the end of the render, "
+                            "so all threads keep working until the image is finished",
+                default=True,
+                )
         cls.use_progressive_refine = BoolProperty(
                 name="Progressive Refine",
                 description="Instead of rendering each tile until it is finished, "
@@ -632,6 +665,27 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
             items=enum_texture_limit
             )
 
+        cls.use_two_level_bvh = BoolProperty(
+            name="Two-Level BVH",
+            description="Keep a BVH for every mesh between frames when using persistent data, so objects that "
+                        "only move do not cause a full BVH rebuild (slightly slower render for static scenes)",
+            default=True,
+            )
+
+        cls.use_texture_cache = BoolProperty(
+            name="Texture Cache",
+            description="Read image textures in tiles as they are needed, instead of loading them into memory "
+                        "in full (CPU only, not used with Open Shading Language)",
+            default=False,
+            )
+        cls.texture_cache_size = IntProperty(
+            name="Cache Size",
+            description="Maximum memory used by the texture cache, in megabytes",
+            min=16, max=1024 * 1024,
+            default=4096,
+            subtype='UNSIGNED',
+            )
+
         cls.ao_bounces = IntProperty(
             name="AO Bounces",
             default=0,
@@ -659,7 +713,9 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         cls.debug_use_cpu_sse3 = BoolProperty(name="SSE3", default=True)
         cls.debug_use_cpu_sse2 = BoolProperty(name="SSE2", default=True)
         cls.debug_use_qbvh = BoolProperty(name="QBVH", default=True)
+        cls.debug_use_obvh = BoolProperty(name="OBVH", default=True)
         cls.debug_use_cpu_split_kernel = BoolProperty(name="Split Kernel", default=False)
+        cls.debug_use_cpu_packet_traversal = BoolProperty(name="Packet Traversal", default=False)
 
         cls.debug_use_cuda_adaptive_compile = BoolProperty(name="Adaptive Compile", default=False)
         cls.debug_use_cuda_split_kernel = BoolProperty(name="Split Kernel", default=False)
@@ -173,6 +173,14 @@ class CyclesRender_PT_sampling(CyclesButtonsPanel, Panel):
         sub.prop(cscene, "sample_clamp_direct")
         sub.prop(cscene, "sample_clamp_indirect")
         sub.prop(cscene, "light_sampling_threshold")
+        sub.prop(cscene, "use_light_tree")
+
+        sub = col.column(align=True)
+        sub.prop(cscene, "use_adaptive_sampling")
+        subsub = sub.column(align=True)
+        subsub.active = cscene.use_adaptive_sampling
+        subsub.prop(cscene, "adaptive_threshold", text="Threshold")
+        subsub.prop(cscene, "adaptive_min_samples", text="Min Samples")
 
         if cscene.progressive == 'PATH' or use_branched_path(context) is False:
             col = split.column()
@@ -407,6 +415,10 @@ class CyclesRender_PT_performance(CyclesButtonsPanel, Panel):
         sub.prop(rd, "tile_x", text="X")
         sub.prop(rd, "tile_y", text="Y")
 
+        subsub = sub.column()
+        subsub.active = not rd.use_save_buffers
+        subsub.prop(cscene, "use_split_tiles")
+
         sub.prop(cscene, "use_progressive_refine")
 
         subsub = sub.column(align=True)
@@ -422,7 +434,14 @@ class CyclesRender_PT_performance(CyclesButtonsPanel, Panel):
         col.separator()
 
         col.label(text="Final Render:")
-        col.prop(rd, "use_persistent_data", text="Persistent Images")
+        col.prop(rd, "use_persistent_data", text="Persistent Data")
+        sub = col.row()
+        sub.active = rd.use_persistent_data
+        sub.prop(cscene, "use_two_level_bvh")
+        col.prop(cscene, "use_texture_cache")
+        sub = col.row()
+        sub.active = cscene.use_texture_cache
+        sub.prop(cscene, "texture_cache_size")
 
         col.separator()
 
@@ -1572,7 +1591,9 @@ class CyclesRender_PT_debug(CyclesButtonsPanel, Panel):
         row.prop(cscene, "debug_use_cpu_avx", toggle=True)
         row.prop(cscene, "debug_use_cpu_avx2", toggle=True)
         col.prop(cscene, "debug_use_qbvh")
+        col.prop(cscene, "debug_use_obvh")
         col.prop(cscene, "debug_use_cpu_split_kernel")
+        col.prop(cscene, "debug_use_cpu_packet_traversal")
 
         col = layout.column()
         col.label('CUDA Flags:')
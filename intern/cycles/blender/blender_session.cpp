@@ -197,6 +197,11 @@ void BlenderSession::reset_session(BL::BlendData& b_data_, BL::Scene& b_scene_)
 		 * them rather than trying to distinguish which settings need to be updated
 		 */
 
+		if(sync) {
+			delete sync;
+			sync = NULL;
+		}
+
 		delete session;
 
 		create_session();
@@ -205,7 +210,29 @@ void BlenderSession::reset_session(BL::BlendData& b_data_, BL::Scene& b_scene_)
 	}
 
 	session->progress.reset();
-	scene->reset();
+
+	if(sync && b_engine.is_incremental_update()) {
+		/* Scene and device memory of the previous frame are kept, only sync
+		 * the data-blocks which changed since then.
+		 */
+		VLOG(1) << "Incremental sync of persistent scene data.";
+		sync->reset(b_data, b_scene);
+		sync->sync_recalc();
+	}
+	else {
+		if(sync) {
+			/* Scene of a previous render was kept, but changes since then are
+			 * not known, so sync it fully.
+			 */
+			session->device_free();
+			delete sync;
+		}
+
+		scene->reset();
+
+		/* sync object should be re-created */
+		sync = new BlenderSync(b_engine, b_data, b_depsgraph, b_scene, scene, !background, session->progress, is_cpu);
+	}
 
 	session->tile_manager.set_tile_order(session_params.tile_order);
 
@@ -214,9 +241,6 @@ void BlenderSession::reset_session(BL::BlendData& b_data_, BL::Scene& b_scene_)
 	 */
 	session->stats.mem_peak = session->stats.mem_used;
 
-	/* sync object should be re-created */
-	sync = new BlenderSync(b_engine, b_data, b_depsgraph, b_scene, scene, !background, session->progress, is_cpu);
-
 	/* for final render we will do full data sync per render layer, only
 	 * do some basic syncing here, no objects or materials for speed */
 	BL::Object b_camera_override(b_engine.camera_override());
@@ -381,6 +405,12 @@ void BlenderSession::render()
 	SessionParams session_params = BlenderSync::get_session_params(b_engine, b_userpref, b_scene, background);
 	BufferParams buffer_params = BlenderSync::get_buffer_params(b_render, b_v3d, b_rv3d, scene->camera, width, height);
 
+	/* adaptive sampling needs all samples of a tile rendered at once, and is only supported on the CPU */
+	PointerRNA cscene = RNA_pointer_get(&b_scene.ptr, "cycles");
+	bool use_adaptive_sampling = !session_params.progressive_refine &&
+	                             session_params.device.type == DEVICE_CPU &&
+	                             get_boolean(cscene, "use_adaptive_sampling");
+
 	/* render each layer */
 	BL::RenderSettings r = b_scene.render();
 	BL::RenderSettings::layers_iterator b_layer_iter;
@@ -435,6 +465,9 @@ void BlenderSession::render()
 		session->params.denoising_feature_strength = get_float(crl, "denoising_feature_strength");
 		session->params.denoising_relative_pca = get_boolean(crl, "denoising_relative_pca");
 
+		buffer_params.adaptive_sampling_pass = use_adaptive_sampling;
+		scene->film->adaptive_sampling_pass = use_adaptive_sampling;
+
 		scene->film->pass_alpha_threshold = b_layer_iter->pass_alpha_threshold();
 		scene->film->tag_passes_update(scene, passes);
 		scene->film->tag_update(scene);
@@ -503,6 +536,20 @@ void BlenderSession::render()
 	session->write_render_tile_cb = function_null;
 	session->update_render_tile_cb = function_null;
 
+	/* With persistent data, keep the scene and its device memory for the next
+	 * frame of the animation, which only syncs what changed. Motion is synced
+	 * from other frames, which the recalc tags don't cover, so such scenes are
+	 * always synced fully.
+	 */
+	if(scene->params.persistent_data &&
+	   b_engine.is_animation() &&
+	   scene->need_motion() == Scene::MOTION_NONE &&
+	   !session->progress.get_cancel())
+	{
+		session->device_free_buffers();
+		return;
+	}
+
 	/* free all memory used (host and device), so we wouldn't leave render
 	 * engine with extra memory allocated
 	 */
@@ -78,6 +78,15 @@ BlenderSync::~BlenderSync()
 {
 }
 
+void BlenderSync::reset(BL::BlendData& b_data, BL::Scene& b_scene)
+{
+	/* Update data and scene pointers in case they change in session reset,
+	 * for example, when rendering the next frame with persistent data.
+	 */
+	this->b_data = b_data;
+	this->b_scene = b_scene;
+}
+
 /* Sync */
 
 bool BlenderSync::sync_recalc()
@@ -295,6 +304,10 @@ void BlenderSync::sync_integrator()
 	integrator->sample_all_lights_direct = get_boolean(cscene, "sample_all_lights_direct");
 	integrator->sample_all_lights_indirect = get_boolean(cscene, "sample_all_lights_indirect");
 	integrator->light_sampling_threshold = get_float(cscene, "light_sampling_threshold");
+	integrator->use_light_tree = get_boolean(cscene, "use_light_tree");
+
+	integrator->adaptive_threshold = get_float(cscene, "adaptive_threshold");
+	integrator->adaptive_min_samples = get_int(cscene, "adaptive_min_samples");
 
 	int diffuse_samples = get_int(cscene, "diffuse_samples");
 	int glossy_samples = get_int(cscene, "glossy_samples");
@@ -605,9 +618,21 @@ SceneParams BlenderSync::get_scene_params(BL::Scene& b_scene,
 		params.shadingsystem = SHADINGSYSTEM_SVM;
 	else if(shadingsystem == 1)
 		params.shadingsystem = SHADINGSYSTEM_OSL;
-	
-	if(background)
-		params.bvh_type = SceneParams::BVH_STATIC;
+
+	if(background && params.shadingsystem != SHADINGSYSTEM_OSL)
+		params.persistent_data = r.use_persistent_data();
+	else
+		params.persistent_data = false;
+
+	if(background) {
+		/* With persistent data, keep a BVH per mesh across frames, so only
+		 * the object level BVH is updated when objects move.
+		 */
+		if(params.persistent_data && get_boolean(cscene, "use_two_level_bvh"))
+			params.bvh_type = SceneParams::BVH_DYNAMIC;
+		else
+			params.bvh_type = SceneParams::BVH_STATIC;
+	}
 	else
 		params.bvh_type = (SceneParams::BVHType)get_enum(
 		        cscene,
@@ -619,11 +644,6 @@ SceneParams BlenderSync::get_scene_params(BL::Scene& b_scene,
 	params.use_bvh_unaligned_nodes = RNA_boolean_get(&cscene, "debug_use_hair_bvh");
 	params.num_bvh_time_steps = RNA_int_get(&cscene, "debug_bvh_time_steps");
 
-	if(background && params.shadingsystem != SHADINGSYSTEM_OSL)
-		params.persistent_data = r.use_persistent_data();
-	else
-		params.persistent_data = false;
-
 	int texture_limit;
 	if(background) {
 		texture_limit = RNA_enum_get(&cscene, "texture_limit_render");
@@ -638,14 +658,29 @@ SceneParams BlenderSync::get_scene_params(BL::Scene& b_scene,
 		params.texture_limit = 0;
 	}
 
+	/* Texture cache is only used by SVM on the CPU, OSL has its own. */
+	if(is_cpu &&
+	   params.shadingsystem == SHADINGSYSTEM_SVM &&
+	   get_boolean(cscene, "use_texture_cache"))
+	{
+		params.texture_cache_size = get_int(cscene, "texture_cache_size");
+	}
+	else {
+		params.texture_cache_size = 0;
+	}
+
 #if !(defined(__GNUC__) && (defined(i386) || defined(_M_IX86)))
 	if(is_cpu) {
 		params.use_qbvh = DebugFlags().cpu.qbvh && system_cpu_support_sse2();
+#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_AVX2
+		params.use_obvh = DebugFlags().cpu.obvh && system_cpu_support_avx2();
+#endif
 	}
 	else
 #endif
 	{
 		params.use_qbvh = false;
+		params.use_obvh = false;
 	}
 
 	return params;
@@ -786,6 +821,11 @@ SessionParams BlenderSync::get_session_params(BL::RenderEngine& b_engine,
 		params.tile_order = TILE_BOTTOM_TO_TOP;
 	}
 
+	/* Tiles written to disk must match the render parts, so they can't be split. */
+	params.use_split_tiles = background &&
+	                         !b_scene.render().use_save_buffers() &&
+	                         get_boolean(cscene, "use_split_tiles");
+
 	params.start_resolution = get_int(cscene, "preview_start_resolution");
 
 	/* other parameters */
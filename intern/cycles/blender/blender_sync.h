@@ -59,6 +59,8 @@ public:
 	            bool is_cpu);
 	~BlenderSync();
 
+	void reset(BL::BlendData& b_data, BL::Scene& b_scene);
+
 	/* sync */
 	bool sync_recalc();
 	void sync_data(BL::RenderSettings& b_render,
@@ -22,6 +22,7 @@
 
 #include "bvh/bvh2.h"
 #include "bvh/bvh4.h"
+#include "bvh/bvh8.h"
 #include "bvh/bvh_build.h"
 #include "bvh/bvh_node.h"
 
@@ -51,7 +52,9 @@ BVH::BVH(const BVHParams& params_, const vector<Object*>& objects_)
 
 BVH *BVH::create(const BVHParams& params, const vector<Object*>& objects)
 {
-	if(params.use_qbvh)
+	if(params.use_obvh)
+		return new BVH8(params, objects);
+	else if(params.use_qbvh)
 		return new BVH4(params, objects);
 	else
 		return new BVH2(params, objects);
@@ -108,6 +111,17 @@ void BVH::refit(Progress& progress)
 	refit_nodes();
 }
 
+/* Refit the top level BVH to changed object bounds and visibility, without
+ * touching primitives. The instance BVH's merged into it must be unchanged.
+ */
+void BVH::refit_objects(Progress& progress)
+{
+	assert(params.top_level);
+
+	progress.set_substatus("Refitting BVH nodes");
+	refit_nodes();
+}
+
 /* Triangles */
 
 void BVH::pack_triangle(int idx, float4 tri_verts[3])
@@ -184,6 +198,7 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 	 * top level BVH, adjusting indexes and offsets where appropriate.
 	 */
 	const bool use_qbvh = params.use_qbvh;
+	const bool use_obvh = params.use_obvh;
 
 	/* Adjust primitive index to point to the triangle in the global array, for
 	 * meshes with transform applied and already in the top level BVH.
@@ -359,7 +374,11 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 
 			for(size_t i = 0, j = 0; i < bvh_nodes_size; j++) {
 				size_t nsize, nsize_bbox;
-				if(bvh_nodes[i].x & PATH_RAY_NODE_UNALIGNED) {
+				if(use_obvh) {
+					nsize = BVH_ONODE_SIZE;
+					nsize_bbox = 13;
+				}
+				else if(bvh_nodes[i].x & PATH_RAY_NODE_UNALIGNED) {
 					nsize = use_qbvh
 					            ? BVH_UNALIGNED_QNODE_SIZE
 					            : BVH_UNALIGNED_NODE_SIZE;
@@ -380,13 +399,24 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 				data.z += (data.z < 0)? -noffset_leaf: noffset;
 				data.w += (data.w < 0)? -noffset_leaf: noffset;
 
-				if(use_qbvh) {
+				if(use_qbvh || use_obvh) {
 					data.x += (data.x < 0)? -noffset_leaf: noffset;
 					data.y += (data.y < 0)? -noffset_leaf: noffset;
 				}
 
 				pack_nodes[pack_nodes_offset + nsize_bbox] = data;
 
+				if(use_obvh) {
+					/* Second half of the eight child indices. */
+					nsize_bbox++;
+					data = bvh_nodes[i + nsize_bbox];
+					data.x += (data.x < 0)? -noffset_leaf: noffset;
+					data.y += (data.y < 0)? -noffset_leaf: noffset;
+					data.z += (data.z < 0)? -noffset_leaf: noffset;
+					data.w += (data.w < 0)? -noffset_leaf: noffset;
+					pack_nodes[pack_nodes_offset + nsize_bbox] = data;
+				}
+
 				/* Usually this copies nothing, but we better
 				 * be prepared for possible node size extension.
 				 */
@@ -87,6 +87,7 @@ public:
 
 	void build(Progress& progress);
 	void refit(Progress& progress);
+	void refit_objects(Progress& progress);
 
 protected:
 	BVH(const BVHParams& params, const vector<Object*>& objects);
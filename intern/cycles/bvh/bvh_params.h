@@ -53,6 +53,9 @@ public:
 	/* QBVH */
 	bool use_qbvh;
 
+	/* OBVH, 8-wide nodes traversed with AVX2. */
+	bool use_obvh;
+
 	/* Mask of primitives to be included into the BVH. */
 	int primitive_mask;
 
@@ -99,6 +102,7 @@ public:
 
 		top_level = false;
 		use_qbvh = false;
+		use_obvh = false;
 		use_unaligned_nodes = false;
 
 		primitive_mask = PRIMITIVE_ALL;
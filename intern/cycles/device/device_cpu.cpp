@@ -34,6 +34,7 @@
 #include "kernel/kernel_types.h"
 #include "kernel/split/kernel_split_data.h"
 #include "kernel/kernel_globals.h"
+#include "kernel/kernels/cpu/kernel_cpu_texture_cache.h"
 
 #include "kernel/filter/filter.h"
 
@@ -51,14 +52,119 @@
 #include "util/util_progress.h"
 #include "util/util_system.h"
 #include "util/util_thread.h"
+#include "util/util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
+#ifdef WITH_CYCLES_KERNEL_STATS
+/* Names of the kernel counters reported in Stats. */
+
+static const char *kernel_stats_ray_type_name(int type)
+{
+	switch(type) {
+		case KERNEL_STATS_RAY_CAMERA: return "camera";
+		case KERNEL_STATS_RAY_INDIRECT: return "indirect";
+		case KERNEL_STATS_RAY_SHADOW: return "shadow";
+		case KERNEL_STATS_RAY_AO: return "ao";
+		case KERNEL_STATS_RAY_SUBSURFACE: return "subsurface";
+		case KERNEL_STATS_RAY_VOLUME: return "volume";
+	}
+	return "unknown";
+}
+
+static const char *kernel_stats_svm_node_name(int type)
+{
+	switch(type) {
+		case NODE_END: return "end";
+		case NODE_CLOSURE_BSDF: return "closure_bsdf";
+		case NODE_CLOSURE_EMISSION: return "closure_emission";
+		case NODE_CLOSURE_BACKGROUND: return "closure_background";
+		case NODE_CLOSURE_SET_WEIGHT: return "closure_set_weight";
+		case NODE_CLOSURE_WEIGHT: return "closure_weight";
+		case NODE_MIX_CLOSURE: return "mix_closure";
+		case NODE_JUMP_IF_ZERO: return "jump_if_zero";
+		case NODE_JUMP_IF_ONE: return "jump_if_one";
+		case NODE_TEX_IMAGE: return "tex_image";
+		case NODE_TEX_IMAGE_BOX: return "tex_image_box";
+		case NODE_TEX_SKY: return "tex_sky";
+		case NODE_GEOMETRY: return "geometry";
+		case NODE_GEOMETRY_DUPLI: return "geometry_dupli";
+		case NODE_LIGHT_PATH: return "light_path";
+		case NODE_VALUE_F: return "value_f";
+		case NODE_VALUE_V: return "value_v";
+		case NODE_MIX: return "mix";
+		case NODE_ATTR: return "attr";
+		case NODE_CONVERT: return "convert";
+		case NODE_FRESNEL: return "fresnel";
+		case NODE_WIREFRAME: return "wireframe";
+		case NODE_WAVELENGTH: return "wavelength";
+		case NODE_BLACKBODY: return "blackbody";
+		case NODE_EMISSION_WEIGHT: return "emission_weight";
+		case NODE_TEX_GRADIENT: return "tex_gradient";
+		case NODE_TEX_VORONOI: return "tex_voronoi";
+		case NODE_TEX_MUSGRAVE: return "tex_musgrave";
+		case NODE_TEX_WAVE: return "tex_wave";
+		case NODE_TEX_MAGIC: return "tex_magic";
+		case NODE_TEX_NOISE: return "tex_noise";
+		case NODE_SHADER_JUMP: return "shader_jump";
+		case NODE_SET_DISPLACEMENT: return "set_displacement";
+		case NODE_GEOMETRY_BUMP_DX: return "geometry_bump_dx";
+		case NODE_GEOMETRY_BUMP_DY: return "geometry_bump_dy";
+		case NODE_SET_BUMP: return "set_bump";
+		case NODE_MATH: return "math";
+		case NODE_VECTOR_MATH: return "vector_math";
+		case NODE_VECTOR_TRANSFORM: return "vector_transform";
+		case NODE_MAPPING: return "mapping";
+		case NODE_TEX_COORD: return "tex_coord";
+		case NODE_TEX_COORD_BUMP_DX: return "tex_coord_bump_dx";
+		case NODE_TEX_COORD_BUMP_DY: return "tex_coord_bump_dy";
+		case NODE_ATTR_BUMP_DX: return "attr_bump_dx";
+		case NODE_ATTR_BUMP_DY: return "attr_bump_dy";
+		case NODE_TEX_ENVIRONMENT: return "tex_environment";
+		case NODE_CLOSURE_HOLDOUT: return "closure_holdout";
+		case NODE_LAYER_WEIGHT: return "layer_weight";
+		case NODE_CLOSURE_VOLUME: return "closure_volume";
+		case NODE_SEPARATE_VECTOR: return "separate_vector";
+		case NODE_COMBINE_VECTOR: return "combine_vector";
+		case NODE_SEPARATE_HSV: return "separate_hsv";
+		case NODE_COMBINE_HSV: return "combine_hsv";
+		case NODE_HSV: return "hsv";
+		case NODE_CAMERA: return "camera";
+		case NODE_INVERT: return "invert";
+		case NODE_NORMAL: return "normal";
+		case NODE_GAMMA: return "gamma";
+		case NODE_TEX_CHECKER: return "tex_checker";
+		case NODE_BRIGHTCONTRAST: return "brightcontrast";
+		case NODE_RGB_RAMP: return "rgb_ramp";
+		case NODE_RGB_CURVES: return "rgb_curves";
+		case NODE_VECTOR_CURVES: return "vector_curves";
+		case NODE_MIN_MAX: return "min_max";
+		case NODE_LIGHT_FALLOFF: return "light_falloff";
+		case NODE_OBJECT_INFO: return "object_info";
+		case NODE_PARTICLE_INFO: return "particle_info";
+		case NODE_TEX_BRICK: return "tex_brick";
+		case NODE_CLOSURE_SET_NORMAL: return "closure_set_normal";
+		case NODE_CLOSURE_AMBIENT_OCCLUSION: return "closure_ambient_occlusion";
+		case NODE_TANGENT: return "tangent";
+		case NODE_NORMAL_MAP: return "normal_map";
+		case NODE_HAIR_INFO: return "hair_info";
+		case NODE_UVMAP: return "uvmap";
+		case NODE_TEX_VOXEL: return "tex_voxel";
+		case NODE_ENTER_BUMP_EVAL: return "enter_bump_eval";
+		case NODE_LEAVE_BUMP_EVAL: return "leave_bump_eval";
+	}
+	return "unknown";
+}
+#endif  /* WITH_CYCLES_KERNEL_STATS */
+
 class CPUDevice;
 
 /* Has to be outside of the class to be shared across template instantiations. */
 static const char *logged_architecture = "";
 
+/* Pixels traced together by path_trace_packet, matches QBVH_PACKET_SIZE. */
+static const int CPU_PACKET_SIZE = 4;
+
 template<typename F>
 class KernelFunctions {
 public:
@@ -164,15 +270,33 @@ public:
 #ifdef WITH_OSL
 	OSLGlobals osl_globals;
 #endif
+	TextureCacheGlobals texture_cache_globals;
 
 	bool use_split_kernel;
+	bool use_packet_traversal;
 
 	DeviceRequestedFeatures requested_features;
 
+	/* Time every thread of the current render task spent rendering tiles. */
+	thread_mutex render_thread_times_mutex;
+	vector<double> render_thread_busy_times;
+	double render_task_start_time;
+
+#ifdef WITH_CYCLES_KERNEL_STATS
+	/* Ray and shading counters of all render threads of the current task. */
+	thread_mutex kernel_stats_mutex;
+	KernelStats kernel_stats;
+#endif
+
 	KernelFunctions<void(*)(KernelGlobals *, float *, unsigned int *, int, int, int, int, int)>   path_trace_kernel;
+	KernelFunctions<void(*)(KernelGlobals *, float *, unsigned int *, int, int, int, int, int, int)> path_trace_packet_kernel;
 	KernelFunctions<void(*)(KernelGlobals *, uchar4 *, float *, float, int, int, int, int)>       convert_to_half_float_kernel;
 	KernelFunctions<void(*)(KernelGlobals *, uchar4 *, float *, float, int, int, int, int)>       convert_to_byte_kernel;
 	KernelFunctions<void(*)(KernelGlobals *, uint4 *, float4 *, float*, int, int, int, int, int)> shader_kernel;
+	KernelFunctions<void(*)(KernelGlobals *, float *, int, int, int, int)>                        adaptive_stopping_kernel;
+	KernelFunctions<bool(*)(KernelGlobals *, float *, int, int, int, int, int)>                   adaptive_filter_x_kernel;
+	KernelFunctions<bool(*)(KernelGlobals *, float *, int, int, int, int, int)>                   adaptive_filter_y_kernel;
+	KernelFunctions<int(*)(KernelGlobals *, float *, int, int, int, int, int)>                    adaptive_adjust_samples_kernel;
 
 	KernelFunctions<void(*)(int, TilesInfo*, int, int, float*, float*, float*, float*, float*, int*, int, int, bool)> filter_divide_shadow_kernel;
 	KernelFunctions<void(*)(int, TilesInfo*, int, int, int, int, float*, float*, int*, int, int, bool)>               filter_get_feature_kernel;
@@ -206,9 +330,14 @@ public:
 	: Device(info, stats, background),
 #define REGISTER_KERNEL(name) name ## _kernel(KERNEL_FUNCTIONS(name))
 	  REGISTER_KERNEL(path_trace),
+	  REGISTER_KERNEL(path_trace_packet),
 	  REGISTER_KERNEL(convert_to_half_float),
 	  REGISTER_KERNEL(convert_to_byte),
 	  REGISTER_KERNEL(shader),
+	  REGISTER_KERNEL(adaptive_stopping),
+	  REGISTER_KERNEL(adaptive_filter_x),
+	  REGISTER_KERNEL(adaptive_filter_y),
+	  REGISTER_KERNEL(adaptive_adjust_samples),
 	  REGISTER_KERNEL(filter_divide_shadow),
 	  REGISTER_KERNEL(filter_get_feature),
 	  REGISTER_KERNEL(filter_detect_outliers),
@@ -227,12 +356,23 @@ public:
 
 #ifdef WITH_OSL
 		kernel_globals.osl = &osl_globals;
+#endif
+		kernel_globals.texture_cache = NULL;
+		render_task_start_time = 0.0;
+#ifdef WITH_CYCLES_KERNEL_STATS
+		memset(&kernel_stats, 0, sizeof(kernel_stats));
+		VLOG(1) << "Kernel ray and shading counters are enabled.";
 #endif
 		use_split_kernel = DebugFlags().cpu.split_kernel;
 		if(use_split_kernel) {
 			VLOG(1) << "Will be using split kernel.";
 		}
 
+		use_packet_traversal = DebugFlags().cpu.packet_traversal;
+		if(use_packet_traversal) {
+			VLOG(1) << "Will be using packet traversal for camera rays.";
+		}
+
 #define REGISTER_SPLIT_KERNEL(name) split_kernels[#name] = KernelFunctions<void(*)(KernelGlobals*, KernelData*)>(KERNEL_FUNCTIONS(name))
 		REGISTER_SPLIT_KERNEL(path_init);
 		REGISTER_SPLIT_KERNEL(scene_intersect);
@@ -361,6 +501,11 @@ public:
 #endif
 	}
 
+	void *texture_cache_memory()
+	{
+		return &texture_cache_globals;
+	}
+
 	void thread_run(DeviceTask *task)
 	{
 		if(task->type == DeviceTask::RENDER) {
@@ -611,6 +756,45 @@ public:
 		return true;
 	}
 
+	/* Mark converged pixels of the tile and returns whether any pixel still
+	 * needs more samples. */
+	bool adaptive_sampling_filter(RenderTile &tile, KernelGlobals *kg)
+	{
+		float *render_buffer = (float*)tile.buffer;
+
+		for(int y = tile.y; y < tile.y + tile.h; y++) {
+			for(int x = tile.x; x < tile.x + tile.w; x++) {
+				adaptive_stopping_kernel()(kg, render_buffer, x, y, tile.offset, tile.stride);
+			}
+		}
+
+		bool any = false;
+		for(int y = tile.y; y < tile.y + tile.h; y++) {
+			any |= adaptive_filter_x_kernel()(kg, render_buffer, y, tile.x, tile.w, tile.offset, tile.stride);
+		}
+		for(int x = tile.x; x < tile.x + tile.w; x++) {
+			any |= adaptive_filter_y_kernel()(kg, render_buffer, x, tile.y, tile.h, tile.offset, tile.stride);
+		}
+		return any;
+	}
+
+	/* Scale passes of pixels which stopped early to the tile sample count and
+	 * returns the number of pixel samples that were not rendered. */
+	uint64_t adaptive_sampling_post(RenderTile &tile, KernelGlobals *kg)
+	{
+		float *render_buffer = (float*)tile.buffer;
+		const int num_samples = tile.sample - tile.start_sample;
+		uint64_t rendered = 0;
+
+		for(int y = tile.y; y < tile.y + tile.h; y++) {
+			for(int x = tile.x; x < tile.x + tile.w; x++) {
+				rendered += adaptive_adjust_samples_kernel()(kg, render_buffer, num_samples,
+				                                             x, y, tile.offset, tile.stride);
+			}
+		}
+		return (uint64_t)tile.w*tile.h*num_samples - rendered;
+	}
+
 	void path_trace(DeviceTask &task, RenderTile &tile, KernelGlobals *kg)
 	{
 		float *render_buffer = (float*)tile.buffer;
@@ -618,22 +802,69 @@ public:
 		int start_sample = tile.start_sample;
 		int end_sample = tile.start_sample + tile.num_samples;
 
+		/* Adaptive sampling needs all samples of the tile to be rendered at
+		 * once, which is the case for all but progressive refine. */
+		const bool use_adaptive_sampling = kg->__data.film.pass_adaptive_aux_buffer != 0 &&
+		                                   start_sample == 0;
+		const int adaptive_min_samples = kg->__data.integrator.adaptive_min_samples;
+		const int adaptive_step = max(kg->__data.integrator.adaptive_step, 1);
+
 		for(int sample = start_sample; sample < end_sample; sample++) {
 			if(task.get_cancel() || task_pool.canceled()) {
 				if(task.need_finish_queue == false)
 					break;
 			}
 
-			for(int y = tile.y; y < tile.y + tile.h; y++) {
-				for(int x = tile.x; x < tile.x + tile.w; x++) {
-					path_trace_kernel()(kg, render_buffer, rng_state,
-					                    sample, x, y, tile.offset, tile.stride);
+			if(use_packet_traversal) {
+				/* Trace camera rays of neighbour pixels together. */
+				for(int y = tile.y; y < tile.y + tile.h; y++) {
+					for(int x = tile.x; x < tile.x + tile.w; x += CPU_PACKET_SIZE) {
+						int num_pixels = min(CPU_PACKET_SIZE, tile.x + tile.w - x);
+						path_trace_packet_kernel()(kg, render_buffer, rng_state,
+						                           sample, x, y, num_pixels,
+						                           tile.offset, tile.stride);
+					}
+				}
+			}
+			else {
+				for(int y = tile.y; y < tile.y + tile.h; y++) {
+					for(int x = tile.x; x < tile.x + tile.w; x++) {
+						path_trace_kernel()(kg, render_buffer, rng_state,
+						                    sample, x, y, tile.offset, tile.stride);
+					}
 				}
 			}
 
 			tile.sample = sample + 1;
 
 			task.update_progress(&tile, tile.w*tile.h);
+
+			/* Give part of the tile to threads which ran out of tiles. Pixels
+			 * handed over keep their samples, so with adaptive sampling the
+			 * tile has to stay in one piece. */
+			if(!use_adaptive_sampling && tile.sample < end_sample && task.split_tile) {
+				task.split_tile(tile);
+			}
+
+			if(use_adaptive_sampling &&
+			   tile.sample < end_sample &&
+			   tile.sample >= adaptive_min_samples &&
+			   (tile.sample - adaptive_min_samples) % adaptive_step == 0)
+			{
+				if(!adaptive_sampling_filter(tile, kg)) {
+					/* All pixels converged, retire the tile early. */
+					task.update_progress(&tile, tile.w*tile.h*(end_sample - tile.sample));
+					tile.sample = end_sample;
+					break;
+				}
+			}
+		}
+
+		if(use_adaptive_sampling) {
+			const uint64_t saved = adaptive_sampling_post(tile, kg);
+			if(saved > 0 && task.update_adaptive_saved_samples) {
+				task.update_adaptive_saved_samples(saved);
+			}
 		}
 	}
 
@@ -696,8 +927,12 @@ public:
 			}
 		}
 
+		double busy_time = 0.0;
+
 		RenderTile tile;
 		while(task.acquire_tile(this, tile)) {
+			const double tile_start_time = time_dt();
+
 			if(tile.task == RenderTile::PATH_TRACE) {
 				if(use_split_kernel) {
 					device_memory data;
@@ -711,6 +946,12 @@ public:
 				denoise(task, tile);
 			}
 
+			busy_time += time_dt() - tile_start_time;
+
+#ifdef WITH_CYCLES_KERNEL_STATS
+			thread_kernel_stats_merge(kg);
+#endif
+
 			task.release_tile(tile);
 
 			if(task_pool.canceled()) {
@@ -723,6 +964,9 @@ public:
 		kg->~KernelGlobals();
 		mem_free(kgbuffer);
 		delete split_kernel;
+
+		thread_scoped_lock times_lock(render_thread_times_mutex);
+		render_thread_busy_times.push_back(busy_time);
 	}
 
 	void thread_film_convert(DeviceTask& task)
@@ -747,6 +991,7 @@ public:
 	void thread_shader(DeviceTask& task)
 	{
 		KernelGlobals kg = kernel_globals;
+		kg.texture_cache = thread_texture_cache();
 
 #ifdef WITH_OSL
 		OSLShader::thread_init(&kg, &kernel_globals, &osl_globals);
@@ -793,6 +1038,12 @@ public:
 		else
 			task.split(tasks, TaskScheduler::num_threads());
 
+		if(task.type == DeviceTask::RENDER) {
+			thread_scoped_lock times_lock(render_thread_times_mutex);
+			render_thread_busy_times.clear();
+			render_task_start_time = time_dt();
+		}
+
 		foreach(DeviceTask& task, tasks)
 			task_pool.push(new CPUDeviceTask(this, task));
 	}
@@ -800,6 +1051,17 @@ public:
 	void task_wait()
 	{
 		task_pool.wait_work();
+
+		thread_scoped_lock times_lock(render_thread_times_mutex);
+		if(render_task_start_time != 0.0) {
+			stats.add_render_thread_times(time_dt() - render_task_start_time,
+			                              render_thread_busy_times);
+			render_thread_busy_times.clear();
+			render_task_start_time = 0.0;
+#ifdef WITH_CYCLES_KERNEL_STATS
+			kernel_stats_report();
+#endif
+		}
 	}
 
 	void task_cancel()
@@ -818,12 +1080,65 @@ protected:
 			kg.decoupled_volume_steps[i] = NULL;
 		}
 		kg.decoupled_volume_steps_index = 0;
+		kg.texture_cache = thread_texture_cache();
+#ifdef WITH_CYCLES_KERNEL_STATS
+		memset(&kg.stats, 0, sizeof(kg.stats));
+#endif
 #ifdef WITH_OSL
 		OSLShader::thread_init(&kg, &kernel_globals, &osl_globals);
 #endif
 		return kg;
 	}
 
+#ifdef WITH_CYCLES_KERNEL_STATS
+	/* Move the counters of a render thread to the device, so the kernel can
+	 * count without atomics and the device only locks once per tile. */
+	void thread_kernel_stats_merge(KernelGlobals *kg)
+	{
+		KernelStats& thread_stats = kg->stats;
+		thread_scoped_lock stats_lock(kernel_stats_mutex);
+		for(int i = 0; i < KERNEL_STATS_NUM_RAY_TYPES; i++) {
+			kernel_stats.rays[i] += thread_stats.rays[i];
+			kernel_stats.bvh_nodes[i] += thread_stats.bvh_nodes[i];
+		}
+		for(int i = 0; i < NODE_NUM_TYPES; i++) {
+			kernel_stats.svm_nodes[i] += thread_stats.svm_nodes[i];
+			kernel_stats.svm_cycles[i] += thread_stats.svm_cycles[i];
+		}
+		stats_lock.unlock();
+
+		memset(&thread_stats, 0, sizeof(thread_stats));
+	}
+
+	/* Add the counters of the finished render task to the stats. */
+	void kernel_stats_report()
+	{
+		thread_scoped_lock stats_lock(kernel_stats_mutex);
+		for(int i = 0; i < KERNEL_STATS_NUM_RAY_TYPES; i++) {
+			const string type = kernel_stats_ray_type_name(i);
+			stats.add_kernel_counter("rays." + type, kernel_stats.rays[i]);
+			stats.add_kernel_counter("bvh_nodes." + type, kernel_stats.bvh_nodes[i]);
+		}
+		for(int i = 0; i < NODE_NUM_TYPES; i++) {
+			if(kernel_stats.svm_nodes[i] == 0) {
+				continue;
+			}
+			const string node = kernel_stats_svm_node_name(i);
+			stats.add_kernel_counter("svm_nodes." + node, kernel_stats.svm_nodes[i]);
+			stats.add_kernel_counter("svm_cycles." + node, kernel_stats.svm_cycles[i]);
+		}
+		memset(&kernel_stats, 0, sizeof(kernel_stats));
+	}
+#endif  /* WITH_CYCLES_KERNEL_STATS */
+
+	/* Only pass the texture cache to the kernel when images are in it, so
+	 * lookups of other images skip the extra check.
+	 */
+	inline TextureCacheGlobals *thread_texture_cache()
+	{
+		return (texture_cache_globals.ts != NULL)? &texture_cache_globals: NULL;
+	}
+
 	inline void thread_kernel_globals_free(KernelGlobals *kg)
 	{
 		if(kg == NULL) {
@@ -62,7 +62,9 @@ public:
 
 	function<bool(Device *device, RenderTile&)> acquire_tile;
 	function<void(long, int)> update_progress_sample;
+	function<void(long)> update_adaptive_saved_samples;
 	function<void(RenderTile&)> update_tile_sample;
+	function<bool(RenderTile&)> split_tile;
 	function<void(RenderTile&)> release_tile;
 	function<bool(void)> get_cancel;
 	function<void(RenderTile*, Device*)> map_neighbor_tiles;
@@ -34,6 +34,11 @@ CCL_NAMESPACE_BEGIN
 #  include "kernel/bvh/qbvh_nodes.h"
 #endif
 
+/* Common OBVH functions. */
+#ifdef __OBVH__
+#  include "kernel/bvh/obvh_nodes.h"
+#endif
+
 /* Regular BVH traversal */
 
 #include "kernel/bvh/bvh_nodes.h"
@@ -157,6 +162,12 @@ CCL_NAMESPACE_BEGIN
 #undef BVH_NAME_EVAL
 #undef BVH_FUNCTION_FULL_NAME
 
+/* Packet traversal */
+
+#ifdef __QBVH__
+#  include "kernel/bvh/qbvh_packet.h"
+#endif
+
 /* Note: ray is passed by value to work around a possible CUDA compiler bug. */
 ccl_device_intersect bool scene_intersect(KernelGlobals *kg,
                                           const Ray ray,
@@ -201,6 +212,28 @@ ccl_device_intersect bool scene_intersect(KernelGlobals *kg,
 #endif /* __KERNEL_CPU__ */
 }
 
+#ifdef __QBVH__
+/* Intersect a packet of QBVH_PACKET_SIZE rays, only valid when the scene uses
+ * QBVH and has no motion blur or curves. Returns mask of rays which hit.
+ */
+ccl_device_inline bool scene_intersect_packet_supported(KernelGlobals *kg)
+{
+	return kernel_data.bvh.use_qbvh &&
+	       !kernel_data.bvh.have_motion &&
+	       !kernel_data.bvh.have_curves;
+}
+
+ccl_device_intersect int scene_intersect_packet(KernelGlobals *kg,
+                                                const Ray *rays,
+                                                Intersection *isects,
+                                                int ray_mask,
+                                                const uint visibility)
+{
+	kernel_assert(scene_intersect_packet_supported(kg));
+	return qbvh_intersect_packet(kg, rays, isects, ray_mask, visibility);
+}
+#endif  /* __QBVH__ */
+
 #ifdef __SUBSURFACE__
 /* Note: ray is passed by value to work around a possible CUDA compiler bug. */
 ccl_device_intersect void scene_intersect_subsurface(KernelGlobals *kg,
@@ -210,6 +243,7 @@ ccl_device_intersect void scene_intersect_subsurface(KernelGlobals *kg,
                                                      uint *lcg_state,
                                                      int max_hits)
 {
+	KERNEL_STATS_RAY(kg, KERNEL_STATS_RAY_SUBSURFACE);
 #ifdef __OBJECT_MOTION__
 	if(kernel_data.bvh.have_motion) {
 		return bvh_intersect_subsurface_motion(kg,
@@ -296,6 +330,7 @@ ccl_device_intersect bool scene_intersect_volume(KernelGlobals *kg,
                                                  Intersection *isect,
                                                  const uint visibility)
 {
+	KERNEL_STATS_RAY(kg, KERNEL_STATS_RAY_VOLUME);
 #  ifdef __OBJECT_MOTION__
 	if(kernel_data.bvh.have_motion) {
 		return bvh_intersect_volume_motion(kg, ray, isect, visibility);
@@ -324,6 +359,7 @@ ccl_device_intersect uint scene_intersect_volume_all(KernelGlobals *kg,
                                                      const uint max_hits,
                                                      const uint visibility)
 {
+	KERNEL_STATS_RAY(kg, KERNEL_STATS_RAY_VOLUME);
 #  ifdef __OBJECT_MOTION__
 	if(kernel_data.bvh.have_motion) {
 		return bvh_intersect_volume_all_motion(kg, ray, isect, max_hits, visibility);
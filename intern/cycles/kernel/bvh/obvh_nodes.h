@@ -0,0 +1,213 @@
+/*
+ * Copyright 2011-2017, Blender Foundation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Aligned nodes intersection AVX code is adopted from Embree,
+ */
+
+/* Node layout, in float4 units relative to the node address:
+ *
+ *   0:     visibility, time_from, time_to
+ *   1-2:   min.x of 8 children
+ *   3-4:   max.x
+ *   5-6:   min.y
+ *   7-8:   max.y
+ *   9-10:  min.z
+ *   11-12: max.z
+ *   13-14: child node addresses
+ *
+ * Bounds are fetched 8 at a time, so the near/far offsets below are relative
+ * to the first bounds float4.
+ */
+
+struct OBVHStackItem {
+	int addr;
+	float dist;
+};
+
+ccl_device_inline void obvh_near_far_idx_calc(const float3& idir,
+                                              int *ccl_restrict near_x,
+                                              int *ccl_restrict near_y,
+                                              int *ccl_restrict near_z,
+                                              int *ccl_restrict far_x,
+                                              int *ccl_restrict far_y,
+                                              int *ccl_restrict far_z)
+
+{
+	*near_x = 0; *far_x = 2;
+	*near_y = 4; *far_y = 6;
+	*near_z = 8; *far_z = 10;
+
+	const size_t mask = movemask(ssef(idir.m128));
+
+	const int mask_x = (mask & 1) << 1;
+	const int mask_y = mask & 2;
+	const int mask_z = (mask & 4) >> 1;
+
+	*near_x += mask_x; *far_x -= mask_x;
+	*near_y += mask_y; *far_y -= mask_y;
+	*near_z += mask_z; *far_z -= mask_z;
+}
+
+/* Sort the topmost num items of the stack, so the closest one is on top. */
+ccl_device_inline void obvh_stack_sort(OBVHStackItem *ccl_restrict s, const int num)
+{
+	for(int i = 1; i < num; i++) {
+		const OBVHStackItem item = s[i];
+		int j = i - 1;
+		while(j >= 0 && s[j].dist < item.dist) {
+			s[j + 1] = s[j];
+			j--;
+		}
+		s[j + 1] = item;
+	}
+}
+
+/* Push all hit children of a node onto the traversal stack and return the
+ * closest one, which the traversal continues with. Distance of the returned
+ * child is written to node_dist when it is not NULL.
+ */
+ccl_device_inline int obvh_node_children_push(KernelGlobals *ccl_restrict kg,
+                                              const int node_addr,
+                                              int child_mask,
+                                              const avxf& dist,
+                                              OBVHStackItem *ccl_restrict traversal_stack,
+                                              int *ccl_restrict stack_ptr,
+                                              float *ccl_restrict node_dist)
+{
+	const avxf cnodes = kernel_tex_fetch_avxf(__bvh_nodes, node_addr+13);
+
+	/* One child is hit, continue with that child. */
+	int r = __bscf(child_mask);
+	const int c0 = __float_as_int(cnodes.f[r]);
+	const float d0 = dist.f[r];
+	if(child_mask == 0) {
+		if(node_dist != NULL) {
+			*node_dist = d0;
+		}
+		return c0;
+	}
+
+	/* Two children are hit, push far child, and continue with closer child. */
+	r = __bscf(child_mask);
+	const int c1 = __float_as_int(cnodes.f[r]);
+	const float d1 = dist.f[r];
+	if(child_mask == 0) {
+		++*stack_ptr;
+		kernel_assert(*stack_ptr < BVH_OSTACK_SIZE);
+		if(d1 < d0) {
+			traversal_stack[*stack_ptr].addr = c0;
+			traversal_stack[*stack_ptr].dist = d0;
+			if(node_dist != NULL) {
+				*node_dist = d1;
+			}
+			return c1;
+		}
+		traversal_stack[*stack_ptr].addr = c1;
+		traversal_stack[*stack_ptr].dist = d1;
+		if(node_dist != NULL) {
+			*node_dist = d0;
+		}
+		return c0;
+	}
+
+	/* Three or more children are hit, push all onto stack and sort them,
+	 * then continue with the closest child.
+	 */
+	const int first = *stack_ptr + 1;
+	traversal_stack[first].addr = c0;
+	traversal_stack[first].dist = d0;
+	traversal_stack[first + 1].addr = c1;
+	traversal_stack[first + 1].dist = d1;
+	*stack_ptr = first + 1;
+	while(child_mask != 0) {
+		r = __bscf(child_mask);
+		++*stack_ptr;
+		traversal_stack[*stack_ptr].addr = __float_as_int(cnodes.f[r]);
+		traversal_stack[*stack_ptr].dist = dist.f[r];
+	}
+	kernel_assert(*stack_ptr < BVH_OSTACK_SIZE);
+	obvh_stack_sort(&traversal_stack[first], *stack_ptr - first + 1);
+
+	const int addr = traversal_stack[*stack_ptr].addr;
+	if(node_dist != NULL) {
+		*node_dist = traversal_stack[*stack_ptr].dist;
+	}
+	--*stack_ptr;
+	return addr;
+}
+
+/* Axis-aligned nodes intersection */
+
+ccl_device_inline int obvh_aligned_node_intersect(KernelGlobals *ccl_restrict kg,
+                                                  const avxf& isect_near,
+                                                  const avxf& isect_far,
+                                                  const avx3f& org_idir,
+                                                  const avx3f& idir,
+                                                  const int near_x,
+                                                  const int near_y,
+                                                  const int near_z,
+                                                  const int far_x,
+                                                  const int far_y,
+                                                  const int far_z,
+                                                  const int node_addr,
+                                                  avxf *ccl_restrict dist)
+{
+	const int offset = node_addr + 1;
+	const avxf tnear_x = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+near_x), idir.x, org_idir.x);
+	const avxf tnear_y = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+near_y), idir.y, org_idir.y);
+	const avxf tnear_z = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+near_z), idir.z, org_idir.z);
+	const avxf tfar_x = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+far_x), idir.x, org_idir.x);
+	const avxf tfar_y = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+far_y), idir.y, org_idir.y);
+	const avxf tfar_z = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+far_z), idir.z, org_idir.z);
+
+	const avxf tnear = max(max(tnear_x, tnear_y), max(tnear_z, isect_near));
+	const avxf tfar = min(min(tfar_x, tfar_y), min(tfar_z, isect_far));
+	const avxf vmask = tnear <= tfar;
+	*dist = tnear;
+	return movemask(vmask);
+}
+
+ccl_device_inline int obvh_aligned_node_intersect_robust(
+        KernelGlobals *ccl_restrict kg,
+        const avxf& isect_near,
+        const avxf& isect_far,
+        const avx3f& P_idir,
+        const avx3f& idir,
+        const int near_x,
+        const int near_y,
+        const int near_z,
+        const int far_x,
+        const int far_y,
+        const int far_z,
+        const int node_addr,
+        const float difl,
+        avxf *ccl_restrict dist)
+{
+	const int offset = node_addr + 1;
+	const avxf tnear_x = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+near_x), idir.x, P_idir.x);
+	const avxf tnear_y = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+near_y), idir.y, P_idir.y);
+	const avxf tnear_z = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+near_z), idir.z, P_idir.z);
+	const avxf tfar_x = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+far_x), idir.x, P_idir.x);
+	const avxf tfar_y = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+far_y), idir.y, P_idir.y);
+	const avxf tfar_z = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+far_z), idir.z, P_idir.z);
+
+	const float round_down = 1.0f - difl;
+	const float round_up = 1.0f + difl;
+	const avxf tnear = max(max(tnear_x, tnear_y), max(tnear_z, isect_near));
+	const avxf tfar = min(min(tfar_x, tfar_y), min(tfar_z, isect_far));
+	const avxf vmask = round_down*tnear <= round_up*tfar;
+	*dist = tnear;
+	return movemask(vmask);
+}
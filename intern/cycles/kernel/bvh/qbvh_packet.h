@@ -0,0 +1,418 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* QBVH traversal of a packet of coherent rays.
+ *
+ * All rays of the packet walk the tree together, each SSE lane holds one ray
+ * and every child box of a node is tested against all rays at once. Nodes and
+ * leaves are fetched once for the whole packet, which pays off for coherent
+ * rays such as the camera rays of neighbour pixels. Rays which miss a node are
+ * masked out, the packet only splits up when no ray is left for a subtree.
+ *
+ * Box tests are done exactly the same way as qbvh_aligned_node_intersect()
+ * does for a single ray, so results match regular traversal.
+ *
+ * Supports triangles and instancing, scenes with motion blur or curves are
+ * expected to use regular traversal. Opaque shadow rays stop at their first
+ * hit, like they do in regular traversal.
+ */
+
+#define QBVH_PACKET_SIZE 4
+
+struct QBVHPacketStackItem {
+	int addr;
+	/* Rays which hit the node. */
+	int mask;
+	/* Entry distance per ray. */
+	ssef dist;
+};
+
+/* Ray data in SoA layout, one ray per lane. */
+struct QBVHPacketRays {
+#ifdef __KERNEL_AVX2__
+	sse3f org_idir;
+#else
+	sse3f org;
+#endif
+	sse3f idir;
+	/* Lanes where the ray goes in negative direction, selecting the upper
+	 * bound of a box as near plane.
+	 */
+	sseb neg_x, neg_y, neg_z;
+};
+
+ccl_device_inline void qbvh_packet_rays_update(QBVHPacketRays *rays,
+                                               const float3 P[QBVH_PACKET_SIZE],
+                                               const float3 idir[QBVH_PACKET_SIZE])
+{
+	rays->idir = sse3f(ssef(idir[0].x, idir[1].x, idir[2].x, idir[3].x),
+	                   ssef(idir[0].y, idir[1].y, idir[2].y, idir[3].y),
+	                   ssef(idir[0].z, idir[1].z, idir[2].z, idir[3].z));
+#ifdef __KERNEL_AVX2__
+	float3 P_idir[QBVH_PACKET_SIZE];
+	for(int i = 0; i < QBVH_PACKET_SIZE; i++) {
+		P_idir[i] = P[i]*idir[i];
+	}
+	rays->org_idir = sse3f(ssef(P_idir[0].x, P_idir[1].x, P_idir[2].x, P_idir[3].x),
+	                       ssef(P_idir[0].y, P_idir[1].y, P_idir[2].y, P_idir[3].y),
+	                       ssef(P_idir[0].z, P_idir[1].z, P_idir[2].z, P_idir[3].z));
+#else
+	rays->org = sse3f(ssef(P[0].x, P[1].x, P[2].x, P[3].x),
+	                  ssef(P[0].y, P[1].y, P[2].y, P[3].y),
+	                  ssef(P[0].z, P[1].z, P[2].z, P[3].z));
+#endif
+	const ssef zero(0.0f);
+	rays->neg_x = rays->idir.x < zero;
+	rays->neg_y = rays->idir.y < zero;
+	rays->neg_z = rays->idir.z < zero;
+}
+
+/* Intersect one child box of an aligned node with all rays of the packet,
+ * returns mask of rays which hit the box.
+ */
+ccl_device_inline int qbvh_packet_box_intersect(const QBVHPacketRays *rays,
+                                                const ssef& isect_far,
+                                                const ssef& lower_x,
+                                                const ssef& upper_x,
+                                                const ssef& lower_y,
+                                                const ssef& upper_y,
+                                                const ssef& lower_z,
+                                                const ssef& upper_z,
+                                                ssef *ccl_restrict dist)
+{
+	const ssef near_x = select(rays->neg_x, upper_x, lower_x);
+	const ssef near_y = select(rays->neg_y, upper_y, lower_y);
+	const ssef near_z = select(rays->neg_z, upper_z, lower_z);
+	const ssef far_x = select(rays->neg_x, lower_x, upper_x);
+	const ssef far_y = select(rays->neg_y, lower_y, upper_y);
+	const ssef far_z = select(rays->neg_z, lower_z, upper_z);
+
+#ifdef __KERNEL_AVX2__
+	const ssef tnear_x = msub(near_x, rays->idir.x, rays->org_idir.x);
+	const ssef tnear_y = msub(near_y, rays->idir.y, rays->org_idir.y);
+	const ssef tnear_z = msub(near_z, rays->idir.z, rays->org_idir.z);
+	const ssef tfar_x = msub(far_x, rays->idir.x, rays->org_idir.x);
+	const ssef tfar_y = msub(far_y, rays->idir.y, rays->org_idir.y);
+	const ssef tfar_z = msub(far_z, rays->idir.z, rays->org_idir.z);
+#else
+	const ssef tnear_x = (near_x - rays->org.x) * rays->idir.x;
+	const ssef tnear_y = (near_y - rays->org.y) * rays->idir.y;
+	const ssef tnear_z = (near_z - rays->org.z) * rays->idir.z;
+	const ssef tfar_x = (far_x - rays->org.x) * rays->idir.x;
+	const ssef tfar_y = (far_y - rays->org.y) * rays->idir.y;
+	const ssef tfar_z = (far_z - rays->org.z) * rays->idir.z;
+#endif
+
+	const ssef isect_near(0.0f);
+#ifdef __KERNEL_SSE41__
+	const ssef tnear = maxi(maxi(tnear_x, tnear_y), maxi(tnear_z, isect_near));
+	const ssef tfar = mini(mini(tfar_x, tfar_y), mini(tfar_z, isect_far));
+	const sseb vmask = cast(tnear) > cast(tfar);
+	int mask = (int)movemask(vmask)^0xf;
+#else
+	const ssef tnear = max4(tnear_x, tnear_y, tnear_z, isect_near);
+	const ssef tfar = min4(tfar_x, tfar_y, tfar_z, isect_far);
+	const sseb vmask = tnear <= tfar;
+	int mask = (int)movemask(vmask);
+#endif
+	*dist = tnear;
+	return mask;
+}
+
+ccl_device_inline void qbvh_packet_stack_push(QBVHPacketStackItem *stack,
+                                              int *stack_ptr,
+                                              int addr,
+                                              int mask,
+                                              const ssef& dist)
+{
+	++(*stack_ptr);
+	kernel_assert(*stack_ptr < BVH_QSTACK_SIZE);
+	stack[*stack_ptr].addr = addr;
+	stack[*stack_ptr].mask = mask;
+	stack[*stack_ptr].dist = dist;
+}
+
+/* Intersect up to QBVH_PACKET_SIZE rays with the scene, only rays in ray_mask
+ * are traced. Returns mask of rays which hit something.
+ */
+ccl_device int qbvh_intersect_packet(KernelGlobals *kg,
+                                     const Ray *ray,
+                                     Intersection *isect,
+                                     int ray_mask,
+                                     const uint visibility)
+{
+	QBVHPacketStackItem traversal_stack[BVH_QSTACK_SIZE];
+	traversal_stack[0].addr = ENTRYPOINT_SENTINEL;
+	traversal_stack[0].mask = 0;
+	traversal_stack[0].dist = ssef(-FLT_MAX);
+
+	float3 P[QBVH_PACKET_SIZE];
+	float3 dir[QBVH_PACKET_SIZE];
+	float3 idir[QBVH_PACKET_SIZE];
+	ssef tfar;
+
+	for(int i = 0; i < QBVH_PACKET_SIZE; i++) {
+		if(ray_mask & (1 << i)) {
+			P[i] = ray[i].P;
+			dir[i] = bvh_clamp_direction(ray[i].D);
+			idir[i] = bvh_inverse_direction(dir[i]);
+			if(!isfinite(P[i].x)) {
+				ray_mask &= ~(1 << i);
+			}
+			isect[i].t = ray[i].t;
+		}
+		else {
+			/* Keep unused lanes finite, they never hit anything. */
+			P[i] = make_float3(0.0f, 0.0f, 0.0f);
+			dir[i] = make_float3(0.0f, 0.0f, 1.0f);
+			idir[i] = bvh_inverse_direction(dir[i]);
+			isect[i].t = 0.0f;
+		}
+		isect[i].u = 0.0f;
+		isect[i].v = 0.0f;
+		isect[i].prim = PRIM_NONE;
+		isect[i].object = OBJECT_NONE;
+		tfar.f[i] = isect[i].t;
+	}
+
+	QBVHPacketRays rays;
+	qbvh_packet_rays_update(&rays, P, idir);
+
+	int stack_ptr = 0;
+	int node_addr = kernel_data.bvh.root;
+	int node_mask = ray_mask;
+	ssef node_dist(-FLT_MAX);
+	int object = OBJECT_NONE;
+	/* Shadow rays which are done, found any hit. */
+	int occluded_mask = 0;
+
+	/* Traversal loop. */
+	do {
+		do {
+			/* Traverse internal nodes. */
+			while(node_addr >= 0 && node_addr != ENTRYPOINT_SENTINEL) {
+				KERNEL_STATS_BVH_NODE(kg);
+
+				float4 inodes = kernel_tex_fetch(__bvh_nodes, node_addr+0);
+				(void)inodes;
+
+				/* Drop rays which found a closer hit since the node was pushed. */
+				node_mask &= (int)movemask(node_dist <= tfar) & ~occluded_mask;
+
+				if(UNLIKELY(node_mask == 0)
+#ifdef __VISIBILITY_FLAG__
+				   || (__float_as_uint(inodes.x) & visibility) == 0
+#endif
+				 )
+				{
+					/* Pop. */
+					node_addr = traversal_stack[stack_ptr].addr;
+					node_mask = traversal_stack[stack_ptr].mask;
+					node_dist = traversal_stack[stack_ptr].dist;
+					--stack_ptr;
+					continue;
+				}
+
+				const int offset = node_addr + 1;
+				const ssef lower_x = kernel_tex_fetch_ssef(__bvh_nodes, offset+0);
+				const ssef upper_x = kernel_tex_fetch_ssef(__bvh_nodes, offset+1);
+				const ssef lower_y = kernel_tex_fetch_ssef(__bvh_nodes, offset+2);
+				const ssef upper_y = kernel_tex_fetch_ssef(__bvh_nodes, offset+3);
+				const ssef lower_z = kernel_tex_fetch_ssef(__bvh_nodes, offset+4);
+				const ssef upper_z = kernel_tex_fetch_ssef(__bvh_nodes, offset+5);
+				const float4 cnodes = kernel_tex_fetch(__bvh_nodes, node_addr+7);
+
+				/* Test all children against the packet, ordering them by the
+				 * distance of the first active ray.
+				 */
+				const int lead = __bsf(node_mask);
+				int child_addr[4], child_mask[4];
+				ssef child_dist[4];
+				int num_hits = 0;
+
+#define QBVH_PACKET_CHILD(c) \
+				{ \
+					ssef dist; \
+					int mask = node_mask & qbvh_packet_box_intersect(&rays, \
+					                                                 tfar, \
+					                                                 shuffle<c>(lower_x), \
+					                                                 shuffle<c>(upper_x), \
+					                                                 shuffle<c>(lower_y), \
+					                                                 shuffle<c>(upper_y), \
+					                                                 shuffle<c>(lower_z), \
+					                                                 shuffle<c>(upper_z), \
+					                                                 &dist); \
+					if(mask != 0) { \
+						/* Insertion sort, farthest child first. */ \
+						int j = num_hits++; \
+						while(j > 0 && child_dist[j-1].f[lead] < dist.f[lead]) { \
+							child_addr[j] = child_addr[j-1]; \
+							child_mask[j] = child_mask[j-1]; \
+							child_dist[j] = child_dist[j-1]; \
+							j--; \
+						} \
+						child_addr[j] = __float_as_int(cnodes[c]); \
+						child_mask[j] = mask; \
+						child_dist[j] = dist; \
+					} \
+				}
+
+				QBVH_PACKET_CHILD(0)
+				QBVH_PACKET_CHILD(1)
+				QBVH_PACKET_CHILD(2)
+				QBVH_PACKET_CHILD(3)
+
+#undef QBVH_PACKET_CHILD
+
+				if(num_hits == 0) {
+					/* Pop. */
+					node_addr = traversal_stack[stack_ptr].addr;
+					node_mask = traversal_stack[stack_ptr].mask;
+					node_dist = traversal_stack[stack_ptr].dist;
+					--stack_ptr;
+					continue;
+				}
+
+				/* Push far children, continue with the closest one. */
+				for(int j = 0; j < num_hits - 1; j++) {
+					qbvh_packet_stack_push(traversal_stack,
+					                       &stack_ptr,
+					                       child_addr[j],
+					                       child_mask[j],
+					                       child_dist[j]);
+				}
+				node_addr = child_addr[num_hits - 1];
+				node_mask = child_mask[num_hits - 1];
+				node_dist = child_dist[num_hits - 1];
+			}
+
+			/* If node is leaf, fetch triangle list. */
+			if(node_addr < 0) {
+				float4 leaf = kernel_tex_fetch(__bvh_leaf_nodes, (-node_addr-1));
+
+				node_mask &= (int)movemask(node_dist <= tfar) & ~occluded_mask;
+
+#ifdef __VISIBILITY_FLAG__
+				if(UNLIKELY((node_mask == 0) ||
+				            ((__float_as_uint(leaf.z) & visibility) == 0)))
+#else
+				if(UNLIKELY(node_mask == 0))
+#endif
+				{
+					/* Pop. */
+					node_addr = traversal_stack[stack_ptr].addr;
+					node_mask = traversal_stack[stack_ptr].mask;
+					node_dist = traversal_stack[stack_ptr].dist;
+					--stack_ptr;
+					continue;
+				}
+
+				int prim_addr = __float_as_int(leaf.x);
+
+				if(prim_addr >= 0) {
+					const int prim_addr2 = __float_as_int(leaf.y);
+					const uint type = __float_as_int(leaf.w);
+					int mask = node_mask;
+
+					/* Pop. */
+					node_addr = traversal_stack[stack_ptr].addr;
+					node_mask = traversal_stack[stack_ptr].mask;
+					node_dist = traversal_stack[stack_ptr].dist;
+					--stack_ptr;
+
+					/* Primitive intersection, only triangles are supported. */
+					kernel_assert((type & PRIMITIVE_ALL) == PRIMITIVE_TRIANGLE);
+					(void)type;
+
+					while(mask != 0) {
+						const int i = __bscf(mask);
+						for(int p = prim_addr; p < prim_addr2; p++) {
+							kernel_assert(kernel_tex_fetch(__prim_type, p) == type);
+							if(triangle_intersect(kg,
+							                      &isect[i],
+							                      P[i],
+							                      dir[i],
+							                      visibility,
+							                      object,
+							                      p))
+							{
+								tfar.f[i] = isect[i].t;
+								/* Shadow ray early termination. */
+								if(visibility == PATH_RAY_SHADOW_OPAQUE) {
+									occluded_mask |= (1 << i);
+									break;
+								}
+							}
+						}
+					}
+
+					if(occluded_mask != 0 && occluded_mask == ray_mask) {
+						return occluded_mask;
+					}
+				}
+				else {
+					/* Instance push, rays which did not hit the instance
+					 * keep their world space data, they are not traced in it.
+					 */
+					object = kernel_tex_fetch(__prim_object, -prim_addr-1);
+
+					int mask = node_mask;
+					while(mask != 0) {
+						const int i = __bscf(mask);
+						qbvh_instance_push(kg, object, &ray[i], &P[i], &dir[i], &idir[i], &isect[i].t, &node_dist.f[i]);
+						tfar.f[i] = isect[i].t;
+					}
+					qbvh_packet_rays_update(&rays, P, idir);
+
+					qbvh_packet_stack_push(traversal_stack,
+					                       &stack_ptr,
+					                       ENTRYPOINT_SENTINEL,
+					                       node_mask,
+					                       ssef(-FLT_MAX));
+
+					node_addr = kernel_tex_fetch(__object_node, object);
+				}
+			}
+		} while(node_addr != ENTRYPOINT_SENTINEL);
+
+		if(stack_ptr >= 0) {
+			kernel_assert(object != OBJECT_NONE);
+
+			/* Instance pop, the sentinel holds the rays which entered it. */
+			int mask = node_mask;
+			while(mask != 0) {
+				const int i = __bscf(mask);
+				isect[i].t = bvh_instance_pop(kg, object, &ray[i], &P[i], &dir[i], &idir[i], isect[i].t);
+				tfar.f[i] = isect[i].t;
+			}
+			qbvh_packet_rays_update(&rays, P, idir);
+
+			object = OBJECT_NONE;
+			node_addr = traversal_stack[stack_ptr].addr;
+			node_mask = traversal_stack[stack_ptr].mask;
+			node_dist = traversal_stack[stack_ptr].dist;
+			--stack_ptr;
+		}
+	} while(node_addr != ENTRYPOINT_SENTINEL);
+
+	int hit_mask = 0;
+	for(int i = 0; i < QBVH_PACKET_SIZE; i++) {
+		if(isect[i].prim != PRIM_NONE) {
+			hit_mask |= (1 << i);
+		}
+	}
+	return hit_mask;
+}
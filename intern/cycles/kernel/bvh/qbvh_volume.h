@@ -96,6 +96,8 @@ ccl_device bool BVH_FUNCTION_FULL_NAME(QBVH)(KernelGlobals *kg,
 		do {
 			/* Traverse internal nodes. */
 			while(node_addr >= 0 && node_addr != ENTRYPOINT_SENTINEL) {
+				KERNEL_STATS_BVH_NODE(kg);
+
 				float4 inodes = kernel_tex_fetch(__bvh_nodes, node_addr+0);
 
 #ifdef __VISIBILITY_FLAG__
@@ -0,0 +1,151 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+CCL_NAMESPACE_BEGIN
+
+/* Adaptive sampling
+ *
+ * Pixels whose estimated error is below the threshold stop taking samples.
+ * See kernel_write_adaptive_aux() for the layout of the adaptive pass.
+ */
+
+ccl_device_inline ccl_global float *kernel_adaptive_aux(KernelGlobals *kg,
+                                                         ccl_global float *buffer,
+                                                         int x, int y,
+                                                         int offset, int stride)
+{
+	const int index = offset + x + y*stride;
+	return buffer + index*kernel_data.film.pass_stride + kernel_data.film.pass_adaptive_aux_buffer;
+}
+
+/* Mark the pixel as converged when its error is below the threshold. */
+ccl_device void kernel_adaptive_stopping(KernelGlobals *kg,
+                                         ccl_global float *buffer,
+                                         int x, int y,
+                                         int offset, int stride)
+{
+	const int index = offset + x + y*stride;
+	ccl_global float *combined = buffer + index*kernel_data.film.pass_stride;
+	ccl_global float *aux = combined + kernel_data.film.pass_adaptive_aux_buffer;
+
+	const float num_samples = aux[3];
+	if(num_samples < (float)kernel_data.integrator.adaptive_min_samples) {
+		return;
+	}
+
+	/* Per pixel error as in section 2.1 of "A hierarchical automatic stopping
+	 * condition for Monte Carlo global illumination", a small epsilon avoids
+	 * division by zero.
+	 */
+	const float error = (fabsf(combined[0] - aux[0]) +
+	                     fabsf(combined[1] - aux[1]) +
+	                     fabsf(combined[2] - aux[2])) /
+	                    (num_samples * 0.0001f + sqrtf(max(combined[0] + combined[1] + combined[2], 0.0f)));
+
+	if(error < kernel_data.integrator.adaptive_threshold * num_samples) {
+		aux[3] = -num_samples;
+	}
+}
+
+/* Neighbours of pixels which did not converge continue sampling as well, to
+ * avoid visible borders between converged and unconverged areas. Returns
+ * whether any pixel of the row still takes samples.
+ */
+ccl_device bool kernel_adaptive_filter_x(KernelGlobals *kg,
+                                         ccl_global float *buffer,
+                                         int y,
+                                         int sx, int sw,
+                                         int offset, int stride)
+{
+	bool any = false;
+	bool prev = false;
+	for(int x = sx; x < sx + sw; ++x) {
+		ccl_global float *aux = kernel_adaptive_aux(kg, buffer, x, y, offset, stride);
+		if(aux[3] > 0.0f) {
+			any = true;
+			if(x > sx && !prev) {
+				ccl_global float *aux_left = kernel_adaptive_aux(kg, buffer, x - 1, y, offset, stride);
+				aux_left[3] = fabsf(aux_left[3]);
+			}
+			prev = true;
+		}
+		else {
+			if(prev) {
+				aux[3] = fabsf(aux[3]);
+			}
+			prev = false;
+		}
+	}
+	return any;
+}
+
+ccl_device bool kernel_adaptive_filter_y(KernelGlobals *kg,
+                                         ccl_global float *buffer,
+                                         int x,
+                                         int sy, int sh,
+                                         int offset, int stride)
+{
+	bool any = false;
+	bool prev = false;
+	for(int y = sy; y < sy + sh; ++y) {
+		ccl_global float *aux = kernel_adaptive_aux(kg, buffer, x, y, offset, stride);
+		if(aux[3] > 0.0f) {
+			any = true;
+			if(y > sy && !prev) {
+				ccl_global float *aux_up = kernel_adaptive_aux(kg, buffer, x, y - 1, offset, stride);
+				aux_up[3] = fabsf(aux_up[3]);
+			}
+			prev = true;
+		}
+		else {
+			if(prev) {
+				aux[3] = fabsf(aux[3]);
+			}
+			prev = false;
+		}
+	}
+	return any;
+}
+
+/* Scale the passes of a pixel which stopped early as if it had taken all
+ * samples, so the rest of the pipeline can divide by the tile sample count.
+ * Returns the number of samples the pixel actually took.
+ */
+ccl_device int kernel_adaptive_adjust_samples(KernelGlobals *kg,
+                                              ccl_global float *buffer,
+                                              int num_samples,
+                                              int x, int y,
+                                              int offset, int stride)
+{
+	const int index = offset + x + y*stride;
+	ccl_global float *pixel = buffer + index*kernel_data.film.pass_stride;
+	ccl_global float *aux = pixel + kernel_data.film.pass_adaptive_aux_buffer;
+
+	const int pixel_samples = (int)fabsf(aux[3]);
+	if(pixel_samples > 0 && pixel_samples < num_samples) {
+		const float scale = (float)num_samples / (float)pixel_samples;
+		for(int i = 0; i < kernel_data.film.pass_adaptive_aux_buffer; i++) {
+			pixel[i] *= scale;
+		}
+		aux[0] *= scale;
+		aux[1] *= scale;
+		aux[2] *= scale;
+		aux[3] = copysignf((float)num_samples, aux[3]);
+	}
+	return min(pixel_samples, num_samples);
+}
+
+CCL_NAMESPACE_END
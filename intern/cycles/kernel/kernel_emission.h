@@ -216,7 +216,9 @@ ccl_device_noinline float3 indirect_primitive_emission(KernelGlobals *kg, Shader
 	{
 		/* multiple importance sampling, get triangle light pdf,
 		 * and compute weight with respect to BSDF pdf */
-		float pdf = triangle_light_pdf(kg, sd->Ng, sd->I, t);
+		float pdf = (kernel_data.integrator.use_light_tree)?
+		        light_tree_triangle_pdf(kg, sd, t):
+		        triangle_light_pdf(kg, sd->Ng, sd->I, t);
 		float mis_weight = power_heuristic(bsdf_pdf, pdf);
 
 		return L*mis_weight;
@@ -243,6 +245,11 @@ ccl_device_noinline bool indirect_lamp_emission(KernelGlobals *kg,
 		if(!lamp_light_eval(kg, lamp, ray->P, ray->D, ray->t, &ls))
 			continue;
 
+		if(kernel_data.integrator.use_light_tree) {
+			/* same pdf as light_sample(), including picking the lamp */
+			ls.pdf *= light_tree_lamp_pdf(kg, lamp, ray->P);
+		}
+
 #ifdef __PASSES__
 		/* use visibility flag to skip lights */
 		if(ls.shader & SHADER_EXCLUDE_ANY) {
@@ -40,6 +40,7 @@ struct OSLShadingSystem;
 
 struct Intersection;
 struct VolumeStep;
+struct TextureCacheGlobals;
 
 typedef struct KernelGlobals {
 	vector<texture_image_float4> texture_float4_images;
@@ -63,6 +64,9 @@ typedef struct KernelGlobals {
 	OSLThreadData *osl_tdata;
 #  endif
 
+	/* On-demand texture cache, NULL when all images are in device memory. */
+	TextureCacheGlobals *texture_cache;
+
 	/* **** Run-time data ****  */
 
 	/* Heap-allocated storage for transparent shadows intersections. */
@@ -78,6 +82,11 @@ typedef struct KernelGlobals {
 
 	int2 global_size;
 	int2 global_id;
+
+#  ifdef __KERNEL_STATS__
+	/* Ray and shading counters of this thread. */
+	KernelStats stats;
+#  endif
 } KernelGlobals;
 
 #endif  /* __KERNEL_CPU__ */
@@ -160,4 +169,6 @@ ccl_device float lookup_table_read_2D(KernelGlobals *kg, float x, float y, int o
 
 CCL_NAMESPACE_END
 
+#include "kernel/kernel_stats.h"
+
 #endif  /* __KERNEL_GLOBALS_H__ */
@@ -848,6 +848,197 @@ ccl_device int light_distribution_sample(KernelGlobals *kg, float randt)
 	return clamp(first-1, 0, kernel_data.integrator.num_distribution-1);
 }
 
+/* Light Tree
+ *
+ * Alternative to the distribution above, where all emitters with a position
+ * are stored in a binary tree. Every node has the bounding box, the bounding
+ * cone of emission directions and the total energy of its emitters, from
+ * which the contribution to a shading point is estimated as described in
+ * "Importance Sampling of Many Lights with Adaptive Tree Splitting". While
+ * traversing, the child with the higher estimate is picked more often, so
+ * distant lights and lights facing away are rarely sampled.
+ *
+ * Distant and background lights are not part of the tree, they are picked
+ * with the same probability as with the distribution, and are stored at the
+ * end of it.
+ */
+
+ccl_device float light_tree_node_importance(KernelGlobals *kg, int node, float3 P)
+{
+	float4 data0 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 0);
+	float energy = data0.w;
+
+	if(energy == 0.0f)
+		return 0.0f;
+
+	float4 data1 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 1);
+	float4 data2 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 2);
+
+	float3 bbox_min = make_float3(data0.x, data0.y, data0.z);
+	float3 bbox_max = make_float3(data1.x, data1.y, data1.z);
+	float radius = 0.5f*len(bbox_max - bbox_min);
+
+	float dist;
+	float3 D = normalize_len(P - 0.5f*(bbox_min + bbox_max), &dist);
+
+	/* Angle between P and the closest emission direction of the cone,
+	 * no light is emitted beyond theta_e. */
+	float theta_o = data2.w;
+	if(theta_o < M_PI_F && dist > radius) {
+		float4 data3 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 3);
+		float3 axis = make_float3(data2.x, data2.y, data2.z);
+		float theta_e = data3.x;
+
+		float theta = safe_acosf(dot(axis, D));
+		float theta_u = safe_asinf(radius/dist);
+		float theta_i = max(theta - theta_o - theta_u, 0.0f);
+
+		if(theta_i > theta_e)
+			return 0.0f;
+
+		energy *= cosf(theta_i);
+	}
+
+	return energy/max(dist*dist, radius*radius);
+}
+
+/* Probability of picking the left child of an inner node. */
+ccl_device float light_tree_node_left_probability(KernelGlobals *kg, int node, int right, float3 P)
+{
+	float importance_left = light_tree_node_importance(kg, node + 1, P);
+	float importance_right = light_tree_node_importance(kg, right, P);
+	float importance = importance_left + importance_right;
+
+	return (importance > 0.0f)? importance_left/importance: -1.0f;
+}
+
+/* Pick an emitter and return its index in the distribution, or -1 when no
+ * emitter can contribute to P. For triangles the inverse area is returned
+ * as well, since the distribution doesn't store it. */
+ccl_device int light_tree_sample(KernelGlobals *kg, float randt, float3 P, float *pdf, float *inv_area)
+{
+	int num_infinite = kernel_data.integrator.light_tree_num_infinite;
+	float infinite_pdf = kernel_data.integrator.light_tree_infinite_pdf;
+
+	*inv_area = 0.0f;
+
+	if(randt < infinite_pdf) {
+		int index = min(float_to_int(randt/infinite_pdf*num_infinite), num_infinite - 1);
+		*pdf = infinite_pdf/num_infinite;
+		return kernel_data.integrator.num_distribution - num_infinite + index;
+	}
+
+	/* The random number is rescaled to be reused for every level of the tree,
+	 * losing the bits used to pick a child. Once fewer than about 14 bits are
+	 * left it is replaced by a hash of the original one, trees of large mesh
+	 * lights are deeper than float precision allows. */
+	const uint seed = __float_as_uint(randt);
+	float randt_range = 1.0f;
+
+	randt = (randt - infinite_pdf)/(1.0f - infinite_pdf);
+	*pdf = 1.0f - infinite_pdf;
+
+	int node = 0;
+
+	for(;;) {
+		float4 data1 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 1);
+		int child = __float_as_int(data1.w);
+
+		if(child < 0) {
+			float4 data3 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 3);
+			*inv_area = data3.z;
+			return ~child;
+		}
+
+		float prob_left = light_tree_node_left_probability(kg, node, child, P);
+
+		if(prob_left < 0.0f)
+			return -1;
+
+		if(randt < prob_left) {
+			node = node + 1;
+			randt = randt/prob_left;
+			randt_range *= prob_left;
+			*pdf *= prob_left;
+		}
+		else {
+			node = child;
+			randt = (randt - prob_left)/(1.0f - prob_left);
+			randt_range *= 1.0f - prob_left;
+			*pdf *= 1.0f - prob_left;
+		}
+
+		if(randt_range < 1.0f/1024.0f) {
+			randt = cmj_randfloat(seed, node);
+			randt_range = 1.0f;
+		}
+	}
+}
+
+/* Probability of light_tree_sample() picking the emitter of a leaf node. */
+ccl_device float light_tree_pdf(KernelGlobals *kg, int node, float3 P)
+{
+	float pdf = 1.0f - kernel_data.integrator.light_tree_infinite_pdf;
+
+	while(node != 0) {
+		float4 data3 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 3);
+		int parent = __float_as_int(data3.y);
+		float4 parent_data1 = kernel_tex_fetch(__light_tree_nodes, parent*LIGHT_TREE_NODE_SIZE + 1);
+		int right = __float_as_int(parent_data1.w);
+
+		float prob_left = light_tree_node_left_probability(kg, parent, right, P);
+
+		if(prob_left < 0.0f)
+			return 0.0f;
+
+		pdf *= (node == right)? 1.0f - prob_left: prob_left;
+		node = parent;
+	}
+
+	return pdf;
+}
+
+/* Triangle light pdf for MIS, when the triangle was hit by a ray of length t. */
+ccl_device float light_tree_triangle_pdf(KernelGlobals *kg, ShaderData *sd, float t)
+{
+	float cos_pi = fabsf(dot(sd->Ng, sd->I));
+
+	if(cos_pi == 0.0f)
+		return 0.0f;
+
+	/* triangles of objects which are not in the tree can't be sampled */
+	uint offset = kernel_tex_fetch(__light_tree_object_map, sd->object*2 + 0);
+	if(offset == LIGHT_TREE_NONE)
+		return 0.0f;
+
+	uint tri_offset = kernel_tex_fetch(__light_tree_object_map, sd->object*2 + 1);
+	uint node = kernel_tex_fetch(__light_tree_triangle_nodes, offset + sd->prim - tri_offset);
+	if(node == LIGHT_TREE_NONE)
+		return 0.0f;
+
+	/* position the ray was traced from, as used for light sampling */
+	float3 P = sd->P + sd->I*t;
+
+	float4 data3 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 3);
+	float inv_area = data3.z;
+
+	return t*t*light_tree_pdf(kg, node, P)*inv_area/cos_pi;
+}
+
+/* Probability of light_sample() picking a lamp, for MIS of lamps hit by rays. */
+ccl_device float light_tree_lamp_pdf(KernelGlobals *kg, int lamp, float3 P)
+{
+	uint node = kernel_tex_fetch(__light_tree_lamp_nodes, lamp);
+
+	if(node == LIGHT_TREE_NONE) {
+		/* distant and background lights are picked outside of the tree */
+		int num_infinite = kernel_data.integrator.light_tree_num_infinite;
+		return (num_infinite > 0)? kernel_data.integrator.light_tree_infinite_pdf/num_infinite: 0.0f;
+	}
+
+	return light_tree_pdf(kg, node, P);
+}
+
 /* Generic Light */
 
 ccl_device bool light_select_reached_max_bounces(KernelGlobals *kg, int index, int bounce)
@@ -866,7 +1057,18 @@ ccl_device_noinline bool light_sample(KernelGlobals *kg,
                                       LightSample *ls)
 {
 	/* sample index */
-	int index = light_distribution_sample(kg, randt);
+	int index;
+	float tree_pdf = 0.0f, tree_inv_area = 0.0f;
+
+	if(kernel_data.integrator.use_light_tree) {
+		index = light_tree_sample(kg, randt, P, &tree_pdf, &tree_inv_area);
+		if(index < 0) {
+			return false;
+		}
+	}
+	else {
+		index = light_distribution_sample(kg, randt);
+	}
 
 	/* fetch light data */
 	float4 l = kernel_tex_fetch(__light_distribution, index);
@@ -879,7 +1081,13 @@ ccl_device_noinline bool light_sample(KernelGlobals *kg,
 		triangle_light_sample(kg, prim, object, randu, randv, time, ls);
 		/* compute incoming direction, distance and pdf */
 		ls->D = normalize_len(ls->P - P, &ls->t);
-		ls->pdf = triangle_light_pdf(kg, ls->Ng, -ls->D, ls->t);
+		if(kernel_data.integrator.use_light_tree) {
+			float cos_pi = fabsf(dot(ls->Ng, ls->D));
+			ls->pdf = (cos_pi > 0.0f)? ls->t*ls->t*tree_pdf*tree_inv_area/cos_pi: 0.0f;
+		}
+		else {
+			ls->pdf = triangle_light_pdf(kg, ls->Ng, -ls->D, ls->t);
+		}
 		ls->shader |= shader_flag;
 		return (ls->pdf > 0.0f);
 	}
@@ -890,7 +1098,24 @@ ccl_device_noinline bool light_sample(KernelGlobals *kg,
 			return false;
 		}
 
-		return lamp_light_sample(kg, lamp, randu, randv, P, ls);
+		if(!lamp_light_sample(kg, lamp, randu, randv, P, ls)) {
+			return false;
+		}
+
+		/* lamp_light_sample() assumes lamps are picked with pdf_lights, which
+		 * background lights include in the pdf and other lamps in eval_fac.
+		 * Use the tree pdf in the pdf instead, so MIS weights account for it. */
+		if(kernel_data.integrator.use_light_tree) {
+			if(ls->type == LIGHT_BACKGROUND) {
+				ls->pdf *= tree_pdf*kernel_data.integrator.inv_pdf_lights;
+			}
+			else {
+				ls->pdf *= tree_pdf;
+				ls->eval_fac *= kernel_data.integrator.pdf_lights;
+			}
+		}
+
+		return true;
 	}
 }
 
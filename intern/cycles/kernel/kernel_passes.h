@@ -333,6 +333,37 @@ ccl_device_inline void kernel_write_light_passes(KernelGlobals *kg, ccl_global f
 #endif
 }
 
+#ifdef __ADAPTIVE_SAMPLING__
+/* Adaptive sampling pass: every second sample is accumulated as well, scaled
+ * by two so it can be compared against the combined pass to estimate the error.
+ * The fourth component counts the samples taken by the pixel, it is negated
+ * once the pixel converged and no more samples are taken.
+ */
+ccl_device_inline void kernel_write_adaptive_aux(ccl_global float *buffer, int sample, float3 L_sum)
+{
+	if(sample == 0) {
+		buffer[0] = 0.0f;
+		buffer[1] = 0.0f;
+		buffer[2] = 0.0f;
+		buffer[3] = 1.0f;
+		return;
+	}
+
+	if(sample & 1) {
+		buffer[0] += 2.0f*L_sum.x;
+		buffer[1] += 2.0f*L_sum.y;
+		buffer[2] += 2.0f*L_sum.z;
+	}
+	buffer[3] += 1.0f;
+}
+
+ccl_device_inline bool kernel_adaptive_pixel_converged(KernelGlobals *kg, ccl_global float *buffer)
+{
+	return kernel_data.film.pass_adaptive_aux_buffer &&
+	       buffer[kernel_data.film.pass_adaptive_aux_buffer + 3] < 0.0f;
+}
+#endif  /* __ADAPTIVE_SAMPLING__ */
+
 ccl_device_inline void kernel_write_result(KernelGlobals *kg, ccl_global float *buffer,
 	int sample, PathRadiance *L, float alpha, bool is_shadow_catcher)
 {
@@ -350,6 +381,12 @@ ccl_device_inline void kernel_write_result(KernelGlobals *kg, ccl_global float *
 
 		kernel_write_pass_float4(buffer, sample, make_float4(L_sum.x, L_sum.y, L_sum.z, alpha));
 
+#ifdef __ADAPTIVE_SAMPLING__
+		if(kernel_data.film.pass_adaptive_aux_buffer) {
+			kernel_write_adaptive_aux(buffer + kernel_data.film.pass_adaptive_aux_buffer, sample, L_sum);
+		}
+#endif
+
 		kernel_write_light_passes(kg, buffer, L, sample);
 
 #ifdef __DENOISING_FEATURES__
@@ -393,6 +430,13 @@ ccl_device_inline void kernel_write_result(KernelGlobals *kg, ccl_global float *
 	else {
 		kernel_write_pass_float4(buffer, sample, make_float4(0.0f, 0.0f, 0.0f, 0.0f));
 
+#ifdef __ADAPTIVE_SAMPLING__
+		if(kernel_data.film.pass_adaptive_aux_buffer) {
+			kernel_write_adaptive_aux(buffer + kernel_data.film.pass_adaptive_aux_buffer,
+			                          sample, make_float3(0.0f, 0.0f, 0.0f));
+		}
+#endif
+
 #ifdef __DENOISING_FEATURES__
 		if(kernel_data.film.pass_denoising_data) {
 			kernel_write_denoising_shadow(kg, buffer + kernel_data.film.pass_denoising_data, sample, 0.0f, 0.0f);
@@ -89,6 +89,7 @@ ccl_device_noinline void kernel_path_ao(KernelGlobals *kg,
 		light_ray.dP = sd->dP;
 		light_ray.dD = differential3_zero();
 
+		KERNEL_STATS_RAY(kg, KERNEL_STATS_RAY_AO);
 		if(!shadow_blocked(kg, emission_sd, state, &light_ray, &ao_shadow)) {
 			path_radiance_accum_ao(L, state, throughput, ao_alpha, ao_bsdf, ao_shadow);
 		}
@@ -119,6 +120,7 @@ ccl_device void kernel_path_indirect(KernelGlobals *kg,
 			visibility = PATH_RAY_SHADOW;
 			ray->t = kernel_data.background.ao_distance;
 		}
+		KERNEL_STATS_RAY(kg, KERNEL_STATS_RAY_INDIRECT);
 		bool hit = scene_intersect(kg,
 		                           *ray,
 		                           visibility,
@@ -429,27 +431,79 @@ ccl_device void kernel_path_indirect(KernelGlobals *kg,
 }
 
 
+/* Path paused right after the direct light of its first hit was sampled, so
+ * the shadow rays of neighbour paths can be traced together as a packet. The
+ * caller adds the light of the shadow ray and then resumes the path, which
+ * keeps the order of accumulation the same as in kernel_path_trace(). Shader
+ * data and indirect subsurface rays live here for the whole path, to avoid
+ * copying them on pause. */
+typedef struct PathPaused {
+	PathShadowRay shadow;
+	ShaderData sd;
+	PathState state;
+	Ray ray;
+	float3 throughput;
+	float L_transparent;
+#ifdef __SUBSURFACE__
+	SubsurfaceIndirectRays ss_indirect;
+#endif  /* __SUBSURFACE__ */
+	bool paused;
+} PathPaused;
+
 ccl_device_inline float kernel_path_integrate(KernelGlobals *kg,
                                               RNG *rng,
                                               int sample,
                                               Ray ray,
                                               ccl_global float *buffer,
                                               PathRadiance *L,
-                                              bool *is_shadow_catcher)
+                                              bool *is_shadow_catcher,
+                                              const Intersection *isect_first,
+                                              PathPaused *paused)
 {
-	/* initialize */
-	float3 throughput = make_float3(1.0f, 1.0f, 1.0f);
-	float L_transparent = 0.0f;
-
-	path_radiance_init(L, kernel_data.film.use_light_pass);
-
 	/* shader data memory used for both volumes and surfaces, saves stack space */
-	ShaderData sd;
+	ShaderData sd_path;
+	ShaderData *sd = (paused != NULL)? &paused->sd: &sd_path;
 	/* shader data used by emission, shadows, volume stacks */
 	ShaderData emission_sd;
 
+	float3 throughput;
+	float L_transparent;
 	PathState state;
-	path_state_init(kg, &emission_sd, &state, rng, sample, &ray);
+
+#ifdef __SUBSURFACE__
+	SubsurfaceIndirectRays ss_indirect_path;
+	SubsurfaceIndirectRays *ss_indirect = (paused != NULL)? &paused->ss_indirect: &ss_indirect_path;
+#endif  /* __SUBSURFACE__ */
+
+	/* the path pauses after the first direct lighting with a deferred shadow ray */
+	PathShadowRay *shadow_first = NULL;
+	bool resume = false;
+
+	if(paused != NULL && paused->paused) {
+		throughput = paused->throughput;
+		L_transparent = paused->L_transparent;
+		state = paused->state;
+		ray = paused->ray;
+		paused->paused = false;
+		resume = true;
+	}
+	else {
+		/* initialize */
+		throughput = make_float3(1.0f, 1.0f, 1.0f);
+		L_transparent = 0.0f;
+
+		path_radiance_init(L, kernel_data.film.use_light_pass);
+		path_state_init(kg, &emission_sd, &state, rng, sample, &ray);
+
+#ifdef __SUBSURFACE__
+		kernel_path_subsurface_init_indirect(ss_indirect);
+#endif  /* __SUBSURFACE__ */
+
+		if(paused != NULL) {
+			paused->shadow.valid = false;
+			shadow_first = &paused->shadow;
+		}
+	}
 
 #ifdef __KERNEL_DEBUG__
 	DebugData debug_data;
@@ -457,14 +511,19 @@ ccl_device_inline float kernel_path_integrate(KernelGlobals *kg,
 #endif  /* __KERNEL_DEBUG__ */
 
 #ifdef __SUBSURFACE__
-	SubsurfaceIndirectRays ss_indirect;
-	kernel_path_subsurface_init_indirect(&ss_indirect);
-
 	for(;;) {
 #endif  /* __SUBSURFACE__ */
 
 	/* path iteration */
 	for(;;) {
+		if(resume) {
+			/* continue a paused path with the bounce off its first hit */
+			resume = false;
+			if(kernel_path_surface_bounce(kg, rng, sd, &throughput, &state, L, &ray))
+				continue;
+			break;
+		}
+
 		/* intersect scene */
 		Intersection isect;
 		uint visibility = path_state_ray_visibility(kg, &state);
@@ -488,11 +547,23 @@ ccl_device_inline float kernel_path_integrate(KernelGlobals *kg,
 			visibility = PATH_RAY_SHADOW;
 			ray.t = kernel_data.background.ao_distance;
 		}
+#endif  /* __HAIR__ */
 
-		bool hit = scene_intersect(kg, ray, visibility, &isect, &lcg_state, difl, extmax);
+		bool hit;
+		if(isect_first != NULL && visibility == PATH_RAY_CAMERA) {
+			/* Camera ray was already traced as part of a packet. */
+			isect = *isect_first;
+			hit = (isect.prim != PRIM_NONE);
+		}
+		else {
+			KERNEL_STATS_RAY(kg, (state.flag & PATH_RAY_CAMERA)? KERNEL_STATS_RAY_CAMERA: KERNEL_STATS_RAY_INDIRECT);
+#ifdef __HAIR__
+			hit = scene_intersect(kg, ray, visibility, &isect, &lcg_state, difl, extmax);
 #else
-		bool hit = scene_intersect(kg, ray, visibility, &isect, NULL, 0.0f, 0.0f);
+			hit = scene_intersect(kg, ray, visibility, &isect, NULL, 0.0f, 0.0f);
 #endif  /* __HAIR__ */
+		}
+		isect_first = NULL;
 
 #ifdef __KERNEL_DEBUG__
 		if(state.flag & PATH_RAY_CAMERA) {
@@ -544,9 +615,9 @@ ccl_device_inline float kernel_path_integrate(KernelGlobals *kg,
 				/* cache steps along volume for repeated sampling */
 				VolumeSegment volume_segment;
 
-				shader_setup_from_volume(kg, &sd, &volume_ray);
+				shader_setup_from_volume(kg, sd, &volume_ray);
 				kernel_volume_decoupled_record(kg, &state,
-					&volume_ray, &sd, &volume_segment, heterogeneous);
+					&volume_ray, sd, &volume_segment, heterogeneous);
 
 				volume_segment.sampling_method = sampling_method;
 
@@ -561,7 +632,7 @@ ccl_device_inline float kernel_path_integrate(KernelGlobals *kg,
 					int all = false;
 
 					/* direct light sampling */
-					kernel_branched_path_volume_connect_light(kg, rng, &sd,
+					kernel_branched_path_volume_connect_light(kg, rng, sd,
 						&emission_sd, throughput, &state, L, all,
 						&volume_ray, &volume_segment);
 
@@ -572,7 +643,7 @@ ccl_device_inline float kernel_path_integrate(KernelGlobals *kg,
 					float rscatter = path_state_rng_1D_for_decision(kg, rng, &state, PRNG_SCATTER_DISTANCE);
 
 					result = kernel_volume_decoupled_scatter(kg,
-						&state, &volume_ray, &sd, &throughput,
+						&state, &volume_ray, sd, &throughput,
 						rphase, rscatter, &volume_segment, NULL, true);
 				}
 
@@ -580,7 +651,7 @@ ccl_device_inline float kernel_path_integrate(KernelGlobals *kg,
 				kernel_volume_decoupled_free(kg, &volume_segment);
 
 				if(result == VOLUME_PATH_SCATTERED) {
-					if(kernel_path_volume_bounce(kg, rng, &sd, &throughput, &state, L, &ray))
+					if(kernel_path_volume_bounce(kg, rng, sd, &throughput, &state, L, &ray))
 						continue;
 					else
 						break;
@@ -594,15 +665,15 @@ ccl_device_inline float kernel_path_integrate(KernelGlobals *kg,
 			{
 				/* integrate along volume segment with distance sampling */
 				VolumeIntegrateResult result = kernel_volume_integrate(
-					kg, &state, &sd, &volume_ray, L, &throughput, rng, heterogeneous);
+					kg, &state, sd, &volume_ray, L, &throughput, rng, heterogeneous);
 
 #  ifdef __VOLUME_SCATTER__
 				if(result == VOLUME_PATH_SCATTERED) {
 					/* direct lighting */
-					kernel_path_volume_connect_light(kg, rng, &sd, &emission_sd, throughput, &state, L);
+					kernel_path_volume_connect_light(kg, rng, sd, &emission_sd, throughput, &state, L);
 
 					/* indirect light bounce */
-					if(kernel_path_volume_bounce(kg, rng, &sd, &throughput, &state, L, &ray))
+					if(kernel_path_volume_bounce(kg, rng, sd, &throughput, &state, L, &ray))
 						continue;
 					else
 						break;
@@ -636,15 +707,15 @@ ccl_device_inline float kernel_path_integrate(KernelGlobals *kg,
 		}
 
 		/* setup shading */
-		shader_setup_from_ray(kg, &sd, &isect, &ray);
+		shader_setup_from_ray(kg, sd, &isect, &ray);
 		float rbsdf = path_state_rng_1D_for_decision(kg, rng, &state, PRNG_BSDF);
-		shader_eval_surface(kg, &sd, rng, &state, rbsdf, state.flag, SHADER_CONTEXT_MAIN);
+		shader_eval_surface(kg, sd, rng, &state, rbsdf, state.flag, SHADER_CONTEXT_MAIN);
 
 #ifdef __SHADOW_TRICKS__
-		if((sd.object_flag & SD_OBJECT_SHADOW_CATCHER)) {
+		if((sd->object_flag & SD_OBJECT_SHADOW_CATCHER)) {
 			if(state.flag & PATH_RAY_CAMERA) {
 				state.flag |= (PATH_RAY_SHADOW_CATCHER | PATH_RAY_SHADOW_CATCHER_ONLY | PATH_RAY_STORE_SHADOW_INFO);
-				state.catcher_object = sd.object;
+				state.catcher_object = sd->object;
 				if(!kernel_data.background.transparent) {
 					L->shadow_color = indirect_background(kg, &emission_sd, &state, &ray);
 				}
@@ -657,30 +728,30 @@ ccl_device_inline float kernel_path_integrate(KernelGlobals *kg,
 
 		/* holdout */
 #ifdef __HOLDOUT__
-		if(((sd.flag & SD_HOLDOUT) ||
-		    (sd.object_flag & SD_OBJECT_HOLDOUT_MASK)) &&
+		if(((sd->flag & SD_HOLDOUT) ||
+		    (sd->object_flag & SD_OBJECT_HOLDOUT_MASK)) &&
 		   (state.flag & PATH_RAY_CAMERA))
 		{
 			if(kernel_data.background.transparent) {
 				float3 holdout_weight;
-				if(sd.object_flag & SD_OBJECT_HOLDOUT_MASK) {
+				if(sd->object_flag & SD_OBJECT_HOLDOUT_MASK) {
 					holdout_weight = make_float3(1.0f, 1.0f, 1.0f);
 				}
 				else {
-					holdout_weight = shader_holdout_eval(kg, &sd);
+					holdout_weight = shader_holdout_eval(kg, sd);
 				}
 				/* any throughput is ok, should all be identical here */
 				L_transparent += average(holdout_weight*throughput);
 			}
 
-			if(sd.object_flag & SD_OBJECT_HOLDOUT_MASK) {
+			if(sd->object_flag & SD_OBJECT_HOLDOUT_MASK) {
 				break;
 			}
 		}
 #endif  /* __HOLDOUT__ */
 
 		/* holdout mask objects do not write data passes */
-		kernel_write_data_passes(kg, buffer, L, &sd, sample, &state, throughput);
+		kernel_write_data_passes(kg, buffer, L, sd, sample, &state, throughput);
 
 		/* blurring of bsdf after bounces, for rays that have a small likelihood
 		 * of following this particular path (diffuse, rough glossy) */
@@ -689,15 +760,15 @@ ccl_device_inline float kernel_path_integrate(KernelGlobals *kg,
 
 			if(blur_pdf < 1.0f) {
 				float blur_roughness = sqrtf(1.0f - blur_pdf)*0.5f;
-				shader_bsdf_blur(kg, &sd, blur_roughness);
+				shader_bsdf_blur(kg, sd, blur_roughness);
 			}
 		}
 
 #ifdef __EMISSION__
 		/* emission */
-		if(sd.flag & SD_EMISSION) {
+		if(sd->flag & SD_EMISSION) {
 			/* todo: is isect.t wrong here for transparent surfaces? */
-			float3 emission = indirect_primitive_emission(kg, &sd, isect.t, state.flag, state.ray_pdf);
+			float3 emission = indirect_primitive_emission(kg, sd, isect.t, state.flag, state.ray_pdf);
 			path_radiance_accum_emission(L, throughput, emission, state.bounce);
 		}
 #endif  /* __EMISSION__ */
@@ -718,28 +789,28 @@ ccl_device_inline float kernel_path_integrate(KernelGlobals *kg,
 			throughput /= probability;
 		}
 
-		kernel_update_denoising_features(kg, &sd, &state, L);
+		kernel_update_denoising_features(kg, sd, &state, L);
 
 #ifdef __AO__
 		/* ambient occlusion */
-		if(kernel_data.integrator.use_ambient_occlusion || (sd.flag & SD_AO)) {
-			kernel_path_ao(kg, &sd, &emission_sd, L, &state, rng, throughput, shader_bsdf_alpha(kg, &sd));
+		if(kernel_data.integrator.use_ambient_occlusion || (sd->flag & SD_AO)) {
+			kernel_path_ao(kg, sd, &emission_sd, L, &state, rng, throughput, shader_bsdf_alpha(kg, sd));
 		}
 #endif  /* __AO__ */
 
 #ifdef __SUBSURFACE__
 		/* bssrdf scatter to a different location on the same object, replacing
 		 * the closures with a diffuse BSDF */
-		if(sd.flag & SD_BSSRDF) {
+		if(sd->flag & SD_BSSRDF) {
 			if(kernel_path_subsurface_scatter(kg,
-			                                  &sd,
+			                                  sd,
 			                                  &emission_sd,
 			                                  L,
 			                                  &state,
 			                                  rng,
 			                                  &ray,
 			                                  &throughput,
-			                                  &ss_indirect))
+			                                  ss_indirect))
 			{
 				break;
 			}
@@ -747,22 +818,32 @@ ccl_device_inline float kernel_path_integrate(KernelGlobals *kg,
 #endif  /* __SUBSURFACE__ */
 
 		/* direct lighting */
-		kernel_path_surface_connect_light(kg, rng, &sd, &emission_sd, throughput, &state, L);
+		kernel_path_surface_connect_light(kg, rng, sd, &emission_sd, throughput, &state, L, shadow_first);
+
+		if(shadow_first != NULL && shadow_first->valid) {
+			paused->throughput = throughput;
+			paused->L_transparent = L_transparent;
+			paused->state = state;
+			paused->ray = ray;
+			paused->paused = true;
+			return 0.0f;
+		}
+		shadow_first = NULL;
 
 		/* compute direct lighting and next bounce */
-		if(!kernel_path_surface_bounce(kg, rng, &sd, &throughput, &state, L, &ray))
+		if(!kernel_path_surface_bounce(kg, rng, sd, &throughput, &state, L, &ray))
 			break;
 	}
 
 #ifdef __SUBSURFACE__
-		kernel_path_subsurface_accum_indirect(&ss_indirect, L);
+		kernel_path_subsurface_accum_indirect(ss_indirect, L);
 
 		/* Trace indirect subsurface rays by restarting the loop. this uses less
 		 * stack memory than invoking kernel_path_indirect.
 		 */
-		if(ss_indirect.num_rays) {
+		if(ss_indirect->num_rays) {
 			kernel_path_subsurface_setup_indirect(kg,
-			                                      &ss_indirect,
+			                                      ss_indirect,
 			                                      &state,
 			                                      &ray,
 			                                      L,
@@ -796,6 +877,12 @@ ccl_device void kernel_path_trace(KernelGlobals *kg,
 	rng_state += index;
 	buffer += index*pass_stride;
 
+#ifdef __ADAPTIVE_SAMPLING__
+	if(kernel_adaptive_pixel_converged(kg, buffer)) {
+		return;
+	}
+#endif
+
 	/* initialize random numbers and ray */
 	RNG rng;
 	Ray ray;
@@ -807,7 +894,7 @@ ccl_device void kernel_path_trace(KernelGlobals *kg,
 	bool is_shadow_catcher;
 
 	if(ray.t != 0.0f) {
-		float alpha = kernel_path_integrate(kg, &rng, sample, ray, buffer, &L, &is_shadow_catcher);
+		float alpha = kernel_path_integrate(kg, &rng, sample, ray, buffer, &L, &is_shadow_catcher, NULL, NULL);
 		kernel_write_result(kg, buffer, sample, &L, alpha, is_shadow_catcher);
 	}
 	else {
@@ -817,6 +904,126 @@ ccl_device void kernel_path_trace(KernelGlobals *kg,
 	path_rng_end(kg, rng_state, rng);
 }
 
+/* Add light of a deferred shadow ray to L once its occlusion is known. */
+ccl_device_inline void kernel_path_shadow_ray_accum(PathShadowRay *shadow_ray,
+                                                    bool blocked,
+                                                    PathRadiance *L)
+{
+	if(!blocked) {
+		path_radiance_accum_light(L,
+		                          &shadow_ray->state,
+		                          shadow_ray->throughput,
+		                          &shadow_ray->L_light,
+		                          make_float3(1.0f, 1.0f, 1.0f),
+		                          1.0f,
+		                          shadow_ray->is_lamp);
+	}
+	else {
+		path_radiance_accum_total_light(L,
+		                                &shadow_ray->state,
+		                                shadow_ray->throughput,
+		                                &shadow_ray->L_light);
+	}
+}
+
+/* Path trace num_pixels neighbour pixels of a row, starting at x. Camera rays
+ * are traced together as a packet, as are the shadow rays from the surfaces
+ * they hit when these only need an opaque test. The rest of each path is
+ * traced as usual.
+ */
+ccl_device void kernel_path_trace_packet(KernelGlobals *kg,
+	ccl_global float *buffer, ccl_global uint *rng_state,
+	int sample, int x, int y, int num_pixels, int offset, int stride)
+{
+#if defined(__QBVH__) && !defined(__KERNEL_DEBUG__)
+	if(scene_intersect_packet_supported(kg)) {
+		const int pass_stride = kernel_data.film.pass_stride;
+		const int index = offset + x + y*stride;
+
+		RNG rng[QBVH_PACKET_SIZE];
+		Ray ray[QBVH_PACKET_SIZE];
+		Intersection isect[QBVH_PACKET_SIZE];
+		int ray_mask = 0, pixel_mask = 0;
+
+		kernel_assert(num_pixels <= QBVH_PACKET_SIZE);
+
+		/* initialize random numbers and rays */
+		for(int i = 0; i < num_pixels; i++) {
+#ifdef __ADAPTIVE_SAMPLING__
+			if(kernel_adaptive_pixel_converged(kg, buffer + (index + i)*pass_stride)) {
+				continue;
+			}
+#endif
+			pixel_mask |= (1 << i);
+			kernel_path_trace_setup(kg, rng_state + index + i, sample, x + i, y, &rng[i], &ray[i]);
+			if(ray[i].t != 0.0f) {
+				ray_mask |= (1 << i);
+				KERNEL_STATS_RAY(kg, KERNEL_STATS_RAY_CAMERA);
+			}
+		}
+
+		scene_intersect_packet(kg, ray, isect, ray_mask, PATH_RAY_CAMERA);
+
+		/* integrate, paths pause after direct light sampling of their first hit
+		 * when its shadow ray can be traced as part of the shadow packet */
+		PathRadiance L[QBVH_PACKET_SIZE];
+		PathPaused paused[QBVH_PACKET_SIZE];
+		float alpha[QBVH_PACKET_SIZE];
+		bool is_shadow_catcher[QBVH_PACKET_SIZE];
+		int shadow_mask = 0;
+
+		for(int i = 0; i < num_pixels; i++) {
+			if(ray_mask & (1 << i)) {
+				ccl_global float *pixel_buffer = buffer + (index + i)*pass_stride;
+
+				paused[i].paused = false;
+				alpha[i] = kernel_path_integrate(kg, &rng[i], sample, ray[i], pixel_buffer, &L[i], &is_shadow_catcher[i], &isect[i], &paused[i]);
+				if(paused[i].paused) {
+					ray[i] = paused[i].shadow.ray;
+					shadow_mask |= (1 << i);
+				}
+			}
+		}
+
+		/* add light of the shadow rays and continue the paused paths */
+		if(shadow_mask != 0) {
+			const int blocked_mask = scene_intersect_packet(kg, ray, isect, shadow_mask, PATH_RAY_SHADOW_OPAQUE);
+
+			for(int i = 0; i < num_pixels; i++) {
+				if(shadow_mask & (1 << i)) {
+					ccl_global float *pixel_buffer = buffer + (index + i)*pass_stride;
+
+					kernel_path_shadow_ray_accum(&paused[i].shadow, (blocked_mask & (1 << i)) != 0, &L[i]);
+					alpha[i] = kernel_path_integrate(kg, &rng[i], sample, ray[i], pixel_buffer, &L[i], &is_shadow_catcher[i], NULL, &paused[i]);
+				}
+			}
+		}
+
+		for(int i = 0; i < num_pixels; i++) {
+			if(!(pixel_mask & (1 << i))) {
+				continue;
+			}
+
+			ccl_global float *pixel_buffer = buffer + (index + i)*pass_stride;
+
+			if(ray_mask & (1 << i)) {
+				kernel_write_result(kg, pixel_buffer, sample, &L[i], alpha[i], is_shadow_catcher[i]);
+			}
+			else {
+				kernel_write_result(kg, pixel_buffer, sample, NULL, 0.0f, false);
+			}
+
+			path_rng_end(kg, rng_state + index + i, rng[i]);
+		}
+		return;
+	}
+#endif  /* __QBVH__ && !__KERNEL_DEBUG__ */
+
+	for(int i = 0; i < num_pixels; i++) {
+		kernel_path_trace(kg, buffer, rng_state, sample, x + i, y, offset, stride);
+	}
+}
+
 #endif  /* __SPLIT_KERNEL__ */
 
 CCL_NAMESPACE_END
@@ -55,6 +55,7 @@ ccl_device_inline void kernel_branched_path_ao(KernelGlobals *kg,
 			light_ray.dP = sd->dP;
 			light_ray.dD = differential3_zero();
 
+			KERNEL_STATS_RAY(kg, KERNEL_STATS_RAY_AO);
 			if(!shadow_blocked(kg, emission_sd, state, &light_ray, &ao_shadow)) {
 				path_radiance_accum_ao(L, state, throughput*num_samples_inv, ao_alpha, ao_bsdf, ao_shadow);
 			}
@@ -298,6 +299,8 @@ ccl_device float kernel_branched_path_integrate(KernelGlobals *kg,
 		Intersection isect;
 		uint visibility = path_state_ray_visibility(kg, &state);
 
+		KERNEL_STATS_RAY(kg, (state.flag & PATH_RAY_CAMERA)? KERNEL_STATS_RAY_CAMERA: KERNEL_STATS_RAY_INDIRECT);
+
 #ifdef __HAIR__
 		float difl = 0.0f, extmax = 0.0f;
 		uint lcg_state = 0;
@@ -646,6 +649,12 @@ ccl_device void kernel_branched_path_trace(KernelGlobals *kg,
 	rng_state += index;
 	buffer += index*pass_stride;
 
+#ifdef __ADAPTIVE_SAMPLING__
+	if(kernel_adaptive_pixel_converged(kg, buffer)) {
+		return;
+	}
+#endif
+
 	/* initialize random numbers and ray */
 	RNG rng;
 	Ray ray;
@@ -68,6 +68,7 @@ ccl_device_noinline void kernel_branched_path_surface_connect_light(
 						/* trace shadow ray */
 						float3 shadow;
 
+						KERNEL_STATS_RAY(kg, KERNEL_STATS_RAY_SHADOW);
 						if(!shadow_blocked(kg, emission_sd, state, &light_ray, &shadow)) {
 							/* accumulate */
 							path_radiance_accum_light(L, state, throughput*num_samples_inv, &L_light, shadow, num_samples_inv, is_lamp);
@@ -105,6 +106,7 @@ ccl_device_noinline void kernel_branched_path_surface_connect_light(
 						/* trace shadow ray */
 						float3 shadow;
 
+						KERNEL_STATS_RAY(kg, KERNEL_STATS_RAY_SHADOW);
 						if(!shadow_blocked(kg, emission_sd, state, &light_ray, &shadow)) {
 							/* accumulate */
 							path_radiance_accum_light(L, state, throughput*num_samples_inv, &L_light, shadow, num_samples_inv, is_lamp);
@@ -131,6 +133,7 @@ ccl_device_noinline void kernel_branched_path_surface_connect_light(
 				/* trace shadow ray */
 				float3 shadow;
 
+				KERNEL_STATS_RAY(kg, KERNEL_STATS_RAY_SHADOW);
 				if(!shadow_blocked(kg, emission_sd, state, &light_ray, &shadow)) {
 					/* accumulate */
 					path_radiance_accum_light(L, state, throughput*num_samples_adjust, &L_light, shadow, num_samples_adjust, is_lamp);
@@ -216,10 +219,23 @@ ccl_device bool kernel_branched_path_surface_bounce(
 
 #endif
 
-/* path tracing: connect path directly to position on a light and add it to L */
+/* Shadow ray whose occlusion test is left to the caller, so it can be traced
+ * together with the shadow rays of other paths. */
+typedef struct PathShadowRay {
+	Ray ray;
+	BsdfEval L_light;
+	float3 throughput;
+	PathState state;
+	bool is_lamp;
+	bool valid;
+} PathShadowRay;
+
+/* path tracing: connect path directly to position on a light and add it to L.
+ * When shadow_deferred is given and the shadow ray only needs an opaque test,
+ * the ray is stored there instead of being traced. */
 ccl_device_inline void kernel_path_surface_connect_light(KernelGlobals *kg, RNG *rng,
 	ShaderData *sd, ShaderData *emission_sd, float3 throughput, ccl_addr_space PathState *state,
-	PathRadiance *L)
+	PathRadiance *L, PathShadowRay *shadow_deferred)
 {
 #ifdef __EMISSION__
 	if(!(kernel_data.integrator.use_direct_light && (sd->flag & SD_BSDF_HAS_EVAL)))
@@ -260,7 +276,16 @@ ccl_device_inline void kernel_path_surface_connect_light(KernelGlobals *kg, RNG
 			/* trace shadow ray */
 			float3 shadow;
 
-			if(!shadow_blocked(kg, emission_sd, state, &light_ray, &shadow)) {
+			KERNEL_STATS_RAY(kg, KERNEL_STATS_RAY_SHADOW);
+			if(shadow_deferred != NULL && shadow_blocked_is_opaque(kg, state)) {
+				shadow_deferred->ray = light_ray;
+				shadow_deferred->L_light = L_light;
+				shadow_deferred->throughput = throughput;
+				shadow_deferred->state = *state;
+				shadow_deferred->is_lamp = is_lamp;
+				shadow_deferred->valid = true;
+			}
+			else if(!shadow_blocked(kg, emission_sd, state, &light_ray, &shadow)) {
 				/* accumulate */
 				path_radiance_accum_light(L, state, throughput, &L_light, shadow, 1.0f, is_lamp);
 			}
@@ -53,6 +53,7 @@ ccl_device_inline void kernel_path_volume_connect_light(
 			/* trace shadow ray */
 			float3 shadow;
 
+			KERNEL_STATS_RAY(kg, KERNEL_STATS_RAY_SHADOW);
 			if(!shadow_blocked(kg, emission_sd, state, &light_ray, &shadow)) {
 				/* accumulate */
 				path_radiance_accum_light(L, state, throughput, &L_light, shadow, 1.0f, is_lamp);
@@ -182,6 +183,7 @@ ccl_device void kernel_branched_path_volume_connect_light(
 						/* trace shadow ray */
 						float3 shadow;
 
+						KERNEL_STATS_RAY(kg, KERNEL_STATS_RAY_SHADOW);
 						if(!shadow_blocked(kg, emission_sd, state, &light_ray, &shadow)) {
 							/* accumulate */
 							path_radiance_accum_light(L, state, tp*num_samples_inv, &L_light, shadow, num_samples_inv, is_lamp);
@@ -231,6 +233,7 @@ ccl_device void kernel_branched_path_volume_connect_light(
 						/* trace shadow ray */
 						float3 shadow;
 
+						KERNEL_STATS_RAY(kg, KERNEL_STATS_RAY_SHADOW);
 						if(!shadow_blocked(kg, emission_sd, state, &light_ray, &shadow)) {
 							/* accumulate */
 							path_radiance_accum_light(L, state, tp*num_samples_inv, &L_light, shadow, num_samples_inv, is_lamp);
@@ -269,6 +272,7 @@ ccl_device void kernel_branched_path_volume_connect_light(
 				/* trace shadow ray */
 				float3 shadow;
 
+				KERNEL_STATS_RAY(kg, KERNEL_STATS_RAY_SHADOW);
 				if(!shadow_blocked(kg, emission_sd, state, &light_ray, &shadow)) {
 					/* accumulate */
 					path_radiance_accum_light(L, state, tp, &L_light, shadow, 1.0f, is_lamp);
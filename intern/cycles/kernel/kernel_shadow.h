@@ -408,6 +408,29 @@ ccl_device bool shadow_blocked_transparent_stepped(
 #  endif  /* __KERNEL_GPU__ || !__SHADOW_RECORD_ALL__ */
 #endif /* __TRANSPARENT_SHADOWS__ */
 
+/* Whether shadow_blocked() only needs an opaque intersection test for the
+ * state, without transparent surfaces, catcher objects or volumes to handle. */
+ccl_device_inline bool shadow_blocked_is_opaque(KernelGlobals *kg,
+                                                ccl_addr_space PathState *state)
+{
+#ifdef __SHADOW_TRICKS__
+	if(state->catcher_object != OBJECT_NONE) {
+		return false;
+	}
+#endif
+#ifdef __TRANSPARENT_SHADOWS__
+	if(kernel_data.integrator.transparent_shadows) {
+		return false;
+	}
+#endif
+#ifdef __VOLUME__
+	if(state->volume_stack[0].shader != SHADER_NONE) {
+		return false;
+	}
+#endif
+	return true;
+}
+
 ccl_device_inline bool shadow_blocked(KernelGlobals *kg,
                                       ShaderData *shadow_sd,
                                       ccl_addr_space PathState *state,
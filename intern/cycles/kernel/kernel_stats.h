@@ -0,0 +1,90 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __KERNEL_STATS_H__
+#define __KERNEL_STATS_H__
+
+CCL_NAMESPACE_BEGIN
+
+/* Kernel Statistics
+ *
+ * CPU kernels built with WITH_CYCLES_KERNEL_STATS count the rays traced per
+ * type, the BVH nodes visited for them, and the evaluations and CPU cycles
+ * per SVM node type. Every render thread has its own KernelGlobals, so the
+ * counters are incremented without atomics and the device merges them after
+ * each tile. In other builds the macros below expand to nothing.
+ */
+
+#ifdef __KERNEL_STATS__
+
+ccl_device_inline uint64_t kernel_stats_cycles()
+{
+#  if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#  else
+	return 0;
+#  endif
+}
+
+ccl_device_inline void kernel_stats_ray(KernelGlobals *kg, KernelStatsRayType type, int num_rays)
+{
+	kg->stats.rays[type] += num_rays;
+	kg->stats.ray_type = type;
+}
+
+ccl_device_inline void kernel_stats_bvh_node(KernelGlobals *kg)
+{
+	kg->stats.bvh_nodes[kg->stats.ray_type]++;
+}
+
+ccl_device_inline void kernel_stats_svm_begin(KernelGlobals *kg)
+{
+	kg->stats.svm_node = NODE_NUM_TYPES;
+}
+
+/* Adds the cycles since the previous node was read to that node. NODE_END
+ * is only counted, so its count is the number of shader evaluations. */
+ccl_device_inline void kernel_stats_svm_node(KernelGlobals *kg, uint type)
+{
+	KernelStats *stats = &kg->stats;
+	const uint64_t cycles = kernel_stats_cycles();
+
+	if(stats->svm_node < NODE_NUM_TYPES) {
+		stats->svm_cycles[stats->svm_node] += cycles - stats->svm_node_start;
+	}
+
+	kernel_assert(type < NODE_NUM_TYPES);
+	stats->svm_nodes[type]++;
+	stats->svm_node = (type == NODE_END)? NODE_NUM_TYPES: type;
+	stats->svm_node_start = cycles;
+}
+
+#  define KERNEL_STATS_RAY(kg, type) kernel_stats_ray(kg, type, 1)
+#  define KERNEL_STATS_RAYS(kg, type, num_rays) kernel_stats_ray(kg, type, num_rays)
+#  define KERNEL_STATS_BVH_NODE(kg) kernel_stats_bvh_node(kg)
+#  define KERNEL_STATS_SVM_BEGIN(kg) kernel_stats_svm_begin(kg)
+#  define KERNEL_STATS_SVM_NODE(kg, type) kernel_stats_svm_node(kg, type)
+#else  /* __KERNEL_STATS__ */
+#  define KERNEL_STATS_RAY(kg, type)
+#  define KERNEL_STATS_RAYS(kg, type, num_rays)
+#  define KERNEL_STATS_BVH_NODE(kg)
+#  define KERNEL_STATS_SVM_BEGIN(kg)
+#  define KERNEL_STATS_SVM_NODE(kg, type)
+#endif  /* __KERNEL_STATS__ */
+
+CCL_NAMESPACE_END
+
+#endif  /* __KERNEL_STATS_H__ */
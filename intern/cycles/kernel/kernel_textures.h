@@ -63,6 +63,10 @@ KERNEL_TEX(float4, texture_float4, __light_distribution)
 KERNEL_TEX(float4, texture_float4, __light_data)
 KERNEL_TEX(float2, texture_float2, __light_background_marginal_cdf)
 KERNEL_TEX(float2, texture_float2, __light_background_conditional_cdf)
+KERNEL_TEX(float4, texture_float4, __light_tree_nodes)
+KERNEL_TEX(uint, texture_uint, __light_tree_object_map)
+KERNEL_TEX(uint, texture_uint, __light_tree_triangle_nodes)
+KERNEL_TEX(uint, texture_uint, __light_tree_lamp_nodes)
 
 /* particles */
 KERNEL_TEX(float4, texture_float4, __particles)
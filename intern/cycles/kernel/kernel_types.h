@@ -38,6 +38,7 @@ CCL_NAMESPACE_BEGIN
 #define OBJECT_SIZE 		12
 #define OBJECT_VECTOR_SIZE	6
 #define LIGHT_SIZE		11
+#define LIGHT_TREE_NODE_SIZE	4
 #define FILTER_TABLE_SIZE	1024
 #define RAMP_TABLE_SIZE		256
 #define SHUTTER_TABLE_SIZE		256
@@ -53,6 +54,7 @@ CCL_NAMESPACE_BEGIN
 #define OBJECT_NONE				(~0)
 #define PRIM_NONE				(~0)
 #define LAMP_NONE				(~0)
+#define LIGHT_TREE_NONE			(~0)
 
 #define VOLUME_STACK_SIZE		16
 
@@ -81,9 +83,15 @@ CCL_NAMESPACE_BEGIN
 #  ifdef __KERNEL_SSE2__
 #    define __QBVH__
 #  endif
+#  ifdef __KERNEL_AVX2__
+#    define __OBVH__
+#  endif
 #  define __KERNEL_SHADING__
 #  define __KERNEL_ADV_SHADING__
 #  define __BRANCHED_PATH__
+#  ifndef __SPLIT_KERNEL__
+#    define __ADAPTIVE_SAMPLING__
+#  endif
 #  ifdef WITH_OSL
 #    define __OSL__
 #  endif
@@ -201,6 +209,11 @@ CCL_NAMESPACE_BEGIN
 #  define __KERNEL_DEBUG__
 #endif
 
+/* Ray and shading counters, only supported by the CPU kernels. */
+#if defined(WITH_CYCLES_KERNEL_STATS) && defined(__KERNEL_CPU__)
+#  define __KERNEL_STATS__
+#endif
+
 /* Scene-based selective features compilation. */
 #ifdef __NO_CAMERA_MOTION__
 #  undef __CAMERA_MOTION__
@@ -414,6 +427,9 @@ typedef enum DenoisingPassOffsets {
 	DENOISING_PASS_SIZE_CLEAN         = 3,
 } DenoisingPassOffsets;
 
+/* Adaptive sampling pass: half sample estimate (3) and pixel sample count (1). */
+#define ADAPTIVE_PASS_SIZE 4
+
 typedef enum BakePassFilter {
 	BAKE_FILTER_NONE = 0,
 	BAKE_FILTER_DIRECT = (1 << 0),
@@ -1173,7 +1189,7 @@ typedef struct KernelFilm {
 	int pass_shadow;
 	float pass_shadow_scale;
 	int filter_table_offset;
-	int pass_pad2;
+	int pass_adaptive_aux_buffer;
 
 	int pass_mist;
 	float mist_start;
@@ -1279,7 +1295,17 @@ typedef struct KernelIntegrator {
 	float light_inv_rr_threshold;
 
 	int start_sample;
-	int pad1, pad2, pad3;
+
+	/* adaptive sampling */
+	float adaptive_threshold;
+	int adaptive_min_samples;
+	int adaptive_step;
+
+	/* light tree */
+	int use_light_tree;
+	int light_tree_num_infinite;
+	float light_tree_infinite_pdf;
+	int light_tree_pad;
 } KernelIntegrator;
 static_assert_align(KernelIntegrator, 16);
 
@@ -1292,7 +1318,7 @@ typedef struct KernelBVH {
 	int have_instancing;
 	int use_qbvh;
 	int use_bvh_steps;
-	int pad1;
+	int use_obvh;
 } KernelBVH;
 static_assert_align(KernelBVH, 16);
 
@@ -1345,6 +1371,35 @@ typedef ccl_addr_space struct DebugData {
 } DebugData;
 #endif
 
+/* Kernel Statistics */
+
+typedef enum KernelStatsRayType {
+	KERNEL_STATS_RAY_CAMERA = 0,
+	KERNEL_STATS_RAY_INDIRECT,
+	KERNEL_STATS_RAY_SHADOW,
+	KERNEL_STATS_RAY_AO,
+	KERNEL_STATS_RAY_SUBSURFACE,
+	KERNEL_STATS_RAY_VOLUME,
+
+	KERNEL_STATS_NUM_RAY_TYPES
+} KernelStatsRayType;
+
+#ifdef __KERNEL_STATS__
+/* NOTE: This is a runtime-only struct, one per render thread. */
+typedef struct KernelStats {
+	uint64_t rays[KERNEL_STATS_NUM_RAY_TYPES];
+	uint64_t bvh_nodes[KERNEL_STATS_NUM_RAY_TYPES];
+	uint64_t svm_nodes[NODE_NUM_TYPES];
+	uint64_t svm_cycles[NODE_NUM_TYPES];
+
+	/* Ray being traced and SVM node being evaluated, BVH nodes and cycles
+	 * are added to these. */
+	int ray_type;
+	uint svm_node;
+	uint64_t svm_node_start;
+} KernelStats;
+#endif
+
 /* Declarations required for split kernel */
 
 /* Macro for queues */
@@ -21,8 +21,28 @@
 
 CCL_NAMESPACE_BEGIN
 
-ccl_device float4 kernel_tex_image_interp_impl(KernelGlobals *kg, int tex, float x, float y)
+/* Defined in kernel_cpu_texture_cache.cpp, returns false for images which
+ * are not in the texture cache.
+ */
+bool kernel_tex_image_cache_lookup(TextureCacheGlobals *tc,
+                                   int tex,
+                                   float x, float y,
+                                   float dsdx, float dtdx,
+                                   float dsdy, float dtdy,
+                                   float result[4]);
+
+/* Lookup with texture coordinate derivatives, used to pick the MIP level of
+ * cached images. Images in device memory have no MIP levels.
+ */
+ccl_device float4 kernel_tex_image_interp_d_impl(KernelGlobals *kg, int tex, float x, float y, float2 dx, float2 dy)
 {
+	if(UNLIKELY(kg->texture_cache != NULL)) {
+		float4 r;
+		if(kernel_tex_image_cache_lookup(kg->texture_cache, tex, x, y, dx.x, dx.y, dy.x, dy.y, (float*)&r)) {
+			return r;
+		}
+	}
+
 	switch(kernel_tex_type(tex)) {
 		case IMAGE_DATA_TYPE_HALF:
 			return kg->texture_half_images[kernel_tex_index(tex)].interp(x, y);
@@ -40,6 +60,11 @@ ccl_device float4 kernel_tex_image_interp_impl(KernelGlobals *kg, int tex, float
 	}
 }
 
+ccl_device float4 kernel_tex_image_interp_impl(KernelGlobals *kg, int tex, float x, float y)
+{
+	return kernel_tex_image_interp_d_impl(kg, tex, x, y, make_float2(0.0f, 0.0f), make_float2(0.0f, 0.0f));
+}
+
 ccl_device float4 kernel_tex_image_interp_3d_impl(KernelGlobals *kg, int tex, float x, float y, float z)
 {
 	switch(kernel_tex_type(tex)) {
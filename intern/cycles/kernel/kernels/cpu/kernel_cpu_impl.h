@@ -34,6 +34,7 @@
 #    include "kernel/kernel_film.h"
 #    include "kernel/kernel_path.h"
 #    include "kernel/kernel_path_branched.h"
+#    include "kernel/kernel_adaptive_sampling.h"
 #    include "kernel/kernel_bake.h"
 #  else
 #    include "kernel/split/kernel_split_common.h"
@@ -101,6 +102,98 @@ void KERNEL_FUNCTION_FULL_NAME(path_trace)(KernelGlobals *kg,
 #endif /* KERNEL_STUB */
 }
 
+void KERNEL_FUNCTION_FULL_NAME(path_trace_packet)(KernelGlobals *kg,
+                                                  float *buffer,
+                                                  unsigned int *rng_state,
+                                                  int sample,
+                                                  int x, int y,
+                                                  int num_pixels,
+                                                  int offset,
+                                                  int stride)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, path_trace_packet);
+#else
+#  ifdef __BRANCHED_PATH__
+	if(kernel_data.integrator.branched) {
+		for(int i = 0; i < num_pixels; i++) {
+			kernel_branched_path_trace(kg,
+			                           buffer,
+			                           rng_state,
+			                           sample,
+			                           x + i, y,
+			                           offset,
+			                           stride);
+		}
+	}
+	else
+#  endif
+	{
+		kernel_path_trace_packet(kg, buffer, rng_state, sample, x, y, num_pixels, offset, stride);
+	}
+#endif /* KERNEL_STUB */
+}
+
+/* Adaptive Sampling */
+
+void KERNEL_FUNCTION_FULL_NAME(adaptive_stopping)(KernelGlobals *kg,
+                                                  float *buffer,
+                                                  int x, int y,
+                                                  int offset,
+                                                  int stride)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, adaptive_stopping);
+#else
+	kernel_adaptive_stopping(kg, buffer, x, y, offset, stride);
+#endif /* KERNEL_STUB */
+}
+
+bool KERNEL_FUNCTION_FULL_NAME(adaptive_filter_x)(KernelGlobals *kg,
+                                                  float *buffer,
+                                                  int y,
+                                                  int x, int w,
+                                                  int offset,
+                                                  int stride)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, adaptive_filter_x);
+	return false;
+#else
+	return kernel_adaptive_filter_x(kg, buffer, y, x, w, offset, stride);
+#endif /* KERNEL_STUB */
+}
+
+bool KERNEL_FUNCTION_FULL_NAME(adaptive_filter_y)(KernelGlobals *kg,
+                                                  float *buffer,
+                                                  int x,
+                                                  int y, int h,
+                                                  int offset,
+                                                  int stride)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, adaptive_filter_y);
+	return false;
+#else
+	return kernel_adaptive_filter_y(kg, buffer, x, y, h, offset, stride);
+#endif /* KERNEL_STUB */
+}
+
+int KERNEL_FUNCTION_FULL_NAME(adaptive_adjust_samples)(KernelGlobals *kg,
+                                                       float *buffer,
+                                                       int num_samples,
+                                                       int x, int y,
+                                                       int offset,
+                                                       int stride)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, adaptive_adjust_samples);
+	return 0;
+#else
+	return kernel_adaptive_adjust_samples(kg, buffer, num_samples, x, y, offset, stride);
+#endif /* KERNEL_STUB */
+}
+
 /* Film */
 
 void KERNEL_FUNCTION_FULL_NAME(convert_to_byte)(KernelGlobals *kg,
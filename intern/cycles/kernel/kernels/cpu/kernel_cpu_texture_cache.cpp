@@ -0,0 +1,73 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Texture cache lookups, compiled once and shared by all CPU kernels. */
+
+#include "kernel/kernels/cpu/kernel_cpu_texture_cache.h"
+
+CCL_NAMESPACE_BEGIN
+
+bool kernel_tex_image_cache_lookup(TextureCacheGlobals *tc,
+                                   int tex,
+                                   float x, float y,
+                                   float dsdx, float dtdx,
+                                   float dsdy, float dtdy,
+                                   float result[4])
+{
+	if(tex < 0 || (size_t)tex >= tc->images.size()) {
+		return false;
+	}
+
+	TextureCacheImage& image = tc->images[tex];
+	if(image.handle == NULL) {
+		return false;
+	}
+
+	/* Cycles images are stored bottom to top, OIIO textures top to bottom. */
+	TextureOpt options = image.options;
+	if(!tc->ts->texture(image.handle, NULL, options,
+	                    x, 1.0f - y,
+	                    dsdx, -dtdx,
+	                    dsdy, -dtdy,
+	                    4, result))
+	{
+		/* Same as the missing image color, clear error so it does not pile up. */
+		result[0] = 1.0f;
+		result[1] = 0.0f;
+		result[2] = 1.0f;
+		result[3] = 1.0f;
+		(void)tc->ts->geterror();
+		return true;
+	}
+
+	/* The texture system always returns associated alpha, match the image
+	 * manager which keeps colors as they are when alpha is not used.
+	 */
+	if(!image.use_alpha) {
+		const float alpha = result[3];
+		if(alpha != 0.0f && alpha != 1.0f) {
+			const float inv_alpha = 1.0f / alpha;
+			result[0] *= inv_alpha;
+			result[1] *= inv_alpha;
+			result[2] *= inv_alpha;
+		}
+		result[3] = 1.0f;
+	}
+
+	return true;
+}
+
+CCL_NAMESPACE_END
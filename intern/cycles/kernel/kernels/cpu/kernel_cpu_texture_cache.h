@@ -0,0 +1,68 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __KERNEL_CPU_TEXTURE_CACHE_H__
+#define __KERNEL_CPU_TEXTURE_CACHE_H__
+
+/* On-demand texture cache for SVM image textures on the CPU.
+ *
+ * Instead of loading image files into memory in full, images are read
+ * through the OIIO texture system, which reads tiles as they are accessed,
+ * picks MIP levels from the texture coordinate derivatives and keeps the
+ * tiles in a cache of bounded size that is shared by all render threads.
+ *
+ * This header includes OIIO and must not be included from the kernels which
+ * are compiled per architecture, they only call kernel_tex_image_cache_lookup().
+ */
+
+#include <OpenImageIO/texture.h>
+
+#include "util/util_vector.h"
+
+OIIO_NAMESPACE_USING
+
+CCL_NAMESPACE_BEGIN
+
+struct TextureCacheImage {
+	TextureCacheImage()
+	: handle(NULL),
+	  use_alpha(true)
+	{
+	}
+
+	ustring filename;
+	TextureSystem::TextureHandle *handle;
+	TextureOpt options;
+	bool use_alpha;
+};
+
+struct TextureCacheGlobals {
+	TextureCacheGlobals()
+	: ts(NULL)
+	{
+	}
+
+	TextureSystem *ts;
+
+	/* Cached images, indexed by flat image slot. Slots without a handle are
+	 * loaded into device memory as usual.
+	 */
+	vector<TextureCacheImage> images;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __KERNEL_CPU_TEXTURE_CACHE_H__ */
@@ -64,6 +64,8 @@ ccl_device void kernel_scene_intersect(KernelGlobals *kg)
 		ray.t = kernel_data.background.ao_distance;
 	}
 
+	KERNEL_STATS_RAY(kg, (state.flag & PATH_RAY_CAMERA)? KERNEL_STATS_RAY_CAMERA: KERNEL_STATS_RAY_INDIRECT);
+
 #ifdef __HAIR__
 	float difl = 0.0f, extmax = 0.0f;
 	uint lcg_state = 0;
@@ -82,6 +82,7 @@ ccl_device void kernel_shadow_blocked_dl(KernelGlobals *kg)
 		/* trace shadow ray */
 		float3 shadow;
 
+		KERNEL_STATS_RAY(kg, KERNEL_STATS_RAY_SHADOW);
 		if(!shadow_blocked(kg,
 			               emission_sd,
 			               state,
@@ -194,9 +194,13 @@ ccl_device_noinline void svm_eval_nodes(KernelGlobals *kg, ShaderData *sd, ccl_a
 	float stack[SVM_STACK_SIZE];
 	int offset = sd->shader & SHADER_MASK;
 
+	KERNEL_STATS_SVM_BEGIN(kg);
+
 	while(1) {
 		uint4 node = read_node(kg, &offset);
 
+		KERNEL_STATS_SVM_NODE(kg, node.x);
+
 		switch(node.x) {
 #if NODES_GROUP(NODE_GROUP_LEVEL_0)
 			case NODE_SHADER_JUMP: {
@@ -266,7 +270,7 @@ ccl_device_noinline void svm_eval_nodes(KernelGlobals *kg, ShaderData *sd, ccl_a
 #  endif  /* NODES_FEATURE(NODE_FEATURE_BUMP) */
 #  ifdef __TEXTURES__
 			case NODE_TEX_IMAGE:
-				svm_node_tex_image(kg, sd, stack, node);
+				svm_node_tex_image(kg, sd, stack, node, &offset);
 				break;
 			case NODE_TEX_IMAGE_BOX:
 				svm_node_tex_image_box(kg, sd, stack, node);
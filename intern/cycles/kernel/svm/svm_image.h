@@ -29,10 +29,10 @@ CCL_NAMESPACE_BEGIN
 #  define TEX_NUM_FLOAT4_IMAGES	TEX_NUM_FLOAT4_OPENCL
 #endif
 
-ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, uint srgb, uint use_alpha)
+ccl_device float4 svm_image_texture_d(KernelGlobals *kg, int id, float x, float y, float2 dx, float2 dy, uint srgb, uint use_alpha)
 {
 #ifdef __KERNEL_CPU__
-	float4 r = kernel_tex_image_interp(id, x, y);
+	float4 r = kernel_tex_image_interp_d(id, x, y, dx, dy);
 #elif defined(__KERNEL_OPENCL__)
 	float4 r = kernel_tex_image_interp(kg, id, x, y);
 #else
@@ -180,34 +180,65 @@ ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y,
 	return r;
 }
 
+ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, uint srgb, uint use_alpha)
+{
+	return svm_image_texture_d(kg, id, x, y, make_float2(0.0f, 0.0f), make_float2(0.0f, 0.0f), srgb, use_alpha);
+}
+
+/* Texture coordinate derivatives from a UV map, only used on the CPU to pick
+ * the MIP level of images in the texture cache.
+ */
+ccl_device_inline void svm_image_uv_derivatives(KernelGlobals *kg, ShaderData *sd, uint attr_id, float2 *dx, float2 *dy)
+{
+#if defined(__KERNEL_CPU__) && defined(__RAY_DIFFERENTIALS__)
+	const AttributeDescriptor desc = find_attribute(kg, sd, attr_id);
+
+	if(desc.offset != ATTR_STD_NOT_FOUND && desc.type == NODE_ATTR_FLOAT3) {
+		float3 uv_dx, uv_dy;
+		primitive_attribute_float3(kg, sd, desc, &uv_dx, &uv_dy);
+		*dx = make_float2(uv_dx.x, uv_dx.y);
+		*dy = make_float2(uv_dy.x, uv_dy.y);
+	}
+#endif
+}
+
 /* Remap coordnate from 0..1 box to -1..-1 */
 ccl_device_inline float3 texco_remap_square(float3 co)
 {
 	return (co - make_float3(0.5f, 0.5f, 0.5f)) * 2.0f;
 }
 
-ccl_device void svm_node_tex_image(KernelGlobals *kg, ShaderData *sd, float *stack, uint4 node)
+ccl_device void svm_node_tex_image(KernelGlobals *kg, ShaderData *sd, float *stack, uint4 node, int *offset)
 {
 	uint id = node.y;
 	uint co_offset, out_offset, alpha_offset, srgb;
+	uint projection = node.w & ~NODE_IMAGE_DERIVATIVES;
 
 	decode_node_uchar4(node.z, &co_offset, &out_offset, &alpha_offset, &srgb);
 
 	float3 co = stack_load_float3(stack, co_offset);
 	float2 tex_co;
 	uint use_alpha = stack_valid(alpha_offset);
-	if(node.w == NODE_IMAGE_PROJ_SPHERE) {
+	if(projection == NODE_IMAGE_PROJ_SPHERE) {
 		co = texco_remap_square(co);
 		tex_co = map_to_sphere(co);
 	}
-	else if(node.w == NODE_IMAGE_PROJ_TUBE) {
+	else if(projection == NODE_IMAGE_PROJ_TUBE) {
 		co = texco_remap_square(co);
 		tex_co = map_to_tube(co);
 	}
 	else {
 		tex_co = make_float2(co.x, co.y);
 	}
-	float4 f = svm_image_texture(kg, id, tex_co.x, tex_co.y, srgb, use_alpha);
+
+	float2 tex_dx = make_float2(0.0f, 0.0f);
+	float2 tex_dy = make_float2(0.0f, 0.0f);
+	if(node.w & NODE_IMAGE_DERIVATIVES) {
+		uint4 data_node = read_node(kg, offset);
+		svm_image_uv_derivatives(kg, sd, data_node.x, &tex_dx, &tex_dy);
+	}
+
+	float4 f = svm_image_texture_d(kg, id, tex_co.x, tex_co.y, tex_dx, tex_dy, srgb, use_alpha);
 
 	if(stack_valid(out_offset))
 		stack_store_float3(stack, out_offset, make_float3(f.x, f.y, f.z));
@@ -132,6 +132,8 @@ typedef enum ShaderNodeType {
 	NODE_TEX_VOXEL,
 	NODE_ENTER_BUMP_EVAL,
 	NODE_LEAVE_BUMP_EVAL,
+
+	NODE_NUM_TYPES
 } ShaderNodeType;
 
 typedef enum NodeAttributeType {
@@ -362,6 +364,11 @@ typedef enum NodeImageProjection {
 	NODE_IMAGE_PROJ_TUBE   = 3,
 } NodeImageProjection;
 
+/* Flag on the projection of NODE_TEX_IMAGE, the next node holds the UV map
+ * attribute to take texture coordinate derivatives from.
+ */
+#define NODE_IMAGE_DERIVATIVES (1 << 8)
+
 typedef enum NodeEnvironmentProjection {
 	NODE_ENVIRONMENT_EQUIRECTANGULAR = 0,
 	NODE_ENVIRONMENT_MIRROR_BALL = 1,
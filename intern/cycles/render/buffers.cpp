@@ -44,6 +44,7 @@ BufferParams::BufferParams()
 
 	denoising_data_pass = false;
 	denoising_clean_pass = false;
+	adaptive_sampling_pass = false;
 
 	Pass::add(PASS_COMBINED, passes);
 }
@@ -77,6 +78,10 @@ int BufferParams::get_passes_size()
 		if(denoising_clean_pass) size += DENOISING_PASS_SIZE_CLEAN;
 	}
 
+	if(adaptive_sampling_pass) {
+		size += ADAPTIVE_PASS_SIZE;
+	}
+
 	return align_up(size, 4);
 }
 
@@ -282,6 +282,7 @@ NODE_DEFINE(Film)
 	SOCKET_BOOLEAN(denoising_data_pass,  "Generate Denoising Data Pass",  false);
 	SOCKET_BOOLEAN(denoising_clean_pass, "Generate Denoising Clean Pass", false);
 	SOCKET_INT(denoising_flags, "Denoising Flags", 0);
+	SOCKET_BOOLEAN(adaptive_sampling_pass, "Generate Adaptive Sampling Pass", false);
 
 	return type;
 }
@@ -455,6 +456,13 @@ void Film::device_update(Device *device, DeviceScene *dscene, Scene *scene)
 		}
 	}
 
+	/* Must be the last pass, adaptive sampling scales all passes before it. */
+	kfilm->pass_adaptive_aux_buffer = 0;
+	if(adaptive_sampling_pass) {
+		kfilm->pass_adaptive_aux_buffer = kfilm->pass_stride;
+		kfilm->pass_stride += ADAPTIVE_PASS_SIZE;
+	}
+
 	kfilm->pass_stride = align_up(kfilm->pass_stride, 4);
 	kfilm->pass_alpha_threshold = pass_alpha_threshold;
 
@@ -18,6 +18,8 @@
 #include "render/image.h"
 #include "render/scene.h"
 
+#include "kernel/kernels/cpu/kernel_cpu_texture_cache.h"
+
 #include "util/util_foreach.h"
 #include "util/util_logging.h"
 #include "util/util_path.h"
@@ -45,6 +47,7 @@ ImageManager::ImageManager(const DeviceInfo& info)
 	need_update = true;
 	pack_images = false;
 	osl_texture_system = NULL;
+	texture_cache_size = 0;
 	animation_frame = 0;
 
 	/* In case of multiple devices used we need to know type of an actual
@@ -74,6 +77,9 @@ ImageManager::ImageManager(const DeviceInfo& info)
 		has_half_images = false;
 	}
 
+	/* The texture cache is only read by the CPU kernels. */
+	texture_cache_supported = (info.type == DEVICE_CPU);
+
 	for(size_t type = 0; type < IMAGE_DATA_NUM_TYPES; type++) {
 		tex_num_images[type] = 0;
 	}
@@ -97,6 +103,33 @@ void ImageManager::set_osl_texture_system(void *texture_system)
 	osl_texture_system = texture_system;
 }
 
+void ImageManager::set_texture_cache_size(int size)
+{
+	texture_cache_size = size;
+}
+
+bool ImageManager::use_texture_cache(const Image *img)
+{
+	/* Builtin images only exist in memory, and with OSL images are read
+	 * through its own texture system already.
+	 */
+	return texture_cache_size > 0 &&
+	       texture_cache_supported &&
+	       !osl_texture_system &&
+	       !img->builtin_data;
+}
+
+bool ImageManager::is_texture_cached(int flat_slot)
+{
+	ImageDataType type;
+	int slot = flattened_slot_to_type_index(flat_slot, &type);
+
+	if(slot >= images[type].size() || !images[type][slot])
+		return false;
+
+	return use_texture_cache(images[type][slot]);
+}
+
 bool ImageManager::set_animation_frame_update(int frame)
 {
 	if(frame != animation_frame) {
@@ -720,6 +753,12 @@ void ImageManager::device_load_image(Device *device,
 	if(osl_texture_system && !img->builtin_data)
 		return;
 
+	if(use_texture_cache(img) && device->texture_cache_memory()) {
+		progress->set_status("Updating Images", "Opening " + path_filename(img->filename));
+		device_load_image_cached(device, type, slot);
+		return;
+	}
+
 	string filename = path_filename(images[type][slot]->filename);
 	progress->set_status("Updating Images", "Loading " + filename);
 
@@ -925,6 +964,9 @@ void ImageManager::device_free_image(Device *device, DeviceScene *dscene, ImageD
 			((OSL::TextureSystem*)osl_texture_system)->invalidate(filename);
 #endif
 		}
+		else if(use_texture_cache(img) && device->texture_cache_memory()) {
+			device_free_image_cached(device, type, slot);
+		}
 		else {
 			device_memory *tex_img = NULL;
 			switch(type) {
@@ -1022,6 +1064,121 @@ void ImageManager::device_prepare_update(DeviceScene *dscene)
 	}
 }
 
+/* Prefer a tiled and MIP-mapped copy of the image made with maketx, so only
+ * the tiles that are used need to be read from disk.
+ */
+static string texture_cache_filename(const string& filename)
+{
+	const string name = path_filename(filename);
+	const size_t dot = name.rfind('.');
+
+	if(dot != string::npos) {
+		const string tx_filename = path_join(path_dirname(filename), name.substr(0, dot) + ".tx");
+
+		if(tx_filename != filename && path_exists(tx_filename))
+			return tx_filename;
+	}
+
+	return filename;
+}
+
+void ImageManager::device_load_image_cached(Device *device,
+                                            ImageDataType type,
+                                            int slot)
+{
+	Image *img = images[type][slot];
+	TextureCacheGlobals *tc = (TextureCacheGlobals*)device->texture_cache_memory();
+	int flat_slot = type_index_to_flattened_slot(slot, type);
+
+	TextureOpt options;
+	switch(img->interpolation) {
+		case INTERPOLATION_CLOSEST:
+			options.interpmode = TextureOpt::InterpClosest;
+			options.mipmode = TextureOpt::MipModeNoMIP;
+			break;
+		case INTERPOLATION_CUBIC:
+			options.interpmode = TextureOpt::InterpBicubic;
+			break;
+		case INTERPOLATION_SMART:
+			options.interpmode = TextureOpt::InterpSmartBicubic;
+			break;
+		case INTERPOLATION_LINEAR:
+		default:
+			options.interpmode = TextureOpt::InterpBilinear;
+			break;
+	}
+
+	switch(img->extension) {
+		case EXTENSION_EXTEND:
+			options.swrap = options.twrap = TextureOpt::WrapClamp;
+			break;
+		case EXTENSION_CLIP:
+			options.swrap = options.twrap = TextureOpt::WrapBlack;
+			break;
+		case EXTENSION_REPEAT:
+		default:
+			options.swrap = options.twrap = TextureOpt::WrapPeriodic;
+			break;
+	}
+
+	/* Images without alpha channel are opaque. */
+	options.fill = 1.0f;
+
+	ustring filename(texture_cache_filename(img->filename));
+
+	thread_scoped_lock device_lock(device_mutex);
+
+	if(!tc->ts) {
+		/* Private cache, so the memory budget is not shared with OSL. */
+		tc->ts = TextureSystem::create(false);
+		tc->ts->attribute("automip", 1);
+		tc->ts->attribute("autotile", 64);
+		tc->ts->attribute("gray_to_rgb", 1);
+		tc->ts->attribute("max_memory_MB", (float)texture_cache_size);
+
+		VLOG(1) << "Created texture cache of " << texture_cache_size << " MB.";
+	}
+
+	if(flat_slot >= tc->images.size())
+		tc->images.resize(flat_slot + 1);
+
+	TextureCacheImage& cache_image = tc->images[flat_slot];
+	cache_image.filename = filename;
+	cache_image.handle = tc->ts->get_texture_handle(filename);
+	cache_image.options = options;
+	cache_image.use_alpha = img->use_alpha;
+
+	img->need_load = false;
+}
+
+void ImageManager::device_free_image_cached(Device *device,
+                                            ImageDataType type,
+                                            int slot)
+{
+	TextureCacheGlobals *tc = (TextureCacheGlobals*)device->texture_cache_memory();
+	int flat_slot = type_index_to_flattened_slot(slot, type);
+
+	thread_scoped_lock device_lock(device_mutex);
+
+	if(flat_slot < tc->images.size() && tc->images[flat_slot].handle) {
+		tc->ts->invalidate(tc->images[flat_slot].filename);
+		tc->images[flat_slot] = TextureCacheImage();
+	}
+}
+
+void ImageManager::device_free_texture_cache(Device *device)
+{
+	TextureCacheGlobals *tc = (TextureCacheGlobals*)device->texture_cache_memory();
+
+	if(tc && tc->ts) {
+		VLOG(1) << "Texture cache statistics:\n" << tc->ts->getstats();
+
+		TextureSystem::destroy(tc->ts);
+		tc->ts = NULL;
+		tc->images.clear();
+	}
+}
+
 void ImageManager::device_update(Device *device,
                                  DeviceScene *dscene,
                                  Scene *scene,
@@ -1263,6 +1420,8 @@ void ImageManager::device_free(Device *device, DeviceScene *dscene)
 	dscene->tex_image_float_packed.clear();
 	dscene->tex_image_byte_packed.clear();
 	dscene->tex_image_packed_info.clear();
+
+	device_free_texture_cache(device);
 }
 
 CCL_NAMESPACE_END
@@ -73,6 +73,8 @@ public:
 	void device_free_builtin(Device *device, DeviceScene *dscene);
 
 	void set_osl_texture_system(void *texture_system);
+	void set_texture_cache_size(int size);
+	bool is_texture_cached(int flat_slot);
 	void set_pack_images(bool pack_images_);
 	bool set_animation_frame_update(int frame);
 
@@ -125,6 +127,12 @@ private:
 	void *osl_texture_system;
 	bool pack_images;
 
+	/* Size of the CPU texture cache in megabytes, 0 when image files are
+	 * loaded into memory in full.
+	 */
+	int texture_cache_size;
+	bool texture_cache_supported;
+
 	bool file_load_image_generic(Image *img, ImageInput **in, int &width, int &height, int &depth, int &components);
 
 	template<TypeDesc::BASETYPE FileFormat,
@@ -153,6 +161,15 @@ private:
 	                       ImageDataType type,
 	                       int slot);
 
+	bool use_texture_cache(const Image *img);
+	void device_load_image_cached(Device *device,
+	                              ImageDataType type,
+	                              int slot);
+	void device_free_image_cached(Device *device,
+	                              ImageDataType type,
+	                              int slot);
+	void device_free_texture_cache(Device *device);
+
 	template<typename T>
 	void device_pack_images_type(
 	        ImageDataType type,
@@ -71,6 +71,11 @@ public:
 	bool sample_all_lights_direct;
 	bool sample_all_lights_indirect;
 	float light_sampling_threshold;
+	bool use_light_tree;
+
+	float adaptive_threshold;
+	int adaptive_min_samples;
+	int adaptive_step;
 
 	enum Method {
 		BRANCHED_PATH = 0,
@@ -18,18 +18,55 @@
 #include "device/device.h"
 #include "render/integrator.h"
 #include "render/film.h"
+#include "render/graph.h"
 #include "render/light.h"
+#include "render/light_tree.h"
 #include "render/mesh.h"
+#include "render/nodes.h"
 #include "render/object.h"
 #include "render/scene.h"
 #include "render/shader.h"
 
+#include "util/util_algorithm.h"
 #include "util/util_foreach.h"
 #include "util/util_progress.h"
 #include "util/util_logging.h"
+#include "util/util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
+/* Bounds, emission cone and energy of a lamp with a position. The energy is
+ * the intensity along the axis, the same measure as for triangles where it
+ * is strength times area. */
+static void light_tree_primitive(Light *light, float strength, LightTreePrimitive *prim)
+{
+	prim->inv_area = 0.0f;
+
+	if(light->type == LIGHT_AREA) {
+		float3 axisu = light->axisu*(light->sizeu*light->size);
+		float3 axisv = light->axisv*(light->sizev*light->size);
+
+		prim->bounds = BoundBox::empty;
+		prim->bounds.grow(light->co - 0.5f*axisu - 0.5f*axisv);
+		prim->bounds.grow(light->co + 0.5f*axisu - 0.5f*axisv);
+		prim->bounds.grow(light->co - 0.5f*axisu + 0.5f*axisv);
+		prim->bounds.grow(light->co + 0.5f*axisu + 0.5f*axisv);
+		prim->cone = LightTreeCone(safe_normalize(light->dir), 0.0f, M_PI_2_F);
+		prim->energy = 0.25f*strength;
+	}
+	else {
+		/* point and spot lights, optionally spheres */
+		float3 radius = make_float3(light->size, light->size, light->size);
+
+		prim->bounds = BoundBox(light->co - radius, light->co + radius);
+		if(light->type == LIGHT_SPOT)
+			prim->cone = LightTreeCone(safe_normalize(light->dir), 0.5f*light->spot_angle, 0.0f);
+		else
+			prim->cone = LightTreeCone();
+		prim->energy = 0.25f*M_1_PI_F*strength;
+	}
+}
+
 static void shade_background_pixels(Device *device, DeviceScene *dscene, int res, vector<float3>& pixels, Progress& progress)
 {
 	/* create input */
@@ -98,6 +135,28 @@ static void shade_background_pixels(Device *device, DeviceScene *dscene, int res
 	}
 }
 
+/* Rough estimate of the power emitted by a shader, used to weight emitters
+ * in the light tree. Only a constant emission node directly connected to the
+ * output is recognized, anything else is assumed to have unit strength. */
+static float shader_emission_estimate(Shader *shader)
+{
+	if(shader->graph == NULL) {
+		return 1.0f;
+	}
+
+	ShaderOutput *surface = shader->graph->output()->input("Surface")->link;
+
+	if(surface && surface->parent->type == EmissionNode::node_type) {
+		EmissionNode *emission = (EmissionNode*)surface->parent;
+
+		if(!emission->input("Color")->link && !emission->input("Strength")->link) {
+			return fabsf(average(emission->color)*emission->strength);
+		}
+	}
+
+	return 1.0f;
+}
+
 /* Light */
 
 NODE_DEFINE(Light)
@@ -174,6 +233,7 @@ LightManager::LightManager()
 {
 	need_update = true;
 	use_light_visibility = false;
+	use_light_tree = false;
 }
 
 LightManager::~LightManager()
@@ -222,6 +282,16 @@ void LightManager::disable_ineffective_light(Device *device, Scene *scene)
 	}
 }
 
+bool LightManager::need_light_tree(Scene *scene)
+{
+	/* Sampling all lights iterates over the distribution, which the tree
+	 * doesn't support. */
+	Integrator *integrator = scene->integrator;
+	return integrator->use_light_tree &&
+	       !(integrator->method == Integrator::BRANCHED_PATH &&
+	         (integrator->sample_all_lights_direct || integrator->sample_all_lights_indirect));
+}
+
 bool LightManager::object_usable_as_light(Object *object) {
 	Mesh *mesh = object->mesh;
 	/* Skip if we are not visible for BSDFs. */
@@ -294,6 +364,19 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 	float4 *distribution = dscene->light_distribution.resize(num_distribution + 1);
 	float totarea = 0.0f;
 
+	/* emitters with a position, for the light tree */
+	vector<LightTreePrimitive> tree_prims;
+	uint *tree_object_map = NULL;
+	vector<uint> tree_triangle_prims;
+
+	if(use_light_tree) {
+		tree_prims.reserve(num_distribution);
+		tree_object_map = dscene->light_tree_object_map.resize(2*scene->objects.size());
+		for(size_t i = 0; i < 2*scene->objects.size(); i++) {
+			tree_object_map[i] = LIGHT_TREE_NONE;
+		}
+	}
+
 	/* triangles */
 	size_t offset = 0;
 	int j = 0;
@@ -312,6 +395,17 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 		int object_id = j;
 		int shader_flag = 0;
 
+		vector<float> shader_strength;
+		if(use_light_tree) {
+			/* map from the triangles of the object to tree primitives */
+			tree_object_map[j*2 + 0] = tree_triangle_prims.size();
+			tree_object_map[j*2 + 1] = mesh->tri_offset;
+
+			foreach(Shader *shader, mesh->used_shaders) {
+				shader_strength.push_back(shader_emission_estimate(shader));
+			}
+		}
+
 		if(!(object->visibility & PATH_RAY_DIFFUSE)) {
 			shader_flag |= SHADER_EXCLUDE_DIFFUSE;
 			use_light_visibility = true;
@@ -335,13 +429,13 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 			Shader *shader = (shader_index < mesh->used_shaders.size())
 			                         ? mesh->used_shaders[shader_index]
 			                         : scene->default_surface;
+			uint tree_prim = LIGHT_TREE_NONE;
 
 			if(shader->use_mis && shader->has_surface_emission) {
 				distribution[offset].x = totarea;
 				distribution[offset].y = __int_as_float(i + mesh->tri_offset);
 				distribution[offset].z = __int_as_float(shader_flag);
 				distribution[offset].w = __int_as_float(object_id);
-				offset++;
 
 				Mesh::Triangle t = mesh->get_triangle(i);
 				float3 p1 = mesh->verts[t.v[0]];
@@ -354,7 +448,30 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 					p3 = transform_point(&tfm, p3);
 				}
 
-				totarea += triangle_area(p1, p2, p3);
+				float area = triangle_area(p1, p2, p3);
+				totarea += area;
+
+				if(use_light_tree) {
+					/* emission is two sided, so the cone covers all directions */
+					LightTreePrimitive prim;
+					prim.bounds = BoundBox(p1);
+					prim.bounds.grow(p2);
+					prim.bounds.grow(p3);
+					prim.energy = area*((shader_index < shader_strength.size())
+					                        ? shader_strength[shader_index]
+					                        : 1.0f);
+					prim.inv_area = (area > 0.0f)? 1.0f/area: 0.0f;
+					prim.distribution_index = offset;
+
+					tree_prim = tree_prims.size();
+					tree_prims.push_back(prim);
+				}
+
+				offset++;
+			}
+
+			if(use_light_tree) {
+				tree_triangle_prims.push_back(tree_prim);
 			}
 		}
 
@@ -367,11 +484,35 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 	float lightarea = (totarea > 0.0f) ? totarea / num_lights : 1.0f;
 	bool use_lamp_mis = false;
 
-	int light_index = 0;
+	/* Enabled lights, indexed like the light data. The light tree picks distant
+	 * and background lights separately, they go at the end of the distribution.
+	 * All lights have the same area, so the order doesn't matter otherwise. */
+	vector<Light*> lights;
+	vector<int> light_order, infinite_lights;
+
 	foreach(Light *light, scene->lights) {
 		if(!light->is_enabled)
 			continue;
 
+		if(use_light_tree && (light->type == LIGHT_DISTANT || light->type == LIGHT_BACKGROUND))
+			infinite_lights.push_back(lights.size());
+		else
+			light_order.push_back(lights.size());
+
+		lights.push_back(light);
+	}
+
+	light_order.insert(light_order.end(), infinite_lights.begin(), infinite_lights.end());
+
+	/* map from lights to tree primitives */
+	vector<uint> tree_lamp_prims;
+	if(use_light_tree) {
+		tree_lamp_prims.resize(lights.size(), LIGHT_TREE_NONE);
+	}
+
+	foreach(int light_index, light_order) {
+		Light *light = lights[light_index];
+
 		distribution[offset].x = totarea;
 		distribution[offset].y = __int_as_float(~light_index);
 		distribution[offset].z = 1.0f;
@@ -385,7 +526,16 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 			background_mis = light->use_mis;
 		}
 
-		light_index++;
+		if(use_light_tree && light->type != LIGHT_DISTANT && light->type != LIGHT_BACKGROUND) {
+			Shader *shader = (light->shader) ? light->shader : scene->default_light;
+			LightTreePrimitive prim;
+
+			light_tree_primitive(light, shader_emission_estimate(shader), &prim);
+			prim.distribution_index = offset;
+			tree_lamp_prims[light_index] = tree_prims.size();
+			tree_prims.push_back(prim);
+		}
+
 		offset++;
 	}
 
@@ -449,9 +599,24 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 		/* CDF */
 		device->tex_alloc("__light_distribution", dscene->light_distribution);
 
+		/* Light tree */
+		kintegrator->use_light_tree = use_light_tree;
+		kintegrator->light_tree_num_infinite = infinite_lights.size();
+		kintegrator->light_tree_infinite_pdf = 0.0f;
+
+		if(use_light_tree) {
+			/* distant and background lights keep the probability they have in the distribution */
+			if(tree_prims.empty())
+				kintegrator->light_tree_infinite_pdf = 1.0f;
+			else
+				kintegrator->light_tree_infinite_pdf = infinite_lights.size()*kintegrator->pdf_lights;
+
+			device_update_light_tree(device, dscene, tree_prims, tree_triangle_prims, tree_lamp_prims);
+		}
+
 		/* Portals */
 		if(num_portals > 0) {
-			kintegrator->portal_offset = light_index;
+			kintegrator->portal_offset = num_lights;
 			kintegrator->num_portals = num_portals;
 			kintegrator->portal_pdf = background_mis? 0.5f: 1.0f;
 		}
@@ -473,11 +638,64 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 		kintegrator->num_portals = 0;
 		kintegrator->portal_offset = 0;
 		kintegrator->portal_pdf = 0.0f;
+		kintegrator->use_light_tree = false;
+		kintegrator->light_tree_num_infinite = 0;
+		kintegrator->light_tree_infinite_pdf = 0.0f;
+
+		dscene->light_tree_object_map.clear();
 
 		kfilm->pass_shadow_scale = 1.0f;
 	}
 }
 
+void LightManager::device_update_light_tree(Device *device,
+                                            DeviceScene *dscene,
+                                            const vector<LightTreePrimitive>& prims,
+                                            const vector<uint>& triangle_prims,
+                                            const vector<uint>& lamp_prims)
+{
+	double time_start = time_dt();
+
+	LightTree tree(prims);
+
+	if(tree.num_nodes() > 0) {
+		float4 *nodes = dscene->light_tree_nodes.resize(tree.num_nodes()*LIGHT_TREE_NODE_SIZE);
+		tree.pack(nodes);
+
+		device->tex_alloc("__light_tree_nodes", dscene->light_tree_nodes);
+	}
+
+	/* Map triangles and lamps to their leaf nodes, for MIS. Emissive triangles
+	 * which are not in the tree can be hit too, so the maps are always needed. */
+	const vector<int>& leaf_nodes = tree.get_leaf_nodes();
+	uint *triangle_nodes = dscene->light_tree_triangle_nodes.resize(max(triangle_prims.size(), (size_t)1));
+	triangle_nodes[0] = LIGHT_TREE_NONE;
+
+	for(size_t i = 0; i < triangle_prims.size(); i++) {
+		triangle_nodes[i] = (triangle_prims[i] == LIGHT_TREE_NONE)
+		                        ? LIGHT_TREE_NONE
+		                        : leaf_nodes[triangle_prims[i]];
+	}
+
+	uint *lamp_nodes = dscene->light_tree_lamp_nodes.resize(max(lamp_prims.size(), (size_t)1));
+	lamp_nodes[0] = LIGHT_TREE_NONE;
+
+	for(size_t i = 0; i < lamp_prims.size(); i++) {
+		lamp_nodes[i] = (lamp_prims[i] == LIGHT_TREE_NONE)
+		                    ? LIGHT_TREE_NONE
+		                    : leaf_nodes[lamp_prims[i]];
+	}
+
+	if(dscene->light_tree_object_map.size() > 0) {
+		device->tex_alloc("__light_tree_object_map", dscene->light_tree_object_map);
+	}
+	device->tex_alloc("__light_tree_triangle_nodes", dscene->light_tree_triangle_nodes);
+	device->tex_alloc("__light_tree_lamp_nodes", dscene->light_tree_lamp_nodes);
+
+	VLOG(1) << "Light tree with " << tree.num_nodes() << " nodes built in "
+	        << time_dt() - time_start << " seconds.";
+}
+
 static void background_cdf(int start,
                            int end,
                            int res,
@@ -814,9 +1032,11 @@ void LightManager::device_update_points(Device *device,
 
 void LightManager::device_update(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress)
 {
-	if(!need_update)
+	if(!need_update && use_light_tree == need_light_tree(scene))
 		return;
 
+	use_light_tree = need_light_tree(scene);
+
 	VLOG(1) << "Total " << scene->lights.size() << " lights.";
 
 	device_free(device, dscene);
@@ -848,11 +1068,19 @@ void LightManager::device_free(Device *device, DeviceScene *dscene)
 	device->tex_free(dscene->light_data);
 	device->tex_free(dscene->light_background_marginal_cdf);
 	device->tex_free(dscene->light_background_conditional_cdf);
+	device->tex_free(dscene->light_tree_nodes);
+	device->tex_free(dscene->light_tree_object_map);
+	device->tex_free(dscene->light_tree_triangle_nodes);
+	device->tex_free(dscene->light_tree_lamp_nodes);
 
 	dscene->light_distribution.clear();
 	dscene->light_data.clear();
 	dscene->light_background_marginal_cdf.clear();
 	dscene->light_background_conditional_cdf.clear();
+	dscene->light_tree_nodes.clear();
+	dscene->light_tree_object_map.clear();
+	dscene->light_tree_triangle_nodes.clear();
+	dscene->light_tree_lamp_nodes.clear();
 }
 
 void LightManager::tag_update(Scene * /*scene*/)
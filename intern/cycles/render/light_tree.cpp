@@ -0,0 +1,321 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "render/light_tree.h"
+
+#include "kernel/kernel_types.h"
+
+#include "util/util_algorithm.h"
+#include "util/util_math.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Number of buckets the centroids are binned into when looking for a split. */
+#define LIGHT_TREE_NUM_BUCKETS 12
+/* Deeper than this the heuristic is skipped and primitives are split in half,
+ * which bounds the build time for large mesh lights. It doesn't bound the depth
+ * of the tree, the kernel rehashes its random number for deep trees. */
+#define LIGHT_TREE_MAX_HEURISTIC_DEPTH 32
+
+/* Light Tree Cone */
+
+float LightTreeCone::measure() const
+{
+	float theta_w = min(theta_o + theta_e, M_PI_F);
+	return M_2PI_F*(1.0f - cosf(theta_o)) +
+	       M_PI_2_F*(2.0f*theta_w*sinf(theta_o) - cosf(theta_o - 2.0f*theta_w) -
+	                 2.0f*theta_o*sinf(theta_o) + cosf(theta_o));
+}
+
+LightTreeCone merge(const LightTreeCone& cone_a, const LightTreeCone& cone_b)
+{
+	/* a is the wider cone */
+	const LightTreeCone& a = (cone_a.theta_o >= cone_b.theta_o)? cone_a: cone_b;
+	const LightTreeCone& b = (cone_a.theta_o >= cone_b.theta_o)? cone_b: cone_a;
+
+	float cos_d = dot(a.axis, b.axis);
+	float theta_d = safe_acosf(cos_d);
+	float theta_e = max(a.theta_e, b.theta_e);
+
+	if(min(theta_d + b.theta_o, M_PI_F) <= a.theta_o) {
+		return LightTreeCone(a.axis, a.theta_o, theta_e);
+	}
+
+	float theta_o = 0.5f*(a.theta_o + theta_d + b.theta_o);
+
+	if(theta_o >= M_PI_F) {
+		return LightTreeCone(a.axis, M_PI_F, theta_e);
+	}
+
+	/* Rotate the axis of a towards b, until the cone contains both. */
+	float3 ortho = b.axis - a.axis*cos_d;
+	float ortho_len = len(ortho);
+
+	if(ortho_len > 1e-6f) {
+		ortho /= ortho_len;
+	}
+	else {
+		float3 unused;
+		make_orthonormals(a.axis, &ortho, &unused);
+	}
+
+	float theta_r = theta_o - a.theta_o;
+	float3 axis = normalize(a.axis*cosf(theta_r) + ortho*sinf(theta_r));
+
+	return LightTreeCone(axis, theta_o, theta_e);
+}
+
+/* Light Tree */
+
+namespace {
+
+struct LightTreeBucket {
+	BoundBox bounds;
+	LightTreeCone cone;
+	float energy;
+	int count;
+
+	LightTreeBucket() : bounds(BoundBox::empty), energy(0.0f), count(0) {}
+
+	void add(const BoundBox& bounds_, const LightTreeCone& cone_, float energy_, int count_)
+	{
+		bounds.grow(bounds_);
+		cone = (count == 0)? cone_: merge(cone, cone_);
+		energy += energy_;
+		count += count_;
+	}
+
+	void add(const LightTreeBucket& bucket)
+	{
+		if(bucket.count > 0) {
+			add(bucket.bounds, bucket.cone, bucket.energy, bucket.count);
+		}
+	}
+
+	float cost() const
+	{
+		return energy*bounds.area()*cone.measure();
+	}
+};
+
+struct LightTreeBucketIndex {
+	const vector<LightTreePrimitive>& prims;
+	float3 centroid_min;
+	float scale;
+	int axis;
+
+	LightTreeBucketIndex(const vector<LightTreePrimitive>& prims_,
+	                     const BoundBox& centroid_bounds,
+	                     int axis_)
+	: prims(prims_), centroid_min(centroid_bounds.min), axis(axis_)
+	{
+		scale = LIGHT_TREE_NUM_BUCKETS/centroid_bounds.size()[axis];
+	}
+
+	int operator()(int index) const
+	{
+		float centroid = prims[index].bounds.center()[axis];
+		int bucket = (int)((centroid - centroid_min[axis])*scale);
+		return clamp(bucket, 0, LIGHT_TREE_NUM_BUCKETS - 1);
+	}
+};
+
+struct LightTreeBucketLess {
+	LightTreeBucketIndex bucket_index;
+	int bucket;
+
+	LightTreeBucketLess(const LightTreeBucketIndex& bucket_index_, int bucket_)
+	: bucket_index(bucket_index_), bucket(bucket_) {}
+
+	bool operator()(int index) const
+	{
+		return bucket_index(index) < bucket;
+	}
+};
+
+struct LightTreeCentroidLess {
+	const vector<LightTreePrimitive>& prims;
+	int axis;
+
+	LightTreeCentroidLess(const vector<LightTreePrimitive>& prims_, int axis_)
+	: prims(prims_), axis(axis_) {}
+
+	bool operator()(int a, int b) const
+	{
+		return prims[a].bounds.center()[axis] < prims[b].bounds.center()[axis];
+	}
+};
+
+}  /* namespace */
+
+LightTree::LightTree(const vector<LightTreePrimitive>& prims_)
+: prims(prims_)
+{
+	if(prims.empty()) {
+		return;
+	}
+
+	vector<int> indices(prims.size());
+	for(size_t i = 0; i < prims.size(); i++) {
+		indices[i] = i;
+	}
+
+	nodes.reserve(2*prims.size() - 1);
+	leaf_nodes.resize(prims.size(), -1);
+
+	build(indices, 0, prims.size(), -1, 0);
+}
+
+int LightTree::build(vector<int>& indices, int start, int end, int parent, int depth)
+{
+	Node node;
+	node.bounds = BoundBox::empty;
+	node.energy = 0.0f;
+	node.inv_area = 0.0f;
+	node.child = -1;
+	node.parent = parent;
+
+	for(int i = start; i < end; i++) {
+		const LightTreePrimitive& prim = prims[indices[i]];
+		node.bounds.grow(prim.bounds);
+		node.cone = (i == start)? prim.cone: merge(node.cone, prim.cone);
+		node.energy += prim.energy;
+	}
+
+	int index = nodes.size();
+
+	if(end - start == 1) {
+		const LightTreePrimitive& prim = prims[indices[start]];
+		node.child = ~prim.distribution_index;
+		node.inv_area = prim.inv_area;
+		nodes.push_back(node);
+		leaf_nodes[indices[start]] = index;
+		return index;
+	}
+
+	nodes.push_back(node);
+
+	int middle = split(indices, start, end, depth);
+	build(indices, start, middle, index, depth + 1);
+	nodes[index].child = build(indices, middle, end, index, depth + 1);
+
+	return index;
+}
+
+int LightTree::split(vector<int>& indices, int start, int end, int depth)
+{
+	BoundBox centroid_bounds = BoundBox::empty;
+	for(int i = start; i < end; i++) {
+		centroid_bounds.grow(prims[indices[i]].bounds.center());
+	}
+
+	float3 extent = centroid_bounds.size();
+	float max_extent = max3(extent);
+
+	/* Surface area orientation heuristic, the cost of a split is the energy
+	 * times bounding box area times cone measure of both sides. Splitting
+	 * along short axes is penalized to avoid long thin nodes. */
+	int best_axis = -1;
+	int best_bucket = 0;
+	float best_cost = FLT_MAX;
+
+	if(depth < LIGHT_TREE_MAX_HEURISTIC_DEPTH) {
+		for(int axis = 0; axis < 3; axis++) {
+			if(extent[axis] <= 0.0f) {
+				continue;
+			}
+
+			LightTreeBucketIndex bucket_index(prims, centroid_bounds, axis);
+			LightTreeBucket buckets[LIGHT_TREE_NUM_BUCKETS];
+
+			for(int i = start; i < end; i++) {
+				const LightTreePrimitive& prim = prims[indices[i]];
+				buckets[bucket_index(indices[i])].add(prim.bounds, prim.cone, prim.energy, 1);
+			}
+
+			for(int bucket = 1; bucket < LIGHT_TREE_NUM_BUCKETS; bucket++) {
+				LightTreeBucket left, right;
+				for(int i = 0; i < bucket; i++) {
+					left.add(buckets[i]);
+				}
+				for(int i = bucket; i < LIGHT_TREE_NUM_BUCKETS; i++) {
+					right.add(buckets[i]);
+				}
+
+				if(left.count == 0 || right.count == 0) {
+					continue;
+				}
+
+				float cost = (left.cost() + right.cost())*max_extent/extent[axis];
+
+				if(cost < best_cost) {
+					best_axis = axis;
+					best_bucket = bucket;
+					best_cost = cost;
+				}
+			}
+		}
+	}
+
+	if(best_axis == -1) {
+		/* Split in half, along the longest axis if the centroids differ. */
+		int middle = (start + end)/2;
+
+		if(max_extent > 0.0f) {
+			int axis = (extent.x == max_extent)? 0: (extent.y == max_extent)? 1: 2;
+			std::nth_element(indices.begin() + start,
+			                 indices.begin() + middle,
+			                 indices.begin() + end,
+			                 LightTreeCentroidLess(prims, axis));
+		}
+
+		return middle;
+	}
+
+	LightTreeBucketIndex bucket_index(prims, centroid_bounds, best_axis);
+	vector<int>::iterator middle = std::partition(indices.begin() + start,
+	                                              indices.begin() + end,
+	                                              LightTreeBucketLess(bucket_index, best_bucket));
+
+	return middle - indices.begin();
+}
+
+void LightTree::pack(float4 *data) const
+{
+	for(size_t i = 0; i < nodes.size(); i++) {
+		const Node& node = nodes[i];
+		float4 *node_data = data + i*LIGHT_TREE_NODE_SIZE;
+
+		node_data[0] = make_float4(node.bounds.min.x,
+		                           node.bounds.min.y,
+		                           node.bounds.min.z,
+		                           node.energy);
+		node_data[1] = make_float4(node.bounds.max.x,
+		                           node.bounds.max.y,
+		                           node.bounds.max.z,
+		                           __int_as_float(node.child));
+		node_data[2] = make_float4(node.cone.axis.x,
+		                           node.cone.axis.y,
+		                           node.cone.axis.z,
+		                           node.cone.theta_o);
+		node_data[3] = make_float4(node.cone.theta_e,
+		                           __int_as_float(node.parent),
+		                           node.inv_area,
+		                           0.0f);
+	}
+}
+
+CCL_NAMESPACE_END
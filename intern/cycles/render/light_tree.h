@@ -0,0 +1,101 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LIGHT_TREE_H__
+#define __LIGHT_TREE_H__
+
+#include "util/util_boundbox.h"
+#include "util/util_types.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Light Tree Cone
+ *
+ * Bounds the directions light is emitted in: all directions within theta_o
+ * of the axis, falling off until theta_e beyond that. */
+
+struct LightTreeCone {
+	float3 axis;
+	float theta_o;
+	float theta_e;
+
+	LightTreeCone()
+	: axis(make_float3(0.0f, 0.0f, 1.0f)), theta_o(M_PI_F), theta_e(M_PI_2_F) {}
+
+	LightTreeCone(const float3& axis_, float theta_o_, float theta_e_)
+	: axis(axis_), theta_o(theta_o_), theta_e(theta_e_) {}
+
+	/* Solid angle measure used by the split heuristic. */
+	float measure() const;
+};
+
+LightTreeCone merge(const LightTreeCone& a, const LightTreeCone& b);
+
+/* Light Tree Primitive
+ *
+ * Emitter with a position, a triangle or a lamp. */
+
+struct LightTreePrimitive {
+	BoundBox bounds;
+	LightTreeCone cone;
+	float energy;
+	/* Only for triangles, used for the pdf of sampled points. */
+	float inv_area;
+	/* Index in the light distribution. */
+	int distribution_index;
+};
+
+/* Light Tree
+ *
+ * Binary tree with one primitive per leaf, built with the surface area
+ * orientation heuristic. Nodes are stored depth first, so the left child
+ * of a node directly follows it. */
+
+class LightTree {
+public:
+	explicit LightTree(const vector<LightTreePrimitive>& prims);
+
+	size_t num_nodes() const { return nodes.size(); }
+
+	/* Leaf node of every primitive. */
+	const vector<int>& get_leaf_nodes() const { return leaf_nodes; }
+
+	/* Pack LIGHT_TREE_NODE_SIZE float4 per node, in the layout kernel_light.h expects. */
+	void pack(float4 *data) const;
+
+protected:
+	struct Node {
+		BoundBox bounds;
+		LightTreeCone cone;
+		float energy;
+		float inv_area;
+		/* Right child for inner nodes, ~distribution_index for leaves. */
+		int child;
+		int parent;
+	};
+
+	int build(vector<int>& indices, int start, int end, int parent, int depth);
+	int split(vector<int>& indices, int start, int end, int depth);
+
+	const vector<LightTreePrimitive>& prims;
+	vector<Node> nodes;
+	vector<int> leaf_nodes;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __LIGHT_TREE_H__ */
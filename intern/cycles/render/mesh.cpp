@@ -37,6 +37,7 @@
 #include "util/util_logging.h"
 #include "util/util_progress.h"
 #include "util/util_set.h"
+#include "util/util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -1050,9 +1051,11 @@ void Mesh::compute_bvh(DeviceScene *dscene,
 
 			BVHParams bparams;
 			bparams.use_spatial_split = params->use_bvh_spatial_split;
-			bparams.use_qbvh = params->use_qbvh;
 			bparams.use_unaligned_nodes = dscene->data.bvh.have_curves &&
 			                              params->use_bvh_unaligned_nodes;
+			/* OBVH has no unaligned nodes, fall back to QBVH for those. */
+			bparams.use_obvh = params->use_obvh && !bparams.use_unaligned_nodes;
+			bparams.use_qbvh = params->use_qbvh && !bparams.use_obvh;
 			bparams.num_motion_triangle_steps = params->num_bvh_time_steps;
 			bparams.num_motion_curve_steps = params->num_bvh_time_steps;
 
@@ -1809,28 +1812,99 @@ void MeshManager::device_update_mesh(Device *device,
 	}
 }
 
-void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress)
+bool MeshManager::can_refit_bvh(Scene *scene, const BVHParams& bparams, bool meshes_modified)
 {
-	/* bvh build */
-	progress.set_status("Updating Scene BVH", "Building");
+	if(!bvh || meshes_modified)
+		return false;
 
-	VLOG(1) << (scene->params.use_qbvh ? "Using QBVH optimization structure"
-	                                   : "Using regular BVH optimization structure");
+	if(bvh->params.use_qbvh != bparams.use_qbvh ||
+	   bvh->params.use_obvh != bparams.use_obvh ||
+	   bvh->params.use_spatial_split != bparams.use_spatial_split ||
+	   bvh->params.use_unaligned_nodes != bparams.use_unaligned_nodes ||
+	   bvh->params.num_motion_triangle_steps != bparams.num_motion_triangle_steps ||
+	   bvh->params.num_motion_curve_steps != bparams.num_motion_curve_steps)
+	{
+		return false;
+	}
+
+	/* Primitive offsets in the top level BVH depend on the order of meshes,
+	 * and object indices on the order of objects.
+	 */
+	if(bvh_meshes != scene->meshes || bvh->objects != scene->objects)
+		return false;
+
+	for(size_t i = 0; i < scene->objects.size(); i++) {
+		if(bvh_object_meshes[i] != scene->objects[i]->mesh)
+			return false;
+	}
 
+	return true;
+}
+
+void MeshManager::device_update_bvh(Device *device,
+                                    DeviceScene *dscene,
+                                    Scene *scene,
+                                    bool meshes_modified,
+                                    Progress& progress)
+{
 	BVHParams bparams;
 	bparams.top_level = true;
-	bparams.use_qbvh = scene->params.use_qbvh;
 	bparams.use_spatial_split = scene->params.use_bvh_spatial_split;
 	bparams.use_unaligned_nodes = dscene->data.bvh.have_curves &&
 	                              scene->params.use_bvh_unaligned_nodes;
+	/* Must match the choice made for the mesh BVH's in Mesh::compute_bvh(). */
+	bparams.use_obvh = scene->params.use_obvh && !bparams.use_unaligned_nodes;
+	bparams.use_qbvh = scene->params.use_qbvh && !bparams.use_obvh;
+
+	VLOG(1) << (bparams.use_obvh ? "Using OBVH optimization structure"
+	            : bparams.use_qbvh ? "Using QBVH optimization structure"
+	                               : "Using regular BVH optimization structure");
 	bparams.num_motion_triangle_steps = scene->params.num_bvh_time_steps;
 	bparams.num_motion_curve_steps = scene->params.num_bvh_time_steps;
 
-	delete bvh;
-	bvh = BVH::create(bparams, scene->objects);
-	bvh->build(progress);
+	const bool use_refit = can_refit_bvh(scene, bparams, meshes_modified);
+	double bvh_time = 0.0;
 
-	if(progress.get_cancel()) return;
+	if(use_refit) {
+		/* Only objects moved, the BVH's of instanced meshes merged into the
+		 * top level BVH are still valid and only the object level needs to
+		 * be fitted to the new object bounds.
+		 */
+		progress.set_status("Updating Scene BVH", "Refitting");
+
+		scoped_timer timer(&bvh_time);
+		bvh->refit_objects(progress);
+	}
+	else {
+		progress.set_status("Updating Scene BVH", "Building");
+
+		bvh_meshes.clear();
+		bvh_object_meshes.clear();
+
+		scoped_timer timer(&bvh_time);
+		delete bvh;
+		bvh = BVH::create(bparams, scene->objects);
+		bvh->build(progress);
+	}
+
+	if(progress.get_cancel()) {
+		/* Partially built, rebuild next time. */
+		delete bvh;
+		bvh = NULL;
+		return;
+	}
+
+	if(!use_refit) {
+		bvh_meshes = scene->meshes;
+		foreach(Object *object, scene->objects) {
+			bvh_object_meshes.push_back(object->mesh);
+		}
+	}
+
+	VLOG(1) << "Scene BVH " << (use_refit? "refitted": "built")
+	        << " for " << scene->objects.size() << " objects in "
+	        << bvh_time << " seconds.";
+	device->stats.add_stage_time("scene_bvh", bvh_time);
 
 	/* copy to device */
 	progress.set_status("Updating Scene BVH", "Copying BVH to device");
@@ -1879,7 +1953,8 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 	}
 
 	dscene->data.bvh.root = pack.root_index;
-	dscene->data.bvh.use_qbvh = scene->params.use_qbvh;
+	dscene->data.bvh.use_qbvh = bparams.use_qbvh;
+	dscene->data.bvh.use_obvh = bparams.use_obvh;
 	dscene->data.bvh.use_bvh_steps = (scene->params.num_bvh_time_steps != 0);
 }
 
@@ -2080,12 +2155,18 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 
 	/* Update bvh. */
 	size_t num_bvh = 0;
+	bool meshes_modified = false;
 	foreach(Mesh *mesh, scene->meshes) {
-		if(mesh->need_update && mesh->need_build_bvh()) {
-			num_bvh++;
+		if(mesh->need_update) {
+			meshes_modified = true;
+			if(mesh->need_build_bvh()) {
+				num_bvh++;
+			}
 		}
 	}
 
+	double mesh_bvh_time = time_dt();
+
 	TaskPool pool;
 
 	i = 0;
@@ -2108,6 +2189,10 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 	pool.wait_work(&summary);
 	VLOG(2) << "Objects BVH build pool statistics:\n"
 	        << summary.full_report();
+	mesh_bvh_time = time_dt() - mesh_bvh_time;
+	VLOG(1) << "Updated " << num_bvh << " mesh BVHs in "
+	        << mesh_bvh_time << " seconds.";
+	device->stats.add_stage_time("mesh_bvh", mesh_bvh_time);
 
 	foreach(Shader *shader, scene->shaders) {
 		shader->need_update_attributes = false;
@@ -2128,7 +2213,7 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 
 	if(progress.get_cancel()) return;
 
-	device_update_bvh(device, dscene, scene, progress);
+	device_update_bvh(device, dscene, scene, meshes_modified, progress);
 	if(progress.get_cancel()) return;
 
 	device_update_mesh(device, dscene, scene, false, progress);
@@ -34,6 +34,7 @@ CCL_NAMESPACE_BEGIN
 
 class Attribute;
 class BVH;
+class BVHParams;
 class Device;
 class DeviceScene;
 class Mesh;
@@ -360,12 +361,22 @@ protected:
 	void device_update_bvh(Device *device,
 	                       DeviceScene *dscene,
 	                       Scene *scene,
+	                       bool meshes_modified,
 	                       Progress& progress);
 
+	/* Top level BVH can be refit when only object transforms or visibility
+	 * changed since it was built.
+	 */
+	bool can_refit_bvh(Scene *scene, const BVHParams& bparams, bool meshes_modified);
+
 	void device_update_displacement_images(Device *device,
 	                                       DeviceScene *dscene,
 	                                       Scene *scene,
 	                                       Progress& progress);
+
+	/* Meshes and object meshes the top level BVH was built for. */
+	vector<Mesh*> bvh_meshes;
+	vector<Mesh*> bvh_object_meshes;
 };
 
 CCL_NAMESPACE_END
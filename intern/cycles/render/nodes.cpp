@@ -294,6 +294,34 @@ void ImageTextureNode::attributes(Shader *shader, AttributeRequestSet *attribute
 	ShaderNode::attributes(shader, attributes);
 }
 
+/* Attribute of the UV map the texture coordinates come from unmodified, to
+ * take derivatives from for MIP-mapping in the texture cache. Returns
+ * ATTR_STD_NONE for any other texture coordinates.
+ */
+static int image_texture_uv_attribute(SVMCompiler& compiler, ShaderInput *vector_in)
+{
+	ShaderOutput *link = vector_in->link;
+	if(!link) {
+		return ATTR_STD_NONE;
+	}
+
+	if(link->parent->type == TextureCoordinateNode::node_type) {
+		TextureCoordinateNode *texco = (TextureCoordinateNode*)link->parent;
+		if(link->name() == "UV" && !texco->from_dupli) {
+			return compiler.attribute(ATTR_STD_UV);
+		}
+	}
+	else if(link->parent->type == UVMapNode::node_type) {
+		UVMapNode *uvmap = (UVMapNode*)link->parent;
+		if(!uvmap->from_dupli) {
+			return (uvmap->attribute != "")? compiler.attribute(uvmap->attribute):
+			                                 compiler.attribute(ATTR_STD_UV);
+		}
+	}
+
+	return ATTR_STD_NONE;
+}
+
 void ImageTextureNode::compile(SVMCompiler& compiler)
 {
 	ShaderInput *vector_in = input("Vector");
@@ -320,6 +348,14 @@ void ImageTextureNode::compile(SVMCompiler& compiler)
 		int vector_offset = tex_mapping.compile_begin(compiler, vector_in);
 
 		if(projection != NODE_IMAGE_PROJ_BOX) {
+			int uv_attr = ATTR_STD_NONE;
+			if(projection == NODE_IMAGE_PROJ_FLAT &&
+			   tex_mapping.skip() &&
+			   image_manager->is_texture_cached(slot))
+			{
+				uv_attr = image_texture_uv_attribute(compiler, vector_in);
+			}
+
 			compiler.add_node(NODE_TEX_IMAGE,
 				slot,
 				compiler.encode_uchar4(
@@ -327,7 +363,11 @@ void ImageTextureNode::compile(SVMCompiler& compiler)
 					compiler.stack_assign_if_linked(color_out),
 					compiler.stack_assign_if_linked(alpha_out),
 					srgb),
-				projection);
+				(uv_attr != ATTR_STD_NONE)? projection | NODE_IMAGE_DERIVATIVES: projection);
+
+			if(uv_attr != ATTR_STD_NONE) {
+				compiler.add_node(uv_attr);
+			}
 		}
 		else {
 			compiler.add_node(NODE_TEX_IMAGE_BOX,
@@ -55,6 +55,7 @@ Scene::Scene(const SceneParams& params_, const DeviceInfo& device_info_)
 	object_manager = new ObjectManager();
 	integrator = new Integrator();
 	image_manager = new ImageManager(device_info_);
+	image_manager->set_texture_cache_size(params.texture_cache_size);
 	particle_system_manager = new ParticleSystemManager();
 	curve_system_manager = new CurveSystemManager();
 	bake_manager = new BakeManager();
@@ -152,7 +153,10 @@ void Scene::device_update(Device *device_, Progress& progress)
 	image_manager->set_pack_images(device->info.pack_images);
 
 	progress.set_status("Updating Shaders");
-	shader_manager->device_update(device, &dscene, this, progress);
+	{
+		scoped_stage_timer timer(device->stats, "shaders");
+		shader_manager->device_update(device, &dscene, this, progress);
+	}
 
 	if(progress.get_cancel() || device->have_error()) return;
 
@@ -172,12 +176,18 @@ void Scene::device_update(Device *device_, Progress& progress)
 	if(progress.get_cancel() || device->have_error()) return;
 
 	progress.set_status("Updating Objects");
-	object_manager->device_update(device, &dscene, this, progress);
+	{
+		scoped_stage_timer timer(device->stats, "objects");
+		object_manager->device_update(device, &dscene, this, progress);
+	}
 
 	if(progress.get_cancel() || device->have_error()) return;
 
 	progress.set_status("Updating Meshes");
-	mesh_manager->device_update(device, &dscene, this, progress);
+	{
+		scoped_stage_timer timer(device->stats, "meshes");
+		mesh_manager->device_update(device, &dscene, this, progress);
+	}
 
 	if(progress.get_cancel() || device->have_error()) return;
 
@@ -187,7 +197,10 @@ void Scene::device_update(Device *device_, Progress& progress)
 	if(progress.get_cancel() || device->have_error()) return;
 
 	progress.set_status("Updating Images");
-	image_manager->device_update(device, &dscene, this, progress);
+	{
+		scoped_stage_timer timer(device->stats, "images");
+		image_manager->device_update(device, &dscene, this, progress);
+	}
 
 	if(progress.get_cancel() || device->have_error()) return;
 
@@ -207,7 +220,10 @@ void Scene::device_update(Device *device_, Progress& progress)
 	if(progress.get_cancel() || device->have_error()) return;
 
 	progress.set_status("Updating Lights");
-	light_manager->device_update(device, &dscene, this, progress);
+	{
+		scoped_stage_timer timer(device->stats, "lights");
+		light_manager->device_update(device, &dscene, this, progress);
+	}
 
 	if(progress.get_cancel() || device->have_error()) return;
 
@@ -98,6 +98,10 @@ public:
 	device_vector<float4> light_data;
 	device_vector<float2> light_background_marginal_cdf;
 	device_vector<float2> light_background_conditional_cdf;
+	device_vector<float4> light_tree_nodes;
+	device_vector<uint> light_tree_object_map;
+	device_vector<uint> light_tree_triangle_nodes;
+	device_vector<uint> light_tree_lamp_nodes;
 
 	/* particles */
 	device_vector<float4> particles;
@@ -146,8 +150,10 @@ public:
 	bool use_bvh_unaligned_nodes;
 	int num_bvh_time_steps;
 	bool use_qbvh;
+	bool use_obvh;
 	bool persistent_data;
 	int texture_limit;
+	int texture_cache_size;
 
 	SceneParams()
 	{
@@ -157,8 +163,10 @@ public:
 		use_bvh_unaligned_nodes = true;
 		num_bvh_time_steps = 0;
 		use_qbvh = false;
+		use_obvh = false;
 		persistent_data = false;
 		texture_limit = 0;
+		texture_cache_size = 0;
 	}
 
 	bool modified(const SceneParams& params)
@@ -168,8 +176,10 @@ public:
 		&& use_bvh_unaligned_nodes == params.use_bvh_unaligned_nodes
 		&& num_bvh_time_steps == params.num_bvh_time_steps
 		&& use_qbvh == params.use_qbvh
+		&& use_obvh == params.use_obvh
 		&& persistent_data == params.persistent_data
-		&& texture_limit == params.texture_limit); }
+		&& texture_limit == params.texture_limit
+		&& texture_cache_size == params.texture_cache_size); }
 };
 
 /* Scene */
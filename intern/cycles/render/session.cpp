@@ -28,6 +28,7 @@
 #include "render/session.h"
 #include "render/bake.h"
 
+#include "util/util_atomic.h"
 #include "util/util_foreach.h"
 #include "util/util_function.h"
 #include "util/util_logging.h"
@@ -38,6 +39,22 @@
 
 CCL_NAMESPACE_BEGIN
 
+/* Number of threads which acquire tiles from the tile manager at the same time. */
+static int device_num_tile_workers(const DeviceInfo& info)
+{
+	if(info.type == DEVICE_CPU) {
+		return TaskScheduler::num_threads();
+	}
+	else if(info.type == DEVICE_MULTI) {
+		int num_workers = 0;
+		foreach(const DeviceInfo& subinfo, info.multi_devices) {
+			num_workers += device_num_tile_workers(subinfo);
+		}
+		return num_workers;
+	}
+	return 1;
+}
+
 /* Note about  preserve_tile_device option for tile manager:
  * progressive refine and viewport rendering does requires tiles to
  * always be allocated for the same device
@@ -55,6 +72,10 @@ Session::Session(const SessionParams& params_)
 
 	device = Device::create(params.device, stats, params.background);
 
+	if(params.use_split_tiles) {
+		tile_manager.set_num_workers(device_num_tile_workers(params.device));
+	}
+
 	if(params.background && params.output_path.empty()) {
 		buffers = NULL;
 		display = NULL;
@@ -69,6 +90,7 @@ Session::Session(const SessionParams& params_)
 
 	reset_time = 0.0;
 	last_update_time = 0.0;
+	num_idle_tile_workers = 0;
 
 	delayed_reset.do_reset = false;
 	delayed_reset.samples = 0;
@@ -362,16 +384,25 @@ bool Session::acquire_tile(Device *tile_device, RenderTile& rtile)
 	Tile *tile;
 	int device_num = device->device_number(tile_device);
 
-	if(!tile_manager.next_tile(tile, device_num))
-		return false;
+	while(!tile_manager.next_tile(tile, device_num)) {
+		/* Wait for a thread to hand over part of its tile instead of idling
+		 * until the end of the frame. Split tiles are taken even when cancelled,
+		 * the buffers they share are only written and freed once all are released. */
+		if(!tile_manager.wait_for_split_tiles())
+			return false;
+
+		atomic_add_and_fetch_uint32(&num_idle_tile_workers, 1);
+		tile_split_cond.wait(tile_lock);
+		atomic_sub_and_fetch_uint32(&num_idle_tile_workers, 1);
+	}
 	
 	/* fill render tile */
 	rtile.x = tile_manager.state.buffer.full_x + tile->x;
 	rtile.y = tile_manager.state.buffer.full_y + tile->y;
 	rtile.w = tile->w;
 	rtile.h = tile->h;
-	rtile.start_sample = tile_manager.state.sample;
-	rtile.num_samples = tile_manager.state.num_samples;
+	rtile.start_sample = tile_manager.state.sample + tile->sample_offset;
+	rtile.num_samples = tile_manager.state.num_samples - tile->sample_offset;
 	rtile.resolution = tile_manager.state.resolution_divider;
 	rtile.tile_index = tile->index;
 	rtile.task = (tile->state == Tile::DENOISE)? RenderTile::DENOISE: RenderTile::PATH_TRACE;
@@ -475,6 +506,36 @@ void Session::update_tile_sample(RenderTile& rtile)
 	update_status_time();
 }
 
+/* Called by devices between samples, hands part of the tile over to a thread
+ * waiting for work and shrinks rtile to the part left for the caller. */
+bool Session::split_tile(RenderTile& rtile)
+{
+	/* Called for every sample, only lock when some thread is waiting. */
+	const uint num_idle_workers = atomic_fetch_and_add_uint32(&num_idle_tile_workers, 0);
+	if(num_idle_workers == 0) {
+		return false;
+	}
+
+	thread_scoped_lock tile_lock(tile_mutex);
+
+	if(!tile_manager.split_rendering_tile(rtile.tile_index,
+	                                      rtile.sample - tile_manager.state.sample,
+	                                      (int)num_idle_tile_workers))
+	{
+		return false;
+	}
+
+	const Tile& tile = tile_manager.state.tiles[rtile.tile_index];
+	rtile.x = tile_manager.state.buffer.full_x + tile.x;
+	rtile.y = tile_manager.state.buffer.full_y + tile.y;
+	rtile.w = tile.w;
+	rtile.h = tile.h;
+
+	tile_split_cond.notify_one();
+
+	return true;
+}
+
 void Session::release_tile(RenderTile& rtile)
 {
 	thread_scoped_lock tile_lock(tile_mutex);
@@ -498,6 +559,9 @@ void Session::release_tile(RenderTile& rtile)
 		}
 	}
 
+	/* Waiting threads stop once no tile is left to split. */
+	tile_split_cond.notify_all();
+
 	update_status_time();
 }
 
@@ -739,6 +803,7 @@ void Session::load_kernels(bool lock_scene)
 		progress.set_status("Loading render kernels (may take a few minutes the first time)");
 
 		scoped_timer timer;
+		scoped_stage_timer stage_timer(stats, "load_kernels");
 
 		VLOG(2) << "Requested features:\n" << requested_features;
 		if(!device->load_kernels(requested_features)) {
@@ -772,6 +837,8 @@ void Session::run()
 	if(!progress.get_cancel()) {
 		/* reset number of rendered samples */
 		progress.reset_sample();
+		stats.reset_render_thread_times();
+		stats.reset_kernel_counters();
 
 		if(device_use_gl)
 			run_gpu();
@@ -779,6 +846,18 @@ void Session::run()
 			run_cpu();
 	}
 
+	if(progress.get_adaptive_saved_samples() > 0) {
+		VLOG(1) << "Adaptive sampling saved " << progress.get_adaptive_saved_samples()
+		        << " of " << tile_manager.state.total_pixel_samples << " pixel samples.";
+	}
+	for(size_t i = 0; i < stats.thread_idle_time.size(); i++) {
+		VLOG(1) << "Render thread " << i << " idle for "
+		        << stats.thread_idle_time[i] << " of " << stats.thread_render_time << " seconds.";
+	}
+	if(!stats.kernel_counters.empty()) {
+		VLOG(1) << "Kernel statistics:\n" << stats.kernel_counters_report();
+	}
+
 	/* progress update */
 	if(progress.get_cancel())
 		progress.set_status("Cancel", progress.get_cancel_message());
@@ -910,6 +989,7 @@ void Session::update_scene()
 		load_kernels(false);
 
 		progress.set_status("Updating Scene");
+		scoped_stage_timer stage_timer(stats, "scene_update");
 		MEM_GUARDED_CALL(&progress, scene->device_update, device, progress);
 	}
 }
@@ -947,6 +1027,19 @@ void Session::update_status_time(bool show_pause, bool show_done)
 		if(params.use_denoising) {
 			substatus += string_printf(", Denoised %d tiles", progress.get_denoised_tiles());
 		}
+		const uint64_t adaptive_saved = progress.get_adaptive_saved_samples();
+		if(adaptive_saved > 0 && tile_manager.state.total_pixel_samples > 0) {
+			substatus += string_printf(", Adaptive saved %.1f%% samples",
+			                           100.0 * adaptive_saved / tile_manager.state.total_pixel_samples);
+		}
+		if(is_cpu && rendering_finished && stats.thread_render_time > 0.0) {
+			substatus += string_printf(", Threads idle %.1f%%",
+			                           100.0 * stats.render_thread_idle_fraction());
+		}
+		if(is_cpu && rendering_finished && !stats.kernel_counters.empty()) {
+			substatus += string_printf(", Rays %s",
+			                           string_human_readable_number(stats.kernel_counter_total("rays")).c_str());
+		}
 	}
 	else if(tile_manager.num_samples == INT_MAX)
 		substatus = string_printf("Path Tracing Sample %d", progressive_sample+1);
@@ -980,7 +1073,9 @@ void Session::render()
 	task.unmap_neighbor_tiles = function_bind(&Session::unmap_neighbor_tiles, this, _1, _2);
 	task.get_cancel = function_bind(&Progress::get_cancel, &this->progress);
 	task.update_tile_sample = function_bind(&Session::update_tile_sample, this, _1);
+	task.split_tile = function_bind(&Session::split_tile, this, _1);
 	task.update_progress_sample = function_bind(&Progress::add_samples, &this->progress, _1, _2);
+	task.update_adaptive_saved_samples = function_bind(&Progress::add_adaptive_saved_samples, &this->progress, _1);
 	task.need_finish_queue = params.progressive_refine;
 	task.integrator_branched = scene->integrator->method == Integrator::BRANCHED_PATH;
 	task.requested_tile_size = params.tile_size;
@@ -1063,7 +1158,12 @@ bool Session::update_progressive_refine(bool cancel)
 void Session::device_free()
 {
 	scene->device_free();
+	device_free_buffers();
+}
 
+/* Free render buffers only, keeping the scene on the device. */
+void Session::device_free_buffers()
+{
 	foreach(RenderTile &tile, render_tiles)
 		delete tile.buffers;
 	tile_manager.free_device();
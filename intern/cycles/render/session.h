@@ -54,6 +54,7 @@ public:
 	TileOrder tile_order;
 	int start_resolution;
 	int threads;
+	bool use_split_tiles;
 
 	bool display_buffer_linear;
 
@@ -82,6 +83,7 @@ public:
 		tile_size = make_int2(64, 64);
 		start_resolution = INT_MAX;
 		threads = 0;
+		use_split_tiles = false;
 
 		use_denoising = false;
 		denoising_radius = 8;
@@ -111,6 +113,7 @@ public:
 		&& tile_size == params.tile_size
 		&& start_resolution == params.start_resolution
 		&& threads == params.threads
+		&& use_split_tiles == params.use_split_tiles
 		&& display_buffer_linear == params.display_buffer_linear
 		&& cancel_timeout == params.cancel_timeout
 		&& reset_timeout == params.reset_timeout
@@ -156,6 +159,7 @@ public:
 	void load_kernels(bool lock_scene=true);
 
 	void device_free();
+	void device_free_buffers();
 
 	/* Returns the rendering progress or 0 if no progress can be determined
 	 * (for example, when rendering with unlimited samples). */
@@ -187,6 +191,7 @@ protected:
 
 	bool acquire_tile(Device *tile_device, RenderTile& tile);
 	void update_tile_sample(RenderTile& tile);
+	bool split_tile(RenderTile& tile);
 	void release_tile(RenderTile& tile);
 
 	void map_neighbor_tiles(RenderTile *tiles, Device *tile_device);
@@ -206,6 +211,10 @@ protected:
 	thread_condition_variable pause_cond;
 	thread_mutex pause_mutex;
 	thread_mutex tile_mutex;
+	/* Threads without tile wait for a rendering tile to be split. */
+	thread_condition_variable tile_split_cond;
+	/* Changed with tile_mutex held, read without it by split_tile(). */
+	uint32_t num_idle_tile_workers;
 	thread_mutex buffers_mutex;
 	thread_mutex display_mutex;
 
@@ -21,6 +21,11 @@
 
 CCL_NAMESPACE_BEGIN
 
+/* Tiles are not split below this size. */
+#define TILE_SPLIT_MIN_SIZE 8
+/* Maximum number of tiles added by splitting per worker and frame. */
+#define TILE_SPLIT_MAX_PER_WORKER 8
+
 namespace {
 
 class TileComparator {
@@ -96,6 +101,7 @@ TileManager::TileManager(bool progressive_, int num_samples_, int2 tile_size_, i
 	start_resolution = start_resolution_;
 	num_samples = num_samples_;
 	num_devices = num_devices_;
+	num_workers = 0;
 	preserve_tile_device = preserve_tile_device_;
 	background = background_;
 	schedule_denoising = false;
@@ -144,6 +150,7 @@ void TileManager::reset(BufferParams& params_, int num_samples_)
 	state.buffer = BufferParams();
 	state.sample = range_start_sample - 1;
 	state.num_tiles = 0;
+	state.num_rendering_tiles = 0;
 	state.num_samples = 0;
 	state.resolution_divider = get_divider(params.width, params.height, start_resolution);
 	state.render_tiles.clear();
@@ -348,6 +355,13 @@ void TileManager::set_tiles()
 	int image_h = max(1, params.height/resolution);
 
 	state.num_tiles = gen_tiles(!background);
+	state.num_rendering_tiles = 0;
+
+	/* Tiles returned by next_tile() are referenced while more tiles get
+	 * split, so make sure adding them never reallocates the tiles. */
+	if(use_split_tiles()) {
+		state.tiles.reserve(state.tiles.size() + TILE_SPLIT_MAX_PER_WORKER*num_workers);
+	}
 
 	state.buffer.width = image_w;
 	state.buffer.height = image_h;
@@ -400,8 +414,20 @@ bool TileManager::finish_tile(int index, bool &delete_tile)
 	switch(state.tiles[index].state) {
 		case Tile::RENDER:
 		{
+			state.num_rendering_tiles--;
 			if(!schedule_denoising) {
-				state.tiles[index].state = Tile::DONE;
+				Tile& tile = state.tiles[index];
+				tile.state = Tile::DONE;
+				/* Buffers may be shared with tiles split off while rendering. */
+				Tile& owner = state.tiles[(tile.buffers_owner != -1)? tile.buffers_owner: index];
+				if(owner.num_buffer_users > 1) {
+					owner.num_buffer_users--;
+					tile.buffers = NULL;
+					return false;
+				}
+				if(&owner != &tile) {
+					owner.buffers = NULL;
+				}
 				delete_tile = true;
 				return true;
 			}
@@ -443,6 +469,101 @@ bool TileManager::finish_tile(int index, bool &delete_tile)
 	}
 }
 
+bool TileManager::use_split_tiles()
+{
+	/* Denoising needs the regular tile grid to find neighbors, and progressive
+	 * refine keeps the buffers of every tile between samples. */
+	return num_workers > 1 && background && !progressive && !preserve_tile_device && !schedule_denoising;
+}
+
+/* Split the largest remaining tiles in half until there are enough tiles
+ * for all workers, so threads which run out of work at the end of the frame
+ * can help with the remaining tiles instead of idling. */
+void TileManager::split_tiles(list<int>& tiles)
+{
+	while((int)tiles.size() < num_workers && state.tiles.size() < state.tiles.capacity()) {
+		list<int>::iterator largest = tiles.end();
+		int largest_size = 0;
+		for(list<int>::iterator it = tiles.begin(); it != tiles.end(); it++) {
+			const Tile& tile = state.tiles[*it];
+			const int size = max(tile.w, tile.h);
+			if(size >= 2*TILE_SPLIT_MIN_SIZE && tile.w*tile.h > largest_size) {
+				largest = it;
+				largest_size = tile.w*tile.h;
+			}
+		}
+
+		if(largest == tiles.end()) {
+			break;
+		}
+
+		/* The new tile is rendered right after the remaining half. */
+		Tile split = split_tile_in_half(state.tiles[*largest]);
+		state.tiles.push_back(split);
+		tiles.insert(++largest, split.index);
+		state.num_tiles++;
+	}
+}
+
+/* Split along the longest side, returns the second half. */
+Tile TileManager::split_tile_in_half(Tile& tile)
+{
+	Tile split = tile;
+	split.index = state.tiles.size();
+	if(tile.w >= tile.h) {
+		tile.w /= 2;
+		split.x += tile.w;
+		split.w -= tile.w;
+	}
+	else {
+		tile.h /= 2;
+		split.y += tile.h;
+		split.h -= tile.h;
+	}
+
+	if(split.buffers) {
+		if(split.buffers_owner == -1) {
+			split.buffers_owner = tile.index;
+		}
+		state.tiles[split.buffers_owner].num_buffer_users++;
+	}
+
+	return split;
+}
+
+bool TileManager::split_rendering_tile(int index, int sample_offset, int num_idle_workers)
+{
+	if(!use_split_tiles() || state.tiles.size() >= state.tiles.capacity()) {
+		return false;
+	}
+
+	/* Tiles which are waiting to be acquired already give work to idle threads. */
+	list<int>& tiles = state.render_tiles[0];
+	if(num_idle_workers <= (int)tiles.size()) {
+		return false;
+	}
+
+	Tile& tile = state.tiles[index];
+	if(tile.state != Tile::RENDER || max(tile.w, tile.h) < 2*TILE_SPLIT_MIN_SIZE ||
+	   sample_offset >= state.num_samples)
+	{
+		return false;
+	}
+
+	Tile split = split_tile_in_half(tile);
+	split.sample_offset = sample_offset;
+	state.tiles.push_back(split);
+	tiles.push_front(split.index);
+	state.num_tiles++;
+
+	return true;
+}
+
+bool TileManager::wait_for_split_tiles()
+{
+	return use_split_tiles() && state.num_rendering_tiles > 0;
+}
+
 bool TileManager::next_tile(Tile* &tile, int device)
 {
 	int logical_device = preserve_tile_device? device: 0;
@@ -460,9 +581,14 @@ bool TileManager::next_tile(Tile* &tile, int device)
 	if(state.render_tiles[logical_device].empty())
 		return false;
 
+	if(use_split_tiles()) {
+		split_tiles(state.render_tiles[logical_device]);
+	}
+
 	int idx = state.render_tiles[logical_device].front();
 	state.render_tiles[logical_device].pop_front();
 	tile = &state.tiles[idx];
+	state.num_rendering_tiles++;
 	return true;
 }
 
@@ -40,11 +40,19 @@ public:
 	State state;
 	RenderBuffers *buffers;
 
+	/* Tiles split off a tile which is being rendered share its buffers and
+	 * start at the sample it had reached. The buffers are written and freed
+	 * once the last tile rendering into them is finished. */
+	int buffers_owner;
+	int num_buffer_users;
+	int sample_offset;
+
 	Tile()
 	{}
 
 	Tile(int index_, int x_, int y_, int w_, int h_, int device_, State state_ = RENDER)
-	: index(index_), x(x_), y(y_), w(w_), h(h_), device(device_), state(state_), buffers(NULL) {}
+	: index(index_), x(x_), y(y_), w(w_), h(h_), device(device_), state(state_), buffers(NULL),
+	  buffers_owner(-1), num_buffer_users(1), sample_offset(0) {}
 };
 
 /* Tile order */
@@ -73,6 +81,8 @@ public:
 		int num_samples;
 		int resolution_divider;
 		int num_tiles;
+		/* Tiles acquired for path tracing which are not finished yet. */
+		int num_rendering_tiles;
 
 		/* Total samples over all pixels: Generally num_samples*num_pixels,
 		 * but can be higher due to the initial resolution division for previews. */
@@ -101,6 +111,17 @@ public:
 
 	void set_tile_order(TileOrder tile_order_) { tile_order = tile_order_; }
 
+	/* Number of threads acquiring tiles. When set, the last tiles of a frame
+	 * are split so no thread runs out of work while others are still busy. */
+	void set_num_workers(int num_workers_) { num_workers = num_workers_; }
+
+	/* Hand the second half of a tile which is being rendered over to one of
+	 * num_idle_workers threads waiting for a tile, the first half keeps rendering
+	 * from the same buffers. sample_offset is the number of samples already rendered. */
+	bool split_rendering_tile(int index, int sample_offset, int num_idle_workers);
+	/* Whether threads without tile should wait for a rendering tile to be split. */
+	bool wait_for_split_tiles();
+
 	/* ** Sample range rendering. ** */
 
 	/* Start sample in the range. */
@@ -123,6 +144,7 @@ protected:
 	TileOrder tile_order;
 	int start_resolution;
 	int num_devices;
+	int num_workers;
 
 	/* in some cases it is important that the same tile will be returned for the same
 	 * device it was originally generated for (i.e. viewport rendering when buffer is
@@ -146,6 +168,10 @@ protected:
 	/* Generate tile list, return number of tiles. */
 	int gen_tiles(bool sliced);
 
+	bool use_split_tiles();
+	void split_tiles(list<int>& tiles);
+	Tile split_tile_in_half(Tile& tile);
+
 	int get_neighbor_index(int index, int neighbor);
 	bool check_neighbor_state(int index, Tile::State state);
 };
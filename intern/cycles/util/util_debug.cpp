@@ -30,7 +30,9 @@ DebugFlags::CPU::CPU()
     sse3(true),
     sse2(true),
     qbvh(true),
-    split_kernel(false)
+    obvh(true),
+    split_kernel(false),
+    packet_traversal(false)
 {
 	reset();
 }
@@ -56,7 +58,9 @@ void DebugFlags::CPU::reset()
 #undef CHECK_CPU_FLAGS
 
 	qbvh = true;
+	obvh = true;
 	split_kernel = false;
+	packet_traversal = false;
 }
 
 DebugFlags::CUDA::CUDA()
@@ -142,7 +146,9 @@ std::ostream& operator <<(std::ostream &os,
 	   << "  SSE3   : " << string_from_bool(debug_flags.cpu.sse3)  << "\n"
 	   << "  SSE2   : " << string_from_bool(debug_flags.cpu.sse2)  << "\n"
 	   << "  QBVH   : " << string_from_bool(debug_flags.cpu.qbvh)  << "\n"
-	   << "  Split  : " << string_from_bool(debug_flags.cpu.split_kernel) << "\n";
+	   << "  OBVH   : " << string_from_bool(debug_flags.cpu.obvh)  << "\n"
+	   << "  Split  : " << string_from_bool(debug_flags.cpu.split_kernel) << "\n"
+	   << "  Packet : " << string_from_bool(debug_flags.cpu.packet_traversal) << "\n";
 
 	os << "CUDA flags:\n"
 	   << " Adaptive Compile: " << string_from_bool(debug_flags.cuda.adaptive_compile) << "\n";
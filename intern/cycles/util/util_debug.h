@@ -47,8 +47,15 @@ public:
 		/* Whether QBVH usage is allowed or not. */
 		bool qbvh;
 
+		/* Whether OBVH usage is allowed or not, requires AVX2. */
+		bool obvh;
+
 		/* Whether split kernel is used */
 		bool split_kernel;
+
+		/* Whether camera rays of neighbour pixels, and the shadow rays from
+		 * the surfaces they hit, are traced as a packet. */
+		bool packet_traversal;
 	};
 
 	/* Descriptor of CUDA feature-set to be used. */
@@ -36,6 +36,7 @@ public:
 	{
 		pixel_samples = 0;
 		total_pixel_samples = 0;
+		adaptive_saved_pixel_samples = 0;
 		current_tile_sample = 0;
 		rendered_tiles = 0;
 		denoised_tiles = 0;
@@ -66,6 +67,7 @@ public:
 
 		pixel_samples = progress.pixel_samples;
 		total_pixel_samples = progress.total_pixel_samples;
+		adaptive_saved_pixel_samples = progress.adaptive_saved_pixel_samples;
 		current_tile_sample = progress.get_current_sample();
 
 		return *this;
@@ -75,6 +77,7 @@ public:
 	{
 		pixel_samples = 0;
 		total_pixel_samples = 0;
+		adaptive_saved_pixel_samples = 0;
 		current_tile_sample = 0;
 		rendered_tiles = 0;
 		denoised_tiles = 0;
@@ -178,6 +181,7 @@ public:
 		thread_scoped_lock lock(progress_mutex);
 
 		pixel_samples = 0;
+		adaptive_saved_pixel_samples = 0;
 		current_tile_sample = 0;
 		rendered_tiles = 0;
 		denoised_tiles = 0;
@@ -212,6 +216,20 @@ public:
 		set_update();
 	}
 
+	void add_adaptive_saved_samples(uint64_t pixel_samples_)
+	{
+		thread_scoped_lock lock(progress_mutex);
+
+		adaptive_saved_pixel_samples += pixel_samples_;
+	}
+
+	uint64_t get_adaptive_saved_samples()
+	{
+		thread_scoped_lock lock(progress_mutex);
+
+		return adaptive_saved_pixel_samples;
+	}
+
 	void add_finished_tile(bool denoised)
 	{
 		thread_scoped_lock lock(progress_mutex);
@@ -326,6 +344,8 @@ protected:
 	 *
 	 * total_pixel_samples is the total amount of pixel samples that will be rendered. */
 	uint64_t pixel_samples, total_pixel_samples;
+	/* Pixel samples not rendered because the pixels converged early with adaptive sampling. */
+	uint64_t adaptive_saved_pixel_samples;
 	/* Stores the current sample count of the last tile that called the update function.
 	 * It's used to display the sample count if only one tile is active. */
 	int current_tile_sample;
@@ -17,7 +17,12 @@
 #ifndef __UTIL_STATS_H__
 #define __UTIL_STATS_H__
 
+#include "util/util_algorithm.h"
 #include "util/util_atomic.h"
+#include "util/util_map.h"
+#include "util/util_string.h"
+#include "util/util_time.h"
+#include "util/util_vector.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -25,7 +30,7 @@ class Stats {
 public:
 	enum static_init_t { static_init = 0 };
 
-	Stats() : mem_used(0), mem_peak(0) {}
+	Stats() : mem_used(0), mem_peak(0), thread_render_time(0.0) {}
 	explicit Stats(static_init_t) {}
 
 	void mem_alloc(size_t size) {
@@ -38,8 +43,154 @@ public:
 		atomic_sub_and_fetch_z(&mem_used, size);
 	}
 
+	/* Add the time each render thread was busy during a render task, which
+	 * took render_time in total. The rest of the time the thread was idle,
+	 * for example waiting for other threads to finish the last tiles. */
+	void add_render_thread_times(double render_time, const vector<double>& busy_times) {
+		if(thread_idle_time.size() < busy_times.size()) {
+			thread_idle_time.resize(busy_times.size(), 0.0);
+		}
+		for(size_t i = 0; i < busy_times.size(); i++) {
+			if(render_time > busy_times[i]) {
+				thread_idle_time[i] += render_time - busy_times[i];
+			}
+		}
+		thread_render_time += render_time;
+	}
+
+	void reset_render_thread_times() {
+		thread_idle_time.clear();
+		thread_render_time = 0.0;
+	}
+
+	/* Fraction of time the render threads were idle, in the 0..1 range. */
+	double render_thread_idle_fraction() const {
+		if(thread_idle_time.empty() || thread_render_time == 0.0) {
+			return 0.0;
+		}
+		double idle_time = 0.0;
+		for(size_t i = 0; i < thread_idle_time.size(); i++) {
+			idle_time += thread_idle_time[i];
+		}
+		return idle_time / (thread_render_time * thread_idle_time.size());
+	}
+
+	/* Add time spent in a named stage of scene update or rendering. Stages
+	 * are only timed from the session thread. */
+	void add_stage_time(const string& stage, double time) {
+		stage_times[stage] += time;
+	}
+
+	void reset_stage_times() {
+		stage_times.clear();
+	}
+
+	/* Add to a named counter of kernels built with WITH_CYCLES_KERNEL_STATS.
+	 * Counters are named "<group>.<item>", for example "rays.camera". */
+	void add_kernel_counter(const string& name, uint64_t count) {
+		kernel_counters[name] += count;
+	}
+
+	void reset_kernel_counters() {
+		kernel_counters.clear();
+	}
+
+	/* Sum of all counters of a group, for example the total number of rays. */
+	uint64_t kernel_counter_total(const string& group) const {
+		const string prefix = group + ".";
+		uint64_t total = 0;
+		for(map<string, uint64_t>::const_iterator it = kernel_counters.begin();
+		    it != kernel_counters.end();
+		    ++it)
+		{
+			if(string_startswith(it->first, prefix.c_str())) {
+				total += it->second;
+			}
+		}
+		return total;
+	}
+
+	/* Human readable report of the kernel counters, empty when there are none. */
+	string kernel_counters_report() const {
+		if(kernel_counters.empty()) {
+			return "";
+		}
+
+		string report = "Rays:\n";
+		for(map<string, uint64_t>::const_iterator it = kernel_counters.begin();
+		    it != kernel_counters.end();
+		    ++it)
+		{
+			if(!string_startswith(it->first, "rays.")) {
+				continue;
+			}
+			const string type = it->first.substr(5);
+			map<string, uint64_t>::const_iterator nodes = kernel_counters.find("bvh_nodes." + type);
+			const uint64_t num_nodes = (nodes != kernel_counters.end())? nodes->second: 0;
+			report += string_printf("  %-12s %14llu rays, %6.1f BVH nodes per ray\n",
+			                        type.c_str(),
+			                        (unsigned long long)it->second,
+			                        (it->second > 0)? (double)num_nodes / it->second: 0.0);
+		}
+
+		/* Shader nodes sorted by the cycles spent in them. */
+		vector<pair<uint64_t, string> > svm_nodes;
+		for(map<string, uint64_t>::const_iterator it = kernel_counters.begin();
+		    it != kernel_counters.end();
+		    ++it)
+		{
+			if(string_startswith(it->first, "svm_cycles.") && it->first != "svm_cycles.end") {
+				svm_nodes.push_back(pair<uint64_t, string>(it->second, it->first.substr(11)));
+			}
+		}
+		sort(svm_nodes.rbegin(), svm_nodes.rend());
+
+		const uint64_t total_cycles = kernel_counter_total("svm_cycles");
+		map<string, uint64_t>::const_iterator num_shaders = kernel_counters.find("svm_nodes.end");
+		report += string_printf("Shader nodes, %llu shader evaluations:\n",
+		                        (unsigned long long)((num_shaders != kernel_counters.end())? num_shaders->second: 0));
+		for(size_t i = 0; i < svm_nodes.size(); i++) {
+			map<string, uint64_t>::const_iterator count = kernel_counters.find("svm_nodes." + svm_nodes[i].second);
+			const uint64_t num_evals = (count != kernel_counters.end())? count->second: 0;
+			report += string_printf("  %-24s %14llu evaluations, %5.1f%% of cycles\n",
+			                        svm_nodes[i].second.c_str(),
+			                        (unsigned long long)num_evals,
+			                        (total_cycles > 0)? 100.0 * svm_nodes[i].first / total_cycles: 0.0);
+		}
+
+		return report;
+	}
+
 	size_t mem_used;
 	size_t mem_peak;
+
+	/* Idle time per render thread, and render time all threads took part in. */
+	vector<double> thread_idle_time;
+	double thread_render_time;
+
+	/* Accumulated time per stage, in seconds. */
+	map<string, double> stage_times;
+
+	/* Ray and shading counters, only filled by kernels with statistics. */
+	map<string, uint64_t> kernel_counters;
+};
+
+/* Adds the time until it goes out of scope to a stage of the stats. */
+
+class scoped_stage_timer {
+public:
+	scoped_stage_timer(Stats& stats, const char *stage)
+	: stats_(stats), stage_(stage), time_start_(time_dt()) {}
+
+	~scoped_stage_timer()
+	{
+		stats_.add_stage_time(stage_, time_dt() - time_start_);
+	}
+
+protected:
+	Stats& stats_;
+	const char *stage_;
+	double time_start_;
 };
 
 CCL_NAMESPACE_END
@@ -33,6 +33,18 @@
  * This class defines a generic memory cache management system
  * to limit memory usage to a fixed global maximum.
  *
+ * The global maximum is shared by all limiters which measure their
+ * elements (have a data size function). Each of them has a budget, by default
+ * an equal share of the maximum among the limiters holding elements. A limiter
+ * may use more than its share while the total stays below the maximum, once
+ * it is exceeded elements are only freed from limiters over their budget, so
+ * one cache can't push all others out. A budget set explicitly is a hard limit
+ * of the limiter, used instead of its share.
+ *
+ * Without an item priority function elements are freed in least recently
+ * used order, preferring elements which are cheap to recompute
+ * (see MEM_CacheLimiterHandle::set_cost).
+ *
  * \note Please use the C-API in MEM_CacheLimiterC-Api.h for code written in C.
  *
  * Usage example:
@@ -74,6 +86,12 @@ extern "C" {
 	size_t MEM_CacheLimiter_get_maximum();
 	void MEM_CacheLimiter_set_disabled(bool disabled);
 	bool MEM_CacheLimiter_is_disabled(void);
+	size_t MEM_CacheLimiter_get_total_memory_in_use(void);
+	void MEM_CacheLimiter_add_total_memory_in_use(size_t size);
+	void MEM_CacheLimiter_sub_total_memory_in_use(size_t size);
+	unsigned int MEM_CacheLimiter_get_limiters_in_use(void);
+	void MEM_CacheLimiter_add_limiter_in_use(void);
+	void MEM_CacheLimiter_sub_limiter_in_use(void);
 };
 #endif
 
@@ -83,6 +101,8 @@ public:
 	explicit MEM_CacheLimiterHandle(T * data_,MEM_CacheLimiter<T> *parent_) :
 		data(data_),
 		refcount(0),
+		size(0),
+		cost(0.0f),
 		parent(parent_)
 	{ }
 
@@ -106,6 +126,21 @@ public:
 		return refcount;
 	}
 
+	/* Size of the data as of the last insert or touch. */
+	size_t get_size() const {
+		return size;
+	}
+
+	/* Cost of recreating the data (any unit, as long as it's the same for
+	 * all elements of the cache, e.g. seconds), 0 when unknown. */
+	void set_cost(float cost_) {
+		cost = cost_;
+	}
+
+	float get_cost() const {
+		return cost;
+	}
+
 	bool can_destroy() const {
 		return !data || !refcount;
 	}
@@ -134,6 +169,8 @@ private:
 	T * data;
 	int refcount;
 	int pos;
+	size_t size;
+	float cost;
 	MEM_CacheLimiter<T> * parent;
 };
 
@@ -145,7 +182,11 @@ public:
 	typedef bool   (*MEM_CacheLimiter_ItemDestroyable_Func) (void *item);
 
 	MEM_CacheLimiter(MEM_CacheLimiter_DataSize_Func data_size_func)
-		: data_size_func(data_size_func) {
+		: data_size_func(data_size_func),
+		  item_priority_func(NULL),
+		  item_destroyable_func(NULL),
+		  memory_in_use(0),
+		  budget(0) {
 	}
 
 	~MEM_CacheLimiter() {
@@ -153,12 +194,17 @@ public:
 		for (i = 0; i < queue.size(); i++) {
 			delete queue[i];
 		}
+		change_memory_in_use(0, memory_in_use);
 	}
 
 	MEM_CacheLimiterHandle<T> *insert(T * elem) {
-		queue.push_back(new MEM_CacheLimiterHandle<T>(elem, this));
-		queue.back()->pos = queue.size() - 1;
-		return queue.back();
+		MEM_CacheElementPtr handle = new MEM_CacheLimiterHandle<T>(elem, this);
+		queue.push_back(handle);
+		handle->pos = queue.size() - 1;
+		if (data_size_func) {
+			update_size(handle);
+		}
+		return handle;
 	}
 
 	void unmanage(MEM_CacheLimiterHandle<T> *handle) {
@@ -166,21 +212,35 @@ public:
 		queue[pos] = queue.back();
 		queue[pos]->pos = pos;
 		queue.pop_back();
+		change_memory_in_use(0, handle->size);
 		delete handle;
 	}
 
 	size_t get_memory_in_use() {
-		size_t size = 0;
 		if (data_size_func) {
-			int i;
-			for (i = 0; i < queue.size(); i++) {
-				size += data_size_func(queue[i]->get()->get_data());
-			}
+			return memory_in_use;
 		}
-		else {
-			size = MEM_get_memory_in_use();
+		return MEM_get_memory_in_use();
+	}
+
+	/* Maximum memory used by the elements of this limiter, 0 to use a share of the
+	 * global maximum. Only used when elements are measured by a data size function. */
+	void set_budget(size_t budget) {
+		this->budget = budget;
+	}
+
+	size_t get_budget() const {
+		return budget;
+	}
+
+	/* Budget the limits are enforced with, the share of the global maximum
+	 * when no budget was set. */
+	size_t get_effective_budget() const {
+		if (budget) {
+			return budget;
 		}
-		return size;
+		unsigned int num_limiters = MEM_CacheLimiter_get_limiters_in_use();
+		return MEM_CacheLimiter_get_maximum() / (num_limiters ? num_limiters : 1);
 	}
 
 	void enforce_limits() {
@@ -192,6 +252,16 @@ public:
 			return;
 		}
 
+		if (data_size_func) {
+			while (!queue.empty() && is_over_limits(max)) {
+				MEM_CacheElementPtr elem = get_least_priority_destroyable_element();
+
+				if (!elem || !elem->destroy_if_possible())
+					break;
+			}
+			return;
+		}
+
 		if (max == 0) {
 			return;
 		}
@@ -208,25 +278,20 @@ public:
 			if (!elem)
 				break;
 
-			if (data_size_func) {
-				cur_size = data_size_func(elem->get()->get_data());
-			}
-			else {
-				cur_size = mem_in_use;
-			}
+			cur_size = mem_in_use;
 
 			if (elem->destroy_if_possible()) {
-				if (data_size_func) {
-					mem_in_use -= cur_size;
-				}
-				else {
-					mem_in_use -= cur_size - MEM_get_memory_in_use();
-				}
+				mem_in_use -= cur_size - MEM_get_memory_in_use();
 			}
 		}
 	}
 
 	void touch(MEM_CacheLimiterHandle<T> * handle) {
+		/* Data might have grown since it was inserted (mipmaps, float buffers...). */
+		if (data_size_func) {
+			update_size(handle);
+		}
+
 		/* If we're using custom priority callback re-arranging the queue
 		 * doesn't make much sense because we'll iterate it all to get
 		 * least priority element anyway.
@@ -253,6 +318,42 @@ private:
 	typedef std::vector<MEM_CacheElementPtr, MEM_Allocator<MEM_CacheElementPtr> > MEM_CacheQueue;
 	typedef typename MEM_CacheQueue::iterator iterator;
 
+	/* Number of least recently used elements compared by cost when choosing
+	 * which one to free. */
+	enum { COST_WINDOW = 16 };
+
+	void update_size(MEM_CacheElementPtr handle) {
+		size_t size = data_size_func(handle->get()->get_data());
+		change_memory_in_use(size, handle->size);
+		handle->size = size;
+	}
+
+	void change_memory_in_use(size_t add, size_t sub) {
+		const bool was_in_use = (memory_in_use != 0);
+		memory_in_use += add - sub;
+		MEM_CacheLimiter_add_total_memory_in_use(add);
+		MEM_CacheLimiter_sub_total_memory_in_use(sub);
+
+		/* count limiters holding elements, to share the global maximum between them */
+		if (was_in_use && memory_in_use == 0) {
+			MEM_CacheLimiter_sub_limiter_in_use();
+		}
+		else if (!was_in_use && memory_in_use != 0) {
+			MEM_CacheLimiter_add_limiter_in_use();
+		}
+	}
+
+	bool is_over_limits(size_t max) {
+		if (budget) {
+			return memory_in_use > budget;
+		}
+		if (max == 0 || MEM_CacheLimiter_get_total_memory_in_use() <= max) {
+			return false;
+		}
+		/* over the global maximum, leave it to the limiters using more than their share */
+		return memory_in_use > get_effective_budget();
+	}
+
 	/* Check whether element can be destroyed when enforcing cache limits */
 	bool can_destroy_element(MEM_CacheElementPtr &elem) {
 		if (!elem->can_destroy()) {
@@ -273,12 +374,24 @@ private:
 		MEM_CacheElementPtr best_match_elem = NULL;
 
 		if (!item_priority_func) {
+			/* Out of the oldest elements free the one which is cheapest to recreate
+			 * per byte. Without costs this is the least recently used element. */
+			float best_match_cost = 0.0f;
+			int tot_checked = 0;
+
 			for (iterator it = queue.begin(); it != queue.end(); it++) {
 				MEM_CacheElementPtr elem = *it;
 				if (!can_destroy_element(elem))
 					continue;
-				best_match_elem = elem;
-				break;
+
+				float cost = elem->cost / (float)(elem->size + 1);
+				if (best_match_elem == NULL || cost < best_match_cost) {
+					best_match_cost = cost;
+					best_match_elem = elem;
+				}
+
+				if (best_match_cost == 0.0f || ++tot_checked == COST_WINDOW)
+					break;
 			}
 		}
 		else {
@@ -311,6 +424,8 @@ private:
 	MEM_CacheLimiter_DataSize_Func data_size_func;
 	MEM_CacheLimiter_ItemPriority_Func item_priority_func;
 	MEM_CacheLimiter_ItemDestroyable_Func item_destroyable_func;
+	size_t memory_in_use;
+	size_t budget;
 };
 
 #endif  // __MEM_CACHELIMITER_H__
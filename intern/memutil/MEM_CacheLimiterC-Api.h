@@ -55,6 +55,12 @@ void MEM_CacheLimiter_set_maximum(size_t m);
 size_t MEM_CacheLimiter_get_maximum(void);
 void MEM_CacheLimiter_set_disabled(bool disabled);
 bool MEM_CacheLimiter_is_disabled(void);
+size_t MEM_CacheLimiter_get_total_memory_in_use(void);
+void MEM_CacheLimiter_add_total_memory_in_use(size_t size);
+void MEM_CacheLimiter_sub_total_memory_in_use(size_t size);
+unsigned int MEM_CacheLimiter_get_limiters_in_use(void);
+void MEM_CacheLimiter_add_limiter_in_use(void);
+void MEM_CacheLimiter_sub_limiter_in_use(void);
 #endif /* __MEM_CACHELIMITER_H__ */
 
 /**
@@ -139,6 +145,14 @@ void MEM_CacheLimiter_unref(MEM_CacheLimiterHandleC *handle);
 
 int MEM_CacheLimiter_get_refcount(MEM_CacheLimiterHandleC *handle);
 
+/**
+ * Get size of managed object, as measured on insert or last touch.
+ *
+ * @param handle of object
+ */
+
+size_t MEM_CacheLimiter_get_size(MEM_CacheLimiterHandleC *handle);
+
 /**
  * Get pointer to managed object
  *
@@ -155,6 +169,27 @@ void MEM_CacheLimiter_ItemDestroyable_Func_set(MEM_CacheLimiterC *This,
 
 size_t MEM_CacheLimiter_get_memory_in_use(MEM_CacheLimiterC *This);
 
+/**
+ * Set memory budget of the limiter, elements are freed whenever it is exceeded.
+ * Zero (the default) means an equal share of the global maximum among all limiters
+ * holding elements, only enforced once the global maximum is exceeded.
+ *
+ * @param This "This" pointer, budget in bytes
+ */
+
+void MEM_CacheLimiter_set_budget(MEM_CacheLimiterC *This, size_t budget);
+
+size_t MEM_CacheLimiter_get_budget(MEM_CacheLimiterC *This);
+
+/**
+ * Set cost of recreating the object, objects which are cheap to recreate
+ * (per byte) are freed first among the least recently used ones.
+ *
+ * @param handle of object, cost in any unit used consistently by the cache
+ */
+
+void MEM_CacheLimiter_set_cost(MEM_CacheLimiterHandleC *handle, float cost);
+
 #ifdef __cplusplus
 }
 #endif
@@ -29,8 +29,15 @@
 #include "MEM_CacheLimiter.h"
 #include "MEM_CacheLimiterC-Api.h"
 
+#include "atomic_ops.h"
+
 static bool is_disabled = false;
 
+/* memory used by the elements of all limiters with a data size function */
+static size_t total_memory_in_use = 0;
+/* number of those limiters which currently hold elements */
+static unsigned int limiters_in_use = 0;
+
 static size_t & get_max()
 {
 	static size_t m = 32 * 1024 * 1024;
@@ -57,6 +64,36 @@ bool MEM_CacheLimiter_is_disabled(void)
 	return is_disabled;
 }
 
+size_t MEM_CacheLimiter_get_total_memory_in_use(void)
+{
+	return total_memory_in_use;
+}
+
+void MEM_CacheLimiter_add_total_memory_in_use(size_t size)
+{
+	atomic_add_and_fetch_z(&total_memory_in_use, size);
+}
+
+void MEM_CacheLimiter_sub_total_memory_in_use(size_t size)
+{
+	atomic_sub_and_fetch_z(&total_memory_in_use, size);
+}
+
+unsigned int MEM_CacheLimiter_get_limiters_in_use(void)
+{
+	return limiters_in_use;
+}
+
+void MEM_CacheLimiter_add_limiter_in_use(void)
+{
+	atomic_add_and_fetch_u(&limiters_in_use, 1);
+}
+
+void MEM_CacheLimiter_sub_limiter_in_use(void)
+{
+	atomic_sub_and_fetch_u(&limiters_in_use, 1);
+}
+
 class MEM_CacheLimiterHandleCClass;
 class MEM_CacheLimiterCClass;
 
@@ -204,6 +241,11 @@ int MEM_CacheLimiter_get_refcount(MEM_CacheLimiterHandleC *handle)
 	return cast(handle)->get_refcount();
 }
 
+size_t MEM_CacheLimiter_get_size(MEM_CacheLimiterHandleC *handle)
+{
+	return cast(handle)->get_size();
+}
+
 void *MEM_CacheLimiter_get(MEM_CacheLimiterHandleC *handle)
 {
 	return cast(handle)->get()->get_data();
@@ -225,3 +267,18 @@ size_t MEM_CacheLimiter_get_memory_in_use(MEM_CacheLimiterC *This)
 {
 	return cast(This)->get_cache()->get_memory_in_use();
 }
+
+void MEM_CacheLimiter_set_budget(MEM_CacheLimiterC *This, size_t budget)
+{
+	cast(This)->get_cache()->set_budget(budget);
+}
+
+size_t MEM_CacheLimiter_get_budget(MEM_CacheLimiterC *This)
+{
+	return cast(This)->get_cache()->get_budget();
+}
+
+void MEM_CacheLimiter_set_cost(MEM_CacheLimiterHandleC *handle, float cost)
+{
+	cast(handle)->set_cost(cost);
+}
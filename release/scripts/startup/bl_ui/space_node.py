@@ -420,6 +420,7 @@ class NODE_PT_quality(bpy.types.Panel):
         col = layout.column()
         col.prop(tree, "render_quality", text="Render")
         col.prop(tree, "edit_quality", text="Edit")
+        col.prop(tree, "execution_mode")
         col.prop(tree, "chunk_size")
 
         col = layout.column()
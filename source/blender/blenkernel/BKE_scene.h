@@ -135,6 +135,17 @@ void  BKE_scene_frame_set(struct Scene *scene, double cfra);
 /* **  Scene evaluation ** */
 void BKE_scene_update_tagged(struct EvaluationContext *eval_ctx, struct Main *bmain, struct Scene *sce);
 void BKE_scene_update_for_newframe(struct EvaluationContext *eval_ctx, struct Main *bmain, struct Scene *sce);
+void BKE_scene_update_for_newframe_ex(struct EvaluationContext *eval_ctx, struct Main *bmain, struct Scene *sce,
+                                      const bool do_clear_recalc);
+void BKE_scene_update_for_newframe_nocallbacks(struct EvaluationContext *eval_ctx, struct Main *bmain, struct Scene *sce);
+
+/* Evaluate frames on independent copies of the scene, see scene_frames.c */
+typedef void (*SceneFrameEvaluatedFn)(void *userdata, struct Main *bmain, struct Scene *scene, double frame);
+
+bool BKE_scene_has_simulations(struct Scene *scene);
+bool BKE_scene_evaluate_frames(
+        struct Main *bmain, struct Scene *scene, const double *frames, int num_frames, int num_copies,
+        SceneFrameEvaluatedFn func, void *userdata);
 
 struct SceneRenderLayer *BKE_scene_add_render_layer(struct Scene *sce, const char *name);
 bool BKE_scene_remove_render_layer(struct Main *main, struct Scene *scene, struct SceneRenderLayer *srl);
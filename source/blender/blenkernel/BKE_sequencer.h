@@ -279,6 +279,9 @@ struct ImBuf *BKE_sequencer_cache_get(const SeqRenderData *context, struct Seque
  */
 
 void BKE_sequencer_cache_put(const SeqRenderData *context, struct Sequence *seq, float cfra, eSeqStripElemIBuf type, struct ImBuf *nval);
+/* cost: seconds it took to render the buffer, cheap buffers are freed first */
+void BKE_sequencer_cache_put_ex(const SeqRenderData *context, struct Sequence *seq, float cfra, eSeqStripElemIBuf type,
+                                struct ImBuf *nval, float cost);
 
 void BKE_sequencer_cache_cleanup_sequence(struct Sequence *seq);
 
@@ -198,6 +198,11 @@ void BKE_undo_write(bContext *C, const char *name)
 		memused = MEM_get_memory_in_use();
 		/* success = */ /* UNUSED */ BLO_write_file_mem(CTX_data_main(C), prevfile, &curundo->memfile, G.fileflags);
 		curundo->undosize = MEM_get_memory_in_use() - memused;
+
+		if (G.debug & G_DEBUG) {
+			printf("undo push '%s': %u kb new of %u kb\n",
+			       curundo->name, curundo->memfile.size / 1024, curundo->memfile.size_total / 1024);
+		}
 	}
 
 	if (U.undomemory != 0) {
@@ -303,6 +308,27 @@ bool BKE_undo_is_valid(const char *name)
 	return undobase.last != undobase.first;
 }
 
+/**
+ * Print the size of each undo step, and how much sharing chunks between steps saves.
+ */
+void BKE_undo_print_memory_stats(void)
+{
+	MemFileStats stats;
+	UndoElem *uel;
+
+	BLO_memfile_stats(&stats);
+
+	printf("\nundo memory statistics:\n");
+	for (uel = undobase.first; uel; uel = uel->next) {
+		printf("  %s%s: %u kb own, %u kb total\n",
+		       (uel == curundo) ? "* " : "  ", uel->name,
+		       uel->memfile.size / 1024, uel->memfile.size_total / 1024);
+	}
+	printf("chunks: %zu, stored: %zu kb, referenced: %zu kb (%zu kb saved by sharing)\n",
+	       stats.chunks_len, stats.size_stored / 1024, stats.size_referenced / 1024,
+	       (stats.size_referenced - stats.size_stored) / 1024);
+}
+
 /* get name of undo item, return null if no item with this index */
 /* if active pointer, set it to 1 if true */
 const char *BKE_undo_get_name(int nr, bool *r_active)
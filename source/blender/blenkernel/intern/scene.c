@@ -1548,6 +1548,16 @@ void BKE_scene_update_tagged(EvaluationContext *eval_ctx, Main *bmain, Scene *sc
 
 /* applies changes right away, does all sets too */
 void BKE_scene_update_for_newframe(EvaluationContext *eval_ctx, Main *bmain, Scene *sce)
+{
+	BKE_scene_update_for_newframe_ex(eval_ctx, bmain, sce, true);
+}
+
+/**
+ * \param do_clear_recalc: When false the recalc tags are kept, so a render engine with
+ * persistent data can see which data-blocks changed, it's up to the caller to clear them.
+ */
+void BKE_scene_update_for_newframe_ex(EvaluationContext *eval_ctx, Main *bmain, Scene *sce,
+                                      const bool do_clear_recalc)
 {
 	float ctime = BKE_scene_frame_get(sce);
 	Scene *sce_iter;
@@ -1597,6 +1607,39 @@ void BKE_scene_update_for_newframe(EvaluationContext *eval_ctx, Main *bmain, Sce
 	DEG_ids_check_recalc(bmain, sce, true);
 
 	/* clear recalc flags */
+	if (do_clear_recalc) {
+		DEG_ids_clear_recalc(bmain);
+	}
+}
+
+/**
+ * Same as #BKE_scene_update_for_newframe, but without frame change handlers,
+ * sound and editors updates. Doesn't use any global state, so it's safe to call
+ * from other threads for a Main database that isn't #G.main.
+ */
+void BKE_scene_update_for_newframe_nocallbacks(EvaluationContext *eval_ctx, Main *bmain, Scene *sce)
+{
+	float ctime = BKE_scene_frame_get(sce);
+	Scene *sce_iter;
+
+	BKE_image_update_frame(bmain, sce->r.cfra);
+
+	for (sce_iter = sce; sce_iter; sce_iter = sce_iter->set)
+		DEG_scene_relations_update(bmain, sce_iter);
+
+	BKE_mask_evaluate_all_masks(bmain, ctime, true);
+
+	BKE_cachefile_update_frame(bmain, sce, ctime, (((double)sce->r.frs_sec) / (double)sce->r.frs_sec_base));
+
+#ifdef POSE_ANIMATION_WORKAROUND
+	scene_armature_depsgraph_workaround(bmain);
+#endif
+
+	BKE_main_id_tag_idcode(bmain, ID_MA, LIB_TAG_DOIT, false);
+	BKE_main_id_tag_idcode(bmain, ID_LA, LIB_TAG_DOIT, false);
+
+	DEG_evaluate_on_framechange(eval_ctx, bmain, sce->depsgraph, ctime);
+
 	DEG_ids_clear_recalc(bmain);
 }
 
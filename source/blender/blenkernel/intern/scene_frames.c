@@ -0,0 +1,293 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2017 Blender Foundation.
+ * All rights reserved.
+ *
+ * Contributor(s): none yet.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenkernel/intern/scene_frames.c
+ *  \ingroup bke
+ *
+ * Evaluation of a range of frames for exporters.
+ *
+ * Without simulations every frame of a scene can be evaluated independently
+ * of the previous one, so frames are distributed over several copies of the
+ * Main database which are evaluated from their own threads. Copies are made by
+ * writing the database to memory and reading it back, the same way undo does.
+ * Evaluated frames are passed to the caller in order, from the calling thread.
+ */
+
+#include <stddef.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "BLI_listbase.h"
+#include "BLI_math_base.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "BKE_global.h"
+#include "BKE_main.h"
+#include "BKE_pointcache.h"
+#include "BKE_scene.h"
+
+#include "BLO_readfile.h"
+#include "BLO_undofile.h"
+#include "BLO_writefile.h"
+
+/* Copies used when the caller doesn't ask for a number, each holds the whole database. */
+#define SCENE_FRAMES_DEFAULT_COPIES 4
+
+/* G.is_break isn't notified, so the calling thread checks it this often (in milliseconds)
+ * while waiting for a frame. */
+#define SCENE_FRAMES_BREAK_INTERVAL 50
+
+typedef struct SceneFramesState {
+	const double *frames;
+	int num_frames;
+
+	ThreadMutex mutex;
+	ThreadCondition cond;
+	/* Set when the caller stopped, workers exit without evaluating further frames. */
+	bool cancel;
+} SceneFramesState;
+
+typedef struct SceneFramesCopy {
+	SceneFramesState *state;
+	BlendFileData *bfd;
+	Scene *scene;
+
+	/* Index in state->frames of the frame this copy evaluates next, or has evaluated when ready. */
+	int index;
+	/* Frame is evaluated and waits for the caller, copy must not be modified. */
+	bool ready;
+} SceneFramesCopy;
+
+/* Point caches depend on the previous frame, as do rigid bodies, so can't be evaluated out of order. */
+bool BKE_scene_has_simulations(Scene *scene)
+{
+	Scene *sce_iter;
+	Base *base;
+	bool found = false;
+
+	for (sce_iter = scene; sce_iter; sce_iter = sce_iter->set) {
+		if (sce_iter->rigidbody_world) {
+			return true;
+		}
+	}
+
+	for (SETLOOPER(scene, sce_iter, base)) {
+		ListBase pidlist;
+
+		BKE_ptcache_ids_from_object(&pidlist, base->object, sce_iter, MAX_DUPLI_RECUR);
+		found = !BLI_listbase_is_empty(&pidlist);
+		BLI_freelistN(&pidlist);
+
+		if (found) {
+			break;
+		}
+	}
+
+	return found;
+}
+
+static void *scene_frames_thread(void *data)
+{
+	SceneFramesCopy *copy = data;
+	SceneFramesState *state = copy->state;
+	Main *bmain = copy->bfd->main;
+
+	while (true) {
+		bool cancel;
+		int index;
+
+		BLI_mutex_lock(&state->mutex);
+		while (copy->ready && !state->cancel) {
+			BLI_condition_wait(&state->cond, &state->mutex);
+		}
+		cancel = state->cancel;
+		index = copy->index;
+		BLI_mutex_unlock(&state->mutex);
+
+		if (cancel || index >= state->num_frames) {
+			break;
+		}
+
+		BKE_scene_frame_set(copy->scene, state->frames[index]);
+		BKE_scene_update_for_newframe_nocallbacks(bmain->eval_ctx, bmain, copy->scene);
+
+		BLI_mutex_lock(&state->mutex);
+		copy->ready = true;
+		BLI_condition_notify_all(&state->cond);
+		BLI_mutex_unlock(&state->mutex);
+	}
+
+	return NULL;
+}
+
+static bool scene_frames_evaluate_serial(
+        Main *bmain, Scene *scene, const double *frames, int num_frames,
+        SceneFrameEvaluatedFn func, void *userdata)
+{
+	int i;
+
+	for (i = 0; i < num_frames; i++) {
+		if (G.is_break) {
+			return false;
+		}
+
+		BKE_scene_frame_set(scene, frames[i]);
+		BKE_scene_update_for_newframe(bmain->eval_ctx, bmain, scene);
+		func(userdata, bmain, scene, frames[i]);
+	}
+
+	return true;
+}
+
+/**
+ * Evaluate \a scene for every frame in \a frames and call \a func for each of
+ * them, in the given order.
+ *
+ * When possible frames are evaluated in parallel on \a num_copies copies of
+ * \a bmain, passed to \a func instead of the originals. These copies only live
+ * for the duration of the callback, data-blocks have to be looked up by name.
+ * Frame change handlers and sound aren't updated for copies, and python drivers
+ * still see the original data.
+ *
+ * Scenes with simulations, or \a num_copies below 2, are evaluated one frame after
+ * another on \a scene itself, which is left at the last frame.
+ *
+ * \param num_copies: Number of copies evaluated at the same time, 0 to use the
+ * number of threads up to #SCENE_FRAMES_DEFAULT_COPIES. Every copy holds the whole
+ * database in memory.
+ * \return false when cancelled by #G.is_break. Copies stop after the frame they
+ * are evaluating, no frames are passed to \a func anymore.
+ */
+bool BKE_scene_evaluate_frames(
+        Main *bmain, Scene *scene, const double *frames, int num_frames, int num_copies,
+        SceneFrameEvaluatedFn func, void *userdata)
+{
+	SceneFramesState state = {NULL};
+	SceneFramesCopy *copies;
+	MemFile memfile = {{NULL}};
+	ListBase threads;
+	bool success = true;
+	int i;
+
+	if (num_copies <= 0) {
+		num_copies = min_ii(BLI_system_thread_count(), SCENE_FRAMES_DEFAULT_COPIES);
+	}
+	num_copies = min_iii(num_copies, num_frames, BLENDER_MAX_THREADS);
+
+	if (num_copies < 2 || BKE_scene_has_simulations(scene)) {
+		return scene_frames_evaluate_serial(bmain, scene, frames, num_frames, func, userdata);
+	}
+
+	if (!BLO_write_file_mem(bmain, NULL, &memfile, G.fileflags)) {
+		BLO_memfile_free(&memfile);
+		return scene_frames_evaluate_serial(bmain, scene, frames, num_frames, func, userdata);
+	}
+
+	state.frames = frames;
+	state.num_frames = num_frames;
+	BLI_mutex_init(&state.mutex);
+	BLI_condition_init(&state.cond);
+
+	/* Read copies on this thread, reading isn't thread safe. An empty old main
+	 * makes linked data be read from its libraries rather than shared. */
+	copies = MEM_callocN(sizeof(*copies) * num_copies, "scene frames copies");
+	for (i = 0; i < num_copies; i++) {
+		Main *oldmain = BKE_main_new();
+		BlendFileData *bfd = BLO_read_from_memfile(oldmain, bmain->name, &memfile, NULL, BLO_READ_SKIP_USERDEF);
+		BKE_main_free(oldmain);
+
+		if (bfd == NULL) {
+			break;
+		}
+
+		copies[i].state = &state;
+		copies[i].bfd = bfd;
+		copies[i].scene = BLI_findstring(&bfd->main->scene, scene->id.name, offsetof(ID, name));
+		copies[i].index = i;
+
+		if (copies[i].scene == NULL) {
+			BLO_blendfiledata_free(bfd);
+			break;
+		}
+	}
+	BLO_memfile_free(&memfile);
+	num_copies = i;
+
+	if (num_copies == 0) {
+		success = scene_frames_evaluate_serial(bmain, scene, frames, num_frames, func, userdata);
+	}
+	else {
+		BLI_init_threads(&threads, scene_frames_thread, num_copies);
+		for (i = 0; i < num_copies; i++) {
+			BLI_insert_thread(&threads, &copies[i]);
+		}
+
+		/* Frame i is evaluated by copy i % num_copies, so while the callback runs
+		 * for one frame the other copies evaluate the frames that follow. */
+		for (i = 0; i < num_frames; i++) {
+			SceneFramesCopy *copy = &copies[i % num_copies];
+
+			BLI_mutex_lock(&state.mutex);
+			while (!copy->ready && !G.is_break) {
+				BLI_condition_wait_timeout(&state.cond, &state.mutex, SCENE_FRAMES_BREAK_INTERVAL);
+			}
+			BLI_mutex_unlock(&state.mutex);
+
+			if (G.is_break) {
+				success = false;
+				break;
+			}
+
+			func(userdata, copy->bfd->main, copy->scene, frames[i]);
+
+			BLI_mutex_lock(&state.mutex);
+			copy->index += num_copies;
+			copy->ready = false;
+			BLI_condition_notify_all(&state.cond);
+			BLI_mutex_unlock(&state.mutex);
+		}
+
+		BLI_mutex_lock(&state.mutex);
+		state.cancel = true;
+		BLI_condition_notify_all(&state.cond);
+		BLI_mutex_unlock(&state.mutex);
+
+		BLI_end_threads(&threads);
+	}
+
+	for (i = 0; i < num_copies; i++) {
+		BLO_blendfiledata_free(copies[i].bfd);
+	}
+	MEM_freeN(copies);
+
+	BLI_condition_end(&state.cond);
+	BLI_mutex_end(&state.mutex);
+
+	return success;
+}
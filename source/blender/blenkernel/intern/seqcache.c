@@ -170,6 +170,12 @@ struct ImBuf *BKE_sequencer_cache_get(const SeqRenderData *context, Sequence *se
 }
 
 void BKE_sequencer_cache_put(const SeqRenderData *context, Sequence *seq, float cfra, eSeqStripElemIBuf type, ImBuf *i)
+{
+	BKE_sequencer_cache_put_ex(context, seq, cfra, type, i, 0.0f);
+}
+
+void BKE_sequencer_cache_put_ex(const SeqRenderData *context, Sequence *seq, float cfra, eSeqStripElemIBuf type,
+                                ImBuf *i, float cost)
 {
 	SeqCacheKey key;
 
@@ -186,7 +192,7 @@ void BKE_sequencer_cache_put(const SeqRenderData *context, Sequence *seq, float
 	key.cfra = cfra - seq->start;
 	key.type = type;
 
-	IMB_moviecache_put(moviecache, &key, i);
+	IMB_moviecache_put_ex(moviecache, &key, i, cost);
 }
 
 void BKE_sequencer_preprocessed_cache_cleanup(void)
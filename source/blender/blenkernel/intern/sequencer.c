@@ -62,6 +62,8 @@
 
 #include "BLT_translation.h"
 
+#include "PIL_time.h"
+
 #include "BKE_animsys.h"
 #include "BKE_global.h"
 #include "BKE_image.h"
@@ -3586,10 +3588,12 @@ static ImBuf *seq_render_strip(
 	/* all effects are handled similarly with the exception of speed effect */
 	int type = (seq->type & SEQ_TYPE_EFFECT && seq->type != SEQ_TYPE_SPEED) ? SEQ_TYPE_EFFECT : seq->type;
 	bool is_preprocessed = !ELEM(type, SEQ_TYPE_IMAGE, SEQ_TYPE_MOVIE, SEQ_TYPE_SCENE, SEQ_TYPE_MOVIECLIP);
+	double time_start = 0.0;
 
 	ibuf = BKE_sequencer_cache_get(context, seq, cfra, SEQ_STRIPELEM_IBUF);
 
 	if (ibuf == NULL) {
+		time_start = PIL_check_seconds_timer();
 		ibuf = copy_from_ibuf_still(context, seq, nr);
 
 		if (ibuf == NULL) {
@@ -3638,7 +3642,12 @@ static ImBuf *seq_render_strip(
 	if (use_preprocess)
 		ibuf = input_preprocess(context, seq, cfra, ibuf, is_proxy_image, is_preprocessed);
 
-	BKE_sequencer_cache_put(context, seq, cfra, SEQ_STRIPELEM_IBUF, ibuf);
+	/* a buffer from the cache is already there, putting it again would only lose its cost */
+	if (time_start != 0.0 || use_preprocess) {
+		/* the cost lets the cache keep frames which are slow to render (effects, scenes) longer */
+		const float cost = (time_start != 0.0) ? (float)(PIL_check_seconds_timer() - time_start) : 0.0f;
+		BKE_sequencer_cache_put_ex(context, seq, cfra, SEQ_STRIPELEM_IBUF, ibuf, cost);
+	}
 
 	return ibuf;
 }
@@ -0,0 +1,100 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+#ifndef __BLI_FLATHASH_H__
+#define __BLI_FLATHASH_H__
+
+/** \file BLI_flathash.h
+ *  \ingroup bli
+ *
+ * Open addressing hash table with the same hash/compare callbacks as #GHash.
+ * Intended for hot lookup paths, see flathash.c for details.
+ */
+
+#include "BLI_compiler_attrs.h"
+#include "BLI_ghash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct FlatHash FlatHash;
+
+typedef struct FlatHashIterator {
+	FlatHash *fh;
+	unsigned int index;
+} FlatHashIterator;
+
+FlatHash *BLI_flathash_new_ex(GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info,
+                              const unsigned int nentries_reserve) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+FlatHash *BLI_flathash_new(GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+void   BLI_flathash_free(FlatHash *fh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp);
+void   BLI_flathash_reserve(FlatHash *fh, const unsigned int nentries_reserve);
+void   BLI_flathash_insert(FlatHash *fh, void *key, void *val);
+bool   BLI_flathash_reinsert(FlatHash *fh, void *key, void *val,
+                             GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp);
+void  *BLI_flathash_lookup(FlatHash *fh, const void *key) ATTR_WARN_UNUSED_RESULT;
+void  *BLI_flathash_lookup_default(FlatHash *fh, const void *key, void *val_default) ATTR_WARN_UNUSED_RESULT;
+void **BLI_flathash_lookup_p(FlatHash *fh, const void *key) ATTR_WARN_UNUSED_RESULT;
+bool   BLI_flathash_ensure_p(FlatHash *fh, void *key, void ***r_val) ATTR_WARN_UNUSED_RESULT;
+bool   BLI_flathash_remove(FlatHash *fh, const void *key, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp);
+void   BLI_flathash_clear(FlatHash *fh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp);
+bool   BLI_flathash_haskey(FlatHash *fh, const void *key) ATTR_WARN_UNUSED_RESULT;
+unsigned int BLI_flathash_size(FlatHash *fh) ATTR_WARN_UNUSED_RESULT;
+
+FlatHash *BLI_flathash_ptr_new_ex(const char *info,
+                                  const unsigned int nentries_reserve) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+FlatHash *BLI_flathash_ptr_new(const char *info) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+FlatHash *BLI_flathash_str_new_ex(const char *info,
+                                  const unsigned int nentries_reserve) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+FlatHash *BLI_flathash_str_new(const char *info) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+FlatHash *BLI_flathash_int_new_ex(const char *info,
+                                  const unsigned int nentries_reserve) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+FlatHash *BLI_flathash_int_new(const char *info) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+
+/* *** */
+
+void   BLI_flathashIterator_init(FlatHashIterator *fhi, FlatHash *fh);
+void   BLI_flathashIterator_step(FlatHashIterator *fhi);
+bool   BLI_flathashIterator_done(FlatHashIterator *fhi) ATTR_WARN_UNUSED_RESULT;
+void  *BLI_flathashIterator_getKey(FlatHashIterator *fhi) ATTR_WARN_UNUSED_RESULT;
+void  *BLI_flathashIterator_getValue(FlatHashIterator *fhi) ATTR_WARN_UNUSED_RESULT;
+void **BLI_flathashIterator_getValue_p(FlatHashIterator *fhi) ATTR_WARN_UNUSED_RESULT;
+
+#define FLATHASH_ITER(fh_iter_, flathash_) \
+	for (BLI_flathashIterator_init(&fh_iter_, flathash_); \
+	     BLI_flathashIterator_done(&fh_iter_) == false; \
+	     BLI_flathashIterator_step(&fh_iter_))
+
+#define FLATHASH_FOREACH_BEGIN(type, var, what) \
+	do { \
+		FlatHashIterator fh_iter##var; \
+		FLATHASH_ITER(fh_iter##var, what) { \
+			type var = (type)(BLI_flathashIterator_getValue(&fh_iter##var)); \
+
+#define FLATHASH_FOREACH_END() \
+		} \
+	} while(0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLI_FLATHASH_H__ */
@@ -0,0 +1,47 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+#ifndef __BLI_LZ4_H__
+#define __BLI_LZ4_H__
+
+/** \file BLI_lz4.h
+ *  \ingroup bli
+ *
+ * Fast compression of independent blocks, using the LZ4 block format.
+ */
+
+#include "BLI_compiler_attrs.h"
+#include "BLI_sys_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+size_t BLI_lz4_compress_bound(const size_t src_len) ATTR_WARN_UNUSED_RESULT;
+size_t BLI_lz4_compress(const void *src, const size_t src_len,
+                        void *dst, const size_t dst_len) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL();
+bool   BLI_lz4_decompress(const void *src, const size_t src_len,
+                          void *dst, const size_t dst_len) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __BLI_LZ4_H__ */
@@ -82,6 +82,16 @@ enum {
 	 * \note order of iteration is only assured to be the order of allocation when no chunks have been freed.
 	 */
 	BLI_MEMPOOL_ALLOW_ITER = (1 << 0),
+	/** allow allocating and freeing elements from multiple threads at once.
+	 *
+	 * Each thread keeps a small cache of free elements which is refilled from
+	 * (and returned to) the shared pool in batches, so the shared lock is only
+	 * taken once per batch.
+	 *
+	 * \note all other functions (iteration, clearing, counting...) must not run
+	 * while elements are being allocated or freed from other threads.
+	 */
+	BLI_MEMPOOL_THREADSAFE = (1 << 1),
 };
 
 void  BLI_mempool_iternew(BLI_mempool *pool, BLI_mempool_iter *iter) ATTR_NONNULL();
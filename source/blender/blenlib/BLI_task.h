@@ -37,8 +37,10 @@ extern "C" {
 
 /* Task Scheduler
  * 
- * Central scheduler that holds running threads ready to execute tasks. A single
- * queue holds the task from all pools.
+ * Central scheduler that holds running threads ready to execute tasks. Each
+ * thread has its own queue of tasks it pushed, idle threads steal tasks from
+ * queues of other threads. Tasks pushed from outside of scheduler's threads are
+ * held by a global queue.
  *
  * Init/exit must be called before/after any task pools are created/freed, and
  * must be called from the main threads. All other scheduler and pool functions
@@ -52,6 +54,10 @@ enum {
 };
 
 TaskScheduler *BLI_task_scheduler_create(int num_threads);
+/* Without work stealing each thread only keeps a single task it pushed, which
+ * no other thread takes, everything else goes to the global queue. This is how
+ * the scheduler worked before thread queues, only meant for benchmarks. */
+TaskScheduler *BLI_task_scheduler_create_ex(int num_threads, const bool use_work_stealing);
 void BLI_task_scheduler_free(TaskScheduler *scheduler);
 
 int BLI_task_scheduler_num_threads(TaskScheduler *scheduler);
@@ -106,9 +112,9 @@ void *BLI_task_pool_userdata(TaskPool *pool);
 /* optional mutex to use from run function */
 ThreadMutex *BLI_task_pool_user_mutex(TaskPool *pool);
 
-/* Delayed push, use that to reduce thread overhead by accumulating
- * all new tasks into local queue first and pushing it to scheduler
- * from within a single mutex lock.
+/* Delayed push, use that to reduce thread overhead by pushing all
+ * new tasks to the thread's queue first and waking up sleeping threads
+ * only once all of them are pushed.
  */
 void BLI_task_pool_delayed_push_begin(TaskPool *pool, int thread_id);
 void BLI_task_pool_delayed_push_end(TaskPool *pool, int thread_id);
@@ -36,17 +36,27 @@
  * - Freeing chunks.
  * - Iterating over allocated chunks
  *   (optionally when using the #BLI_MEMPOOL_ALLOW_ITER flag).
+ * - Allocating and freeing from multiple threads
+ *   (optionally when using the #BLI_MEMPOOL_THREADSAFE flag).
+ *
+ * Thread-safe pools give every thread a slot in a small array of free-list caches.
+ * Allocation and freeing only touch the slot of the calling thread, the shared
+ * free list is locked once per #MEMPOOL_THREAD_BATCH elements to refill or drain a cache.
+ * Cached elements keep their #FREEWORD, so iteration skips them like any other free element.
  */
 
 #include <string.h>
 #include <stdlib.h>
 
 #include "BLI_utildefines.h"
+#include "BLI_threads.h"
 
 #include "BLI_mempool.h" /* own include */
 
 #include "MEM_guardedalloc.h"
 
+#include "atomic_ops.h"
+
 #include "BLI_strict_flags.h"  /* keep last */
 
 #ifdef WITH_MEM_VALGRIND
@@ -92,6 +102,21 @@
 #define USE_CHUNK_POW2
 
 
+/* number of per-thread caches of a #BLI_MEMPOOL_THREADSAFE pool, must be a power of 2.
+ * Threads beyond this share caches, which stays correct since each cache has its own lock. */
+#define MEMPOOL_THREAD_CACHE_NUM 64
+/* number of elements moved between a thread cache and the shared free list at once */
+#define MEMPOOL_THREAD_BATCH 32
+
+#ifdef BLI_MEMPOOL_NO_THREADS
+/* bf_dna_blenlib (linked by makesrna) doesn't include threads.c,
+ * thread-safe pools can't be created there so the locks are never used. */
+#  define BLI_spin_init(spin) ((void)(spin))
+#  define BLI_spin_lock(spin) ((void)(spin))
+#  define BLI_spin_unlock(spin) ((void)(spin))
+#  define BLI_spin_end(spin) ((void)(spin))
+#endif
+
 #ifndef NDEBUG
 static bool mempool_debug_memset = false;
 #endif
@@ -118,6 +143,17 @@ typedef struct BLI_mempool_chunk {
 #endif
 } BLI_mempool_chunk;
 
+/**
+ * Free elements owned by one thread of a #BLI_MEMPOOL_THREADSAFE pool.
+ */
+typedef struct BLI_mempool_thread_cache {
+	SpinLock lock;
+	BLI_freenode *free;
+	unsigned int totfree;
+	/* keep caches of different threads on separate cache lines */
+	char _pad[64];
+} BLI_mempool_thread_cache;
+
 /**
  * The mempool, stores and tracks memory \a chunks and elements within those chunks \a free.
  */
@@ -139,6 +175,11 @@ struct BLI_mempool {
 #ifdef USE_TOTALLOC
 	unsigned int totalloc;          /* number of elements allocated in total */
 #endif
+
+	/* only for #BLI_MEMPOOL_THREADSAFE, in that case
+	 * 'totused' also counts the elements held by thread caches */
+	SpinLock lock;              /* protects chunks, free list and totused */
+	BLI_mempool_thread_cache *thread_caches;
 };
 
 #define MEMPOOL_ELEM_SIZE_MIN (sizeof(void *) * 2)
@@ -289,6 +330,198 @@ static void mempool_chunk_free_all(BLI_mempool_chunk *mpchunk)
 	}
 }
 
+/* -------------------------------------------------------------------- */
+/* Thread Caches (#BLI_MEMPOOL_THREADSAFE) */
+
+#ifdef __APPLE__
+static pthread_key_t mempool_thread_slot;
+static pthread_once_t mempool_thread_slot_once = PTHREAD_ONCE_INIT;
+
+static void mempool_thread_slot_create(void)
+{
+	BLI_thread_local_create(mempool_thread_slot);
+}
+#else
+static ThreadLocal(void *) mempool_thread_slot = NULL;
+#endif
+static unsigned int mempool_thread_slot_next = 0;
+
+/**
+ * \return the cache slot of the calling thread, assigned on first use.
+ */
+static unsigned int mempool_thread_slot_get(void)
+{
+	void *slot;
+
+#ifdef __APPLE__
+	pthread_once(&mempool_thread_slot_once, mempool_thread_slot_create);
+#endif
+
+	slot = BLI_thread_local_get(mempool_thread_slot);
+	if (UNLIKELY(slot == NULL)) {
+		/* offset by one so NULL means unassigned */
+		slot = SET_UINT_IN_POINTER(atomic_add_and_fetch_u(&mempool_thread_slot_next, 1));
+		BLI_thread_local_set(mempool_thread_slot, slot);
+	}
+	return GET_UINT_FROM_POINTER(slot) & (MEMPOOL_THREAD_CACHE_NUM - 1);
+}
+
+static void mempool_thread_caches_reset(BLI_mempool *pool)
+{
+	unsigned int i;
+	for (i = 0; i < MEMPOOL_THREAD_CACHE_NUM; i++) {
+		pool->thread_caches[i].free = NULL;
+		pool->thread_caches[i].totfree = 0;
+	}
+}
+
+/**
+ * Move up to #MEMPOOL_THREAD_BATCH elements from the shared free list into \a cache,
+ * allocating a new chunk when the shared list is empty.
+ *
+ * \note caller must hold the cache lock.
+ */
+static void mempool_thread_cache_refill(BLI_mempool *pool, BLI_mempool_thread_cache *cache)
+{
+	BLI_freenode *first, *last;
+	unsigned int num = 1;
+
+	BLI_spin_lock(&pool->lock);
+
+	while (UNLIKELY(pool->free == NULL)) {
+		/* don't hold the lock while allocating, other threads may return elements
+		 * in the meantime, so link the new chunk in front of whatever is free by then */
+		BLI_mempool_chunk *mpchunk;
+		BLI_freenode *free_prev;
+
+		BLI_spin_unlock(&pool->lock);
+		mpchunk = mempool_chunk_alloc(pool);
+		BLI_spin_lock(&pool->lock);
+
+		free_prev = pool->free;
+		pool->free = NULL;
+		last = mempool_chunk_add(pool, mpchunk, NULL);
+		last->next = free_prev;
+	}
+
+	first = last = pool->free;
+	while (num < MEMPOOL_THREAD_BATCH && last->next) {
+		last = last->next;
+		num++;
+	}
+
+	pool->free = last->next;
+	pool->totused += num;
+
+	BLI_spin_unlock(&pool->lock);
+
+	last->next = cache->free;
+	cache->free = first;
+	cache->totfree += num;
+}
+
+/**
+ * Return #MEMPOOL_THREAD_BATCH elements from \a cache to the shared free list.
+ *
+ * \note caller must hold the cache lock.
+ */
+static void mempool_thread_cache_drain(BLI_mempool *pool, BLI_mempool_thread_cache *cache)
+{
+	BLI_freenode *first, *last;
+	unsigned int num = 1;
+
+	BLI_assert(cache->totfree >= MEMPOOL_THREAD_BATCH);
+
+	first = last = cache->free;
+	while (num < MEMPOOL_THREAD_BATCH) {
+		last = last->next;
+		num++;
+	}
+
+	cache->free = last->next;
+	cache->totfree -= num;
+
+	BLI_spin_lock(&pool->lock);
+	last->next = pool->free;
+	pool->free = first;
+	pool->totused -= num;
+	BLI_spin_unlock(&pool->lock);
+}
+
+static void *mempool_alloc_threadsafe(BLI_mempool *pool)
+{
+	BLI_mempool_thread_cache *cache = &pool->thread_caches[mempool_thread_slot_get()];
+	BLI_freenode *free_pop;
+
+	BLI_spin_lock(&cache->lock);
+
+	if (UNLIKELY(cache->free == NULL)) {
+		mempool_thread_cache_refill(pool, cache);
+	}
+
+	free_pop = cache->free;
+	cache->free = free_pop->next;
+	cache->totfree--;
+
+	if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
+		free_pop->freeword = USEDWORD;
+	}
+
+	BLI_spin_unlock(&cache->lock);
+
+#ifdef WITH_MEM_VALGRIND
+	VALGRIND_MEMPOOL_ALLOC(pool, free_pop, pool->esize);
+#endif
+
+	return (void *)free_pop;
+}
+
+/**
+ * Elements may be freed by a different thread than the one which allocated them,
+ * they simply end up in the cache of the freeing thread.
+ * Chunks are never released here, only on #BLI_mempool_clear or #BLI_mempool_destroy.
+ */
+static void mempool_free_threadsafe(BLI_mempool *pool, BLI_freenode *newhead)
+{
+	BLI_mempool_thread_cache *cache = &pool->thread_caches[mempool_thread_slot_get()];
+
+	BLI_spin_lock(&cache->lock);
+
+	newhead->next = cache->free;
+	cache->free = newhead;
+	cache->totfree++;
+
+	/* keep one batch around so alternating alloc/free doesn't bounce over the shared lock */
+	if (UNLIKELY(cache->totfree >= MEMPOOL_THREAD_BATCH * 2)) {
+		mempool_thread_cache_drain(pool, cache);
+	}
+
+	BLI_spin_unlock(&cache->lock);
+
+#ifdef WITH_MEM_VALGRIND
+	VALGRIND_MEMPOOL_FREE(pool, newhead);
+#endif
+}
+
+/**
+ * \return the number of elements in use, excluding ones held by thread caches.
+ */
+static unsigned int mempool_totused(BLI_mempool *pool)
+{
+	unsigned int totused = pool->totused;
+
+	if (pool->flag & BLI_MEMPOOL_THREADSAFE) {
+		unsigned int i;
+		for (i = 0; i < MEMPOOL_THREAD_CACHE_NUM; i++) {
+			totused -= pool->thread_caches[i].totfree;
+		}
+	}
+
+	return totused;
+}
+
+/* -------------------------------------------------------------------- */
+
 BLI_mempool *BLI_mempool_create(unsigned int esize, unsigned int totelem,
                                 unsigned int pchunk, unsigned int flag)
 {
@@ -335,6 +568,22 @@ BLI_mempool *BLI_mempool_create(unsigned int esize, unsigned int totelem,
 #endif
 	pool->totused = 0;
 
+	if (flag & BLI_MEMPOOL_THREADSAFE) {
+#ifdef BLI_MEMPOOL_NO_THREADS
+		BLI_assert(!"Thread-safe pools are not supported in this build");
+#endif
+		BLI_spin_init(&pool->lock);
+		pool->thread_caches = MEM_mallocN(sizeof(*pool->thread_caches) * MEMPOOL_THREAD_CACHE_NUM,
+		                                  "BLI_Mempool Thread Caches");
+		for (i = 0; i < MEMPOOL_THREAD_CACHE_NUM; i++) {
+			BLI_spin_init(&pool->thread_caches[i].lock);
+		}
+		mempool_thread_caches_reset(pool);
+	}
+	else {
+		pool->thread_caches = NULL;
+	}
+
 	if (totelem) {
 		/* allocate the actual chunks */
 		for (i = 0; i < maxchunks; i++) {
@@ -354,6 +603,10 @@ void *BLI_mempool_alloc(BLI_mempool *pool)
 {
 	BLI_freenode *free_pop;
 
+	if (pool->flag & BLI_MEMPOOL_THREADSAFE) {
+		return mempool_alloc_threadsafe(pool);
+	}
+
 	if (UNLIKELY(pool->free == NULL)) {
 		/* need to allocate a new chunk */
 		BLI_mempool_chunk *mpchunk = mempool_chunk_alloc(pool);
@@ -398,12 +651,18 @@ void BLI_mempool_free(BLI_mempool *pool, void *addr)
 	{
 		BLI_mempool_chunk *chunk;
 		bool found = false;
+		if (pool->flag & BLI_MEMPOOL_THREADSAFE) {
+			BLI_spin_lock(&pool->lock);
+		}
 		for (chunk = pool->chunks; chunk; chunk = chunk->next) {
 			if (ARRAY_HAS_ITEM((char *)addr, (char *)CHUNK_DATA(chunk), pool->csize)) {
 				found = true;
 				break;
 			}
 		}
+		if (pool->flag & BLI_MEMPOOL_THREADSAFE) {
+			BLI_spin_unlock(&pool->lock);
+		}
 		if (!found) {
 			BLI_assert(!"Attempt to free data which is not in pool.\n");
 		}
@@ -423,6 +682,11 @@ void BLI_mempool_free(BLI_mempool *pool, void *addr)
 		newhead->freeword = FREEWORD;
 	}
 
+	if (pool->flag & BLI_MEMPOOL_THREADSAFE) {
+		mempool_free_threadsafe(pool, newhead);
+		return;
+	}
+
 	newhead->next = pool->free;
 	pool->free = newhead;
 
@@ -474,14 +738,14 @@ void BLI_mempool_free(BLI_mempool *pool, void *addr)
 
 int BLI_mempool_count(BLI_mempool *pool)
 {
-	return (int)pool->totused;
+	return (int)mempool_totused(pool);
 }
 
 void *BLI_mempool_findelem(BLI_mempool *pool, unsigned int index)
 {
 	BLI_assert(pool->flag & BLI_MEMPOOL_ALLOW_ITER);
 
-	if (index < pool->totused) {
+	if (index < mempool_totused(pool)) {
 		/* we could have some faster mem chunk stepping code inline */
 		BLI_mempool_iter iter;
 		void *elem;
@@ -512,7 +776,7 @@ void BLI_mempool_as_table(BLI_mempool *pool, void **data)
 	while ((elem = BLI_mempool_iterstep(&iter))) {
 		*p++ = elem;
 	}
-	BLI_assert((unsigned int)(p - data) == pool->totused);
+	BLI_assert((unsigned int)(p - data) == mempool_totused(pool));
 }
 
 /**
@@ -520,7 +784,7 @@ void BLI_mempool_as_table(BLI_mempool *pool, void **data)
  */
 void **BLI_mempool_as_tableN(BLI_mempool *pool, const char *allocstr)
 {
-	void **data = MEM_mallocN((size_t)pool->totused * sizeof(void *), allocstr);
+	void **data = MEM_mallocN((size_t)mempool_totused(pool) * sizeof(void *), allocstr);
 	BLI_mempool_as_table(pool, data);
 	return data;
 }
@@ -539,7 +803,7 @@ void BLI_mempool_as_array(BLI_mempool *pool, void *data)
 		memcpy(p, elem, (size_t)esize);
 		p = NODE_STEP_NEXT(p);
 	}
-	BLI_assert((unsigned int)(p - (char *)data) == pool->totused * esize);
+	BLI_assert((unsigned int)(p - (char *)data) == mempool_totused(pool) * esize);
 }
 
 /**
@@ -547,7 +811,7 @@ void BLI_mempool_as_array(BLI_mempool *pool, void *data)
  */
 void *BLI_mempool_as_arrayN(BLI_mempool *pool, const char *allocstr)
 {
-	char *data = MEM_mallocN((size_t)(pool->totused * pool->esize), allocstr);
+	char *data = MEM_mallocN((size_t)(mempool_totused(pool) * pool->esize), allocstr);
 	BLI_mempool_as_array(pool, data);
 	return data;
 }
@@ -677,6 +941,9 @@ void BLI_mempool_clear_ex(BLI_mempool *pool, const int totelem_reserve)
 	/* re-initialize */
 	pool->free = NULL;
 	pool->totused = 0;
+	if (pool->flag & BLI_MEMPOOL_THREADSAFE) {
+		mempool_thread_caches_reset(pool);
+	}
 #ifdef USE_TOTALLOC
 	pool->totalloc = 0;
 #endif
@@ -706,6 +973,15 @@ void BLI_mempool_destroy(BLI_mempool *pool)
 {
 	mempool_chunk_free_all(pool->chunks);
 
+	if (pool->flag & BLI_MEMPOOL_THREADSAFE) {
+		unsigned int i;
+		for (i = 0; i < MEMPOOL_THREAD_CACHE_NUM; i++) {
+			BLI_spin_end(&pool->thread_caches[i].lock);
+		}
+		MEM_freeN(pool->thread_caches);
+		BLI_spin_end(&pool->lock);
+	}
+
 #ifdef WITH_MEM_VALGRIND
 	VALGRIND_DESTROY_MEMPOOL(pool);
 #endif
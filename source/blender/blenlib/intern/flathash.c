@@ -0,0 +1,636 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenlib/intern/flathash.c
+ *  \ingroup bli
+ *
+ * Open addressing hash table, keys and values are stored inline in a single
+ * array, so a lookup does not need to chase per-entry pointers like #GHash does.
+ *
+ * Every slot has a control byte, which is either #FH_CTRL_EMPTY, #FH_CTRL_DELETED
+ * or the 7 highest bits of the key hash when slot is used. Slots are grouped by
+ * #FH_GROUP_SIZE, and all control bytes of a group are compared against the key
+ * hash at once (using SSE2 when available). The key compare callback is only
+ * called for slots with matching hash bits, which rarely gives false positives.
+ *
+ * Groups are probed in triangular order, which visits every group since their
+ * number is a power of two. Lookup stops at the first group with an empty slot.
+ *
+ * Hash and compare callbacks follow the #GHash contract, so all of the
+ * BLI_ghashutil_ functions can be used.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#  include <intrin.h>
+#endif
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_sys_types.h"  /* for intptr_t support */
+#include "BLI_utildefines.h"
+#include "BLI_flathash.h"
+#include "BLI_strict_flags.h"
+
+/* Number of slots in a group, matches SSE2 register width. */
+#define FH_GROUP_SIZE 16
+
+/* Control byte values for unused slots, used slots store 7 bits of hash. */
+#define FH_CTRL_EMPTY ((uint8_t)0x80)
+#define FH_CTRL_DELETED ((uint8_t)0xfe)
+
+#define FH_INDEX_NONE ((unsigned int)-1)
+
+/* Maximum load factor (including deleted slots) is 7/8. */
+#define FH_CAPACITY_LIMIT(capacity) ((capacity) - ((capacity) / 8))
+
+typedef struct FlatHashEntry {
+	void *key;
+	void *val;
+} FlatHashEntry;
+
+struct FlatHash {
+	GHashHashFP hashfp;
+	GHashCmpFP cmpfp;
+
+	FlatHashEntry *entries;
+	uint8_t *ctrl;
+
+	/* Number of slots, always multiple of FH_GROUP_SIZE and power of two. */
+	unsigned int capacity;
+	unsigned int group_mask;
+
+	unsigned int nentries;
+	unsigned int ndeleted;
+};
+
+/* -------------------------------------------------------------------- */
+/* Group Matching */
+
+BLI_INLINE unsigned int flathash_bitscan(unsigned int mask)
+{
+	BLI_assert(mask != 0);
+#ifdef __GNUC__
+	return (unsigned int)__builtin_ctz(mask);
+#elif defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (unsigned int)index;
+#else
+	unsigned int index = 0;
+	while ((mask & 1) == 0) {
+		mask >>= 1;
+		index++;
+	}
+	return index;
+#endif
+}
+
+/* Each function returns bitmask of group slots which match the criteria. */
+
+#ifdef __SSE2__
+
+BLI_INLINE unsigned int flathash_group_match(const uint8_t *ctrl, const uint8_t h2)
+{
+	const __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+	return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)h2)));
+}
+
+BLI_INLINE unsigned int flathash_group_match_empty(const uint8_t *ctrl)
+{
+	return flathash_group_match(ctrl, FH_CTRL_EMPTY);
+}
+
+BLI_INLINE unsigned int flathash_group_match_free(const uint8_t *ctrl)
+{
+	/* Both empty and deleted slots have highest bit set. */
+	const __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+	return (unsigned int)_mm_movemask_epi8(group);
+}
+
+#else  /* __SSE2__ */
+
+BLI_INLINE unsigned int flathash_group_match(const uint8_t *ctrl, const uint8_t h2)
+{
+	unsigned int mask = 0;
+	for (unsigned int i = 0; i < FH_GROUP_SIZE; i++) {
+		if (ctrl[i] == h2) {
+			mask |= (1u << i);
+		}
+	}
+	return mask;
+}
+
+BLI_INLINE unsigned int flathash_group_match_empty(const uint8_t *ctrl)
+{
+	return flathash_group_match(ctrl, FH_CTRL_EMPTY);
+}
+
+BLI_INLINE unsigned int flathash_group_match_free(const uint8_t *ctrl)
+{
+	unsigned int mask = 0;
+	for (unsigned int i = 0; i < FH_GROUP_SIZE; i++) {
+		if (ctrl[i] & 0x80) {
+			mask |= (1u << i);
+		}
+	}
+	return mask;
+}
+
+#endif  /* __SSE2__ */
+
+/* -------------------------------------------------------------------- */
+/* Internal Utils */
+
+/* Hash callbacks are often weak (pointer hash keeps most bits of the address),
+ * so mix the bits, since both group index and control byte are taken from it.
+ * This is the finalizer of MurmurHash3. */
+BLI_INLINE unsigned int flathash_keyhash(FlatHash *fh, const void *key)
+{
+	unsigned int hash = fh->hashfp(key);
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bu;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35u;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+BLI_INLINE uint8_t flathash_h2(const unsigned int hash)
+{
+	return (uint8_t)(hash >> 25);
+}
+
+BLI_INLINE bool flathash_ctrl_is_used(const uint8_t ctrl)
+{
+	return (ctrl & 0x80) == 0;
+}
+
+static unsigned int flathash_capacity_for(const unsigned int nentries)
+{
+	unsigned int capacity = FH_GROUP_SIZE;
+	while (FH_CAPACITY_LIMIT(capacity) < nentries) {
+		capacity *= 2;
+	}
+	return capacity;
+}
+
+static void flathash_buffers_alloc(FlatHash *fh, const unsigned int capacity)
+{
+	/* Single allocation for both entries and control bytes. */
+	fh->entries = MEM_mallocN((sizeof(FlatHashEntry) + sizeof(uint8_t)) * capacity, "FlatHash entries");
+	fh->ctrl = (uint8_t *)(fh->entries + capacity);
+	memset(fh->ctrl, FH_CTRL_EMPTY, capacity);
+
+	fh->capacity = capacity;
+	fh->group_mask = capacity / FH_GROUP_SIZE - 1;
+	fh->ndeleted = 0;
+}
+
+/* Index of the slot with given key, or FH_INDEX_NONE. */
+static unsigned int flathash_find_index(FlatHash *fh, const void *key, const unsigned int hash)
+{
+	const uint8_t h2 = flathash_h2(hash);
+	unsigned int group = hash & fh->group_mask;
+
+	for (unsigned int step = 1; ; step++) {
+		const uint8_t *ctrl = &fh->ctrl[group * FH_GROUP_SIZE];
+		unsigned int match = flathash_group_match(ctrl, h2);
+
+		while (match) {
+			const unsigned int index = group * FH_GROUP_SIZE + flathash_bitscan(match);
+			if (fh->cmpfp(key, fh->entries[index].key) == false) {
+				return index;
+			}
+			match &= match - 1;
+		}
+
+		if (flathash_group_match_empty(ctrl)) {
+			return FH_INDEX_NONE;
+		}
+
+		BLI_assert(step <= fh->group_mask + 1);
+		group = (group + step) & fh->group_mask;
+	}
+}
+
+/* Index of the first empty or deleted slot in the probe sequence of the hash. */
+static unsigned int flathash_find_free_index(FlatHash *fh, const unsigned int hash)
+{
+	unsigned int group = hash & fh->group_mask;
+
+	for (unsigned int step = 1; ; step++) {
+		const unsigned int match = flathash_group_match_free(&fh->ctrl[group * FH_GROUP_SIZE]);
+		if (match) {
+			return group * FH_GROUP_SIZE + flathash_bitscan(match);
+		}
+
+		BLI_assert(step <= fh->group_mask + 1);
+		group = (group + step) & fh->group_mask;
+	}
+}
+
+/* Rebuild the table with new capacity, also gets rid of deleted slots. */
+static void flathash_resize(FlatHash *fh, const unsigned int capacity)
+{
+	FlatHashEntry *entries_old = fh->entries;
+	const uint8_t *ctrl_old = fh->ctrl;
+	const unsigned int capacity_old = fh->capacity;
+
+	BLI_assert(FH_CAPACITY_LIMIT(capacity) >= fh->nentries);
+
+	flathash_buffers_alloc(fh, capacity);
+
+	for (unsigned int i = 0; i < capacity_old; i++) {
+		if (flathash_ctrl_is_used(ctrl_old[i])) {
+			const unsigned int hash = flathash_keyhash(fh, entries_old[i].key);
+			const unsigned int index = flathash_find_free_index(fh, hash);
+			fh->ctrl[index] = flathash_h2(hash);
+			fh->entries[index] = entries_old[i];
+		}
+	}
+
+	MEM_freeN(entries_old);
+}
+
+/* Insert the key which is known to not be in the hash. */
+static FlatHashEntry *flathash_insert_ex(FlatHash *fh, void *key, void *val, const unsigned int hash)
+{
+	unsigned int index;
+
+	BLI_assert(flathash_find_index(fh, key, hash) == FH_INDEX_NONE);
+
+	if (fh->nentries + fh->ndeleted >= FH_CAPACITY_LIMIT(fh->capacity)) {
+		/* Either grow, or only get rid of deleted slots if there are many of them. */
+		if (fh->nentries + 1 > FH_CAPACITY_LIMIT(fh->capacity) / 2) {
+			flathash_resize(fh, fh->capacity * 2);
+		}
+		else {
+			flathash_resize(fh, fh->capacity);
+		}
+	}
+
+	index = flathash_find_free_index(fh, hash);
+	if (fh->ctrl[index] == FH_CTRL_DELETED) {
+		fh->ndeleted--;
+	}
+	fh->ctrl[index] = flathash_h2(hash);
+	fh->entries[index].key = key;
+	fh->entries[index].val = val;
+	fh->nentries++;
+
+	return &fh->entries[index];
+}
+
+static void flathash_remove_index(FlatHash *fh, const unsigned int index)
+{
+	const unsigned int group_start = index & ~(unsigned int)(FH_GROUP_SIZE - 1);
+
+	/* If the group has empty slot, lookups never probed past it, so the slot
+	 * can become empty again. Otherwise it has to be marked as deleted to keep
+	 * probe sequences of other keys. */
+	if (flathash_group_match_empty(&fh->ctrl[group_start])) {
+		fh->ctrl[index] = FH_CTRL_EMPTY;
+	}
+	else {
+		fh->ctrl[index] = FH_CTRL_DELETED;
+		fh->ndeleted++;
+	}
+	fh->nentries--;
+}
+
+static void flathash_free_entries(FlatHash *fh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	if (keyfreefp == NULL && valfreefp == NULL) {
+		return;
+	}
+	for (unsigned int i = 0; i < fh->capacity; i++) {
+		if (flathash_ctrl_is_used(fh->ctrl[i])) {
+			if (keyfreefp) keyfreefp(fh->entries[i].key);
+			if (valfreefp) valfreefp(fh->entries[i].val);
+		}
+	}
+}
+
+/* -------------------------------------------------------------------- */
+/* Public API */
+
+/**
+ * Creates a new, empty FlatHash.
+ *
+ * \param hashfp  Hash callback.
+ * \param cmpfp  Comparison callback.
+ * \param info  Identifier string for the FlatHash.
+ * \param nentries_reserve  Optionally reserve the number of members that the hash will hold.
+ * \return  An empty FlatHash.
+ */
+FlatHash *BLI_flathash_new_ex(GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info,
+                              const unsigned int nentries_reserve)
+{
+	FlatHash *fh = MEM_mallocN(sizeof(*fh), info);
+
+	fh->hashfp = hashfp;
+	fh->cmpfp = cmpfp;
+	fh->nentries = 0;
+
+	flathash_buffers_alloc(fh, flathash_capacity_for(nentries_reserve));
+
+	return fh;
+}
+
+/**
+ * Wraps #BLI_flathash_new_ex with zero entries reserved.
+ */
+FlatHash *BLI_flathash_new(GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info)
+{
+	return BLI_flathash_new_ex(hashfp, cmpfp, info, 0);
+}
+
+/**
+ * Frees the FlatHash and its members.
+ *
+ * \param keyfreefp  Optional callback to free the key.
+ * \param valfreefp  Optional callback to free the value.
+ */
+void BLI_flathash_free(FlatHash *fh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	flathash_free_entries(fh, keyfreefp, valfreefp);
+	MEM_freeN(fh->entries);
+	MEM_freeN(fh);
+}
+
+/**
+ * Reserve given amount of entries (resize \a fh accordingly if needed).
+ */
+void BLI_flathash_reserve(FlatHash *fh, const unsigned int nentries_reserve)
+{
+	const unsigned int capacity = flathash_capacity_for(nentries_reserve);
+	if (capacity > fh->capacity) {
+		flathash_resize(fh, capacity);
+	}
+}
+
+/**
+ * Insert a key/value pair into the \a fh.
+ *
+ * \note Duplicates are not checked,
+ * the caller is expected to ensure elements are unique.
+ */
+void BLI_flathash_insert(FlatHash *fh, void *key, void *val)
+{
+	flathash_insert_ex(fh, key, val, flathash_keyhash(fh, key));
+}
+
+/**
+ * Inserts a new value to a key that may already be in the hash.
+ *
+ * Avoids #BLI_flathash_remove, #BLI_flathash_insert calls (double lookups)
+ *
+ * \returns true if a new key has been added.
+ */
+bool BLI_flathash_reinsert(FlatHash *fh, void *key, void *val,
+                           GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	const unsigned int hash = flathash_keyhash(fh, key);
+	const unsigned int index = flathash_find_index(fh, key, hash);
+
+	if (index != FH_INDEX_NONE) {
+		FlatHashEntry *e = &fh->entries[index];
+		if (keyfreefp) keyfreefp(e->key);
+		if (valfreefp) valfreefp(e->val);
+		e->key = key;
+		e->val = val;
+		return false;
+	}
+
+	flathash_insert_ex(fh, key, val, hash);
+	return true;
+}
+
+/**
+ * Lookup the value of \a key in \a fh.
+ *
+ * \param key  The key to lookup.
+ * \returns the value for \a key or NULL.
+ *
+ * \note When NULL is a valid value, use #BLI_flathash_lookup_p to differentiate a missing key
+ * from a key with a NULL value. (Avoids calling #BLI_flathash_haskey before #BLI_flathash_lookup)
+ */
+void *BLI_flathash_lookup(FlatHash *fh, const void *key)
+{
+	const unsigned int index = flathash_find_index(fh, key, flathash_keyhash(fh, key));
+	return (index != FH_INDEX_NONE) ? fh->entries[index].val : NULL;
+}
+
+/**
+ * A version of #BLI_flathash_lookup which accepts a fallback argument.
+ */
+void *BLI_flathash_lookup_default(FlatHash *fh, const void *key, void *val_default)
+{
+	const unsigned int index = flathash_find_index(fh, key, flathash_keyhash(fh, key));
+	return (index != FH_INDEX_NONE) ? fh->entries[index].val : val_default;
+}
+
+/**
+ * Lookup a pointer to the value of \a key in \a fh.
+ *
+ * \returns the pointer to value for \a key or NULL.
+ *
+ * \note This has 2 main benefits over #BLI_flathash_lookup.
+ * - A NULL return always means that \a key isn't in \a fh.
+ * - The value can be modified in-place without further function calls (faster).
+ *
+ * \warning The pointer is only valid until the hash is modified.
+ */
+void **BLI_flathash_lookup_p(FlatHash *fh, const void *key)
+{
+	const unsigned int index = flathash_find_index(fh, key, flathash_keyhash(fh, key));
+	return (index != FH_INDEX_NONE) ? &fh->entries[index].val : NULL;
+}
+
+/**
+ * Ensure \a key is exists in \a fh.
+ *
+ * This handles the common situation where the caller needs ensure a key is added to \a fh,
+ * constructing a new value in the case the key isn't found.
+ * Otherwise use the existing value.
+ *
+ * \returns true when the value didn't need to be added.
+ * (when false, the caller _must_ initialize the value).
+ */
+bool BLI_flathash_ensure_p(FlatHash *fh, void *key, void ***r_val)
+{
+	const unsigned int hash = flathash_keyhash(fh, key);
+	const unsigned int index = flathash_find_index(fh, key, hash);
+
+	if (index != FH_INDEX_NONE) {
+		*r_val = &fh->entries[index].val;
+		return true;
+	}
+
+	*r_val = &flathash_insert_ex(fh, key, NULL, hash)->val;
+	return false;
+}
+
+/**
+ * Remove \a key from \a fh, or return false if the key wasn't found.
+ *
+ * \param key  The key to remove.
+ * \param keyfreefp  Optional callback to free the key.
+ * \param valfreefp  Optional callback to free the value.
+ * \return true if \a key was removed from \a fh.
+ */
+bool BLI_flathash_remove(FlatHash *fh, const void *key, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	const unsigned int index = flathash_find_index(fh, key, flathash_keyhash(fh, key));
+
+	if (index == FH_INDEX_NONE) {
+		return false;
+	}
+
+	if (keyfreefp) keyfreefp(fh->entries[index].key);
+	if (valfreefp) valfreefp(fh->entries[index].val);
+	flathash_remove_index(fh, index);
+
+	return true;
+}
+
+/**
+ * Reset \a fh clearing all entries, keeps the allocated memory.
+ *
+ * \param keyfreefp  Optional callback to free the key.
+ * \param valfreefp  Optional callback to free the value.
+ */
+void BLI_flathash_clear(FlatHash *fh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	flathash_free_entries(fh, keyfreefp, valfreefp);
+	memset(fh->ctrl, FH_CTRL_EMPTY, fh->capacity);
+	fh->nentries = 0;
+	fh->ndeleted = 0;
+}
+
+/**
+ * \return true if the \a key is in \a fh.
+ */
+bool BLI_flathash_haskey(FlatHash *fh, const void *key)
+{
+	return (flathash_find_index(fh, key, flathash_keyhash(fh, key)) != FH_INDEX_NONE);
+}
+
+/**
+ * \return size of the FlatHash.
+ */
+unsigned int BLI_flathash_size(FlatHash *fh)
+{
+	return fh->nentries;
+}
+
+/* -------------------------------------------------------------------- */
+/* Iterator API
+ *
+ * \note Hash must not be modified while iterating over it.
+ */
+
+static void flathash_iterator_skip_unused(FlatHashIterator *fhi)
+{
+	FlatHash *fh = fhi->fh;
+	while (fhi->index < fh->capacity && !flathash_ctrl_is_used(fh->ctrl[fhi->index])) {
+		fhi->index++;
+	}
+}
+
+/**
+ * Init an already allocated FlatHashIterator.
+ *
+ * \param fhi  The FlatHashIterator to initialize.
+ * \param fh  The FlatHash to iterate over.
+ */
+void BLI_flathashIterator_init(FlatHashIterator *fhi, FlatHash *fh)
+{
+	fhi->fh = fh;
+	fhi->index = 0;
+	flathash_iterator_skip_unused(fhi);
+}
+
+/**
+ * Steps the iterator to the next index.
+ */
+void BLI_flathashIterator_step(FlatHashIterator *fhi)
+{
+	BLI_assert(!BLI_flathashIterator_done(fhi));
+	fhi->index++;
+	flathash_iterator_skip_unused(fhi);
+}
+
+bool BLI_flathashIterator_done(FlatHashIterator *fhi)
+{
+	return fhi->index >= fhi->fh->capacity;
+}
+
+void *BLI_flathashIterator_getKey(FlatHashIterator *fhi)
+{
+	return fhi->fh->entries[fhi->index].key;
+}
+
+void *BLI_flathashIterator_getValue(FlatHashIterator *fhi)
+{
+	return fhi->fh->entries[fhi->index].val;
+}
+
+void **BLI_flathashIterator_getValue_p(FlatHashIterator *fhi)
+{
+	return &fhi->fh->entries[fhi->index].val;
+}
+
+/* -------------------------------------------------------------------- */
+/* Convenience FlatHash Creation Functions */
+
+FlatHash *BLI_flathash_ptr_new_ex(const char *info, const unsigned int nentries_reserve)
+{
+	return BLI_flathash_new_ex(BLI_ghashutil_ptrhash, BLI_ghashutil_ptrcmp, info, nentries_reserve);
+}
+FlatHash *BLI_flathash_ptr_new(const char *info)
+{
+	return BLI_flathash_ptr_new_ex(info, 0);
+}
+
+FlatHash *BLI_flathash_str_new_ex(const char *info, const unsigned int nentries_reserve)
+{
+	return BLI_flathash_new_ex(BLI_ghashutil_strhash_p, BLI_ghashutil_strcmp, info, nentries_reserve);
+}
+FlatHash *BLI_flathash_str_new(const char *info)
+{
+	return BLI_flathash_str_new_ex(info, 0);
+}
+
+FlatHash *BLI_flathash_int_new_ex(const char *info, const unsigned int nentries_reserve)
+{
+	return BLI_flathash_new_ex(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, info, nentries_reserve);
+}
+FlatHash *BLI_flathash_int_new(const char *info)
+{
+	return BLI_flathash_int_new_ex(info, 0);
+}
@@ -0,0 +1,257 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenlib/intern/lz4.c
+ *  \ingroup bli
+ *
+ * Compressor and decompressor for the LZ4 block format.
+ *
+ * A block is a sequence of (literals, match) pairs, each starting with a token byte
+ * holding the literal length (high 4 bits) and the match length minus 4 (low 4 bits),
+ * lengths of 15 and above continue in extra bytes. The last sequence only has literals.
+ *
+ * The compressor is a simple greedy matcher with a small hash table of 4 byte sequences,
+ * which favors speed over ratio. Output can be read by any LZ4 block decoder.
+ */
+
+#include <string.h>
+
+#include "BLI_utildefines.h"
+
+#include "BLI_lz4.h"  /* own include */
+
+#include "BLI_strict_flags.h"
+
+#define LZ4_MIN_MATCH 4
+/* the last match must start at least 12 bytes before the end of the block */
+#define LZ4_MFLIMIT 12
+/* the last 5 bytes are always literals */
+#define LZ4_LAST_LITERALS 5
+#define LZ4_MAX_OFFSET 65535
+
+#define LZ4_HASH_LOG 12
+#define LZ4_HASH_SIZE (1 << LZ4_HASH_LOG)
+
+BLI_INLINE uint32_t lz4_read32(const unsigned char *p)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+BLI_INLINE unsigned int lz4_hash(const uint32_t v)
+{
+	return (v * 2654435761u) >> (32 - LZ4_HASH_LOG);
+}
+
+/* space needed to store a length beyond the 4 bits of the token */
+BLI_INLINE size_t lz4_length_extra_size(const size_t len)
+{
+	return (len >= 15) ? ((len - 15) / 255 + 1) : 0;
+}
+
+BLI_INLINE unsigned char *lz4_write_length_extra(unsigned char *op, size_t len)
+{
+	if (len >= 15) {
+		len -= 15;
+		while (len >= 255) {
+			*op++ = 255;
+			len -= 255;
+		}
+		*op++ = (unsigned char)len;
+	}
+	return op;
+}
+
+/**
+ * \return the compressed size written to \a dst, or 0 when it doesn't fit in \a dst_len.
+ * Using #BLI_lz4_compress_bound for \a dst_len always fits.
+ */
+size_t BLI_lz4_compress(const void *src, const size_t src_len, void *dst, const size_t dst_len)
+{
+	const unsigned char *base = src;
+	const unsigned char *ip = base;
+	const unsigned char *anchor = base;
+	const unsigned char *iend = base + src_len;
+	unsigned char *op = dst;
+	unsigned char *oend = op + dst_len;
+	size_t lit_len;
+
+	if (src_len > LZ4_MFLIMIT) {
+		const unsigned char *mflimit = iend - LZ4_MFLIMIT;
+		const unsigned char *matchlimit = iend - LZ4_LAST_LITERALS;
+		uint32_t table[LZ4_HASH_SIZE];
+
+		/* positions are stored as 32 bit offsets */
+		BLI_assert(src_len <= UINT32_MAX);
+
+		memset(table, 0, sizeof(table));
+
+		while (ip <= mflimit) {
+			const uint32_t seq = lz4_read32(ip);
+			const unsigned int h = lz4_hash(seq);
+			const unsigned char *ref = base + table[h];
+			table[h] = (uint32_t)(ip - base);
+
+			if ((ref < ip) && ((size_t)(ip - ref) <= LZ4_MAX_OFFSET) && (lz4_read32(ref) == seq)) {
+				const unsigned char *mp, *rp;
+				size_t match_len, offset;
+
+				/* extend backwards into pending literals */
+				while ((ip > anchor) && (ref > base) && (ip[-1] == ref[-1])) {
+					ip--;
+					ref--;
+				}
+
+				mp = ip + LZ4_MIN_MATCH;
+				rp = ref + LZ4_MIN_MATCH;
+				while ((mp < matchlimit) && (*mp == *rp)) {
+					mp++;
+					rp++;
+				}
+
+				lit_len = (size_t)(ip - anchor);
+				match_len = (size_t)(mp - ip) - LZ4_MIN_MATCH;
+				offset = (size_t)(ip - ref);
+
+				if ((size_t)(oend - op) < 1 + lz4_length_extra_size(lit_len) + lit_len + 2 +
+				                          lz4_length_extra_size(match_len))
+				{
+					return 0;
+				}
+
+				*op++ = (unsigned char)((MIN2(lit_len, 15u) << 4) | MIN2(match_len, 15u));
+				op = lz4_write_length_extra(op, lit_len);
+				memcpy(op, anchor, lit_len);
+				op += lit_len;
+
+				*op++ = (unsigned char)(offset & 0xff);
+				*op++ = (unsigned char)(offset >> 8);
+				op = lz4_write_length_extra(op, match_len);
+
+				ip = anchor = mp;
+
+				/* keep the table warm for the position right before the next search */
+				if (ip <= mflimit) {
+					table[lz4_hash(lz4_read32(ip - 2))] = (uint32_t)(ip - 2 - base);
+				}
+			}
+			else {
+				/* skip faster through data that doesn't compress */
+				ip += 1 + ((size_t)(ip - anchor) >> 6);
+			}
+		}
+	}
+
+	/* last literals */
+	lit_len = (size_t)(iend - anchor);
+	if ((size_t)(oend - op) < 1 + lz4_length_extra_size(lit_len) + lit_len) {
+		return 0;
+	}
+	*op++ = (unsigned char)(MIN2(lit_len, 15u) << 4);
+	op = lz4_write_length_extra(op, lit_len);
+	memcpy(op, anchor, lit_len);
+	op += lit_len;
+
+	return (size_t)(op - (unsigned char *)dst);
+}
+
+size_t BLI_lz4_compress_bound(const size_t src_len)
+{
+	return src_len + (src_len / 255) + 16;
+}
+
+/**
+ * Decompress a block of exactly \a dst_len bytes.
+ *
+ * \return false for corrupt input or when the data doesn't decompress to \a dst_len bytes.
+ */
+bool BLI_lz4_decompress(const void *src, const size_t src_len, void *dst, const size_t dst_len)
+{
+	const unsigned char *ip = src;
+	const unsigned char *iend = ip + src_len;
+	unsigned char *op = dst;
+	unsigned char *oend = op + dst_len;
+
+	while (ip < iend) {
+		const unsigned int token = *ip++;
+		size_t lit_len = token >> 4;
+		size_t match_len = token & 15;
+		size_t offset;
+		const unsigned char *match;
+
+		if (lit_len == 15) {
+			unsigned int b;
+			do {
+				if (ip >= iend) {
+					return false;
+				}
+				b = *ip++;
+				lit_len += b;
+			} while (b == 255);
+		}
+
+		if ((lit_len > (size_t)(iend - ip)) || (lit_len > (size_t)(oend - op))) {
+			return false;
+		}
+		memcpy(op, ip, lit_len);
+		ip += lit_len;
+		op += lit_len;
+
+		/* last sequence has no match */
+		if (ip == iend) {
+			break;
+		}
+
+		if ((iend - ip) < 2) {
+			return false;
+		}
+		offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+		ip += 2;
+
+		if ((offset == 0) || (offset > (size_t)(op - (unsigned char *)dst))) {
+			return false;
+		}
+
+		if (match_len == 15) {
+			unsigned int b;
+			do {
+				if (ip >= iend) {
+					return false;
+				}
+				b = *ip++;
+				match_len += b;
+			} while (b == 255);
+		}
+		match_len += LZ4_MIN_MATCH;
+
+		if (match_len > (size_t)(oend - op)) {
+			return false;
+		}
+
+		/* matches may overlap the output, copy byte by byte */
+		match = op - offset;
+		while (match_len--) {
+			*op++ = *match++;
+		}
+	}
+
+	return (op == oend);
+}
@@ -48,18 +48,13 @@
  */
 #define MEMPOOL_SIZE 256
 
-/* Number of tasks which are pushed directly to local thread queue.
+/* Capacity of per-thread work-stealing queue, must be power of two.
  *
- * This allows thread to fetch next task without locking the whole queue.
+ * When queue is saturated new tasks are pushed to the scheduler's global queue.
+ * For more details see description of TaskDeque.
  */
-#define LOCAL_QUEUE_SIZE 1
-
-/* Number of tasks which are allowed to be scheduled in a delayed manner.
- *
- * This allows to use less locks per graph node children schedule. More details
- * could be found at TaskThreadLocalStorage::do_delayed_push.
- */
-#define DELAYED_QUEUE_SIZE 4096
+#define TASK_DEQUE_SIZE 1024
+#define TASK_DEQUE_MASK (TASK_DEQUE_SIZE - 1)
 
 #ifndef NDEBUG
 #  define ASSERT_THREAD_ID(scheduler, thread_id)                              \
@@ -135,45 +130,79 @@ typedef struct TaskMemPoolStats {
 } TaskMemPoolStats;
 #endif
 
+/* This is a per-thread work-stealing queue of tasks ready to be executed
+ * (Chase-Lev deque with fixed capacity).
+ *
+ * Owner thread pushes and pops tasks at the bottom end without any locks,
+ * which gives LIFO order and keeps data of just-spawned tasks hot in cache.
+ * Other threads which ran out of work steal from the top end, racing for
+ * the task with a single compare-and-swap.
+ *
+ * Pool of the task is stored next to it, so it's possible to check whether
+ * the task can be taken by a thread which waits for specific pool without
+ * dereferencing the task, which might have been already executed and freed
+ * by another thread.
+ *
+ * The bottom and top ends are kept on opposite sides of the task storage so
+ * owner and thieves do not fight for the same cache line.
+ *
+ * All accesses which may race go through atomic_ops: stores of items and
+ * indices are release and loads acquire, so a thief which sees the new bottom
+ * also sees the item. Owner and thieves racing for the last task are ordered
+ * by a sequentially consistent fence between the bottom store and top load in
+ * pop(), and between the top load and bottom load in steal().
+ */
+typedef struct TaskDequeItem {
+	Task *task;
+	TaskPool *pool;
+} TaskDequeItem;
+
+typedef struct TaskDeque {
+	/* Index past the most recently pushed task, only modified by owner. */
+	size_t bottom;
+	TaskDequeItem items[TASK_DEQUE_SIZE];
+	/* Index of the oldest task, advanced by owner and thieves. */
+	size_t top;
+} TaskDeque;
+
 typedef struct TaskThreadLocalStorage {
 	/* Memory pool for faster task allocation.
 	 * The idea is to re-use memory of finished/discarded tasks by this thread.
 	 */
 	TaskMemPool task_mempool;
 
-	/* Local queue keeps thread alive by keeping small amount of tasks ready
-	 * to be picked up without causing global thread locks for synchronization.
-	 */
-	int num_local_queue;
-	Task *local_queue[LOCAL_QUEUE_SIZE];
-
 	/* Thread can be marked for delayed tasks push. This is helpful when it's
 	 * know that lots of subsequent task pushed will happen from the same thread
 	 * without "interrupting" for task execution.
 	 *
-	 * We try to accumulate as much tasks as possible in a local queue without
-	 * any locks first, and then we push all of them into a scheduler's queue
-	 * from within a single mutex lock.
+	 * Tasks are still pushed to thread's queue, but sleeping threads are only
+	 * woken up once all of the tasks are pushed.
 	 */
 	bool do_delayed_push;
-	int num_delayed_queue;
-	Task *delayed_queue[DELAYED_QUEUE_SIZE];
+	int num_delayed_push;
 } TaskThreadLocalStorage;
 
 struct TaskPool {
 	TaskScheduler *scheduler;
 
-	volatile size_t num;
+	size_t num;
 	ThreadMutex num_mutex;
 	ThreadCondition num_cond;
 
+	/* Number of tasks ever pushed to this pool, and number of threads waiting
+	 * for the pool in work_and_wait(). Used to avoid waking up waiting threads
+	 * when there is nobody to wake up.
+	 */
+	size_t num_pushed;
+	unsigned int num_waiting;
+
 	void *userdata;
 	ThreadMutex user_mutex;
 
-	volatile bool do_cancel;
+	bool do_cancel;
 	volatile bool do_work;
 
-	volatile bool is_suspended;
+	bool is_suspended;
 	ListBase suspended_queue;
 	size_t num_suspended;
 
@@ -208,12 +237,24 @@ struct TaskScheduler {
 	struct TaskThread *task_threads;
 	int num_threads;
 	bool background_thread_only;
+	/* See BLI_task_scheduler_create_ex(). */
+	bool use_work_stealing;
 
+	/* Global queue, used for tasks pushed from outside of the scheduler's
+	 * threads, high priority tasks and tasks which did not fit into a thread
+	 * queue.
+	 */
 	ListBase queue;
 	ThreadMutex queue_mutex;
 	ThreadCondition queue_cond;
+	/* Number of tasks in the global queue, changed with queue_mutex held,
+	 * read without it to avoid locking when the queue is empty. */
+	size_t num_queued;
 
-	volatile bool do_exit;
+	/* Number of worker threads which are waiting on queue_cond. */
+	unsigned int num_sleeping;
+
+	bool do_exit;
 
 	/* NOTE: In pthread's TLS we store the whole TaskThread structure. */
 	pthread_key_t tls_id_key;
@@ -223,6 +264,7 @@ typedef struct TaskThread {
 	TaskScheduler *scheduler;
 	int id;
 	TaskThreadLocalStorage tls;
+	TaskDeque deque;
 } TaskThread;
 
 /* Helper */
@@ -262,6 +304,17 @@ BLI_INLINE TaskThreadLocalStorage *get_task_tls(TaskPool *pool,
 	return &scheduler->task_threads[thread_id].tls;
 }
 
+BLI_INLINE TaskDeque *get_task_deque(TaskPool *pool, const int thread_id)
+{
+	if (pool->use_local_tls && thread_id == 0) {
+		/* Thread is not managed by the scheduler, so nobody would steal
+		 * from its queue. Such tasks are going to the global queue.
+		 */
+		return NULL;
+	}
+	return &pool->scheduler->task_threads[thread_id].deque;
+}
+
 BLI_INLINE void free_task_tls(TaskThreadLocalStorage *tls)
 {
 	TaskMemPool *task_mempool = &tls->task_mempool;
@@ -325,141 +378,423 @@ static void task_free(TaskPool *pool, Task *task, const int thread_id)
 	}
 }
 
+/* Task Deque */
+
+BLI_INLINE bool task_deque_is_empty(const TaskDeque *deque)
+{
+	const size_t top = atomic_load_z(&deque->top);
+	const size_t bottom = atomic_load_z(&deque->bottom);
+	return (ptrdiff_t)(bottom - top) <= 0;
+}
+
+/* Push task to the bottom of the queue, only allowed from the owner thread.
+ * Returns false if the queue is saturated.
+ */
+static bool task_deque_push(TaskDeque *deque, Task *task)
+{
+	const size_t bottom = deque->bottom;
+	const size_t top = atomic_load_z(&deque->top);
+	if ((ptrdiff_t)(bottom - top) >= TASK_DEQUE_SIZE) {
+		return false;
+	}
+	/* A thief which lost the race for the task previously stored here
+	 * might still be reading the slot. */
+	TaskDequeItem *item = &deque->items[bottom & TASK_DEQUE_MASK];
+	atomic_store_ptr((void **)&item->task, task);
+	atomic_store_ptr((void **)&item->pool, task->pool);
+	/* Release: item is visible to whoever sees the new bottom. */
+	atomic_store_z(&deque->bottom, bottom + 1);
+	return true;
+}
+
+/* Pop most recently pushed task, only allowed from the owner thread. */
+static Task *task_deque_pop(TaskDeque *deque)
+{
+	const size_t bottom = deque->bottom - 1;
+	atomic_store_z(&deque->bottom, bottom);
+	/* Reserve the bottom task before looking at the top, thieves either see
+	 * the reservation or we see their top increment. */
+	atomic_fence();
+	const size_t top = atomic_load_z(&deque->top);
+	Task *task;
+	if ((ptrdiff_t)(bottom - top) < 0) {
+		/* Queue was empty. */
+		atomic_store_z(&deque->bottom, bottom + 1);
+		return NULL;
+	}
+	task = deque->items[bottom & TASK_DEQUE_MASK].task;
+	if (bottom != top) {
+		/* There are more tasks in the queue, thieves can not reach this one. */
+		return task;
+	}
+	/* This is the last task, race with thieves for it. */
+	if (atomic_cas_z(&deque->top, top, top + 1) != top) {
+		task = NULL;
+	}
+	atomic_store_z(&deque->bottom, bottom + 1);
+	return task;
+}
+
+/* Check whether queue has any task from the given pool, only allowed from the
+ * owner thread. Tasks are checked starting from the bottom, so the common case
+ * of the most recent task belonging to the pool is fast.
+ */
+static bool task_deque_has_pool(const TaskDeque *deque, const TaskPool *pool)
+{
+	const size_t top = atomic_load_z(&deque->top);
+	for (size_t index = deque->bottom; (ptrdiff_t)(index - top) > 0; index--) {
+		if (deque->items[(index - 1) & TASK_DEQUE_MASK].pool == pool) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/* Steal the oldest task, allowed from any thread.
+ * Returns NULL if queue is empty, the oldest task does not belong to the given
+ * pool (if any) or another thread won the race for the task.
+ */
+static Task *task_deque_steal(TaskDeque *deque, const TaskPool *pool)
+{
+	if (task_deque_is_empty(deque)) {
+		return NULL;
+	}
+	const size_t top = atomic_load_z(&deque->top);
+	/* Top is to be read before the bottom, pairs with the fence in pop(). */
+	atomic_fence();
+	const size_t bottom = atomic_load_z(&deque->bottom);
+	if ((ptrdiff_t)(bottom - top) <= 0) {
+		return NULL;
+	}
+	/* Item may be overwritten by the owner once another thief took it, in which
+	 * case the compare-and-swap below fails and the value is not used. */
+	const TaskDequeItem *item = &deque->items[top & TASK_DEQUE_MASK];
+	if (pool != NULL && atomic_load_ptr((void *const *)&item->pool) != pool) {
+		return NULL;
+	}
+	Task *task = atomic_load_ptr((void *const *)&item->task);
+	if (atomic_cas_z(&deque->top, top, top + 1) != top) {
+		return NULL;
+	}
+	return task;
+}
+
+/* Simple xorshift generator used for picking a victim to steal from. */
+BLI_INLINE unsigned int task_steal_random(unsigned int *seed)
+{
+	unsigned int x = *seed;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*seed = x;
+	return x;
+}
+
 /* Task Scheduler */
 
 static void task_pool_num_decrease(TaskPool *pool, size_t done)
 {
-	BLI_mutex_lock(&pool->num_mutex);
+	size_t num = atomic_load_z(&pool->num);
 
-	BLI_assert(pool->num >= done);
+	BLI_assert(num >= done);
 
-	pool->num -= done;
+	/* Decrements which don't finish the pool need no lock. */
+	while (num > done) {
+		const size_t prev = atomic_cas_z(&pool->num, num, num - done);
+		if (prev == num) {
+			return;
+		}
+		num = prev;
+	}
 
-	if (pool->num == 0)
+	/* The counter only drops to zero with num_mutex held, so a thread which saw
+	 * zero and then took the lock knows nobody touches the pool any more and
+	 * it can be freed.
+	 */
+	BLI_mutex_lock(&pool->num_mutex);
+	if (atomic_sub_and_fetch_z(&pool->num, done) == 0) {
 		BLI_condition_notify_all(&pool->num_cond);
-
+	}
 	BLI_mutex_unlock(&pool->num_mutex);
 }
 
+/* NOTE: Is to be called before tasks become visible to other threads, so the
+ * counter never goes negative.
+ */
 static void task_pool_num_increase(TaskPool *pool, size_t new)
 {
-	BLI_mutex_lock(&pool->num_mutex);
+	atomic_add_and_fetch_z(&pool->num, new);
+}
 
-	pool->num += new;
-	BLI_condition_notify_all(&pool->num_cond);
+/* Count new tasks before they become visible to other threads, plus one
+ * reference for the pushing thread. The new tasks may be finished by other
+ * threads before task_pool_push_end() is reached, the reference keeps the pool
+ * from being freed meanwhile.
+ */
+static void task_pool_push_begin(TaskPool *pool, size_t new)
+{
+	task_pool_num_increase(pool, new + 1);
+}
 
-	BLI_mutex_unlock(&pool->num_mutex);
+/* Wake up threads which are waiting for this pool in work_and_wait() and drop
+ * the reference of the pushing thread, is to be called after the new tasks
+ * became visible to other threads. The pool must not be accessed after this.
+ */
+static void task_pool_push_end(TaskPool *pool)
+{
+	/* Full barrier: ordered against num_waiting increment of the waiter. */
+	atomic_add_and_fetch_z(&pool->num_pushed, 1);
+	if (atomic_load_u(&pool->num_waiting) != 0) {
+		BLI_mutex_lock(&pool->num_mutex);
+		BLI_condition_notify_all(&pool->num_cond);
+		BLI_mutex_unlock(&pool->num_mutex);
+	}
+	task_pool_num_decrease(pool, 1);
+}
+
+static void task_scheduler_wakeup(TaskScheduler *scheduler, int num_tasks)
+{
+	/* Unlocked check is fine here: the fence orders the bottom store of the
+	 * pushed tasks before this load, and sleeping thread re-checks the queues
+	 * after registering itself in num_sleeping.
+	 */
+	atomic_fence();
+	if (atomic_load_u(&scheduler->num_sleeping) != 0) {
+		BLI_mutex_lock(&scheduler->queue_mutex);
+		if (num_tasks == 1) {
+			BLI_condition_notify_one(&scheduler->queue_cond);
+		}
+		else {
+			BLI_condition_notify_all(&scheduler->queue_cond);
+		}
+		BLI_mutex_unlock(&scheduler->queue_mutex);
+	}
+}
+
+/* Run the task and release all its resources. */
+static void task_execute(TaskPool *pool, Task *task, const int thread_id)
+{
+	/* Thread queues are not cleared when pool is canceled, so skip tasks
+	 * from the canceled pools here.
+	 */
+	if (!atomic_load_uint8((const uint8_t *)&pool->do_cancel)) {
+		task->run(pool, task->taskdata, thread_id);
+	}
+	task_free(pool, task, thread_id);
+	task_pool_num_decrease(pool, 1);
+}
+
+/* Pop task from the global queue.
+ *
+ * If pool is specified, only tasks from this pool are considered, otherwise
+ * any task which can be handled by a worker thread is returned.
+ */
+static Task *task_scheduler_global_pop(TaskScheduler *scheduler, TaskPool *pool)
+{
+	Task *task;
+
+	/* Avoid locking when there is nothing in the global queue, which is the
+	 * most common case when all threads are busy with their own queues.
+	 */
+	if (atomic_load_z(&scheduler->num_queued) == 0) {
+		return NULL;
+	}
+
+	BLI_mutex_lock(&scheduler->queue_mutex);
+	for (task = scheduler->queue.first; task != NULL; task = task->next) {
+		if (pool != NULL) {
+			if (task->pool != pool) {
+				continue;
+			}
+		}
+		else if (scheduler->background_thread_only && !task->pool->run_in_background) {
+			continue;
+		}
+		BLI_remlink(&scheduler->queue, task);
+		atomic_sub_and_fetch_z(&scheduler->num_queued, 1);
+		break;
+	}
+	BLI_mutex_unlock(&scheduler->queue_mutex);
+
+	return task;
 }
 
-static bool task_scheduler_thread_wait_pop(TaskScheduler *scheduler, Task **task)
+static void task_scheduler_global_push(TaskScheduler *scheduler, Task *task, TaskPriority priority)
 {
-	bool found_task = false;
 	BLI_mutex_lock(&scheduler->queue_mutex);
 
-	while (!scheduler->queue.first && !scheduler->do_exit)
-		BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
+	if (priority == TASK_PRIORITY_HIGH)
+		BLI_addhead(&scheduler->queue, task);
+	else
+		BLI_addtail(&scheduler->queue, task);
+	atomic_add_and_fetch_z(&scheduler->num_queued, 1);
 
-	do {
-		Task *current_task;
+	BLI_condition_notify_one(&scheduler->queue_cond);
+	BLI_mutex_unlock(&scheduler->queue_mutex);
+}
 
-		/* Assuming we can only have a void queue in 'exit' case here seems logical (we should only be here after
-		 * our worker thread has been woken up from a condition_wait(), which only happens after a new task was
-		 * added to the queue), but it is wrong.
-		 * Waiting on condition may wake up the thread even if condition is not signaled (spurious wake-ups), and some
-		 * race condition may also empty the queue **after** condition has been signaled, but **before** awoken thread
-		 * reaches this point...
-		 * See http://stackoverflow.com/questions/8594591
-		 *
-		 * So we only abort here if do_exit is set.
-		 */
-		if (scheduler->do_exit) {
-			BLI_mutex_unlock(&scheduler->queue_mutex);
-			return false;
+/* Move task which can not be handled by current thread to the global queue,
+ * where threads which can handle it will find it.
+ */
+static void task_scheduler_reroute(TaskScheduler *scheduler, Task *task)
+{
+	TaskPool *pool = task->pool;
+	task_pool_push_begin(pool, 0);
+	task_scheduler_global_push(scheduler, task, TASK_PRIORITY_HIGH);
+	task_pool_push_end(pool);
+}
+
+/* Steal task from the queue of a random thread.
+ *
+ * If pool is specified, only tasks from this pool are stolen.
+ */
+static Task *task_scheduler_steal(TaskScheduler *scheduler,
+                                  TaskDeque *self,
+                                  TaskPool *pool,
+                                  unsigned int *seed)
+{
+	const int num_queues = scheduler->num_threads + 1;
+	const int start = (int)(task_steal_random(seed) % (unsigned int)num_queues);
+
+	if (!scheduler->use_work_stealing) {
+		return NULL;
+	}
+
+	for (int i = 0; i < num_queues; i++) {
+		TaskDeque *victim = &scheduler->task_threads[(start + i) % num_queues].deque;
+		Task *task;
+		if (victim == self) {
+			continue;
+		}
+		if ((task = task_deque_steal(victim, pool)) != NULL) {
+			return task;
 		}
+	}
 
-		for (current_task = scheduler->queue.first;
-		     current_task != NULL;
-		     current_task = current_task->next)
-		{
-			TaskPool *pool = current_task->pool;
+	return NULL;
+}
 
-			if (scheduler->background_thread_only && !pool->run_in_background) {
-				continue;
-			}
+static Task *task_scheduler_thread_get(TaskScheduler *scheduler,
+                                       TaskThread *thread,
+                                       unsigned int *seed)
+{
+	Task *task;
 
-			*task = current_task;
-			found_task = true;
-			BLI_remlink(&scheduler->queue, *task);
-			break;
+	/* Own queue first, most recently pushed task is most likely to have its
+	 * data in cache.
+	 */
+	if ((task = task_deque_pop(&thread->deque)) != NULL) {
+		return task;
+	}
+
+	/* Background-only thread must not pick up tasks from other pools, all its
+	 * tasks are coming from the global queue.
+	 */
+	if (!scheduler->background_thread_only) {
+		if ((task = task_scheduler_steal(scheduler, &thread->deque, NULL, seed)) != NULL) {
+			return task;
 		}
-		if (!found_task)
-			BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
-	} while (!found_task);
+	}
 
-	BLI_mutex_unlock(&scheduler->queue_mutex);
+	return task_scheduler_global_pop(scheduler, NULL);
+}
 
-	return true;
+/* NOTE: Is to be called with queue_mutex locked. */
+static bool task_scheduler_has_work(TaskScheduler *scheduler, TaskThread *thread)
+{
+	if (!task_deque_is_empty(&thread->deque)) {
+		return true;
+	}
+
+	if (scheduler->background_thread_only) {
+		for (Task *task = scheduler->queue.first; task != NULL; task = task->next) {
+			if (task->pool->run_in_background) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	if (scheduler->queue.first != NULL) {
+		return true;
+	}
+
+	if (!scheduler->use_work_stealing) {
+		return false;
+	}
+
+	for (int i = 0; i < scheduler->num_threads + 1; i++) {
+		if (!task_deque_is_empty(&scheduler->task_threads[i].deque)) {
+			return true;
+		}
+	}
+
+	return false;
 }
 
-BLI_INLINE void handle_local_queue(TaskThreadLocalStorage *tls,
-                                   const int thread_id)
+/* Sleep until new tasks are pushed, returns false when thread is to exit. */
+static bool task_scheduler_thread_wait(TaskScheduler *scheduler, TaskThread *thread)
 {
-	BLI_assert(!tls->do_delayed_push);
-	while (tls->num_local_queue > 0) {
-		/* We pop task from queue before handling it so handler of the task can
-		 * push next job to the local queue.
-		 */
-		tls->num_local_queue--;
-		Task *local_task = tls->local_queue[tls->num_local_queue];
-		/* TODO(sergey): Double-check work_and_wait() doesn't handle other's
-		 * pool tasks.
-		 */
-		TaskPool *local_pool = local_task->pool;
-		local_task->run(local_pool, local_task->taskdata, thread_id);
-		task_free(local_pool, local_task, thread_id);
+	bool do_exit;
+
+	BLI_mutex_lock(&scheduler->queue_mutex);
+
+	/* Full barrier: ordered against the bottom increment of a pushing thread,
+	 * so either it sees us sleeping or we see its task.
+	 */
+	atomic_add_and_fetch_u(&scheduler->num_sleeping, 1);
+
+	/* Spurious wake-ups are handled by the caller, which will try to get task
+	 * and come back here if there is nothing to do.
+	 */
+	if (!scheduler->do_exit && !task_scheduler_has_work(scheduler, thread)) {
+		BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
 	}
-	BLI_assert(!tls->do_delayed_push);
+
+	atomic_sub_and_fetch_u(&scheduler->num_sleeping, 1);
+	do_exit = scheduler->do_exit;
+
+	BLI_mutex_unlock(&scheduler->queue_mutex);
+
+	return !do_exit;
 }
 
 static void *task_scheduler_thread_run(void *thread_p)
 {
 	TaskThread *thread = (TaskThread *) thread_p;
-	TaskThreadLocalStorage *tls = &thread->tls;
 	TaskScheduler *scheduler = thread->scheduler;
 	int thread_id = thread->id;
-	Task *task;
+	unsigned int seed = (unsigned int)thread_id * 2654435761u + 1;
 
 	pthread_setspecific(scheduler->tls_id_key, thread);
 
 	/* keep popping off tasks */
-	while (task_scheduler_thread_wait_pop(scheduler, &task)) {
-		TaskPool *pool = task->pool;
+	while (!atomic_load_uint8((const uint8_t *)&scheduler->do_exit)) {
+		Task *task = task_scheduler_thread_get(scheduler, thread, &seed);
 
-		/* run task */
-		BLI_assert(!tls->do_delayed_push);
-		task->run(pool, task->taskdata, thread_id);
-		BLI_assert(!tls->do_delayed_push);
-
-		/* delete task */
-		task_free(pool, task, thread_id);
-
-		/* Handle all tasks from local queue. */
-		handle_local_queue(tls, thread_id);
+		if (task == NULL) {
+			if (!task_scheduler_thread_wait(scheduler, thread)) {
+				break;
+			}
+			continue;
+		}
 
-		/* notify pool task was done */
-		task_pool_num_decrease(pool, 1);
+		BLI_assert(!thread->tls.do_delayed_push);
+		task_execute(task->pool, task, thread_id);
+		BLI_assert(!thread->tls.do_delayed_push);
 	}
 
 	return NULL;
 }
 
-TaskScheduler *BLI_task_scheduler_create(int num_threads)
+TaskScheduler *BLI_task_scheduler_create_ex(int num_threads, const bool use_work_stealing)
 {
 	TaskScheduler *scheduler = MEM_callocN(sizeof(TaskScheduler), "TaskScheduler");
 
 	/* multiple places can use this task scheduler, sharing the same
 	 * threads, so we keep track of the number of users. */
 	scheduler->do_exit = false;
+	scheduler->use_work_stealing = use_work_stealing;
 
 	BLI_listbase_clear(&scheduler->queue);
 	BLI_mutex_init(&scheduler->queue_mutex);
@@ -479,10 +814,12 @@ TaskScheduler *BLI_task_scheduler_create(int num_threads)
 		num_threads = 1;
 	}
 
-	scheduler->task_threads = MEM_mallocN(sizeof(TaskThread) * (num_threads + 1),
+	scheduler->task_threads = MEM_callocN(sizeof(TaskThread) * (num_threads + 1),
 	                                      "TaskScheduler task threads");
 
-	/* Initialize TLS for main thread. */
+	/* Initialize TLS and queue for main thread. */
+	scheduler->task_threads[0].scheduler = scheduler;
+	scheduler->task_threads[0].id = 0;
 	initialize_task_tls(&scheduler->task_threads[0].tls);
 
 	pthread_key_create(&scheduler->tls_id_key, NULL);
@@ -509,13 +846,18 @@ TaskScheduler *BLI_task_scheduler_create(int num_threads)
 	return scheduler;
 }
 
+TaskScheduler *BLI_task_scheduler_create(int num_threads)
+{
+	return BLI_task_scheduler_create_ex(num_threads, true);
+}
+
 void BLI_task_scheduler_free(TaskScheduler *scheduler)
 {
 	Task *task;
 
 	/* stop all waiting threads */
 	BLI_mutex_lock(&scheduler->queue_mutex);
-	scheduler->do_exit = true;
+	atomic_store_uint8((uint8_t *)&scheduler->do_exit, true);
 	BLI_condition_notify_all(&scheduler->queue_cond);
 	BLI_mutex_unlock(&scheduler->queue_mutex);
 
@@ -537,6 +879,12 @@ void BLI_task_scheduler_free(TaskScheduler *scheduler)
 	if (scheduler->task_threads) {
 		for (int i = 0; i < scheduler->num_threads + 1; ++i) {
 			TaskThreadLocalStorage *tls = &scheduler->task_threads[i].tls;
+			TaskDeque *deque = &scheduler->task_threads[i].deque;
+			/* delete leftover tasks */
+			while ((task = task_deque_pop(deque)) != NULL) {
+				task_data_free(task, 0);
+				MEM_freeN(task);
+			}
 			free_task_tls(tls);
 		}
 
@@ -563,39 +911,14 @@ int BLI_task_scheduler_num_threads(TaskScheduler *scheduler)
 
 static void task_scheduler_push(TaskScheduler *scheduler, Task *task, TaskPriority priority)
 {
-	task_pool_num_increase(task->pool, 1);
+	TaskPool *pool = task->pool;
 
-	/* add task to queue */
-	BLI_mutex_lock(&scheduler->queue_mutex);
+	task_pool_push_begin(pool, 1);
 
-	if (priority == TASK_PRIORITY_HIGH)
-		BLI_addhead(&scheduler->queue, task);
-	else
-		BLI_addtail(&scheduler->queue, task);
-
-	BLI_condition_notify_one(&scheduler->queue_cond);
-	BLI_mutex_unlock(&scheduler->queue_mutex);
-}
-
-static void task_scheduler_push_all(TaskScheduler *scheduler,
-                                    TaskPool *pool,
-                                    Task **tasks,
-                                    int num_tasks)
-{
-	if (num_tasks == 0) {
-		return;
-	}
-
-	task_pool_num_increase(pool, num_tasks);
-
-	BLI_mutex_lock(&scheduler->queue_mutex);
-
-	for (int i = 0; i < num_tasks; i++) {
-		BLI_addhead(&scheduler->queue, tasks[i]);
-	}
+	/* add task to queue */
+	task_scheduler_global_push(scheduler, task, priority);
 
-	BLI_condition_notify_all(&scheduler->queue_cond);
-	BLI_mutex_unlock(&scheduler->queue_mutex);
+	task_pool_push_end(pool);
 }
 
 static void task_scheduler_clear(TaskScheduler *scheduler, TaskPool *pool)
@@ -612,6 +935,7 @@ static void task_scheduler_clear(TaskScheduler *scheduler, TaskPool *pool)
 		if (task->pool == pool) {
 			task_data_free(task, pool->thread_id);
 			BLI_freelinkN(&scheduler->queue, task);
+			atomic_sub_and_fetch_z(&scheduler->num_queued, 1);
 
 			done++;
 		}
@@ -619,8 +943,29 @@ static void task_scheduler_clear(TaskScheduler *scheduler, TaskPool *pool)
 
 	BLI_mutex_unlock(&scheduler->queue_mutex);
 
+	/* Tasks from other thread queues will be discarded by whoever picks them
+	 * up, but current thread's queue is not guaranteed to be handled by anyone
+	 * else (i.e. in single-threaded case), so clear it from here.
+	 */
+	TaskThread *thread = BLI_thread_is_main() ? &scheduler->task_threads[0]
+	                                          : pthread_getspecific(scheduler->tls_id_key);
+	if (thread != NULL) {
+		while ((task = task_deque_pop(&thread->deque)) != NULL) {
+			if (task->pool == pool) {
+				task_data_free(task, thread->id);
+				MEM_freeN(task);
+				done++;
+			}
+			else {
+				task_scheduler_reroute(scheduler, task);
+			}
+		}
+	}
+
 	/* notify done */
-	task_pool_num_decrease(pool, done);
+	if (done != 0) {
+		task_pool_num_decrease(pool, done);
+	}
 }
 
 /* Task Pool */
@@ -646,6 +991,8 @@ static TaskPool *task_pool_create_ex(TaskScheduler *scheduler,
 
 	pool->scheduler = scheduler;
 	pool->num = 0;
+	pool->num_pushed = 0;
+	pool->num_waiting = 0;
 	pool->do_cancel = false;
 	pool->do_work = false;
 	pool->is_suspended = is_suspended;
@@ -788,34 +1135,43 @@ static void task_pool_push(
 	 * This tasks will be moved to actual execution when pool is
 	 * activated by work_and_wait().
 	 */
-	if (pool->is_suspended) {
+	if (atomic_load_uint8((const uint8_t *)&pool->is_suspended)) {
 		BLI_addhead(&pool->suspended_queue, task);
 		atomic_fetch_and_add_z(&pool->num_suspended, 1);
 		return;
 	}
-	/* Populate to any local queue first, this is cheapest push ever. */
+	/* Populate to the thread's own queue first, this is cheapest push ever.
+	 * The task will be picked up by this thread next, unless some idle thread
+	 * steals it first.
+	 */
 	if (task_can_use_local_queues(pool, thread_id)) {
 		ASSERT_THREAD_ID(pool->scheduler, thread_id);
-		TaskThreadLocalStorage *tls = get_task_tls(pool, thread_id);
-		/* Try to push to a local execution queue.
-		 * These tasks will be picked up next.
-		 */
-		if (tls->num_local_queue < LOCAL_QUEUE_SIZE) {
-			tls->local_queue[tls->num_local_queue] = task;
-			tls->num_local_queue++;
-			return;
-		}
-		/* If we are in the delayed tasks push mode, we push tasks to a
-		 * temporary local queue first without any locks, and then move them
-		 * to global execution queue with a single lock.
-		 */
-		if (tls->do_delayed_push && tls->num_delayed_queue < DELAYED_QUEUE_SIZE) {
-			tls->delayed_queue[tls->num_delayed_queue] = task;
-			tls->num_delayed_queue++;
+		TaskDeque *deque = get_task_deque(pool, thread_id);
+		if (deque != NULL) {
+			TaskScheduler *scheduler = pool->scheduler;
+			TaskThreadLocalStorage *tls = get_task_tls(pool, thread_id);
+			task_pool_push_begin(pool, 1);
+			if ((!scheduler->use_work_stealing && !task_deque_is_empty(deque)) ||
+			    !task_deque_push(deque, task))
+			{
+				/* Queue is saturated, fallback to a global one. */
+				task_scheduler_global_push(scheduler, task, priority);
+			}
+			else if (!scheduler->use_work_stealing) {
+				/* Nobody else takes the task, no need to wake anyone up. */
+			}
+			else if (tls->do_delayed_push) {
+				/* Sleeping threads will be woken up in delayed_push_end(). */
+				tls->num_delayed_push++;
+			}
+			else {
+				task_scheduler_wakeup(pool->scheduler, 1);
+			}
+			task_pool_push_end(pool);
 			return;
 		}
 	}
-	/* Do push to a global execution ppol, slowest possible method,
+	/* Do push to a global execution pool, slowest possible method,
 	 * causes quite reasonable amount of threading overhead.
 	 */
 	task_scheduler_push(pool->scheduler, task, priority);
@@ -840,10 +1196,40 @@ void BLI_task_pool_push_from_thread(TaskPool *pool, TaskRunFunction run,
 	task_pool_push(pool, run, taskdata, free_taskdata, NULL, priority, thread_id);
 }
 
+/* Find task from the given pool. If we get a task from another pool, we can get
+ * into deadlock, so tasks from other pools which are above the pool's ones in
+ * the own queue are moved to the global queue, where other threads will pick
+ * them up.
+ */
+static Task *task_pool_find_task(TaskPool *pool, TaskDeque *deque, unsigned int *seed)
+{
+	TaskScheduler *scheduler = pool->scheduler;
+	Task *task;
+
+	if (deque != NULL && task_deque_has_pool(deque, pool)) {
+		while ((task = task_deque_pop(deque)) != NULL) {
+			if (task->pool == pool) {
+				return task;
+			}
+			task_scheduler_reroute(scheduler, task);
+		}
+	}
+
+	if (!scheduler->background_thread_only) {
+		if ((task = task_scheduler_steal(scheduler, deque, pool, seed)) != NULL) {
+			return task;
+		}
+	}
+
+	return task_scheduler_global_pop(scheduler, pool);
+}
+
 void BLI_task_pool_work_and_wait(TaskPool *pool)
 {
 	TaskThreadLocalStorage *tls = get_task_tls(pool, pool->thread_id);
 	TaskScheduler *scheduler = pool->scheduler;
+	TaskDeque *deque = get_task_deque(pool, pool->thread_id);
+	unsigned int seed = (unsigned int)pool->thread_id * 2654435761u + 1;
 
 	if (atomic_fetch_and_and_uint8((uint8_t *)&pool->is_suspended, 0)) {
 		if (pool->num_suspended) {
@@ -851,6 +1237,7 @@ void BLI_task_pool_work_and_wait(TaskPool *pool)
 			BLI_mutex_lock(&scheduler->queue_mutex);
 
 			BLI_movelisttolist(&scheduler->queue, &pool->suspended_queue);
+			atomic_add_and_fetch_z(&scheduler->num_queued, pool->num_suspended);
 
 			BLI_condition_notify_all(&scheduler->queue_cond);
 			BLI_mutex_unlock(&scheduler->queue_mutex);
@@ -861,78 +1248,58 @@ void BLI_task_pool_work_and_wait(TaskPool *pool)
 
 	ASSERT_THREAD_ID(pool->scheduler, pool->thread_id);
 
-	BLI_mutex_lock(&pool->num_mutex);
-
-	while (pool->num != 0) {
-		Task *task, *work_task = NULL;
-		bool found_task = false;
-
-		BLI_mutex_unlock(&pool->num_mutex);
-
-		BLI_mutex_lock(&scheduler->queue_mutex);
-
-		/* find task from this pool. if we get a task from another pool,
-		 * we can get into deadlock */
-
-		for (task = scheduler->queue.first; task; task = task->next) {
-			if (task->pool == pool) {
-				work_task = task;
-				found_task = true;
-				BLI_remlink(&scheduler->queue, task);
-				break;
-			}
-		}
-
-		BLI_mutex_unlock(&scheduler->queue_mutex);
+	while (atomic_load_z(&pool->num) != 0) {
+		const size_t num_pushed = atomic_load_z(&pool->num_pushed);
+		Task *task = task_pool_find_task(pool, deque, &seed);
 
 		/* if found task, do it, otherwise wait until other tasks are done */
-		if (found_task) {
-			/* run task */
+		if (task != NULL) {
 			BLI_assert(!tls->do_delayed_push);
-			work_task->run(pool, work_task->taskdata, pool->thread_id);
+			task_execute(pool, task, pool->thread_id);
 			BLI_assert(!tls->do_delayed_push);
-
-			/* delete task */
-			task_free(pool, task, pool->thread_id);
-
-			/* Handle all tasks from local queue. */
-			handle_local_queue(tls, pool->thread_id);
-
-			/* notify pool task was done */
-			task_pool_num_decrease(pool, 1);
+			continue;
 		}
 
+		/* Wait until either all tasks are done or new tasks are pushed to
+		 * the pool. Tasks pushed after num_pushed was read are not missed
+		 * since that would change the counter.
+		 */
 		BLI_mutex_lock(&pool->num_mutex);
-		if (pool->num == 0)
-			break;
-
-		if (!found_task)
+		atomic_add_and_fetch_u(&pool->num_waiting, 1);
+		if (atomic_load_z(&pool->num) != 0 && atomic_load_z(&pool->num_pushed) == num_pushed) {
 			BLI_condition_wait(&pool->num_cond, &pool->num_mutex);
+		}
+		atomic_sub_and_fetch_u(&pool->num_waiting, 1);
+		BLI_mutex_unlock(&pool->num_mutex);
 	}
 
+	/* Thread which finished the last task might still be notifying, the pool
+	 * can only be freed once it released num_mutex.
+	 */
+	BLI_mutex_lock(&pool->num_mutex);
 	BLI_mutex_unlock(&pool->num_mutex);
 
-	handle_local_queue(tls, pool->thread_id);
+	UNUSED_VARS_NDEBUG(tls);
 }
 
 void BLI_task_pool_cancel(TaskPool *pool)
 {
-	pool->do_cancel = true;
+	atomic_store_uint8((uint8_t *)&pool->do_cancel, true);
 
 	task_scheduler_clear(pool->scheduler, pool);
 
 	/* wait until all entries are cleared */
 	BLI_mutex_lock(&pool->num_mutex);
-	while (pool->num)
+	while (atomic_load_z(&pool->num))
 		BLI_condition_wait(&pool->num_cond, &pool->num_mutex);
 	BLI_mutex_unlock(&pool->num_mutex);
 
-	pool->do_cancel = false;
+	atomic_store_uint8((uint8_t *)&pool->do_cancel, false);
 }
 
 bool BLI_task_pool_canceled(TaskPool *pool)
 {
-	return pool->do_cancel;
+	return atomic_load_uint8((const uint8_t *)&pool->do_cancel);
 }
 
 void *BLI_task_pool_userdata(TaskPool *pool)
@@ -960,12 +1327,11 @@ void BLI_task_pool_delayed_push_end(TaskPool *pool, int thread_id)
 		ASSERT_THREAD_ID(pool->scheduler, thread_id);
 		TaskThreadLocalStorage *tls = get_task_tls(pool, thread_id);
 		BLI_assert(tls->do_delayed_push);
-		task_scheduler_push_all(pool->scheduler,
-		                        pool,
-		                        tls->delayed_queue,
-		                        tls->num_delayed_queue);
+		if (tls->num_delayed_push != 0) {
+			task_scheduler_wakeup(pool->scheduler, tls->num_delayed_push);
+		}
 		tls->do_delayed_push = false;
-		tls->num_delayed_queue = 0;
+		tls->num_delayed_push = 0;
 	}
 }
 
@@ -596,6 +596,41 @@ void BLI_ticket_mutex_unlock(TicketMutex *ticket)
 
 /* Condition */
 
+static void wait_timeout(struct timespec *timeout, int ms)
+{
+	ldiv_t div_result;
+	long sec, usec, x;
+
+#ifdef WIN32
+	{
+		struct _timeb now;
+		_ftime(&now);
+		sec = now.time;
+		usec = now.millitm * 1000; /* microsecond precision would be better */
+	}
+#else
+	{
+		struct timeval now;
+		gettimeofday(&now, NULL);
+		sec = now.tv_sec;
+		usec = now.tv_usec;
+	}
+#endif
+
+	/* add current time + millisecond offset */
+	div_result = ldiv(ms, 1000);
+	timeout->tv_sec = sec + div_result.quot;
+
+	x = usec + (div_result.rem * 1000);
+
+	if (x >= 1000000) {
+		timeout->tv_sec++;
+		x -= 1000000;
+	}
+
+	timeout->tv_nsec = x * 1000;
+}
+
 void BLI_condition_init(ThreadCondition *cond)
 {
 	pthread_cond_init(cond, NULL);
@@ -606,6 +641,15 @@ void BLI_condition_wait(ThreadCondition *cond, ThreadMutex *mutex)
 	pthread_cond_wait(cond, mutex);
 }
 
+/* Wait until notified or \a ms milliseconds passed, callers have to check their condition again. */
+void BLI_condition_wait_timeout(ThreadCondition *cond, ThreadMutex *mutex, int ms)
+{
+	struct timespec timeout;
+
+	wait_timeout(&timeout, ms);
+	pthread_cond_timedwait(cond, mutex, &timeout);
+}
+
 void BLI_condition_wait_global_mutex(ThreadCondition *cond, const int type)
 {
 	pthread_cond_wait(cond, global_mutex_from_type(type));
@@ -696,41 +740,6 @@ void *BLI_thread_queue_pop(ThreadQueue *queue)
 	return work;
 }
 
-static void wait_timeout(struct timespec *timeout, int ms)
-{
-	ldiv_t div_result;
-	long sec, usec, x;
-
-#ifdef WIN32
-	{
-		struct _timeb now;
-		_ftime(&now);
-		sec = now.time;
-		usec = now.millitm * 1000; /* microsecond precision would be better */
-	}
-#else
-	{
-		struct timeval now;
-		gettimeofday(&now, NULL);
-		sec = now.tv_sec;
-		usec = now.tv_usec;
-	}
-#endif
-
-	/* add current time + millisecond offset */
-	div_result = ldiv(ms, 1000);
-	timeout->tv_sec = sec + div_result.quot;
-
-	x = usec + (div_result.rem * 1000);
-
-	if (x >= 1000000) {
-		timeout->tv_sec++;
-		x -= 1000000;
-	}
-
-	timeout->tv_nsec = x * 1000;
-}
-
 void *BLI_thread_queue_pop_timeout(ThreadQueue *queue, int ms)
 {
 	double t;
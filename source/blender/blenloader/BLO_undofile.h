@@ -33,25 +33,41 @@
  *  \ingroup blenloader
  */
 
+struct MemFileSharedChunk;
+
 typedef struct {
 	void *next, *prev;
 	
 	char *buf;
+	/* buf is owned by the shared chunk, refcounted between all undo steps */
+	struct MemFileSharedChunk *shared;
+	/* ident: data was already stored by another undo step */
 	unsigned int ident, size;
 	
 } MemFileChunk;
 
 typedef struct MemFile {
 	ListBase chunks;
-	unsigned int size;
+	/* size of the chunks newly stored by this file, and size of all chunks */
+	unsigned int size, size_total;
 } MemFile;
 
+typedef struct MemFileStats {
+	/* chunks shared between all memfiles */
+	size_t chunks_len;
+	/* bytes stored once per unique chunk */
+	size_t size_stored;
+	/* bytes all memfiles would use without sharing chunks */
+	size_t size_referenced;
+} MemFileStats;
+
 /* actually only used writefile.c */
 extern void memfile_chunk_add(MemFile *compare, MemFile *current, const char *buf, unsigned int size);
 
 /* exports */
 extern void BLO_memfile_free(MemFile *memfile);
 extern void BLO_memfile_merge(MemFile *first, MemFile *second);
+extern void BLO_memfile_stats(MemFileStats *r_stats);
 
 #endif
 
@@ -45,6 +45,8 @@
 #include "BLI_utildefines.h"
 #ifndef WIN32
 #  include <unistd.h> // for read close
+#  include <sys/mman.h> // for mmap
+#  include <sys/stat.h>
 #else
 #  include <io.h> // for open close read
 #  include "winsock2.h"
@@ -115,9 +117,12 @@
 
 #include "BLI_endian_switch.h"
 #include "BLI_blenlib.h"
+#include "BLI_flathash.h"
+#include "BLI_lz4.h"
 #include "BLI_math.h"
 #include "BLI_threads.h"
 #include "BLI_mempool.h"
+#include "BLI_task.h"
 
 #include "BLT_translation.h"
 
@@ -225,8 +230,8 @@
  * (added remark: oh, i thought that was solved? will look at that... (ton).
  */
 
-/* use GHash for BHead name-based lookups (speeds up linking) */
-#define USE_GHASH_BHEAD
+/* use FlatHash for BHead name-based lookups (speeds up linking) */
+#define USE_FLATHASH_BHEAD
 
 /* Use GHash for restoring pointers by name */
 #define USE_GHASH_RESTORE_POINTER
@@ -249,6 +254,8 @@ typedef struct OldNewMap {
 
 /* local prototypes */
 static void *read_struct(FileData *fd, BHead *bh, const char *blockname);
+static const void *read_struct_temp(FileData *fd, BHead *bh, const char *blockname);
+static void read_struct_temp_free(BHead *bh, const void *data);
 static void direct_link_modifiers(FileData *fd, ListBase *lb);
 static BHead *find_bhead_from_code_name(FileData *fd, const short idcode, const char *name);
 static BHead *find_bhead_from_idname(FileData *fd, const char *idname);
@@ -565,12 +572,12 @@ static void read_file_version(FileData *fd, Main *main)
 	
 	for (bhead= blo_firstbhead(fd); bhead; bhead= blo_nextbhead(fd, bhead)) {
 		if (bhead->code == GLOB) {
-			FileGlobal *fg= read_struct(fd, bhead, "Global");
+			const FileGlobal *fg= read_struct_temp(fd, bhead, "Global");
 			if (fg) {
 				main->subversionfile= fg->subversion;
 				main->minversionfile= fg->minversion;
 				main->minsubversionfile= fg->minsubversion;
-				MEM_freeN(fg);
+				read_struct_temp_free(bhead, fg);
 			}
 			else if (bhead->code == ENDB)
 				break;
@@ -582,7 +589,7 @@ static void read_file_version(FileData *fd, Main *main)
 	}
 }
 
-#ifdef USE_GHASH_BHEAD
+#ifdef USE_FLATHASH_BHEAD
 static void read_file_bhead_idname_map_create(FileData *fd)
 {
 	BHead *bhead;
@@ -605,7 +612,7 @@ static void read_file_bhead_idname_map_create(FileData *fd)
 
 	BLI_assert(fd->bhead_idname_hash == NULL);
 
-	fd->bhead_idname_hash = BLI_ghash_str_new_ex(__func__, reserve);
+	fd->bhead_idname_hash = BLI_flathash_str_new_ex(__func__, reserve);
 
 	for (bhead = blo_firstbhead(fd); bhead; bhead = blo_nextbhead(fd, bhead)) {
 		if (code_prev != bhead->code) {
@@ -614,7 +621,7 @@ static void read_file_bhead_idname_map_create(FileData *fd)
 		}
 
 		if (is_link) {
-			BLI_ghash_insert(fd->bhead_idname_hash, (void *)bhead_id_name(fd, bhead), bhead);
+			BLI_flathash_insert(fd->bhead_idname_hash, (void *)bhead_id_name(fd, bhead), bhead);
 		}
 	}
 }
@@ -798,13 +805,33 @@ static BHeadN *get_bhead(FileData *fd)
 			/* bhead now contains the (converted) bhead structure. Now read
 			 * the associated data and put everything in a BHeadN (creative naming !)
 			 */
-			if (!fd->eof) {
+			if (!fd->eof && fd->filebuf_data) {
+				/* point into the file mapping or buffer, a block running past its end
+				 * (truncated file) ends reading instead of touching unmapped pages */
+				if ((size_t)bhead.len <= fd->filebuf_size - fd->filebuf_offset) {
+					new_bhead = MEM_mallocN(sizeof(BHeadN), "new_bhead");
+					new_bhead->next = new_bhead->prev = NULL;
+					new_bhead->data = fd->filebuf_data + fd->filebuf_offset;
+					new_bhead->data_converted = NULL;
+					new_bhead->is_converted = false;
+					new_bhead->bhead = bhead;
+
+					fd->filebuf_offset += (size_t)bhead.len;
+				}
+				else {
+					fd->eof = 1;
+				}
+			}
+			else if (!fd->eof) {
 				new_bhead = MEM_mallocN(sizeof(BHeadN) + bhead.len, "new_bhead");
 				if (new_bhead) {
 					new_bhead->next = new_bhead->prev = NULL;
+					new_bhead->data = new_bhead + 1;
+					new_bhead->data_converted = NULL;
+					new_bhead->is_converted = false;
 					new_bhead->bhead = bhead;
 					
-					readsize = fd->read(fd, new_bhead + 1, bhead.len);
+					readsize = fd->read(fd, new_bhead->data, bhead.len);
 					
 					if (readsize != bhead.len) {
 						fd->eof = 1;
@@ -851,7 +878,7 @@ BHead *blo_firstbhead(FileData *fd)
 
 BHead *blo_prevbhead(FileData *UNUSED(fd), BHead *thisblock)
 {
-	BHeadN *bheadn = (BHeadN *)POINTER_OFFSET(thisblock, -offsetof(BHeadN, bhead));
+	BHeadN *bheadn = BHEADN_FROM_BHEAD(thisblock);
 	BHeadN *prev = bheadn->prev;
 	
 	return (prev) ? &prev->bhead : NULL;
@@ -865,7 +892,7 @@ BHead *blo_nextbhead(FileData *fd, BHead *thisblock)
 	if (thisblock) {
 		/* bhead is actually a sub part of BHeadN
 		 * We calculate the BHeadN pointer from the BHead pointer below */
-		new_bhead = (BHeadN *)POINTER_OFFSET(thisblock, -offsetof(BHeadN, bhead));
+		new_bhead = BHEADN_FROM_BHEAD(thisblock);
 		
 		/* get the next BHeadN. If it doesn't exist we read in the next one */
 		new_bhead = new_bhead->next;
@@ -886,7 +913,7 @@ BHead *blo_nextbhead(FileData *fd, BHead *thisblock)
 /* Warning! Caller's responsability to ensure given bhead **is** and ID one! */
 const char *bhead_id_name(const FileData *fd, const BHead *bhead)
 {
-	return (const char *)POINTER_OFFSET(bhead, sizeof(*bhead) + fd->id_name_offs);
+	return (const char *)POINTER_OFFSET(BHEAD_DATA(bhead), fd->id_name_offs);
 }
 
 static void decode_blender_header(FileData *fd)
@@ -940,7 +967,7 @@ static bool read_file_dna(FileData *fd, const char **r_error_message)
 		if (bhead->code == DNA1) {
 			const bool do_endian_swap = (fd->flags & FD_FLAGS_SWITCH_ENDIAN) != 0;
 			
-			fd->filesdna = DNA_sdna_from_data(&bhead[1], bhead->len, do_endian_swap, true, r_error_message);
+			fd->filesdna = DNA_sdna_from_data(BHEAD_DATA(bhead), bhead->len, do_endian_swap, true, r_error_message);
 			if (fd->filesdna) {
 				fd->compflags = DNA_struct_get_compareflags(fd->filesdna, fd->memsdna);
 				/* used to retrieve ID names from (bhead+1) */
@@ -969,7 +996,7 @@ static int *read_file_thumbnail(FileData *fd)
 	for (bhead = blo_firstbhead(fd); bhead; bhead = blo_nextbhead(fd, bhead)) {
 		if (bhead->code == TEST) {
 			const bool do_endian_swap = (fd->flags & FD_FLAGS_SWITCH_ENDIAN) != 0;
-			int *data = (int *)(bhead + 1);
+			int *data = (int *)BHEAD_DATA(bhead);
 
 			if (bhead->len < (2 * sizeof(int))) {
 				break;
@@ -1035,6 +1062,17 @@ static int fd_read_from_memory(FileData *filedata, void *buffer, unsigned int si
 	return (readsize);
 }
 
+static int fd_read_from_filebuf(FileData *filedata, void *buffer, unsigned int size)
+{
+	/* don't read more bytes then there are available in the buffer */
+	const size_t readsize = MIN2((size_t)size, filedata->filebuf_size - filedata->filebuf_offset);
+
+	memcpy(buffer, filedata->filebuf_data + filedata->filebuf_offset, readsize);
+	filedata->filebuf_offset += readsize;
+
+	return (int)readsize;
+}
+
 static int fd_read_from_memfile(FileData *filedata, void *buffer, unsigned int size)
 {
 	static unsigned int seek = (1<<30);	/* the current position */
@@ -1133,11 +1171,356 @@ static FileData *blo_decode_and_check(FileData *fd, ReportList *reports)
 	return fd;
 }
 
+#ifndef WIN32
+/**
+ * Map uncompressed files into memory, so block data doesn't have to be read into
+ * separate allocations (see get_bhead) and points into the mapping. The mapping is
+ * private, pages which are modified in place (endian switching) are copied on write
+ * by the system.
+ *
+ * Block lengths are checked against the size of the mapping, so a file which was
+ * truncated before it was opened reads up to the broken block, as with gzip reading.
+ *
+ * \return NULL for compressed files or when mapping fails, read into a buffer then.
+ */
+static FileData *blo_openblenderfile_mmap(const char *filepath)
+{
+	FileData *fd = NULL;
+	struct stat st;
+	char header[7];
+	void *data;
+	int file;
+
+	file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+	if (file == -1) {
+		return NULL;
+	}
+
+	if ((fstat(file, &st) == 0) &&
+	    (st.st_size > (off_t)sizeof(header)) &&
+	    (read(file, header, sizeof(header)) == sizeof(header)) &&
+	    (memcmp(header, "BLENDER", sizeof(header)) == 0))
+	{
+		data = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+		if (data != MAP_FAILED) {
+			fd = filedata_new();
+			fd->filebuf_data = data;
+			fd->filebuf_size = (size_t)st.st_size;
+			fd->filebuf_offset = 0;
+			fd->flags |= FD_FLAGS_FILE_MAPPED;
+			fd->read = fd_read_from_filebuf;
+		}
+	}
+
+	/* the mapping stays valid after closing */
+	close(file);
+
+	return fd;
+}
+#endif
+
+/**
+ * Read uncompressed files into memory with a single read, so block data doesn't have
+ * to be read into separate allocations (see get_bhead) and points into this buffer.
+ * Used where files can't be mapped.
+ *
+ * \return NULL for compressed files or when reading fails, use gzip reading then.
+ */
+static FileData *blo_openblenderfile_buffer(const char *filepath)
+{
+	FileData *fd = NULL;
+	char header[7];
+	void *data;
+	size_t data_len;
+	int file;
+	bool ok;
+
+	file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+	if (file == -1) {
+		return NULL;
+	}
+	ok = ((read(file, header, sizeof(header)) == sizeof(header)) &&
+	      (memcmp(header, "BLENDER", sizeof(header)) == 0));
+	close(file);
+
+	if (!ok) {
+		return NULL;
+	}
+
+	data = BLI_file_read_binary_as_mem(filepath, 0, &data_len);
+	if (data != NULL) {
+		fd = filedata_new();
+		fd->filebuf_data = data;
+		fd->filebuf_size = data_len;
+		fd->filebuf_offset = 0;
+		fd->read = fd_read_from_filebuf;
+	}
+
+	return fd;
+}
+
+/* Block compressed files, see writefile.c */
+
+typedef struct BlendFileBlock {
+	const unsigned char *src;
+	size_t src_len;
+	char *dst;
+	size_t dst_len;
+	unsigned int crc;
+	bool error;
+} BlendFileBlock;
+
+typedef struct BlendFileBlocks {
+	BlendFileBlock *blocks;
+	int blocks_len;
+	bool is_lz4;
+} BlendFileBlocks;
+
+BLI_INLINE unsigned int blend_blocks_uint32_from_le(const unsigned char *src)
+{
+	return ((unsigned int)src[0]) | ((unsigned int)src[1] << 8) |
+	       ((unsigned int)src[2] << 16) | ((unsigned int)src[3] << 24);
+}
+
+static bool blend_blocks_is_gzip_member(const unsigned char *src, const size_t src_len)
+{
+	return ((src_len >= BLEND_GZIP_BLOCK_HEADER_SIZE + 8) &&
+	        (src[0] == 0x1f) && (src[1] == 0x8b) && (src[2] == 8) && (src[3] == 4) &&
+	        (src[10] == 8) && (src[11] == 0) &&
+	        (src[12] == BLEND_GZIP_BLOCK_SI1) && (src[13] == BLEND_GZIP_BLOCK_SI2) &&
+	        (src[14] == 4) && (src[15] == 0));
+}
+
+/**
+ * Locate the blocks in \a data, when \a r_blocks is NULL only count them.
+ *
+ * \return The number of blocks, -1 when the data is invalid.
+ */
+static int blend_blocks_index(
+        const unsigned char *data, const size_t data_len, const bool is_lz4,
+        BlendFileBlock *r_blocks, size_t *r_total)
+{
+	size_t offset = is_lz4 ? BLEND_LZ4_MAGIC_SIZE : 0;
+	size_t total = 0;
+	int blocks_len = 0;
+
+	if (is_lz4) {
+		for (;;) {
+			size_t raw_len, comp_len;
+
+			if (data_len - offset < 8) {
+				return -1;
+			}
+			raw_len = blend_blocks_uint32_from_le(data + offset);
+			comp_len = blend_blocks_uint32_from_le(data + offset + 4);
+			offset += 8;
+
+			if (raw_len == 0) {
+				break;
+			}
+			if ((raw_len > BLEND_BLOCK_SIZE_MAX) || (comp_len > raw_len) || (comp_len > data_len - offset)) {
+				return -1;
+			}
+
+			if (r_blocks) {
+				BlendFileBlock *block = &r_blocks[blocks_len];
+				block->src = data + offset;
+				block->src_len = comp_len;
+				block->dst_len = raw_len;
+			}
+
+			offset += comp_len;
+			total += raw_len;
+			blocks_len++;
+		}
+	}
+	else {
+		while (offset < data_len) {
+			const unsigned char *member = data + offset;
+			size_t member_len;
+
+			if (!blend_blocks_is_gzip_member(member, data_len - offset)) {
+				return -1;
+			}
+			member_len = blend_blocks_uint32_from_le(member + 16);
+			if ((member_len < BLEND_GZIP_BLOCK_HEADER_SIZE + 8) || (member_len > data_len - offset) ||
+			    (blend_blocks_uint32_from_le(member + member_len - 4) > BLEND_BLOCK_SIZE_MAX))
+			{
+				return -1;
+			}
+
+			if (r_blocks) {
+				BlendFileBlock *block = &r_blocks[blocks_len];
+				block->src = member + BLEND_GZIP_BLOCK_HEADER_SIZE;
+				block->src_len = member_len - (BLEND_GZIP_BLOCK_HEADER_SIZE + 8);
+				block->dst_len = blend_blocks_uint32_from_le(member + member_len - 4);
+				block->crc = blend_blocks_uint32_from_le(member + member_len - 8);
+			}
+
+			offset += member_len;
+			total += blend_blocks_uint32_from_le(member + member_len - 4);
+			blocks_len++;
+		}
+	}
+
+	*r_total = total;
+	return blocks_len;
+}
+
+static void blend_blocks_decode_cb(void *userdata, const int index)
+{
+	BlendFileBlocks *bfb = userdata;
+	BlendFileBlock *block = &bfb->blocks[index];
+
+	if (bfb->is_lz4) {
+		if (block->src_len == block->dst_len) {
+			/* stored uncompressed */
+			memcpy(block->dst, block->src, block->dst_len);
+		}
+		else {
+			block->error = !BLI_lz4_decompress(block->src, block->src_len, block->dst, block->dst_len);
+		}
+	}
+	else {
+		z_stream strm = {NULL};
+
+		if (inflateInit2(&strm, -MAX_WBITS) != Z_OK) {
+			block->error = true;
+			return;
+		}
+
+		strm.next_in = (Bytef *)block->src;
+		strm.avail_in = (uInt)block->src_len;
+		strm.next_out = (Bytef *)block->dst;
+		strm.avail_out = (uInt)block->dst_len;
+
+		block->error = ((inflate(&strm, Z_FINISH) != Z_STREAM_END) ||
+		                (strm.total_out != block->dst_len) ||
+		                (crc32(0, (const Bytef *)block->dst, (uInt)block->dst_len) != block->crc));
+		inflateEnd(&strm);
+	}
+}
+
+/**
+ * Decompress files written in independent blocks (LZ4, or gzip with the block size stored
+ * in the member headers) in parallel, reading then happens from the decompressed buffer.
+ *
+ * \param use_gzip: Also handle block compressed gzip files,
+ * these can be streamed with gzip reading as well.
+ * \return NULL when the file isn't block compressed, \a r_error is set when it is but decoding failed.
+ */
+static FileData *blo_openblenderfile_blocks(const char *filepath, const bool use_gzip, bool *r_error)
+{
+	FileData *fd = NULL;
+	unsigned char header[BLEND_GZIP_BLOCK_HEADER_SIZE];
+	unsigned char *data;
+	size_t data_len, total;
+	BlendFileBlocks bfb = {NULL};
+	int file, i;
+	bool ok;
+
+	*r_error = false;
+
+	file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+	if (file == -1) {
+		return NULL;
+	}
+	ok = (read(file, header, sizeof(header)) == sizeof(header));
+	close(file);
+
+	if (!ok) {
+		return NULL;
+	}
+	if (memcmp(header, BLEND_LZ4_MAGIC, BLEND_LZ4_MAGIC_SIZE) == 0) {
+		bfb.is_lz4 = true;
+	}
+	else if (!(use_gzip && blend_blocks_is_gzip_member(header, SIZE_MAX))) {
+		return NULL;
+	}
+
+	data = BLI_file_read_binary_as_mem(filepath, 0, &data_len);
+	if (data == NULL) {
+		*r_error = true;
+		return NULL;
+	}
+
+	bfb.blocks_len = blend_blocks_index(data, data_len, bfb.is_lz4, NULL, &total);
+	if (bfb.blocks_len > 0) {
+		char *dst = MEM_mallocN(total, __func__);
+
+		bfb.blocks = MEM_callocN(sizeof(*bfb.blocks) * (size_t)bfb.blocks_len, __func__);
+		blend_blocks_index(data, data_len, bfb.is_lz4, bfb.blocks, &total);
+
+		for (i = 0; i < bfb.blocks_len; i++) {
+			bfb.blocks[i].dst = dst;
+			dst += bfb.blocks[i].dst_len;
+		}
+
+		BLI_task_parallel_range(0, bfb.blocks_len, &bfb, blend_blocks_decode_cb, bfb.blocks_len > 1);
+
+		ok = true;
+		for (i = 0; i < bfb.blocks_len; i++) {
+			ok &= !bfb.blocks[i].error;
+		}
+
+		if (ok) {
+			fd = filedata_new();
+			fd->filebuf_data = bfb.blocks[0].dst;
+			fd->filebuf_size = total;
+			fd->filebuf_offset = 0;
+			fd->read = fd_read_from_filebuf;
+		}
+		else {
+			MEM_freeN(bfb.blocks[0].dst);
+		}
+
+		MEM_freeN(bfb.blocks);
+	}
+
+	MEM_freeN(data);
+
+	*r_error = (fd == NULL);
+	return fd;
+}
+
 /* cannot be called with relative paths anymore! */
 /* on each new library added, it now checks for the current FileData and expands relativeness */
 FileData *blo_openblenderfile(const char *filepath, ReportList *reports)
 {
 	gzFile gzfile;
+	bool error;
+
+	{
+		FileData *fd = NULL;
+#ifndef WIN32
+		fd = blo_openblenderfile_mmap(filepath);
+#endif
+		if (fd == NULL) {
+			fd = blo_openblenderfile_buffer(filepath);
+		}
+		if (fd) {
+			/* needed for library_append and read_libraries */
+			BLI_strncpy(fd->relabase, filepath, sizeof(fd->relabase));
+
+			return blo_decode_and_check(fd, reports);
+		}
+	}
+
+	{
+		FileData *fd = blo_openblenderfile_blocks(filepath, true, &error);
+		if (fd) {
+			/* needed for library_append and read_libraries */
+			BLI_strncpy(fd->relabase, filepath, sizeof(fd->relabase));
+
+			return blo_decode_and_check(fd, reports);
+		}
+		else if (error) {
+			BKE_reportf(reports, RPT_WARNING, "Unable to read '%s': %s",
+			            filepath, TIP_("corrupt compressed data"));
+			return NULL;
+		}
+	}
+
 	errno = 0;
 	gzfile = BLI_gzopen(filepath, "rb");
 	
@@ -1158,6 +1541,118 @@ FileData *blo_openblenderfile(const char *filepath, ReportList *reports)
 	}
 }
 
+/**
+ * Read and decode the next block of a LZ4 block compressed file, blocks which don't
+ * match their header or exceed #BLEND_BLOCK_SIZE_MAX end reading.
+ */
+static bool fd_lz4_block_read_next(FileData *filedata)
+{
+	unsigned char header[8];
+	unsigned char *src;
+	size_t raw_len, comp_len;
+	bool ok;
+
+	if ((filedata->lz4_file_remaining < sizeof(header)) ||
+	    (read(filedata->filedes, header, sizeof(header)) != sizeof(header)))
+	{
+		return false;
+	}
+	filedata->lz4_file_remaining -= sizeof(header);
+
+	raw_len = blend_blocks_uint32_from_le(header);
+	comp_len = blend_blocks_uint32_from_le(header + 4);
+
+	if ((raw_len == 0) || (raw_len > BLEND_BLOCK_SIZE_MAX) ||
+	    (comp_len > raw_len) || (comp_len > filedata->lz4_file_remaining))
+	{
+		/* end marker or invalid, nothing after it is read */
+		filedata->lz4_file_remaining = 0;
+		return false;
+	}
+
+	if (filedata->lz4_block) {
+		MEM_freeN(filedata->lz4_block);
+	}
+	filedata->lz4_block = MEM_mallocN(raw_len, __func__);
+	filedata->lz4_block_len = 0;
+	filedata->lz4_block_offset = 0;
+
+	/* stored uncompressed when compression didn't help */
+	src = (comp_len == raw_len) ? (unsigned char *)filedata->lz4_block : MEM_mallocN(comp_len, __func__);
+	ok = (read(filedata->filedes, src, (unsigned int)comp_len) == (int)comp_len);
+	filedata->lz4_file_remaining -= comp_len;
+
+	if (src != (unsigned char *)filedata->lz4_block) {
+		ok = ok && BLI_lz4_decompress(src, comp_len, filedata->lz4_block, raw_len);
+		MEM_freeN(src);
+	}
+
+	if (ok) {
+		filedata->lz4_block_len = raw_len;
+	}
+	else {
+		filedata->lz4_file_remaining = 0;
+	}
+	return ok;
+}
+
+static int fd_read_from_lz4_blocks(FileData *filedata, void *buffer, unsigned int size)
+{
+	unsigned int readsize = 0;
+
+	while (readsize < size) {
+		size_t len;
+
+		if ((filedata->lz4_block_offset == filedata->lz4_block_len) && !fd_lz4_block_read_next(filedata)) {
+			break;
+		}
+
+		len = MIN2((size_t)(size - readsize), filedata->lz4_block_len - filedata->lz4_block_offset);
+		memcpy((char *)buffer + readsize, filedata->lz4_block + filedata->lz4_block_offset, len);
+		filedata->lz4_block_offset += len;
+		readsize += (unsigned int)len;
+	}
+
+	filedata->seek += (int)readsize;
+	return (int)readsize;
+}
+
+/**
+ * Open a LZ4 block compressed file for reading one block at a time,
+ * unlike #blo_openblenderfile_blocks which decodes the whole file up-front.
+ *
+ * \return NULL when the file isn't LZ4 block compressed.
+ */
+static FileData *blo_openblenderfile_lz4_stream(const char *filepath)
+{
+	FileData *fd;
+	char header[BLEND_LZ4_MAGIC_SIZE];
+	const size_t file_len = BLI_file_size(filepath);
+	int file;
+
+	if ((file_len == (size_t)-1) || (file_len < sizeof(header))) {
+		return NULL;
+	}
+
+	file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+	if (file == -1) {
+		return NULL;
+	}
+	if ((read(file, header, sizeof(header)) != sizeof(header)) ||
+	    (memcmp(header, BLEND_LZ4_MAGIC, BLEND_LZ4_MAGIC_SIZE) != 0))
+	{
+		close(file);
+		return NULL;
+	}
+
+	fd = filedata_new();
+	fd->filedes = file;
+	fd->lz4_file_remaining = file_len - sizeof(header);
+	fd->read = fd_read_from_lz4_blocks;
+
+	return fd;
+}
+
 /**
  * Same as blo_openblenderfile(), but does not reads DNA data, only header. Use it for light access
  * (e.g. thumbnail reading).
@@ -1165,11 +1660,27 @@ FileData *blo_openblenderfile(const char *filepath, ReportList *reports)
 static FileData *blo_openblenderfile_minimal(const char *filepath)
 {
 	gzFile gzfile;
+	FileData *fd;
+
+	/* only decode the LZ4 blocks holding the header and thumbnail,
+	 * gzip compressed blocks are streamed */
+	fd = blo_openblenderfile_lz4_stream(filepath);
+	if (fd) {
+		decode_blender_header(fd);
+
+		if (fd->flags & FD_FLAGS_FILE_OK) {
+			return fd;
+		}
+
+		blo_freefiledata(fd);
+		return NULL;
+	}
+
 	errno = 0;
 	gzfile = BLI_gzopen(filepath, "rb");
 
 	if (gzfile != (gzFile)Z_NULL) {
-		FileData *fd = filedata_new();
+		fd = filedata_new();
 		fd->gzfiledes = gzfile;
 		fd->read = fd_read_gzip_from_file;
 
@@ -1193,7 +1704,19 @@ static int fd_read_gzip_from_memory(FileData *filedata, void *buffer, unsigned i
 	filedata->strm.avail_out = size;
 
 	// Inflate another chunk.
-	err = inflate (&filedata->strm, Z_SYNC_FLUSH);
+	for (;;) {
+		err = inflate(&filedata->strm, Z_SYNC_FLUSH);
+
+		if ((err == Z_STREAM_END) && (filedata->strm.avail_in != 0)) {
+			/* block compressed files are a sequence of gzip members, continue with the next one */
+			inflateReset(&filedata->strm);
+			if (filedata->strm.avail_out != 0) {
+				continue;
+			}
+			err = Z_OK;
+		}
+		break;
+	}
 
 	if (err == Z_STREAM_END) {
 		return 0;
@@ -1295,8 +1818,30 @@ void blo_freefiledata(FileData *fd)
 		}
 		
 		// Free all BHeadN data blocks
+		for (BHeadN *bheadn = fd->listbase.first; bheadn; bheadn = bheadn->next) {
+			/* converted ahead of time but never used */
+			if (bheadn->data_converted) {
+				MEM_freeN(bheadn->data_converted);
+			}
+		}
 		BLI_freelistN(&fd->listbase);
 
+		if (fd->lz4_block) {
+			MEM_freeN(fd->lz4_block);
+		}
+
+		if (fd->filebuf_data) {
+#ifndef WIN32
+			if (fd->flags & FD_FLAGS_FILE_MAPPED) {
+				munmap(fd->filebuf_data, fd->filebuf_size);
+			}
+			else
+#endif
+			{
+				MEM_freeN(fd->filebuf_data);
+			}
+		}
+
 		if (fd->filesdna)
 			DNA_sdna_free(fd->filesdna);
 		if (fd->compflags)
@@ -1319,9 +1864,9 @@ void blo_freefiledata(FileData *fd)
 		if (fd->bheadmap)
 			MEM_freeN(fd->bheadmap);
 		
-#ifdef USE_GHASH_BHEAD
+#ifdef USE_FLATHASH_BHEAD
 		if (fd->bhead_idname_hash) {
-			BLI_ghash_free(fd->bhead_idname_hash, NULL, NULL);
+			BLI_flathash_free(fd->bhead_idname_hash, NULL, NULL);
 		}
 #endif
 
@@ -1874,7 +2419,7 @@ static void switch_endian_structs(const struct SDNA *filesdna, BHead *bhead)
 	int blocksize, nblocks;
 	char *data;
 	
-	data = (char *)(bhead+1);
+	data = BHEAD_DATA(bhead);
 	blocksize = filesdna->typelens[ filesdna->structs[bhead->SDNAnr][0] ];
 	
 	nblocks = bhead->nr;
@@ -1885,7 +2430,7 @@ static void switch_endian_structs(const struct SDNA *filesdna, BHead *bhead)
 	}
 }
 
-static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
+static void *read_struct_convert(const FileData *fd, BHead *bh, const char *blockname)
 {
 	void *temp = NULL;
 	
@@ -1896,12 +2441,12 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
 		
 		if (fd->compflags[bh->SDNAnr] != SDNA_CMP_REMOVED) {
 			if (fd->compflags[bh->SDNAnr] == SDNA_CMP_NOT_EQUAL) {
-				temp = DNA_struct_reconstruct(fd->memsdna, fd->filesdna, fd->compflags, bh->SDNAnr, bh->nr, (bh+1));
+				temp = DNA_struct_reconstruct(fd->memsdna, fd->filesdna, fd->compflags, bh->SDNAnr, bh->nr, BHEAD_DATA(bh));
 			}
 			else {
 				/* SDNA_CMP_EQUAL */
 				temp = MEM_mallocN(bh->len, blockname);
-				memcpy(temp, (bh+1), bh->len);
+				memcpy(temp, BHEAD_DATA(bh), bh->len);
 			}
 		}
 	}
@@ -1909,6 +2454,46 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
 	return temp;
 }
 
+static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
+{
+	BHeadN *bheadn = BHEADN_FROM_BHEAD(bh);
+
+	if (bheadn->is_converted) {
+		/* see read_file_convert_bheads, ownership moves to the caller */
+		void *temp = bheadn->data_converted;
+		bheadn->data_converted = NULL;
+		bheadn->is_converted = false;
+		return temp;
+	}
+
+	return read_struct_convert(fd, bh, blockname);
+}
+
+/**
+ * Read block data which is only looked at while reading the file, and never given
+ * to an ID (which would free it with MEM_freeN). When no DNA reconstruction or
+ * endian switch is needed this points straight into the file mapping or buffer,
+ * without a copy. Release with #read_struct_temp_free.
+ */
+static const void *read_struct_temp(FileData *fd, BHead *bh, const char *blockname)
+{
+	if (bh->len &&
+	    fd->compflags[bh->SDNAnr] == SDNA_CMP_EQUAL &&
+	    !(bh->SDNAnr && (fd->flags & FD_FLAGS_SWITCH_ENDIAN)))
+	{
+		return BHEAD_DATA(bh);
+	}
+
+	return read_struct(fd, bh, blockname);
+}
+
+static void read_struct_temp_free(BHead *bh, const void *data)
+{
+	if (data && data != BHEAD_DATA(bh)) {
+		MEM_freeN((void *)data);
+	}
+}
+
 typedef void (*link_list_cb)(FileData *fd, void *data);
 
 static void link_list_ex(FileData *fd, ListBase *lb, link_list_cb callback)		/* only direct data */
@@ -8575,7 +9160,7 @@ static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const short
 /* also version info is written here */
 static BHead *read_global(BlendFileData *bfd, FileData *fd, BHead *bhead)
 {
-	FileGlobal *fg = read_struct(fd, bhead, "Global");
+	const FileGlobal *fg = read_struct_temp(fd, bhead, "Global");
 	
 	/* copy to bfd handle */
 	bfd->main->subversionfile = fg->subversion;
@@ -8606,7 +9191,7 @@ static BHead *read_global(BlendFileData *bfd, FileData *fd, BHead *bhead)
 	bfd->curscene = fg->curscene;
 	bfd->cur_render_layer = fg->cur_render_layer;
 
-	MEM_freeN(fg);
+	read_struct_temp_free(bhead, fg);
 	
 	fd->globalf = bfd->globalf;
 	fd->fileflags = bfd->fileflags;
@@ -8818,6 +9403,90 @@ static BHead *read_userdef(BlendFileData *bfd, FileData *fd, BHead *bhead)
 	return bhead;
 }
 
+/* ********** PARALLEL BLOCK CONVERSION ****************** */
+
+/* files with less blocks are not worth the threading overhead */
+#define READ_CONVERT_PARALLEL_MIN_BHEADS 1024
+
+typedef struct ReadConvertData {
+	const FileData *fd;
+	BHeadN **bheads;
+	const char **allocnames;
+} ReadConvertData;
+
+static void read_file_convert_bhead_cb(void *userdata, void *UNUSED(userdata_chunk), const int index,
+                                       const int UNUSED(thread_id))
+{
+	ReadConvertData *data = userdata;
+	BHeadN *bheadn = data->bheads[index];
+
+	bheadn->data_converted = read_struct_convert(data->fd, &bheadn->bhead, data->allocnames[index]);
+	bheadn->is_converted = true;
+}
+
+/**
+ * Index all blocks of the file in one pass and run endian switching, DNA reconstruction
+ * and copying of ID and DATA blocks in parallel, so blo_read_file_internal only has to
+ * pick up the converted data in read_struct.
+ *
+ * \note Blocks are converted in place for endian switching, this is only valid when each
+ * block is read at most once, as is the case for regular (non-undo) file reading.
+ */
+static void read_file_convert_bheads(FileData *fd)
+{
+	ReadConvertData data;
+	BHead *bhead;
+	int bheads_len = 0, convert_len = 0;
+	bool convert_data = false;
+	const char *allocname = NULL;
+
+	/* read all blocks, they are kept in fd->listbase anyway */
+	for (bhead = blo_firstbhead(fd); bhead; bhead = blo_nextbhead(fd, bhead)) {
+		bheads_len++;
+	}
+
+	if (bheads_len < READ_CONVERT_PARALLEL_MIN_BHEADS) {
+		return;
+	}
+
+	data.fd = fd;
+	data.bheads = MEM_mallocN(sizeof(*data.bheads) * (size_t)bheads_len, __func__);
+	data.allocnames = MEM_mallocN(sizeof(*data.allocnames) * (size_t)bheads_len, __func__);
+
+	for (bhead = blo_firstbhead(fd); bhead; bhead = blo_nextbhead(fd, bhead)) {
+		const char *bhead_allocname;
+
+		if (bhead->code == DATA) {
+			if (!convert_data) {
+				continue;
+			}
+			bhead_allocname = allocname;
+		}
+		else if (bhead->code == ID_SCRN || BKE_idcode_is_valid(bhead->code)) {
+			/* ID_ID only holds the ID part, its data is never read */
+			convert_data = (bhead->code != ID_ID);
+			allocname = dataname((bhead->code == ID_SCRN) ? ID_SCR : bhead->code);
+			bhead_allocname = "lib block";
+		}
+		else {
+			/* GLOB, USER, DNA1... are read separately */
+			convert_data = false;
+			continue;
+		}
+
+		data.bheads[convert_len] = BHEADN_FROM_BHEAD(bhead);
+		data.allocnames[convert_len] = bhead_allocname;
+		convert_len++;
+	}
+
+	BLI_task_parallel_range_ex(0, convert_len, &data, NULL, 0, read_file_convert_bhead_cb, true, true);
+
+	MEM_freeN(data.bheads);
+	MEM_freeN((void *)data.allocnames);
+}
+
+#undef READ_CONVERT_PARALLEL_MIN_BHEADS
+
 BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 {
 	BHead *bhead = blo_firstbhead(fd);
@@ -8852,6 +9521,10 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 		}
 	}
 
+	if ((fd->memfile == NULL) && !(fd->skip_flags & BLO_READ_SKIP_DATA)) {
+		read_file_convert_bheads(fd);
+	}
+
 	while (bhead) {
 		switch (bhead->code) {
 		case DATA:
@@ -9018,14 +9691,14 @@ static BHead *find_bhead(FileData *fd, void *old)
 
 static BHead *find_bhead_from_code_name(FileData *fd, const short idcode, const char *name)
 {
-#ifdef USE_GHASH_BHEAD
+#ifdef USE_FLATHASH_BHEAD
 
 	char idname_full[MAX_ID_NAME];
 
 	*((short *)idname_full) = idcode;
 	BLI_strncpy(idname_full + 2, name, sizeof(idname_full) - 2);
 
-	return BLI_ghash_lookup(fd->bhead_idname_hash, idname_full);
+	return BLI_flathash_lookup(fd->bhead_idname_hash, idname_full);
 
 #else
 	BHead *bhead;
@@ -9048,8 +9721,8 @@ static BHead *find_bhead_from_code_name(FileData *fd, const short idcode, const
 
 static BHead *find_bhead_from_idname(FileData *fd, const char *idname)
 {
-#ifdef USE_GHASH_BHEAD
-	return BLI_ghash_lookup(fd->bhead_idname_hash, idname);
+#ifdef USE_FLATHASH_BHEAD
+	return BLI_flathash_lookup(fd->bhead_idname_hash, idname);
 #else
 	return find_bhead_from_code_name(fd, GS(idname), idname + 2);
 #endif
@@ -9075,7 +9748,7 @@ static void expand_doit_library(void *fdhandle, Main *mainvar, void *old)
 			BHead *bheadlib= find_previous_lib(fd, bhead);
 			
 			if (bheadlib) {
-				Library *lib = read_struct(fd, bheadlib, "Library");
+				const Library *lib = read_struct_temp(fd, bheadlib, "Library");
 				Main *ptr = blo_find_main(fd, lib->name, fd->relabase);
 				
 				if (ptr->curlib == NULL) {
@@ -9083,6 +9756,7 @@ static void expand_doit_library(void *fdhandle, Main *mainvar, void *old)
 					
 					blo_reportf_wrap(fd->reports, RPT_WARNING, TIP_("LIB: Data refers to main .blend file: '%s' from %s"),
 					                 idname, mainvar->curlib->filepath);
+					read_struct_temp_free(bheadlib, lib);
 					return;
 				}
 				else
@@ -9121,7 +9795,7 @@ static void expand_doit_library(void *fdhandle, Main *mainvar, void *old)
 					// if (G.debug & G_DEBUG) printf("expand_doit: already linked: %s lib: %s\n", id->name, lib->name);
 				}
 				
-				MEM_freeN(lib);
+				read_struct_temp_free(bheadlib, lib);
 			}
 		}
 		else {
@@ -10492,7 +11166,7 @@ static Main *library_link_begin(Main *mainvar, FileData **fd, const char *filepa
 	/* needed for do_version */
 	mainl->versionfile = (*fd)->fileversion;
 	read_file_version(*fd, mainl);
-#ifdef USE_GHASH_BHEAD
+#ifdef USE_FLATHASH_BHEAD
 	read_file_bhead_idname_map_create(*fd);
 #endif
 	
@@ -10752,7 +11426,7 @@ static void read_libraries(FileData *basefd, ListBase *mainlist)
 						
 						/* subversion */
 						read_file_version(fd, mainptr);
-#ifdef USE_GHASH_BHEAD
+#ifdef USE_FLATHASH_BHEAD
 						read_file_bhead_idname_map_create(fd);
 #endif
 
@@ -38,6 +38,7 @@
 #include "DNA_space_types.h"
 #include "DNA_windowmanager_types.h"  /* for ReportType */
 
+struct FlatHash;
 struct OldNewMap;
 struct MemFile;
 struct ReportList;
@@ -64,6 +65,19 @@ typedef struct FileData {
 	int filedes;
 	gzFile gzfiledes;
 
+	// variables needed for reading from a memory mapped (uncompressed) file (FD_FLAGS_FILE_MAPPED),
+	// a file read into memory at once or the decompressed buffer of a block compressed file
+	char *filebuf_data;
+	size_t filebuf_size;
+	size_t filebuf_offset;
+
+	// variables needed for reading a LZ4 block compressed file from filedes one block
+	// at a time, so only the blocks which are read get decoded (minimal reading)
+	char *lz4_block;
+	size_t lz4_block_len;
+	size_t lz4_block_offset;
+	size_t lz4_file_remaining;
+
 	// now only in use for library appending
 	char relabase[FILE_MAX];
 	
@@ -96,8 +110,8 @@ typedef struct FileData {
 	struct BHeadSort *bheadmap;
 	int tot_bheadmap;
 
-	/* see: USE_GHASH_BHEAD */
-	struct GHash *bhead_idname_hash;
+	/* see: USE_FLATHASH_BHEAD */
+	struct FlatHash *bhead_idname_hash;
 	
 	ListBase *mainlist;
 	ListBase *old_mainlist;  /* Used for undo. */
@@ -111,9 +125,19 @@ typedef struct FileData {
 
 typedef struct BHeadN {
 	struct BHeadN *next, *prev;
+	/* Block data, stored right after the BHeadN or in the file mapping or buffer
+	 * (see FileData.filebuf_data), access with #BHEAD_DATA. */
+	void *data;
+	/* Block data converted ahead of time by the parallel read pass,
+	 * handed over (once) by read_struct(). */
+	void *data_converted;
+	int is_converted;
 	struct BHead bhead;
 } BHeadN;
 
+#define BHEADN_FROM_BHEAD(bh) ((BHeadN *)POINTER_OFFSET(bh, -offsetof(BHeadN, bhead)))
+#define BHEAD_DATA(bh) (BHEADN_FROM_BHEAD(bh)->data)
+
 /* FileData->flags */
 enum {
 	FD_FLAGS_SWITCH_ENDIAN         = 1 << 0,
@@ -122,10 +146,21 @@ enum {
 	FD_FLAGS_FILE_OK               = 1 << 3,
 	FD_FLAGS_NOT_MY_BUFFER         = 1 << 4,
 	FD_FLAGS_NOT_MY_LIBMAP         = 1 << 5,  /* XXX Unused in practice (checked once but never set). */
+	FD_FLAGS_FILE_MAPPED           = 1 << 6,  /* filebuf_data is a file mapping, not allocated. */
 };
 
 #define SIZEOFBLENDERHEADER 12
 
+/* Compressed files written as independent blocks, see writefile.c */
+#define BLEND_LZ4_MAGIC "BLENDLZ4"
+#define BLEND_LZ4_MAGIC_SIZE 8
+/* gzip extra sub-field ID storing the size of each member. */
+#define BLEND_GZIP_BLOCK_SI1 'B'
+#define BLEND_GZIP_BLOCK_SI2 'L'
+#define BLEND_GZIP_BLOCK_HEADER_SIZE 20
+/* Largest uncompressed block accepted when reading, writefile.c uses 1mb blocks. */
+#define BLEND_BLOCK_SIZE_MAX (1 << 24)
+
 /***/
 struct Main;
 void blo_join_main(ListBase *mainlist);
@@ -40,44 +40,160 @@
 #include "DNA_listBase.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_flathash.h"
+#include "BLI_hash_mm2a.h"
+#include "BLI_threads.h"
 
 #include "BLO_undofile.h"
 
 /* **************** support for memory-write, for undo buffers *************** */
 
+/**
+ * Chunk data is stored once and shared by all undo steps writing the same bytes,
+ * looked up by content hash. This way inserting data only stores the chunks which changed,
+ * instead of everything after the insertion (which no longer lines up with the previous step).
+ */
+typedef struct MemFileSharedChunk {
+	char *buf;
+	unsigned int size;
+	unsigned int hash;
+	unsigned int users;
+} MemFileSharedChunk;
+
+/* Shared by all memfiles, which can be written from other threads than the main one
+ * (see BKE_scene_evaluate_frames), so all access goes through the lock. */
+static struct {
+	FlatHash *chunks;
+	size_t size_stored;
+	size_t size_referenced;
+	ThreadMutex lock;
+} g_memfile_store = {NULL, 0, 0, BLI_MUTEX_INITIALIZER};
+
+static unsigned int memfile_shared_chunk_hash(const void *key)
+{
+	const MemFileSharedChunk *shared = key;
+	return shared->hash;
+}
+
+static bool memfile_shared_chunk_cmp(const void *a, const void *b)
+{
+	const MemFileSharedChunk *shared_a = a;
+	const MemFileSharedChunk *shared_b = b;
+	return ((shared_a->hash != shared_b->hash) ||
+	        (shared_a->size != shared_b->size) ||
+	        (memcmp(shared_a->buf, shared_b->buf, shared_a->size) != 0));
+}
+
+/**
+ * \return A user of the shared chunk holding \a buf, adding it when not stored yet.
+ */
+static MemFileSharedChunk *memfile_shared_chunk_ensure(const char *buf, unsigned int size, bool *r_is_new)
+{
+	MemFileSharedChunk key, *shared;
+
+	key.buf = (char *)buf;
+	key.size = size;
+	key.hash = BLI_hash_mm2((const unsigned char *)buf, size, 0);
+
+	BLI_mutex_lock(&g_memfile_store.lock);
+
+	if (g_memfile_store.chunks == NULL) {
+		g_memfile_store.chunks = BLI_flathash_new(memfile_shared_chunk_hash, memfile_shared_chunk_cmp, __func__);
+	}
+
+	shared = BLI_flathash_lookup(g_memfile_store.chunks, &key);
+	*r_is_new = (shared == NULL);
+
+	if (shared == NULL) {
+		shared = MEM_mallocN(sizeof(*shared) + size, "MemFileSharedChunk");
+		shared->buf = (char *)(shared + 1);
+		shared->size = size;
+		shared->hash = key.hash;
+		shared->users = 0;
+		memcpy(shared->buf, buf, size);
+
+		BLI_flathash_insert(g_memfile_store.chunks, shared, shared);
+		g_memfile_store.size_stored += size;
+	}
+
+	shared->users++;
+	g_memfile_store.size_referenced += size;
+
+	BLI_mutex_unlock(&g_memfile_store.lock);
+
+	return shared;
+}
+
+static void memfile_shared_chunk_release(MemFileSharedChunk *shared)
+{
+	BLI_mutex_lock(&g_memfile_store.lock);
+
+	BLI_assert(shared->users != 0);
+
+	g_memfile_store.size_referenced -= shared->size;
+
+	if (--shared->users == 0) {
+		BLI_flathash_remove(g_memfile_store.chunks, shared, NULL, NULL);
+		g_memfile_store.size_stored -= shared->size;
+		MEM_freeN(shared);
+
+		if (BLI_flathash_size(g_memfile_store.chunks) == 0) {
+			BLI_flathash_free(g_memfile_store.chunks, NULL, NULL);
+			g_memfile_store.chunks = NULL;
+		}
+	}
+
+	BLI_mutex_unlock(&g_memfile_store.lock);
+}
+
+/* Add a user to a chunk which is already stored. */
+static void memfile_shared_chunk_add_user(MemFileSharedChunk *shared)
+{
+	BLI_mutex_lock(&g_memfile_store.lock);
+	shared->users++;
+	g_memfile_store.size_referenced += shared->size;
+	BLI_mutex_unlock(&g_memfile_store.lock);
+}
+
 /* not memfile itself */
 void BLO_memfile_free(MemFile *memfile)
 {
 	MemFileChunk *chunk;
 	
 	while ((chunk = BLI_pophead(&memfile->chunks))) {
-		if (chunk->ident == 0)
-			MEM_freeN(chunk->buf);
+		memfile_shared_chunk_release(chunk->shared);
 		MEM_freeN(chunk);
 	}
 	memfile->size = 0;
+	memfile->size_total = 0;
 }
 
 /* to keep list of memfiles consistent, 'first' is always first in list */
 /* result is that 'first' is being freed */
 void BLO_memfile_merge(MemFile *first, MemFile *second)
 {
-	MemFileChunk *fc, *sc;
-	
-	fc = first->chunks.first;
-	sc = second->chunks.first;
-	while (fc || sc) {
-		if (fc && sc) {
-			if (sc->ident) {
-				sc->ident = 0;
-				fc->ident = 1;
-			}
+	MemFileChunk *sc;
+
+	BLO_memfile_free(first);
+
+	/* chunks only 'second' uses now count as its own */
+	BLI_mutex_lock(&g_memfile_store.lock);
+	for (sc = second->chunks.first; sc; sc = sc->next) {
+		if (sc->ident && (sc->shared->users == 1)) {
+			sc->ident = 0;
+			second->size += sc->size;
 		}
-		if (fc) fc = fc->next;
-		if (sc) sc = sc->next;
 	}
-	
-	BLO_memfile_free(first);
+	BLI_mutex_unlock(&g_memfile_store.lock);
+}
+
+void BLO_memfile_stats(MemFileStats *r_stats)
+{
+	BLI_mutex_lock(&g_memfile_store.lock);
+	r_stats->chunks_len = g_memfile_store.chunks ? BLI_flathash_size(g_memfile_store.chunks) : 0;
+	r_stats->size_stored = g_memfile_store.size_stored;
+	r_stats->size_referenced = g_memfile_store.size_referenced;
+	BLI_mutex_unlock(&g_memfile_store.lock);
 }
 
 void memfile_chunk_add(MemFile *compare, MemFile *current, const char *buf, unsigned int size)
@@ -97,26 +213,34 @@ void memfile_chunk_add(MemFile *compare, MemFile *current, const char *buf, unsi
 	
 	curchunk = MEM_mallocN(sizeof(MemFileChunk), "MemFileChunk");
 	curchunk->size = size;
-	curchunk->buf = NULL;
+	curchunk->shared = NULL;
 	curchunk->ident = 0;
 	BLI_addtail(&current->chunks, curchunk);
 	
-	/* we compare compchunk with buf */
+	/* cheap check first, unchanged data usually lines up with the previous step */
 	if (compchunk) {
 		if (compchunk->size == curchunk->size) {
 			if (memcmp(compchunk->buf, buf, size) == 0) {
-				curchunk->buf = compchunk->buf;
+				curchunk->shared = compchunk->shared;
 				curchunk->ident = 1;
+				memfile_shared_chunk_add_user(curchunk->shared);
 			}
 		}
 		compchunk = compchunk->next;
 	}
 	
-	/* not equal... */
-	if (curchunk->buf == NULL) {
-		curchunk->buf = MEM_mallocN(size, "Chunk buffer");
-		memcpy(curchunk->buf, buf, size);
-		current->size += size;
+	/* not equal, look up by content */
+	if (curchunk->shared == NULL) {
+		bool is_new;
+		curchunk->shared = memfile_shared_chunk_ensure(buf, size, &is_new);
+		if (is_new) {
+			current->size += size;
+		}
+		else {
+			curchunk->ident = 1;
+		}
 	}
-}
 
+	curchunk->buf = curchunk->shared->buf;
+	current->size_total += size;
+}
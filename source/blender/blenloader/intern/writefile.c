@@ -89,8 +89,9 @@
 #include <string.h>
 #include <stdlib.h>
 
+#include <zlib.h>  /* odd include order-issue, keep before winsock2.h */
+
 #ifdef WIN32
-#  include <zlib.h>  /* odd include order-issue */
 #  include "winsock2.h"
 #  include <io.h>
 #  include "BLI_winstuff.h"
@@ -160,7 +161,10 @@
 #include "BLI_bitmap.h"
 #include "BLI_blenlib.h"
 #include "BLI_linklist.h"
+#include "BLI_lz4.h"
 #include "BLI_mempool.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "BKE_action.h"
 #include "BKE_blender_version.h"
@@ -211,6 +215,7 @@
 typedef enum {
 	WW_WRAP_NONE = 1,
 	WW_WRAP_ZLIB,
+	WW_WRAP_LZ4,
 } eWriteWrapType;
 
 typedef struct WriteWrap WriteWrap;
@@ -223,7 +228,7 @@ struct WriteWrap {
 	/* internal */
 	union {
 		int file_handle;
-		gzFile gz_handle;
+		struct WriteWrapBlocks *blocks;
 	} _user_data;
 };
 
@@ -255,33 +260,272 @@ static size_t ww_write_none(WriteWrap *ww, const char *buf, size_t buf_len)
 }
 #undef FILE_HANDLE
 
-/* zlib */
-#define FILE_HANDLE(ww) \
-	(ww)->_user_data.gz_handle
+/* Block compression (zlib & lz4).
+ *
+ * The stream is split into blocks of #WW_BLOCK_SIZE which are compressed independently,
+ * a batch of blocks at a time using the task scheduler, then written in order.
+ *
+ * - zlib: each block is a complete gzip member, so the file is still a regular
+ *   (multi-member) gzip stream any gzip reader handles.
+ *   The header stores the size of the member in an extra field (see #BLEND_GZIP_BLOCK_SI1),
+ *   so reading can locate the members and inflate them in parallel too.
+ * - lz4: #BLEND_LZ4_MAGIC followed by blocks of `{uint32 raw_len, uint32 comp_len, data}`,
+ *   a block that doesn't compress is stored as-is (`comp_len == raw_len`),
+ *   terminated by a zero `raw_len`.
+ */
 
-static bool ww_open_zlib(WriteWrap *ww, const char *filepath)
+#define WW_BLOCK_SIZE (1 << 20)  /* 1mb */
+/* Upper limit for the number of blocks kept in memory at once. */
+#define WW_BLOCK_BATCH_MAX 64
+
+typedef struct WriteWrapBlock {
+	char *data;
+	size_t data_len;
+	/* Compressed result, including the per-block header & trailer. */
+	char *data_comp;
+	size_t data_comp_len;
+	size_t data_comp_alloc;
+	bool error;
+} WriteWrapBlock;
+
+typedef struct WriteWrapBlocks {
+	eWriteWrapType type;
+	int file_handle;
+
+	WriteWrapBlock *blocks;
+	int blocks_len;
+	/* Block being filled. */
+	int block_active;
+	bool error;
+} WriteWrapBlocks;
+
+#define FILE_BLOCKS(ww) \
+	(ww)->_user_data.blocks
+
+BLI_INLINE void ww_uint32_to_le(unsigned char *dst, const unsigned int value)
 {
-	gzFile file;
+	dst[0] = (unsigned char)(value);
+	dst[1] = (unsigned char)(value >> 8);
+	dst[2] = (unsigned char)(value >> 16);
+	dst[3] = (unsigned char)(value >> 24);
+}
 
-	file = BLI_gzopen(filepath, "wb1");
+static void ww_block_comp_ensure(WriteWrapBlock *block, const size_t len)
+{
+	if (block->data_comp_alloc < len) {
+		MEM_SAFE_FREE(block->data_comp);
+		block->data_comp = MEM_mallocN(len, __func__);
+		block->data_comp_alloc = len;
+	}
+}
 
-	if (file != Z_NULL) {
-		FILE_HANDLE(ww) = file;
-		return true;
+static bool ww_block_compress_zlib(WriteWrapBlock *block)
+{
+	z_stream strm = {NULL};
+	unsigned char *dst;
+	size_t dst_len;
+	bool ok;
+
+	if (deflateInit2(&strm, 1, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		return false;
+	}
+
+	ww_block_comp_ensure(
+	        block, BLEND_GZIP_BLOCK_HEADER_SIZE + deflateBound(&strm, (uLong)block->data_len) + 8);
+	dst = (unsigned char *)block->data_comp;
+
+	strm.next_in = (Bytef *)block->data;
+	strm.avail_in = (uInt)block->data_len;
+	strm.next_out = dst + BLEND_GZIP_BLOCK_HEADER_SIZE;
+	strm.avail_out = (uInt)(block->data_comp_alloc - (BLEND_GZIP_BLOCK_HEADER_SIZE + 8));
+
+	ok = (deflate(&strm, Z_FINISH) == Z_STREAM_END);
+	dst_len = BLEND_GZIP_BLOCK_HEADER_SIZE + strm.total_out + 8;
+	deflateEnd(&strm);
+
+	if (!ok) {
+		return false;
+	}
+
+	/* gzip header: magic, deflate, FEXTRA flag, no mtime, no extra flags, unknown OS. */
+	dst[0] = 0x1f;
+	dst[1] = 0x8b;
+	dst[2] = 8;
+	dst[3] = 4;
+	memset(&dst[4], 0, 5);
+	dst[9] = 255;
+	/* extra field: XLEN, then one sub-field holding the size of this member. */
+	dst[10] = 8;
+	dst[11] = 0;
+	dst[12] = BLEND_GZIP_BLOCK_SI1;
+	dst[13] = BLEND_GZIP_BLOCK_SI2;
+	dst[14] = 4;
+	dst[15] = 0;
+	ww_uint32_to_le(&dst[16], (unsigned int)dst_len);
+
+	/* trailer */
+	ww_uint32_to_le(&dst[dst_len - 8], (unsigned int)crc32(0, (const Bytef *)block->data, (uInt)block->data_len));
+	ww_uint32_to_le(&dst[dst_len - 4], (unsigned int)block->data_len);
+
+	block->data_comp_len = dst_len;
+	return true;
+}
+
+static bool ww_block_compress_lz4(WriteWrapBlock *block)
+{
+	unsigned char *dst;
+	size_t comp_len;
+
+	ww_block_comp_ensure(block, 8 + BLI_lz4_compress_bound(block->data_len));
+	dst = (unsigned char *)block->data_comp;
+
+	/* only keep the compressed data when it's actually smaller */
+	comp_len = BLI_lz4_compress(block->data, block->data_len, dst + 8, block->data_len - 1);
+	if (comp_len == 0) {
+		memcpy(dst + 8, block->data, block->data_len);
+		comp_len = block->data_len;
+	}
+
+	ww_uint32_to_le(&dst[0], (unsigned int)block->data_len);
+	ww_uint32_to_le(&dst[4], (unsigned int)comp_len);
+
+	block->data_comp_len = 8 + comp_len;
+	return true;
+}
+
+static void ww_block_compress_cb(void *userdata, const int index)
+{
+	WriteWrapBlocks *wwb = userdata;
+	WriteWrapBlock *block = &wwb->blocks[index];
+
+	if (wwb->type == WW_WRAP_LZ4) {
+		block->error = !ww_block_compress_lz4(block);
 	}
 	else {
+		block->error = !ww_block_compress_zlib(block);
+	}
+}
+
+/* Compress all filled blocks and write them to the file. */
+static void ww_blocks_flush(WriteWrapBlocks *wwb)
+{
+	int blocks_len = wwb->block_active;
+	int i;
+
+	if ((blocks_len < wwb->blocks_len) && (wwb->blocks[blocks_len].data_len != 0)) {
+		blocks_len++;
+	}
+
+	BLI_task_parallel_range(0, blocks_len, wwb, ww_block_compress_cb, blocks_len > 1);
+
+	for (i = 0; i < blocks_len; i++) {
+		WriteWrapBlock *block = &wwb->blocks[i];
+
+		if (block->error) {
+			wwb->error = true;
+		}
+		else {
+			const int64_t written = write(wwb->file_handle, block->data_comp, block->data_comp_len);
+			if (written != (int64_t)block->data_comp_len) {
+				wwb->error = true;
+			}
+		}
+		block->data_len = 0;
+	}
+
+	wwb->block_active = 0;
+}
+
+static bool ww_open_blocks(WriteWrap *ww, const char *filepath, const eWriteWrapType type)
+{
+	WriteWrapBlocks *wwb;
+	int file;
+	int i;
+
+	file = BLI_open(filepath, O_BINARY + O_WRONLY + O_CREAT + O_TRUNC, 0666);
+
+	if (file == -1) {
 		return false;
 	}
+
+	if (type == WW_WRAP_LZ4) {
+		if (write(file, BLEND_LZ4_MAGIC, BLEND_LZ4_MAGIC_SIZE) != BLEND_LZ4_MAGIC_SIZE) {
+			close(file);
+			return false;
+		}
+	}
+
+	wwb = MEM_callocN(sizeof(*wwb), __func__);
+	wwb->type = type;
+	wwb->file_handle = file;
+	/* enough blocks to keep all threads busy */
+	wwb->blocks_len = MIN2(BLI_system_thread_count() * 2, WW_BLOCK_BATCH_MAX);
+	wwb->blocks = MEM_callocN(sizeof(*wwb->blocks) * (size_t)wwb->blocks_len, __func__);
+	for (i = 0; i < wwb->blocks_len; i++) {
+		wwb->blocks[i].data = MEM_mallocN(WW_BLOCK_SIZE, __func__);
+	}
+
+	FILE_BLOCKS(ww) = wwb;
+	return true;
 }
-static bool ww_close_zlib(WriteWrap *ww)
+static bool ww_open_zlib(WriteWrap *ww, const char *filepath)
 {
-	return (gzclose(FILE_HANDLE(ww)) == Z_OK);
+	return ww_open_blocks(ww, filepath, WW_WRAP_ZLIB);
 }
-static size_t ww_write_zlib(WriteWrap *ww, const char *buf, size_t buf_len)
+static bool ww_open_lz4(WriteWrap *ww, const char *filepath)
 {
-	return gzwrite(FILE_HANDLE(ww), buf, buf_len);
+	return ww_open_blocks(ww, filepath, WW_WRAP_LZ4);
 }
-#undef FILE_HANDLE
+static bool ww_close_blocks(WriteWrap *ww)
+{
+	WriteWrapBlocks *wwb = FILE_BLOCKS(ww);
+	bool ok;
+	int i;
+
+	ww_blocks_flush(wwb);
+
+	if (wwb->type == WW_WRAP_LZ4) {
+		const unsigned char end[8] = {0};
+		if (write(wwb->file_handle, end, sizeof(end)) != sizeof(end)) {
+			wwb->error = true;
+		}
+	}
+
+	ok = (close(wwb->file_handle) != -1) && !wwb->error;
+
+	for (i = 0; i < wwb->blocks_len; i++) {
+		MEM_freeN(wwb->blocks[i].data);
+		MEM_SAFE_FREE(wwb->blocks[i].data_comp);
+	}
+	MEM_freeN(wwb->blocks);
+	MEM_freeN(wwb);
+	FILE_BLOCKS(ww) = NULL;
+
+	return ok;
+}
+static size_t ww_write_blocks(WriteWrap *ww, const char *buf, size_t buf_len)
+{
+	WriteWrapBlocks *wwb = FILE_BLOCKS(ww);
+	size_t done = 0;
+
+	while (done < buf_len) {
+		WriteWrapBlock *block = &wwb->blocks[wwb->block_active];
+		const size_t len = MIN2(buf_len - done, WW_BLOCK_SIZE - block->data_len);
+
+		memcpy(block->data + block->data_len, buf + done, len);
+		block->data_len += len;
+		done += len;
+
+		if (block->data_len == WW_BLOCK_SIZE) {
+			if (++wwb->block_active == wwb->blocks_len) {
+				ww_blocks_flush(wwb);
+			}
+		}
+	}
+
+	return wwb->error ? 0 : buf_len;
+}
+#undef FILE_BLOCKS
 
 /* --- end compression types --- */
 
@@ -293,8 +537,15 @@ static void ww_handle_init(eWriteWrapType ww_type, WriteWrap *r_ww)
 		case WW_WRAP_ZLIB:
 		{
 			r_ww->open  = ww_open_zlib;
-			r_ww->close = ww_close_zlib;
-			r_ww->write = ww_write_zlib;
+			r_ww->close = ww_close_blocks;
+			r_ww->write = ww_write_blocks;
+			break;
+		}
+		case WW_WRAP_LZ4:
+		{
+			r_ww->open  = ww_open_lz4;
+			r_ww->close = ww_close_blocks;
+			r_ww->write = ww_write_blocks;
 			break;
 		}
 		default:
@@ -4164,7 +4415,7 @@ bool BLO_write_file(
 	BLI_snprintf(tempname, sizeof(tempname), "%s@", filepath);
 
 	if (write_flags & G_FILE_COMPRESS) {
-		ww_type = WW_WRAP_ZLIB;
+		ww_type = (write_flags & G_FILE_COMPRESS_FAST) ? WW_WRAP_LZ4 : WW_WRAP_ZLIB;
 	}
 	else {
 		ww_type = WW_WRAP_NONE;
@@ -4252,9 +4503,15 @@ bool BLO_write_file(
  */
 bool BLO_write_file_mem(Main *mainvar, MemFile *compare, MemFile *current, int write_flags)
 {
+	/* memfile_chunk_add() keeps its position in the compared memfile between calls,
+	 * so only one memfile is written at a time. */
+	static ThreadMutex write_mem_lock = BLI_MUTEX_INITIALIZER;
+
 	write_flags &= ~G_FILE_USERPREFS;
 
+	BLI_mutex_lock(&write_mem_lock);
 	const bool err = write_file_handle(mainvar, NULL, compare, current, write_flags, NULL);
+	BLI_mutex_unlock(&write_mem_lock);
 
 	return (err == 0);
 }
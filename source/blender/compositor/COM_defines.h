@@ -72,19 +72,24 @@ typedef enum CompositorPriority {
 
 // workscheduler threading models
 /**
- * COM_TM_QUEUE is a multithreaded model, which uses the BLI_thread_queue pattern. This is the default option.
+ * COM_TM_QUEUE is a multithreaded model, which uses the BLI_thread_queue pattern. It starts its own thread for every CPUDevice.
  */
 #define COM_TM_QUEUE 1
 
+/**
+ * COM_TM_TASK is a multithreaded model, which pushes the chunks to a BLI_task pool. The threads are shared with the rest of Blender. This is the default option.
+ */
+#define COM_TM_TASK 2
+
 /**
  * COM_TM_NOTHREAD is a single threading model, everything is executed in the caller thread. easy for debugging
  */
 #define COM_TM_NOTHREAD 0
 
 /**
- * COM_CURRENT_THREADING_MODEL can be one of the above, COM_TM_QUEUE is currently default.
+ * COM_CURRENT_THREADING_MODEL can be one of the above, COM_TM_TASK is currently default.
  */
-#define COM_CURRENT_THREADING_MODEL COM_TM_QUEUE
+#define COM_CURRENT_THREADING_MODEL COM_TM_TASK
 // chunk order
 /**
  * @brief The order of chunks to be scheduled
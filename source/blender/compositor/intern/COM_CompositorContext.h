@@ -200,6 +200,12 @@ public:
 	void setFastCalculation(bool fastCalculation) {this->m_fastCalculation = fastCalculation;}
 	bool isFastCalculation() const { return this->m_fastCalculation; }
 	bool isGroupnodeBufferEnabled() const { return (this->getbNodeTree()->flag & NTREE_COM_GROUPNODE_BUFFER) != 0; }
+
+	/**
+	 * @brief calculate whole buffers per operation instead of tiles per output
+	 * @see ExecutionGroup.executeFullFrame
+	 */
+	bool isFullFrame() const { return (this->getbNodeTree()->flag & NTREE_COM_FULL_FRAME) != 0; }
 };
 
 
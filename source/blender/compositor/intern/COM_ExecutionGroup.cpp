@@ -36,6 +36,7 @@
 #include "COM_ViewerOperation.h"
 #include "COM_ChunkOrder.h"
 #include "COM_Debug.h"
+#include "COM_FullFrameExecution.h"
 
 #include "MEM_guardedalloc.h"
 #include "BLI_math.h"
@@ -61,6 +62,7 @@ ExecutionGroup::ExecutionGroup()
 	this->m_openCL = false;
 	this->m_singleThreaded = false;
 	this->m_chunksFinished = 0;
+	this->m_fullFrameExecuted = false;
 	BLI_rcti_init(&this->m_viewerBorder, 0, 0, 0, 0);
 	this->m_executionStartTime = 0;
 }
@@ -115,6 +117,7 @@ void ExecutionGroup::initExecution()
 	}
 	unsigned int index;
 	determineNumberOfChunks();
+	this->m_fullFrameExecuted = false;
 
 	this->m_chunkExecutionStates = NULL;
 	if (this->m_numberOfChunks != 0) {
@@ -308,6 +311,11 @@ void ExecutionGroup::execute(ExecutionSystem *graph)
 	bool finished = false;
 	unsigned int startIndex = 0;
 	const int maxNumberEvaluated = BLI_system_thread_count() * 2;
+	/* the chunks closest to the hotspot of the viewer go before other work of the task scheduler,
+	 * so the area the user is looking at updates first */
+	const bool useHotspot = (operation->isViewerOperation() &&
+	                         ELEM(chunkorder, COM_TO_CENTER_OUT, COM_TO_RULE_OF_THIRDS));
+	const unsigned int hotspotChunksLen = BLI_system_thread_count();
 
 	while (!finished && !breaked) {
 		bool startEvaluated = false;
@@ -320,7 +328,7 @@ void ExecutionGroup::execute(ExecutionSystem *graph)
 			int xChunk = chunkNumber - (yChunk * this->m_numberOfXChunks);
 			const ChunkExecutionState state = this->m_chunkExecutionStates[chunkNumber];
 			if (state == COM_ES_NOT_SCHEDULED) {
-				scheduleChunkWhenPossible(graph, xChunk, yChunk);
+				scheduleChunkWhenPossible(graph, xChunk, yChunk, useHotspot && index < hotspotChunksLen);
 				finished = false;
 				startEvaluated = true;
 				numberEvaluated++;
@@ -350,6 +358,47 @@ void ExecutionGroup::execute(ExecutionSystem *graph)
 	MEM_freeN(chunkOrder);
 }
 
+/**
+ * this method is called for the top execution groups when the tree is calculated as full frames,
+ * the groups it depends on are calculated first.
+ */
+void ExecutionGroup::executeFullFrame(ExecutionSystem *graph)
+{
+	const CompositorContext &context = graph->getContext();
+	const bNodeTree *bTree = context.getbNodeTree();
+	unsigned int index;
+
+	if (this->m_fullFrameExecuted) {
+		return;
+	}
+	this->m_fullFrameExecuted = true;
+
+	for (index = 0; index < this->m_cachedReadOperations.size(); index++) {
+		ReadBufferOperation *readOperation = (ReadBufferOperation *)this->m_cachedReadOperations[index];
+		ExecutionGroup *inputGroup = readOperation->getMemoryProxy()->getExecutor();
+		if (inputGroup) {
+			inputGroup->executeFullFrame(graph);
+		}
+	}
+
+	rcti area;
+	BLI_rcti_init(&area, 0, this->m_width, 0, this->m_height);
+	if (!BLI_rcti_isect(&area, &this->m_viewerBorder, &area)) {
+		return; /// @note: break out... no pixels to calculate.
+	}
+	if (bTree->test_break && bTree->test_break(bTree->tbh)) {
+		return;
+	}
+
+	this->m_executionStartTime = PIL_check_seconds_timer();
+	DebugInfo::execution_group_started(this);
+
+	FullFrameExecution execution(this, bTree, &area, this->m_singleThreaded);
+	execution.execute();
+
+	DebugInfo::execution_group_finished(this);
+}
+
 MemoryBuffer **ExecutionGroup::getInputBuffersOpenCL(int chunkNumber)
 {
 	rcti rect;
@@ -448,10 +497,10 @@ MemoryBuffer *ExecutionGroup::allocateOutputBuffer(int /*chunkNumber*/,
 }
 
 
-bool ExecutionGroup::scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *area)
+bool ExecutionGroup::scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *area, bool highPriority)
 {
 	if (this->m_singleThreaded) {
-		return scheduleChunkWhenPossible(graph, 0, 0);
+		return scheduleChunkWhenPossible(graph, 0, 0, highPriority);
 	}
 	// find all chunks inside the rect
 	// determine minxchunk, minychunk, maxxchunk, maxychunk where x and y are chunknumbers
@@ -473,7 +522,7 @@ bool ExecutionGroup::scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *area
 	bool result = true;
 	for (indexx = minxchunk; indexx < maxxchunk; indexx++) {
 		for (indexy = minychunk; indexy < maxychunk; indexy++) {
-			if (!scheduleChunkWhenPossible(graph, indexx, indexy)) {
+			if (!scheduleChunkWhenPossible(graph, indexx, indexy, highPriority)) {
 				result = false;
 			}
 		}
@@ -482,17 +531,17 @@ bool ExecutionGroup::scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *area
 	return result;
 }
 
-bool ExecutionGroup::scheduleChunk(unsigned int chunkNumber)
+bool ExecutionGroup::scheduleChunk(unsigned int chunkNumber, bool highPriority)
 {
 	if (this->m_chunkExecutionStates[chunkNumber] == COM_ES_NOT_SCHEDULED) {
 		this->m_chunkExecutionStates[chunkNumber] = COM_ES_SCHEDULED;
-		WorkScheduler::schedule(this, chunkNumber);
+		WorkScheduler::schedule(this, chunkNumber, highPriority);
 		return true;
 	}
 	return false;
 }
 
-bool ExecutionGroup::scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk)
+bool ExecutionGroup::scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk, bool highPriority)
 {
 	if (xChunk < 0 || xChunk >= (int)this->m_numberOfXChunks) {
 		return true;
@@ -529,7 +578,7 @@ bool ExecutionGroup::scheduleChunkWhenPossible(ExecutionSystem *graph, int xChun
 		ExecutionGroup *group = memoryProxy->getExecutor();
 
 		if (group != NULL) {
-			if (!group->scheduleAreaWhenPossible(graph, &area)) {
+			if (!group->scheduleAreaWhenPossible(graph, &area, highPriority)) {
 				canBeExecuted = false;
 			}
 		}
@@ -539,7 +588,7 @@ bool ExecutionGroup::scheduleChunkWhenPossible(ExecutionSystem *graph, int xChun
 	}
 
 	if (canBeExecuted) {
-		scheduleChunk(chunkNumber);
+		scheduleChunk(chunkNumber, highPriority);
 	}
 
 	return false;
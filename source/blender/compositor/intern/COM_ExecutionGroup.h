@@ -173,6 +173,12 @@ private:
 	 */
 	rcti m_viewerBorder;
 
+	/**
+	 * @brief has this ExecutionGroup been calculated by executeFullFrame
+	 * @note groups read by several other groups are only calculated once
+	 */
+	bool m_fullFrameExecuted;
+
 	/**
 	 * @brief start time of execution
 	 */
@@ -213,11 +219,12 @@ private:
 	 * @param graph
 	 * @param xChunk
 	 * @param yChunk
+	 * @param highPriority the chunk is near the hotspot of the viewer, see WorkScheduler.schedule
 	 * @return [true:false]
 	 * true: package(s) are scheduled
 	 * false: scheduling is deferred (depending workpackages are scheduled)
 	 */
-	bool scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk);
+	bool scheduleChunkWhenPossible(ExecutionSystem *graph, int xChunk, int yChunk, bool highPriority);
 
 	/**
 	 * @brief try to schedule a specific area.
@@ -225,17 +232,19 @@ private:
 	 * @note This method is called from other ExecutionGroup's.
 	 * @param graph
 	 * @param rect
+	 * @param highPriority the area is needed by a chunk near the hotspot of the viewer
 	 * @return [true:false]
 	 * true: package(s) are scheduled
 	 * false: scheduling is deferred (depending workpackages are scheduled)
 	 */
-	bool scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *rect);
+	bool scheduleAreaWhenPossible(ExecutionSystem *graph, rcti *rect, bool highPriority);
 
 	/**
 	 * @brief add a chunk to the WorkScheduler.
 	 * @param chunknumber
+	 * @param highPriority
 	 */
-	bool scheduleChunk(unsigned int chunkNumber);
+	bool scheduleChunk(unsigned int chunkNumber, bool highPriority);
 	
 	/**
 	 * @brief determine the area of interest of a certain input area
@@ -375,6 +384,14 @@ public:
 	 * @param system
 	 */
 	void execute(ExecutionSystem *system);
+
+	/**
+	 * @brief calculate this ExecutionGroup as a whole, instead of in chunks
+	 * @note the ExecutionGroups it reads from are calculated first.
+	 * @see FullFrameExecution
+	 * @see CompositorContext.isFullFrame
+	 */
+	void executeFullFrame(ExecutionSystem *system);
 	
 	/**
 	 * @brief this method determines the MemoryProxy's where this execution group depends on.
@@ -204,7 +204,12 @@ void ExecutionSystem::executeGroups(CompositorPriority priority)
 
 	for (index = 0; index < executionGroups.size(); index++) {
 		ExecutionGroup *group = executionGroups[index];
-		group->execute(this);
+		if (this->m_context.isFullFrame()) {
+			group->executeFullFrame(this);
+		}
+		else {
+			group->execute(this);
+		}
 	}
 }
 
@@ -0,0 +1,265 @@
+/*
+ * Copyright 2017, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "COM_FullFrameExecution.h"
+#include "COM_ReadBufferOperation.h"
+#include "COM_WriteBufferOperation.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_math.h"
+#include "BLI_rect.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+}
+
+/* rows per band, bands are the unit of work for the task scheduler */
+#define COM_FF_BAND_HEIGHT_MAX 64
+
+typedef struct BandData {
+	FullFrameExecution *execution;
+	NodeOperation *operation;
+	FullFrameExecution::BandMode mode;
+	MemoryBuffer *output;
+	MemoryBuffer **inputs;
+	const rcti *area;
+	int bandHeight;
+} BandData;
+
+static NodeOperation *input_operation(NodeOperation *operation, unsigned int index)
+{
+	NodeOperationOutput *link = operation->getInputSocket(index)->getLink();
+	return link ? &link->getOperation() : NULL;
+}
+
+static void execute_band_pixels(NodeOperation *operation, MemoryBuffer *output, rcti *rect)
+{
+	const int num_channels = output->get_num_channels();
+
+	if (operation->isComplex()) {
+		void *data = operation->initializeTileData(rect);
+		for (int y = rect->ymin; y < rect->ymax; y++) {
+			float *out = output->getElem(rect->xmin, y);
+			for (int x = rect->xmin; x < rect->xmax; x++, out += num_channels) {
+				operation->read(out, x, y, data);
+			}
+		}
+		if (data) {
+			operation->deinitializeTileData(rect, data);
+		}
+	}
+	else {
+		for (int y = rect->ymin; y < rect->ymax; y++) {
+			float *out = output->getElem(rect->xmin, y);
+			for (int x = rect->xmin; x < rect->xmax; x++, out += num_channels) {
+				operation->readSampled(out, x, y, COM_PS_NEAREST);
+			}
+		}
+	}
+}
+
+static void execute_band_cb(void *userdata, const int band)
+{
+	BandData *data = (BandData *)userdata;
+	FullFrameExecution *execution = data->execution;
+	NodeOperation *operation = data->operation;
+	rcti rect;
+
+	if (execution->isBreaked()) {
+		return;
+	}
+
+	BLI_rcti_init(&rect, data->area->xmin, data->area->xmax,
+	              data->area->ymin + band * data->bandHeight,
+	              min_ii(data->area->ymin + (band + 1) * data->bandHeight, data->area->ymax));
+
+	switch (data->mode) {
+		case FullFrameExecution::COM_FF_BAND_PARTIAL:
+			operation->updateMemoryBufferPartial(data->output, &rect, data->inputs);
+			break;
+		case FullFrameExecution::COM_FF_BAND_PIXELS:
+			execute_band_pixels(operation, data->output, &rect);
+			break;
+		case FullFrameExecution::COM_FF_BAND_REGION:
+			operation->executeRegion(&rect, band);
+			break;
+	}
+
+	if (operation->isBreaked()) {
+		execution->setBreaked();
+	}
+}
+
+FullFrameExecution::FullFrameExecution(ExecutionGroup *group, const bNodeTree *bTree, const rcti *area,
+                                       bool singleThreaded)
+{
+	this->m_group = group;
+	this->m_bTree = bTree;
+	this->m_area = *area;
+	this->m_singleThreaded = singleThreaded;
+	this->m_breaked = false;
+}
+
+void FullFrameExecution::executeBands(NodeOperation *operation, BandMode mode, MemoryBuffer *output,
+                                      MemoryBuffer **inputs)
+{
+	const int height = BLI_rcti_size_y(&this->m_area);
+	BandData data;
+	int bandsLen;
+
+	data.execution = this;
+	data.operation = operation;
+	data.mode = mode;
+	data.output = output;
+	data.inputs = inputs;
+	data.area = &this->m_area;
+
+	if (this->m_singleThreaded) {
+		data.bandHeight = max_ii(height, 1);
+	}
+	else {
+		/* a few bands per thread, so threads finishing early can take more work */
+		const int bandsMin = BLI_system_thread_count() * 4;
+		data.bandHeight = min_ii(max_ii((height + bandsMin - 1) / bandsMin, 1), COM_FF_BAND_HEIGHT_MAX);
+	}
+	bandsLen = (height + data.bandHeight - 1) / data.bandHeight;
+
+	BLI_task_parallel_range(0, bandsLen, &data, execute_band_cb, bandsLen > 1);
+}
+
+void FullFrameExecution::countUsers(NodeOperation *operation)
+{
+	if (!operation->isFullFrame()) {
+		/* reads its inputs per pixel, no buffers needed */
+		return;
+	}
+
+	for (unsigned int index = 0; index < operation->getNumberOfInputSockets(); index++) {
+		NodeOperation *input = input_operation(operation, index);
+		OperationBuffer &entry = this->m_buffers[input];
+		if (entry.users++ == 0) {
+			entry.buffer = NULL;
+			entry.owned = false;
+			countUsers(input);
+		}
+	}
+}
+
+MemoryBuffer **FullFrameExecution::evaluateInputs(NodeOperation *operation)
+{
+	const unsigned int inputsLen = operation->getNumberOfInputSockets();
+	MemoryBuffer **inputs = (MemoryBuffer **)MEM_callocN(sizeof(MemoryBuffer *) * (inputsLen + 1), __func__);
+
+	for (unsigned int index = 0; index < inputsLen; index++) {
+		inputs[index] = evaluate(input_operation(operation, index), NULL);
+	}
+	return inputs;
+}
+
+void FullFrameExecution::releaseInputs(NodeOperation *operation, MemoryBuffer **inputs)
+{
+	for (unsigned int index = 0; index < operation->getNumberOfInputSockets(); index++) {
+		std::map<NodeOperation *, OperationBuffer>::iterator it = this->m_buffers.find(input_operation(operation, index));
+		BLI_assert(it != this->m_buffers.end());
+
+		OperationBuffer &entry = it->second;
+		if (--entry.users == 0) {
+			if (entry.owned) {
+				delete entry.buffer;
+			}
+			this->m_buffers.erase(it);
+		}
+	}
+	MEM_freeN(inputs);
+}
+
+/**
+ * Calculate the area of an operation.
+ *
+ * \param output: Buffer to write to, when NULL the result is allocated and kept until all readers are done.
+ */
+MemoryBuffer *FullFrameExecution::evaluate(NodeOperation *operation, MemoryBuffer *output)
+{
+	OperationBuffer *entry = NULL;
+
+	if (output == NULL) {
+		entry = &this->m_buffers[operation];
+		if (entry->buffer) {
+			return entry->buffer;
+		}
+
+		if (operation->isReadBufferOperation()) {
+			/* use the buffer directly when it matches */
+			entry->buffer = ((ReadBufferOperation *)operation)->getFullFrameBuffer(&this->m_area);
+			if (entry->buffer) {
+				return entry->buffer;
+			}
+		}
+
+		output = new MemoryBuffer(operation->getOutputSocket()->getDataType(), &this->m_area);
+		entry->buffer = output;
+		entry->owned = true;
+	}
+
+	if (!this->m_breaked) {
+		if (operation->isFullFrame()) {
+			MemoryBuffer **inputs = evaluateInputs(operation);
+			if (!this->m_breaked) {
+				executeBands(operation, COM_FF_BAND_PARTIAL, output, inputs);
+			}
+			releaseInputs(operation, inputs);
+		}
+		else {
+			executeBands(operation, COM_FF_BAND_PIXELS, output, NULL);
+		}
+	}
+
+	return output;
+}
+
+void FullFrameExecution::execute()
+{
+	NodeOperation *operation = this->m_group->getOutputOperation();
+
+	if (operation->isWriteBufferOperation()) {
+		/* calculate the input directly into the buffer of the memory proxy */
+		MemoryBuffer *buffer = ((WriteBufferOperation *)operation)->getMemoryProxy()->getBuffer();
+		NodeOperation *input = input_operation(operation, 0);
+
+		countUsers(input);
+		evaluate(input, buffer);
+		buffer->setCreatedState();
+	}
+	else if (operation->isFullFrame()) {
+		countUsers(operation);
+		MemoryBuffer **inputs = evaluateInputs(operation);
+		if (!this->m_breaked) {
+			executeBands(operation, COM_FF_BAND_PARTIAL, NULL, inputs);
+		}
+		releaseInputs(operation, inputs);
+	}
+	else {
+		executeBands(operation, COM_FF_BAND_REGION, NULL, NULL);
+	}
+
+	BLI_assert(this->m_buffers.empty());
+	if (this->m_bTree->update_draw) {
+		this->m_bTree->update_draw(this->m_bTree->udh);
+	}
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2017, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _COM_FullFrameExecution_h_
+#define _COM_FullFrameExecution_h_
+
+#include <map>
+
+#include "COM_ExecutionGroup.h"
+#include "COM_MemoryBuffer.h"
+#include "COM_NodeOperation.h"
+
+/**
+ * @brief Calculates the result of an ExecutionGroup as whole buffers.
+ *
+ * Instead of reading every pixel through the chain of operations, each operation supporting it
+ * (NodeOperation.isFullFrame) calculates its complete output buffer from the buffers of its inputs
+ * (NodeOperation.updateMemoryBufferPartial). Other operations are still evaluated per pixel,
+ * reading their inputs the regular way.
+ *
+ * The area is split in bands of rows which are calculated in parallel. Buffers are freed as soon
+ * as all operations reading them are done.
+ * @ingroup Execution
+ */
+class FullFrameExecution {
+private:
+	typedef struct OperationBuffer {
+		MemoryBuffer *buffer;
+		/** number of operations still reading the buffer */
+		int users;
+		/** buffer is allocated here (and not shared with a ReadBufferOperation) */
+		bool owned;
+	} OperationBuffer;
+
+	ExecutionGroup *m_group;
+	const bNodeTree *m_bTree;
+	rcti m_area;
+	bool m_singleThreaded;
+	bool m_breaked;
+
+	std::map<NodeOperation *, OperationBuffer> m_buffers;
+
+	void countUsers(NodeOperation *operation);
+	MemoryBuffer *evaluate(NodeOperation *operation, MemoryBuffer *output);
+	MemoryBuffer **evaluateInputs(NodeOperation *operation);
+	void releaseInputs(NodeOperation *operation, MemoryBuffer **inputs);
+
+public:
+	typedef enum BandMode {
+		/** call updateMemoryBufferPartial */
+		COM_FF_BAND_PARTIAL,
+		/** read every pixel of the operation into the output buffer */
+		COM_FF_BAND_PIXELS,
+		/** call executeRegion (output operations without full frame support) */
+		COM_FF_BAND_REGION
+	} BandMode;
+
+	FullFrameExecution(ExecutionGroup *group, const bNodeTree *bTree, const rcti *area, bool singleThreaded);
+
+	void execute();
+
+	/**
+	 * @brief calculate the area of an operation in parallel bands
+	 */
+	void executeBands(NodeOperation *operation, BandMode mode, MemoryBuffer *output, MemoryBuffer **inputs);
+
+	bool isBreaked() const { return this->m_breaked; }
+	void setBreaked() { this->m_breaked = true; }
+
+#ifdef WITH_CXX_GUARDEDALLOC
+	MEM_CXX_CLASS_ALLOC_FUNCS("COM:FullFrameExecution")
+#endif
+};
+
+#endif
@@ -172,6 +172,16 @@ void MemoryBuffer::copyContentFrom(MemoryBuffer *otherBuffer)
 	}
 }
 
+void MemoryBuffer::fill(const rcti *area, const float *value)
+{
+	for (int y = area->ymin; y < area->ymax; y++) {
+		float *out = this->getElem(area->xmin, y);
+		for (int x = area->xmin; x < area->xmax; x++, out += this->m_num_channels) {
+			memcpy(out, value, this->m_num_channels * sizeof(float));
+		}
+	}
+}
+
 void MemoryBuffer::writePixel(int x, int y, const float color[4])
 {
 	if (x >= this->m_rect.xmin && x < this->m_rect.xmax &&
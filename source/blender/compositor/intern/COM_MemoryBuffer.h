@@ -250,6 +250,16 @@ public:
 		memcpy(result, buffer, sizeof(float) * this->m_num_channels);
 	}
 	
+	/**
+	 * @brief get the pixel at x, y (image space) for direct access
+	 * @note the pixel must be inside the rect of this buffer
+	 */
+	inline float *getElem(int x, int y)
+	{
+		BLI_assert(x >= m_rect.xmin && x < m_rect.xmax && y >= m_rect.ymin && y < m_rect.ymax);
+		return &this->m_buffer[((y - m_rect.ymin) * this->m_width + (x - m_rect.xmin)) * this->m_num_channels];
+	}
+
 	void writePixel(int x, int y, const float color[4]);
 	void addPixel(int x, int y, const float color[4]);
 	inline void readBilinear(float *result, float x, float y,
@@ -285,6 +295,12 @@ public:
 	 *       uninitialized values in areas where the buffers don't overlap.
 	 */
 	void copyContentFrom(MemoryBuffer *otherBuffer);
+
+	/**
+	 * @brief set every pixel of area to value
+	 * @note value has the number of channels of this buffer
+	 */
+	void fill(const rcti *area, const float *value);
 	
 	/**
 	 * @brief get the rect of this MemoryBuffer
@@ -105,6 +105,12 @@ private:
 	 */
 	bool m_openCL;
 
+	/**
+	 * @brief does this operation implement updateMemoryBufferPartial.
+	 * @see CompositorContext.isFullFrame
+	 */
+	bool m_fullFrame;
+
 	/**
 	 * @brief mutex reference for very special node initializations
 	 * @note only use when you really know what you are doing.
@@ -216,6 +222,19 @@ public:
 	                           list<cl_kernel> * /*clKernelsToCleanUp*/) {}
 	virtual void deinitExecution();
 
+	/**
+	 * @brief calculate an area of the output at once, used by the full frame execution model
+	 * @ingroup execution
+	 * @note only called when isFullFrame() is set, other operations are evaluated per pixel
+	 * @param output buffer to write to, covering at least area. NULL for output operations,
+	 * which write their own result.
+	 * @param area the area to calculate, the result must match executePixelSampled at the same coordinates
+	 * @param inputs buffers with the result of the input operations (in socket order), covering area
+	 */
+	virtual void updateMemoryBufferPartial(MemoryBuffer * /*output*/,
+	                                       rcti * /*area*/,
+	                                       MemoryBuffer ** /*inputs*/) {}
+
 	bool isResolutionSet() {
 		return this->m_isResolutionSet;
 	}
@@ -288,6 +307,11 @@ public:
 	 * @see ExecutionGroup.addOperation
 	 */
 	bool isOpenCL() const { return this->m_openCL; }
+
+	/**
+	 * @brief can this NodeOperation calculate areas at once using updateMemoryBufferPartial
+	 */
+	bool isFullFrame() const { return this->m_fullFrame; }
 	
 	virtual bool isViewerOperation() const { return false; }
 	virtual bool isPreviewOperation() const { return false; }
@@ -333,6 +357,11 @@ protected:
 	 */
 	void setOpenCL(bool openCL) { this->m_openCL = openCL; }
 
+	/**
+	 * @brief set if this NodeOperation implements updateMemoryBufferPartial
+	 */
+	void setFullFrame(bool fullFrame) { this->m_fullFrame = fullFrame; }
+
 	/* allow the DebugInfo class to look at internals */
 	friend class DebugInfo;
 
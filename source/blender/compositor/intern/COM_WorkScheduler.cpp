@@ -34,6 +34,7 @@
 #include "MEM_guardedalloc.h"
 
 #include "PIL_time.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "BKE_global.h"
@@ -43,6 +44,8 @@
 #    warning COM_CURRENT_THREADING_MODEL COM_TM_NOTHREAD is activated. Use only for debugging.
 #  endif
 #elif COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+   /* do nothing */
+#elif COM_CURRENT_THREADING_MODEL == COM_TM_TASK
    /* do nothing - default */
 #else
 #  error COM_CURRENT_THREADING_MODEL No threading model selected
@@ -53,12 +56,19 @@
 static vector<CPUDevice*> g_cpudevices;
 static ThreadLocal(CPUDevice *) g_thread_device;
 
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
+static bool g_cpuInitialized = false;
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
 /// @brief list of all thread for every CPUDevice in cpudevices a thread exists
 static ListBase g_cputhreads;
-static bool g_cpuInitialized = false;
 /// @brief all scheduled work for the cpu
 static ThreadQueue *g_cpuqueue;
+#else
+/// @brief all scheduled work for the cpu, executed by the threads of the task scheduler
+static TaskPool *g_cpupool;
+/// @brief own task scheduler when the render settings limit the number of threads, NULL to use the global one
+static TaskScheduler *g_cpuscheduler = NULL;
+#endif
 static ThreadQueue *g_gpuqueue;
 #ifdef COM_OPENCL_ENABLED
 static cl_context g_context;
@@ -88,7 +98,60 @@ void *WorkScheduler::thread_execute_cpu(void *data)
 	
 	return NULL;
 }
+#elif COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+static void thread_execute_cpu_task(TaskPool *__restrict /*pool*/, void *taskdata, int threadid)
+{
+	WorkPackage *work = (WorkPackage *)taskdata;
+	CPUDevice *device = g_cpudevices[threadid];
+
+	/* once the user breaks, the remaining chunks are skipped instead of calculated */
+	if (work->getExecutionGroup()->getOutputOperation()->isBreaked()) {
+		return;
+	}
+
+	BLI_thread_local_set(g_thread_device, device);
+	device->execute(work);
+}
+
+static void thread_free_work_package(TaskPool *__restrict /*pool*/, void *taskdata, int /*threadid*/)
+{
+	delete (WorkPackage *)taskdata;
+}
+
+static TaskScheduler *cpu_task_scheduler()
+{
+	return g_cpuscheduler ? g_cpuscheduler : BLI_task_scheduler_get();
+}
+
+/* Use the global task scheduler unless fewer threads than it has are requested. */
+static void cpu_task_scheduler_init(int num_cpu_threads)
+{
+	TaskScheduler *global_scheduler = BLI_task_scheduler_get();
+	const int num_threads = (num_cpu_threads < BLI_task_scheduler_num_threads(global_scheduler)) ?
+	                        num_cpu_threads : 0;
+
+	if (g_cpuscheduler && BLI_task_scheduler_num_threads(g_cpuscheduler) == num_threads) {
+		return;
+	}
+	if (g_cpuscheduler) {
+		BLI_task_scheduler_free(g_cpuscheduler);
+		g_cpuscheduler = NULL;
+	}
+	if (num_threads > 0) {
+		g_cpuscheduler = BLI_task_scheduler_create(num_threads);
+	}
+}
+
+static void cpu_task_scheduler_free()
+{
+	if (g_cpuscheduler) {
+		BLI_task_scheduler_free(g_cpuscheduler);
+		g_cpuscheduler = NULL;
+	}
+}
+#endif
 
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
 void *WorkScheduler::thread_execute_gpu(void *data)
 {
 	Device *device = (Device *)data;
@@ -105,14 +168,16 @@ void *WorkScheduler::thread_execute_gpu(void *data)
 
 
 
-void WorkScheduler::schedule(ExecutionGroup *group, int chunkNumber)
+void WorkScheduler::schedule(ExecutionGroup *group, int chunkNumber, bool highPriority)
 {
 	WorkPackage *package = new WorkPackage(group, chunkNumber);
 #if COM_CURRENT_THREADING_MODEL == COM_TM_NOTHREAD
 	CPUDevice device(0);
 	device.execute(package);
 	delete package;
+	(void)highPriority;
 #elif COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+	(void)highPriority;
 #ifdef COM_OPENCL_ENABLED
 	if (group->isOpenCL() && g_openclActive) {
 		BLI_thread_queue_push(g_gpuqueue, package);
@@ -123,19 +188,32 @@ void WorkScheduler::schedule(ExecutionGroup *group, int chunkNumber)
 #else
 	BLI_thread_queue_push(g_cpuqueue, package);
 #endif
+#elif COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+#ifdef COM_OPENCL_ENABLED
+	if (group->isOpenCL() && g_openclActive) {
+		BLI_thread_queue_push(g_gpuqueue, package);
+		return;
+	}
+#endif
+	BLI_task_pool_push_ex(g_cpupool, thread_execute_cpu_task, package, true, thread_free_work_package,
+	                      highPriority ? TASK_PRIORITY_HIGH : TASK_PRIORITY_LOW);
 #endif
 }
 
 void WorkScheduler::start(CompositorContext &context)
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
 	unsigned int index;
+#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
 	g_cpuqueue = BLI_thread_queue_init();
 	BLI_init_threads(&g_cputhreads, thread_execute_cpu, g_cpudevices.size());
 	for (index = 0; index < g_cpudevices.size(); index++) {
 		Device *device = g_cpudevices[index];
 		BLI_insert_thread(&g_cputhreads, device);
 	}
+#else
+	g_cpupool = BLI_task_pool_create(cpu_task_scheduler(), NULL);
+#endif
 #ifdef COM_OPENCL_ENABLED
 	if (context.getHasActiveOpenCLDevices()) {
 		g_gpuqueue = BLI_thread_queue_init();
@@ -166,15 +244,28 @@ void WorkScheduler::finish()
 #else
 	BLI_thread_queue_wait_finish(cpuqueue);
 #endif
+#elif COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+	/* the calling thread helps calculating the chunks while waiting */
+	BLI_task_pool_work_and_wait(g_cpupool);
+#ifdef COM_OPENCL_ENABLED
+	if (g_openclActive) {
+		BLI_thread_queue_wait_finish(g_gpuqueue);
+	}
+#endif
 #endif
 }
 void WorkScheduler::stop()
 {
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
 	BLI_thread_queue_nowait(g_cpuqueue);
 	BLI_end_threads(&g_cputhreads);
 	BLI_thread_queue_free(g_cpuqueue);
 	g_cpuqueue = NULL;
+#else
+	BLI_task_pool_free(g_cpupool);
+	g_cpupool = NULL;
+#endif
 #ifdef COM_OPENCL_ENABLED
 	if (g_openclActive) {
 		BLI_thread_queue_nowait(g_gpuqueue);
@@ -188,7 +279,7 @@ void WorkScheduler::stop()
 
 bool WorkScheduler::hasGPUDevices()
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
 #ifdef COM_OPENCL_ENABLED
 	return g_gpudevices.size() > 0;
 #else
@@ -199,7 +290,7 @@ bool WorkScheduler::hasGPUDevices()
 #endif
 }
 
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
 static void CL_CALLBACK clContextError(const char *errinfo,
                                        const void * /*private_info*/,
                                        size_t /*cb*/,
@@ -211,7 +302,13 @@ static void CL_CALLBACK clContextError(const char *errinfo,
 
 void WorkScheduler::initialize(bool use_opencl, int num_cpu_threads)
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
+#if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+	/* the threads are owned by the task scheduler, one device for each of its threads
+	 * and one for the thread waiting in WorkScheduler.finish */
+	cpu_task_scheduler_init(num_cpu_threads);
+	num_cpu_threads = BLI_task_scheduler_num_threads(cpu_task_scheduler()) + 1;
+#endif
 	/* deinitialize if number of threads doesn't match */
 	if (g_cpudevices.size() != num_cpu_threads) {
 		Device *device;
@@ -311,7 +408,7 @@ void WorkScheduler::initialize(bool use_opencl, int num_cpu_threads)
 
 void WorkScheduler::deinitialize()
 {
-#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
 	/* deinitialize CPU threads */
 	if (g_cpuInitialized) {
 		Device *device;
@@ -324,6 +421,9 @@ void WorkScheduler::deinitialize()
 		BLI_thread_local_delete(g_thread_device);
 		g_cpuInitialized = false;
 	}
+#if COM_CURRENT_THREADING_MODEL == COM_TM_TASK
+	cpu_task_scheduler_free();
+#endif
 
 #ifdef COM_OPENCL_ENABLED
 	/* deinitialize OpenCL GPU's */
@@ -47,7 +47,9 @@ class WorkScheduler {
 	 * inside this loop new work is queried and being executed
 	 */
 	static void *thread_execute_cpu(void *data);
+#endif
 
+#if COM_CURRENT_THREADING_MODEL != COM_TM_NOTHREAD
 	/**
 	 * @brief main thread loop for gpudevices
 	 * inside this loop new work is queried and being executed
@@ -63,8 +65,9 @@ public:
 	 * @see ExecutionGroup.execute
 	 * @param group the execution group
 	 * @param chunkNumber the number of the chunk in the group to be executed
+	 * @param highPriority calculate the chunk before other work of the task scheduler (COM_TM_TASK only)
 	 */
-	static void schedule(ExecutionGroup *group, int chunkNumber);
+	static void schedule(ExecutionGroup *group, int chunkNumber, bool highPriority);
 
 	/**
 	 * @brief initialize the WorkScheduler
@@ -88,7 +91,8 @@ public:
 	/**
 	 * @brief Start the execution
 	 * this methods will start the WorkScheduler. Inside this method all threads are initialized.
-	 * for every device a thread is created.
+	 * for every device a thread is created, with COM_TM_TASK only for the OpenCL devices,
+	 * chunks for the CPU are pushed to a task pool.
 	 * @see initialize Initialization and query of the number of devices
 	 */
 	static void start(CompositorContext &context);
@@ -102,6 +106,7 @@ public:
 
 	/**
 	 * @brief wait for all work to be completed.
+	 * @note with COM_TM_TASK the calling thread calculates chunks as well.
 	 */
 	static void finish();
 
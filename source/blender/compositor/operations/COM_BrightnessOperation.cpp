@@ -30,6 +30,7 @@ BrightnessOperation::BrightnessOperation() : NodeOperation()
 	this->addOutputSocket(COM_DT_COLOR);
 	this->m_inputProgram = NULL;
 	this->m_use_premultiply = false;
+	this->setFullFrame(true);
 }
 
 void BrightnessOperation::setUsePremultiply(bool use_premultiply)
@@ -83,6 +84,44 @@ void BrightnessOperation::executePixelSampled(float output[4], float x, float y,
 	}
 }
 
+void BrightnessOperation::updateMemoryBufferPartial(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+	for (int y = area->ymin; y < area->ymax; y++) {
+		float *out = output->getElem(area->xmin, y);
+		const float *in_color = inputs[0]->getElem(area->xmin, y);
+		const float *in_brightness = inputs[1]->getElem(area->xmin, y);
+		const float *in_contrast = inputs[2]->getElem(area->xmin, y);
+		for (int x = area->xmin; x < area->xmax; x++, out += 4, in_color += 4, in_brightness++, in_contrast++) {
+			float color[4];
+			float a, b;
+			const float brightness = in_brightness[0] / 100.0f;
+			const float contrast = in_contrast[0];
+			float delta = contrast / 200.0f;
+			a = 1.0f - delta * 2.0f;
+			/* same as executePixelSampled */
+			if (contrast > 0) {
+				a = 1.0f / a;
+				b = a * (brightness - delta);
+			}
+			else {
+				delta *= -1;
+				b = a * (brightness + delta);
+			}
+			copy_v4_v4(color, in_color);
+			if (this->m_use_premultiply) {
+				premul_to_straight_v4(color);
+			}
+			out[0] = a * color[0] + b;
+			out[1] = a * color[1] + b;
+			out[2] = a * color[2] + b;
+			out[3] = color[3];
+			if (this->m_use_premultiply) {
+				straight_to_premul_v4(out);
+			}
+		}
+	}
+}
+
 void BrightnessOperation::deinitExecution()
 {
 	this->m_inputProgram = NULL;
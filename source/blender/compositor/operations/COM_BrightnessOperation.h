@@ -43,6 +43,7 @@ public:
 	 * the inner loop of this program
 	 */
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void updateMemoryBufferPartial(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
 	
 	/**
 	 * Initialize the execution
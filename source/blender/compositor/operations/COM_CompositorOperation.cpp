@@ -210,6 +210,31 @@ void CompositorOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/)
 	}
 }
 
+void CompositorOperation::updateMemoryBufferPartial(MemoryBuffer * /*output*/, rcti *area, MemoryBuffer **inputs)
+{
+	float *buffer = this->m_outputBuffer;
+	float *zbuffer = this->m_depthBuffer;
+
+	if (!buffer) return;
+
+	for (int y = area->ymin; y < area->ymax; y++) {
+		const int offset = y * this->getWidth() + area->xmin;
+		float *out = buffer + offset * COM_NUM_CHANNELS_COLOR;
+		float *out_depth = zbuffer + offset;
+		const float *in_color = inputs[0]->getElem(area->xmin, y);
+		const float *in_alpha = inputs[1]->getElem(area->xmin, y);
+		const float *in_depth = inputs[2]->getElem(area->xmin, y);
+
+		memcpy(out, in_color, sizeof(float) * COM_NUM_CHANNELS_COLOR * BLI_rcti_size_x(area));
+		memcpy(out_depth, in_depth, sizeof(float) * BLI_rcti_size_x(area));
+		if (this->m_useAlphaInput) {
+			for (int x = area->xmin; x < area->xmax; x++, out += COM_NUM_CHANNELS_COLOR, in_alpha++) {
+				out[3] = in_alpha[0];
+			}
+		}
+	}
+}
+
 void CompositorOperation::determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2])
 {
 	int width = this->m_rd->xsch * this->m_rd->size / 100;
@@ -84,6 +84,7 @@ public:
 	CompositorOperation();
 	const bool isActiveCompositorOutput() const { return this->m_active; }
 	void executeRegion(rcti *rect, unsigned int tileNumber);
+	void updateMemoryBufferPartial(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
 	void setSceneName(const char *sceneName) { BLI_strncpy(this->m_sceneName, sceneName, sizeof(this->m_sceneName)); }
 	void setViewName(const char *viewName) { this->m_viewName = viewName; }
 	void setRenderData(const RenderData *rd) { this->m_rd = rd; }
@@ -93,7 +94,7 @@ public:
 	const CompositorPriority getRenderPriority() const { return COM_PRIORITY_MEDIUM; }
 	void determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2]);
 	void setUseAlphaInput(bool value) { this->m_useAlphaInput = value; }
-	void setActive(bool active) { this->m_active = active; }
+	void setActive(bool active) { this->m_active = active; this->setFullFrame(active); }
 };
 #endif
 
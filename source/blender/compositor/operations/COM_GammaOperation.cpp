@@ -30,6 +30,7 @@ GammaOperation::GammaOperation() : NodeOperation()
 	this->addOutputSocket(COM_DT_COLOR);
 	this->m_inputProgram = NULL;
 	this->m_inputGammaProgram = NULL;
+	this->setFullFrame(true);
 }
 void GammaOperation::initExecution()
 {
@@ -53,6 +54,23 @@ void GammaOperation::executePixelSampled(float output[4], float x, float y, Pixe
 	output[3] = inputValue[3];
 }
 
+void GammaOperation::updateMemoryBufferPartial(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+	for (int y = area->ymin; y < area->ymax; y++) {
+		float *out = output->getElem(area->xmin, y);
+		const float *in_value = inputs[0]->getElem(area->xmin, y);
+		const float *in_gamma = inputs[1]->getElem(area->xmin, y);
+		for (int x = area->xmin; x < area->xmax; x++, out += 4, in_value += 4, in_gamma++) {
+			const float gamma = in_gamma[0];
+			/* check for negative to avoid nan's */
+			out[0] = in_value[0] > 0.0f ? powf(in_value[0], gamma) : in_value[0];
+			out[1] = in_value[1] > 0.0f ? powf(in_value[1], gamma) : in_value[1];
+			out[2] = in_value[2] > 0.0f ? powf(in_value[2], gamma) : in_value[2];
+			out[3] = in_value[3];
+		}
+	}
+}
+
 void GammaOperation::deinitExecution()
 {
 	this->m_inputProgram = NULL;
@@ -55,6 +55,7 @@ BaseImageOperation::BaseImageOperation() : NodeOperation()
 ImageOperation::ImageOperation() : BaseImageOperation()
 {
 	this->addOutputSocket(COM_DT_COLOR);
+	this->setFullFrame(true);
 }
 ImageAlphaOperation::ImageAlphaOperation() : BaseImageOperation()
 {
@@ -171,6 +172,34 @@ void ImageOperation::executePixelSampled(float output[4], float x, float y, Pixe
 	}
 }
 
+void ImageOperation::updateMemoryBufferPartial(MemoryBuffer *output, rcti *area, MemoryBuffer ** /*inputs*/)
+{
+	for (int y = area->ymin; y < area->ymax; y++) {
+		float *out = output->getElem(area->xmin, y);
+		if ((this->m_imageFloatBuffer == NULL && this->m_imageByteBuffer == NULL) ||
+		    y < 0 || y >= this->m_buffer->y)
+		{
+			memset(out, 0, sizeof(float) * 4 * BLI_rcti_size_x(area));
+			continue;
+		}
+		for (int x = area->xmin; x < area->xmax; x++, out += 4) {
+			if (x < 0 || x >= this->m_buffer->x) {
+				zero_v4(out);
+			}
+			else if (this->m_imageFloatBuffer && this->m_numberOfChannels == 4) {
+				/* nearest sampling at pixel coordinates, copy the remaining part of the row */
+				const int len = min_ii(area->xmax, this->m_buffer->x) - x;
+				memcpy(out, this->m_imageFloatBuffer + ((size_t)y * this->m_buffer->x + x) * 4, sizeof(float) * 4 * len);
+				out += 4 * (len - 1);
+				x += len - 1;
+			}
+			else {
+				sampleImageAtLocation(this->m_buffer, x, y, COM_PS_NEAREST, true, out);
+			}
+		}
+	}
+}
+
 void ImageAlphaOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float tempcolor[4];
@@ -77,6 +77,7 @@ public:
 	 */
 	ImageOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void updateMemoryBufferPartial(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
 };
 class ImageAlphaOperation : public BaseImageOperation {
 public:
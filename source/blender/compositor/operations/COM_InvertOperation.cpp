@@ -32,6 +32,7 @@ InvertOperation::InvertOperation() : NodeOperation()
 	this->m_color = true;
 	this->m_alpha = false;
 	setResolutionInputSocketIndex(1);
+	this->setFullFrame(true);
 }
 void InvertOperation::initExecution()
 {
@@ -65,6 +66,33 @@ void InvertOperation::executePixelSampled(float output[4], float x, float y, Pix
 
 }
 
+void InvertOperation::updateMemoryBufferPartial(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+	for (int y = area->ymin; y < area->ymax; y++) {
+		float *out = output->getElem(area->xmin, y);
+		const float *in_value = inputs[0]->getElem(area->xmin, y);
+		const float *in_color = inputs[1]->getElem(area->xmin, y);
+		for (int x = area->xmin; x < area->xmax; x++, out += 4, in_value++, in_color += 4) {
+			const float value = in_value[0];
+			const float invertedValue = 1.0f - value;
+
+			if (this->m_color) {
+				out[0] = (1.0f - in_color[0]) * value + in_color[0] * invertedValue;
+				out[1] = (1.0f - in_color[1]) * value + in_color[1] * invertedValue;
+				out[2] = (1.0f - in_color[2]) * value + in_color[2] * invertedValue;
+			}
+			else {
+				copy_v3_v3(out, in_color);
+			}
+
+			if (this->m_alpha)
+				out[3] = (1.0f - in_color[3]) * value + in_color[3] * invertedValue;
+			else
+				out[3] = in_color[3];
+		}
+	}
+}
+
 void InvertOperation::deinitExecution()
 {
 	this->m_inputValueProgram = NULL;
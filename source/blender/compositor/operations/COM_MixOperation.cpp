@@ -104,7 +104,7 @@ void MixBaseOperation::deinitExecution()
 
 MixAddOperation::MixAddOperation() : MixBaseOperation()
 {
-	/* pass */
+	this->setFullFrame(true);
 }
 
 void MixAddOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
@@ -129,11 +129,33 @@ void MixAddOperation::executePixelSampled(float output[4], float x, float y, Pix
 	clampIfNeeded(output);
 }
 
+void MixAddOperation::updateMemoryBufferPartial(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+	for (int y = area->ymin; y < area->ymax; y++) {
+		float *out = output->getElem(area->xmin, y);
+		const float *in_value = inputs[0]->getElem(area->xmin, y);
+		const float *in_color1 = inputs[1]->getElem(area->xmin, y);
+		const float *in_color2 = inputs[2]->getElem(area->xmin, y);
+		for (int x = area->xmin; x < area->xmax; x++, out += 4, in_value++, in_color1 += 4, in_color2 += 4) {
+			float value = in_value[0];
+			if (this->useValueAlphaMultiply()) {
+				value *= in_color2[3];
+			}
+			out[0] = in_color1[0] + value * in_color2[0];
+			out[1] = in_color1[1] + value * in_color2[1];
+			out[2] = in_color1[2] + value * in_color2[2];
+			out[3] = in_color1[3];
+
+			clampIfNeeded(out);
+		}
+	}
+}
+
 /* ******** Mix Blend Operation ******** */
 
 MixBlendOperation::MixBlendOperation() : MixBaseOperation()
 {
-	/* pass */
+	this->setFullFrame(true);
 }
 
 void MixBlendOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
@@ -160,6 +182,29 @@ void MixBlendOperation::executePixelSampled(float output[4], float x, float y, P
 	clampIfNeeded(output);
 }
 
+void MixBlendOperation::updateMemoryBufferPartial(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+	for (int y = area->ymin; y < area->ymax; y++) {
+		float *out = output->getElem(area->xmin, y);
+		const float *in_value = inputs[0]->getElem(area->xmin, y);
+		const float *in_color1 = inputs[1]->getElem(area->xmin, y);
+		const float *in_color2 = inputs[2]->getElem(area->xmin, y);
+		for (int x = area->xmin; x < area->xmax; x++, out += 4, in_value++, in_color1 += 4, in_color2 += 4) {
+			float value = in_value[0];
+			if (this->useValueAlphaMultiply()) {
+				value *= in_color2[3];
+			}
+			const float valuem = 1.0f - value;
+			out[0] = valuem * (in_color1[0]) + value * (in_color2[0]);
+			out[1] = valuem * (in_color1[1]) + value * (in_color2[1]);
+			out[2] = valuem * (in_color1[2]) + value * (in_color2[2]);
+			out[3] = in_color1[3];
+
+			clampIfNeeded(out);
+		}
+	}
+}
+
 /* ******** Mix Burn Operation ******** */
 
 MixBurnOperation::MixBurnOperation() : MixBaseOperation()
@@ -597,7 +642,7 @@ void MixLinearLightOperation::executePixelSampled(float output[4], float x, floa
 
 MixMultiplyOperation::MixMultiplyOperation() : MixBaseOperation()
 {
-	/* pass */
+	this->setFullFrame(true);
 }
 
 void MixMultiplyOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
@@ -623,6 +668,29 @@ void MixMultiplyOperation::executePixelSampled(float output[4], float x, float y
 	clampIfNeeded(output);
 }
 
+void MixMultiplyOperation::updateMemoryBufferPartial(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+	for (int y = area->ymin; y < area->ymax; y++) {
+		float *out = output->getElem(area->xmin, y);
+		const float *in_value = inputs[0]->getElem(area->xmin, y);
+		const float *in_color1 = inputs[1]->getElem(area->xmin, y);
+		const float *in_color2 = inputs[2]->getElem(area->xmin, y);
+		for (int x = area->xmin; x < area->xmax; x++, out += 4, in_value++, in_color1 += 4, in_color2 += 4) {
+			float value = in_value[0];
+			if (this->useValueAlphaMultiply()) {
+				value *= in_color2[3];
+			}
+			const float valuem = 1.0f - value;
+			out[0] = in_color1[0] * (valuem + value * in_color2[0]);
+			out[1] = in_color1[1] * (valuem + value * in_color2[1]);
+			out[2] = in_color1[2] * (valuem + value * in_color2[2]);
+			out[3] = in_color1[3];
+
+			clampIfNeeded(out);
+		}
+	}
+}
+
 /* ******** Mix Ovelray Operation ******** */
 
 MixOverlayOperation::MixOverlayOperation() : MixBaseOperation()
@@ -781,7 +849,7 @@ void MixSoftLightOperation::executePixelSampled(float output[4], float x, float
 
 MixSubtractOperation::MixSubtractOperation() : MixBaseOperation()
 {
-	/* pass */
+	this->setFullFrame(true);
 }
 
 void MixSubtractOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
@@ -806,6 +874,28 @@ void MixSubtractOperation::executePixelSampled(float output[4], float x, float y
 	clampIfNeeded(output);
 }
 
+void MixSubtractOperation::updateMemoryBufferPartial(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs)
+{
+	for (int y = area->ymin; y < area->ymax; y++) {
+		float *out = output->getElem(area->xmin, y);
+		const float *in_value = inputs[0]->getElem(area->xmin, y);
+		const float *in_color1 = inputs[1]->getElem(area->xmin, y);
+		const float *in_color2 = inputs[2]->getElem(area->xmin, y);
+		for (int x = area->xmin; x < area->xmax; x++, out += 4, in_value++, in_color1 += 4, in_color2 += 4) {
+			float value = in_value[0];
+			if (this->useValueAlphaMultiply()) {
+				value *= in_color2[3];
+			}
+			out[0] = in_color1[0] - value * (in_color2[0]);
+			out[1] = in_color1[1] - value * (in_color2[1]);
+			out[2] = in_color1[2] - value * (in_color2[2]);
+			out[3] = in_color1[3];
+
+			clampIfNeeded(out);
+		}
+	}
+}
+
 /* ******** Mix Value Operation ******** */
 
 MixValueOperation::MixValueOperation() : MixBaseOperation()
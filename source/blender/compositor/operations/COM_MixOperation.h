@@ -84,12 +84,14 @@ class MixAddOperation : public MixBaseOperation {
 public:
 	MixAddOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void updateMemoryBufferPartial(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
 };
 
 class MixBlendOperation : public MixBaseOperation {
 public:
 	MixBlendOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void updateMemoryBufferPartial(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
 };
 
 class MixBurnOperation : public MixBaseOperation {
@@ -156,6 +158,7 @@ class MixMultiplyOperation : public MixBaseOperation {
 public:
 	MixMultiplyOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void updateMemoryBufferPartial(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
 };
 
 class MixOverlayOperation : public MixBaseOperation {
@@ -186,6 +189,7 @@ class MixSubtractOperation : public MixBaseOperation {
 public:
 	MixSubtractOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	void updateMemoryBufferPartial(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
 };
 
 class MixValueOperation : public MixBaseOperation {
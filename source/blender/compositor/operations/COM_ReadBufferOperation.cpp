@@ -30,6 +30,7 @@ ReadBufferOperation::ReadBufferOperation(DataType datatype) : NodeOperation()
 	this->m_single_value = false;
 	this->m_offset = 0;
 	this->m_buffer = NULL;
+	this->setFullFrame(true);
 }
 
 void *ReadBufferOperation::initializeTileData(rcti * /*rect*/)
@@ -125,3 +126,38 @@ void ReadBufferOperation::updateMemoryBuffer()
 	this->m_buffer = this->getMemoryProxy()->getBuffer();
 	
 }
+
+MemoryBuffer *ReadBufferOperation::getFullFrameBuffer(const rcti *area)
+{
+	if (!m_single_value && m_buffer && BLI_rcti_compare(m_buffer->getRect(), area)) {
+		return m_buffer;
+	}
+	return NULL;
+}
+
+void ReadBufferOperation::updateMemoryBufferPartial(MemoryBuffer *output, rcti *area, MemoryBuffer ** /*inputs*/)
+{
+	const int num_channels = output->get_num_channels();
+	const size_t row_size = sizeof(float) * num_channels * BLI_rcti_size_x(area);
+
+	for (int y = area->ymin; y < area->ymax; y++) {
+		float *out = output->getElem(area->xmin, y);
+		if (m_single_value) {
+			/* write buffer has a single value stored at (0,0) */
+			const float *value = m_buffer->getBuffer();
+			for (int x = area->xmin; x < area->xmax; x++, out += num_channels) {
+				memcpy(out, value, sizeof(float) * num_channels);
+			}
+		}
+		else if (BLI_rcti_isect_pt(m_buffer->getRect(), area->xmin, y) &&
+		         BLI_rcti_isect_pt(m_buffer->getRect(), area->xmax - 1, y))
+		{
+			memcpy(out, m_buffer->getElem(area->xmin, y), row_size);
+		}
+		else {
+			for (int x = area->xmin; x < area->xmax; x++, out += num_channels) {
+				m_buffer->read(out, x, y);
+			}
+		}
+	}
+}
@@ -51,6 +51,12 @@ public:
 	MemoryBuffer *getInputMemoryBuffer(MemoryBuffer **memoryBuffers) { return memoryBuffers[this->m_offset]; }
 	void readResolutionFromWriteBuffer();
 	void updateMemoryBuffer();
+
+	/**
+	 * @brief the buffer of the memory proxy, when it holds exactly area (full frame execution)
+	 */
+	MemoryBuffer *getFullFrameBuffer(const rcti *area);
+	void updateMemoryBufferPartial(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
 };
 
 #endif
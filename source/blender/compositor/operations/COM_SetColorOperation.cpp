@@ -25,6 +25,7 @@
 SetColorOperation::SetColorOperation() : NodeOperation()
 {
 	this->addOutputSocket(COM_DT_COLOR);
+	this->setFullFrame(true);
 }
 
 void SetColorOperation::executePixelSampled(float output[4],
@@ -34,6 +35,11 @@ void SetColorOperation::executePixelSampled(float output[4],
 	copy_v4_v4(output, this->m_color);
 }
 
+void SetColorOperation::updateMemoryBufferPartial(MemoryBuffer *output, rcti *area, MemoryBuffer ** /*inputs*/)
+{
+	output->fill(area, this->m_color);
+}
+
 void SetColorOperation::determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2])
 {
 	resolution[0] = preferredResolution[0];
@@ -25,6 +25,7 @@
 SetValueOperation::SetValueOperation() : NodeOperation()
 {
 	this->addOutputSocket(COM_DT_VALUE);
+	this->setFullFrame(true);
 }
 
 void SetValueOperation::executePixelSampled(float output[4],
@@ -34,6 +35,11 @@ void SetValueOperation::executePixelSampled(float output[4],
 	output[0] = this->m_value;
 }
 
+void SetValueOperation::updateMemoryBufferPartial(MemoryBuffer *output, rcti *area, MemoryBuffer ** /*inputs*/)
+{
+	output->fill(area, &this->m_value);
+}
+
 void SetValueOperation::determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2])
 {
 	resolution[0] = preferredResolution[0];
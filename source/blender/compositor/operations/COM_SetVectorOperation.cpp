@@ -26,6 +26,7 @@
 SetVectorOperation::SetVectorOperation() : NodeOperation()
 {
 	this->addOutputSocket(COM_DT_VECTOR);
+	this->setFullFrame(true);
 }
 
 void SetVectorOperation::executePixelSampled(float output[4],
@@ -37,6 +38,12 @@ void SetVectorOperation::executePixelSampled(float output[4],
 	output[2] = this->m_z;
 }
 
+void SetVectorOperation::updateMemoryBufferPartial(MemoryBuffer *output, rcti *area, MemoryBuffer ** /*inputs*/)
+{
+	const float vector[3] = {this->m_x, this->m_y, this->m_z};
+	output->fill(area, vector);
+}
+
 void SetVectorOperation::determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2])
 {
 	resolution[0] = preferredResolution[0];
@@ -123,6 +123,32 @@ void ViewerOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/)
 	updateImage(rect);
 }
 
+void ViewerOperation::updateMemoryBufferPartial(MemoryBuffer * /*output*/, rcti *area, MemoryBuffer **inputs)
+{
+	float *buffer = this->m_outputBuffer;
+	float *depthbuffer = this->m_depthBuffer;
+
+	if (!buffer) return;
+
+	for (int y = area->ymin; y < area->ymax; y++) {
+		const int offset = y * this->getWidth() + area->xmin;
+		float *out = buffer + offset * 4;
+		const float *in_color = inputs[0]->getElem(area->xmin, y);
+		const float *in_alpha = inputs[1]->getElem(area->xmin, y);
+
+		memcpy(out, in_color, sizeof(float) * 4 * BLI_rcti_size_x(area));
+		if (this->m_useAlphaInput) {
+			for (int x = area->xmin; x < area->xmax; x++, out += 4, in_alpha++) {
+				out[3] = in_alpha[0];
+			}
+		}
+		if (depthbuffer) {
+			memcpy(depthbuffer + offset, inputs[2]->getElem(area->xmin, y), sizeof(float) * BLI_rcti_size_x(area));
+		}
+	}
+	updateImage(area);
+}
+
 void ViewerOperation::initImage()
 {
 	Image *ima = this->m_image;
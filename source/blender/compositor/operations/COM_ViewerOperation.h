@@ -55,11 +55,12 @@ public:
 	void initExecution();
 	void deinitExecution();
 	void executeRegion(rcti *rect, unsigned int tileNumber);
+	void updateMemoryBufferPartial(MemoryBuffer *output, rcti *area, MemoryBuffer **inputs);
 	bool isOutputOperation(bool /*rendering*/) const { if (G.background) return false; return isActiveViewerOutput(); }
 	void setImage(Image *image) { this->m_image = image; }
 	void setImageUser(ImageUser *imageUser) { this->m_imageUser = imageUser; }
 	const bool isActiveViewerOutput() const { return this->m_active; }
-	void setActive(bool active) { this->m_active = active; }
+	void setActive(bool active) { this->m_active = active; this->setFullFrame(active); }
 	void setCenterX(float centerX) { this->m_centerX = centerX;}
 	void setCenterY(float centerY) { this->m_centerY = centerY;}
 	void setChunkOrder(OrderOfChunks tileOrder) { this->m_chunkOrder = tileOrder; }
@@ -43,6 +43,7 @@ struct Depsgraph;
 struct CacheFile;
 struct EffectorWeights;
 struct Group;
+struct ID;
 struct Main;
 struct ModifierData;
 struct Object;
@@ -67,6 +68,11 @@ void DEG_graph_tag_relations_update(struct Depsgraph *graph);
 /* Tag all relations in the database for update.*/
 void DEG_relations_tag_update(struct Main *bmain);
 
+/* Tag relations of the given ID for update, only nodes and relations of
+ * this ID and IDs directly depending on it are rebuilt when possible.
+ */
+void DEG_relations_tag_update_id(struct Main *bmain, struct ID *id);
+
 /* Create new graph if didn't exist yet,
  * or update relations if graph was tagged for update.
  */
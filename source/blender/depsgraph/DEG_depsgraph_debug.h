@@ -82,6 +82,24 @@ void DEG_stats_simple(const struct Depsgraph *graph,
                       size_t *r_operations,
                       size_t *r_relations);
 
+void DEG_stats_eval(const struct Depsgraph *graph,
+                    double *r_wall_time,
+                    double *r_critical_path_time,
+                    double *r_operations_time);
+
+/* ************************************************ */
+/* Evaluation Trace */
+
+/* Record start and end time, thread, ID and name of every evaluated operation,
+ * for all graphs, until the trace is ended.
+ */
+void DEG_debug_trace_begin(const char *filepath);
+
+/* Write the recorded trace as Chrome trace event JSON, which can be opened in
+ * chrome://tracing. Returns false when nothing was recorded or writing failed.
+ */
+bool DEG_debug_trace_end(void);
+
 /* ************************************************ */
 /* Diagram-Based Graph Debugging */
 
@@ -93,6 +111,10 @@ void DEG_debug_graphviz(const struct Depsgraph *graph, FILE *stream, const char
 bool DEG_debug_compare(const struct Depsgraph *graph1,
                        const struct Depsgraph *graph2);
 
+/* Number of incremental relations updates which differed from a full
+ * rebuild, when validated with debug value 801. */
+int DEG_debug_invalid_incremental_updates(const struct Depsgraph *graph);
+
 /* Check that dependnecies in the graph are really up to date. */
 bool DEG_debug_scene_relations_validate(struct Main *bmain,
                                         struct Scene *scene);
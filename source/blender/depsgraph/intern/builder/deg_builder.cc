@@ -35,20 +35,90 @@
 #include "DNA_ID.h"
 
 #include "BLI_utildefines.h"
+#include "BLI_flathash.h"
 #include "BLI_ghash.h"
+#include "BLI_math_base.h"
 
 #include "intern/depsgraph.h"
 #include "intern/depsgraph_types.h"
 #include "intern/nodes/deg_node.h"
+#include "intern/nodes/deg_node_operation.h"
+
+#include "util/deg_util_foreach.h"
+
+/* Cost of operations which were never evaluated, in seconds. */
+#define DEG_EVAL_DEFAULT_COST 1e-5f
 
 namespace DEG {
 
+static bool relation_counts_for_priority(const DepsRelation *rel)
+{
+	return (rel->from->type == DEG_NODE_TYPE_OPERATION &&
+	        rel->to->type == DEG_NODE_TYPE_OPERATION &&
+	        (rel->flag & DEPSREL_FLAG_CYCLIC) == 0);
+}
+
+/* Priority of an operation is the estimated time of the longest chain of
+ * operations which can only start after it, including itself. Estimates come
+ * from the cost model, so operations which are kept by an incremental
+ * relations update use the time measured in earlier evaluations.
+ *
+ * Operations are visited after all of their children, starting with the ones
+ * which have none, so there is no recursion however long the chains are.
+ */
+void deg_graph_calculate_eval_priority(Depsgraph *graph)
+{
+	vector<OperationDepsNode *> queue;
+	queue.reserve(graph->operations.size());
+
+	/* Until the node is visited, num_links_pending counts its children which
+	 * were not visited yet and eval_priority is the highest priority among the
+	 * visited ones. Evaluation resets num_links_pending to count parents. */
+	foreach (OperationDepsNode *node, graph->operations) {
+		node->num_links_pending = 0;
+		node->eval_priority = 0.0f;
+		foreach (DepsRelation *rel, node->outlinks) {
+			if (relation_counts_for_priority(rel)) {
+				++node->num_links_pending;
+			}
+		}
+		if (node->num_links_pending == 0) {
+			queue.push_back(node);
+		}
+	}
+
+	for (size_t i = 0; i < queue.size(); ++i) {
+		OperationDepsNode *node = queue[i];
+
+		/* NOOP nodes have no cost */
+		if (!node->is_noop()) {
+			node->eval_priority += (node->eval_cost != 0.0f) ? node->eval_cost
+			                                                  : DEG_EVAL_DEFAULT_COST;
+		}
+
+		foreach (DepsRelation *rel, node->inlinks) {
+			if (!relation_counts_for_priority(rel)) {
+				continue;
+			}
+			OperationDepsNode *from = (OperationDepsNode *)rel->from;
+			from->eval_priority = max_ff(from->eval_priority, node->eval_priority);
+			BLI_assert(from->num_links_pending > 0);
+			if (--from->num_links_pending == 0) {
+				queue.push_back(from);
+			}
+		}
+	}
+
+	/* All cycles were broken by flagging relations as cyclic. */
+	BLI_assert(queue.size() == graph->operations.size());
+}
+
 void deg_graph_build_finalize(Depsgraph *graph)
 {
 	/* Re-tag IDs for update if it was tagged before the relations
 	 * update tag.
 	 */
-	GHASH_FOREACH_BEGIN(IDDepsNode *, id_node, graph->id_hash)
+	FLATHASH_FOREACH_BEGIN(IDDepsNode *, id_node, graph->id_hash)
 	{
 		ID *id = id_node->id;
 		if ((id->tag & LIB_TAG_ID_RECALC_ALL)) {
@@ -62,7 +132,7 @@ void deg_graph_build_finalize(Depsgraph *graph)
 		}
 		id_node->finalize_build();
 	}
-	GHASH_FOREACH_END();
+	FLATHASH_FOREACH_END();
 }
 
 }  // namespace DEG
@@ -35,5 +35,6 @@ namespace DEG {
 struct Depsgraph;
 
 void deg_graph_build_finalize(struct Depsgraph *graph);
+void deg_graph_calculate_eval_priority(struct Depsgraph *graph);
 
 }  // namespace DEG
@@ -0,0 +1,111 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2017 Blender Foundation.
+ * All rights reserved.
+ *
+ * Contributor(s): None Yet
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/depsgraph/intern/builder/deg_builder_fusion.cc
+ *  \ingroup depsgraph
+ */
+
+#include "intern/builder/deg_builder_fusion.h"
+
+#include "intern/nodes/deg_node.h"
+#include "intern/nodes/deg_node_operation.h"
+
+#include "intern/depsgraph.h"
+
+#include "util/deg_util_foreach.h"
+
+namespace DEG {
+
+/* -------------------------------------------------- */
+
+/* Operation chain fusion.
+ *
+ * Rigs create long chains of tiny operations, for example the local, pose
+ * and done operations of every bone, where scheduling a task per operation
+ * costs more than the evaluation itself. When an operation has a single
+ * child which depends on nothing else, the child becomes ready exactly when
+ * the operation is done, so it is linked as chain_next and evaluated right
+ * after it by the same task, without touching the pending counters.
+ *
+ * Relations are left as they are, so tagging, flushing and everything else
+ * traversing the graph behaves the same with fused chains.
+ */
+
+/* Only operation which the given one depends on, NULL when there are more
+ * or cyclic relations. Relations from time sources are ignored, like the
+ * evaluation ignores them when counting pending parents.
+ */
+static OperationDepsNode *get_single_parent(const OperationDepsNode *node)
+{
+	OperationDepsNode *parent = NULL;
+	foreach (DepsRelation *rel, node->inlinks) {
+		if (rel->flag & DEPSREL_FLAG_CYCLIC) {
+			return NULL;
+		}
+		if (rel->from->type != DEG_NODE_TYPE_OPERATION) {
+			continue;
+		}
+		if (parent != NULL) {
+			return NULL;
+		}
+		parent = (OperationDepsNode *)rel->from;
+	}
+	return parent;
+}
+
+/* Only operation depending on the given one. */
+static OperationDepsNode *get_single_child(const OperationDepsNode *node)
+{
+	if (node->outlinks.size() != 1) {
+		return NULL;
+	}
+	const DepsRelation *rel = node->outlinks[0];
+	if (rel->flag & DEPSREL_FLAG_CYCLIC || rel->to->type != DEG_NODE_TYPE_OPERATION) {
+		return NULL;
+	}
+	return (OperationDepsNode *)rel->to;
+}
+
+void deg_graph_clear_operation_chains(Depsgraph *graph)
+{
+	foreach (OperationDepsNode *node, graph->operations) {
+		node->chain_next = NULL;
+	}
+}
+
+int deg_graph_fuse_operation_chains(Depsgraph *graph)
+{
+	int num_fused = 0;
+	foreach (OperationDepsNode *node, graph->operations) {
+		OperationDepsNode *child = get_single_child(node);
+		if (child != NULL && get_single_parent(child) == node) {
+			node->chain_next = child;
+			num_fused++;
+		}
+	}
+	return num_fused;
+}
+
+}  // namespace DEG
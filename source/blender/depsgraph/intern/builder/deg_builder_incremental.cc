@@ -0,0 +1,369 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2017 Blender Foundation.
+ * All rights reserved.
+ *
+ * Contributor(s): None Yet
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/depsgraph/intern/builder/deg_builder_incremental.cc
+ *  \ingroup depsgraph
+ */
+
+#include "intern/builder/deg_builder_incremental.h"
+
+#include <algorithm>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_flathash.h"
+#include "BLI_ghash.h"
+
+extern "C" {
+#include "DNA_key_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "BKE_key.h"
+} /* extern "C" */
+
+#include "intern/builder/deg_builder_nodes.h"
+#include "intern/builder/deg_builder_relations.h"
+
+#include "intern/nodes/deg_node.h"
+#include "intern/nodes/deg_node_component.h"
+#include "intern/nodes/deg_node_operation.h"
+
+#include "intern/depsgraph.h"
+#include "intern/depsgraph_intern.h"
+
+#include "util/deg_util_foreach.h"
+
+namespace DEG {
+
+/* -------------------------------------------------- */
+
+/* Incremental relations update.
+ *
+ * Nodes of the tagged IDs are removed together with all their relations, and
+ * built again. Relations of their direct dependents lose their source, so all
+ * incoming relations of the dependents are removed and built again as well.
+ * Everything else is left as it is, so the builders are given LIB_TAG_DOIT on
+ * all the IDs which are to be skipped, exactly like for IDs which they have
+ * already handled during a full build.
+ *
+ * Only objects are handled this way. Relations of some objects are built by
+ * other IDs (proxies, metaballs, rigid bodies), those fall back to a full
+ * rebuild, as does anything touching more than a fraction of the graph.
+ */
+
+/* When more IDs than this part of the graph are affected, building the graph
+ * from scratch is about as fast and has less to go wrong.
+ */
+static const float DEG_INCREMENTAL_MAX_AFFECTED_RATIO = 0.25f;
+
+static bool object_relations_are_local(const Object *object)
+{
+	if (object->proxy != NULL || object->proxy_from != NULL) {
+		/* Proxy relations are built by the object the proxy is made from. */
+		return false;
+	}
+	if (object->type == OB_MBALL) {
+		/* Every metaball adds relations to its motherball. */
+		return false;
+	}
+	if (object->rigidbody_object != NULL || object->rigidbody_constraint != NULL) {
+		/* Simulation relations are built by the scene. */
+		return false;
+	}
+	return true;
+}
+
+/* Gathers relations of all operations of the ID node into the set. */
+static void id_node_relations_gather(IDDepsNode *id_node,
+                                     bool outlinks,
+                                     GSet *relations)
+{
+	GHASH_FOREACH_BEGIN(ComponentDepsNode *, comp_node, id_node->components)
+	{
+		foreach (OperationDepsNode *op_node, comp_node->operations) {
+			foreach (DepsRelation *rel, op_node->inlinks) {
+				BLI_gset_add(relations, rel);
+			}
+			if (outlinks) {
+				foreach (DepsRelation *rel, op_node->outlinks) {
+					BLI_gset_add(relations, rel);
+				}
+			}
+		}
+	}
+	GHASH_FOREACH_END();
+}
+
+/* Predicate for std::remove_if(), true for pointers stored in the set. */
+struct PointerInSet {
+	PointerInSet(GSet *set) : set(set) {}
+
+	bool operator()(const void *pointer) const
+	{
+		return BLI_gset_haskey(set, pointer);
+	}
+
+	GSet *set;
+};
+
+static void relations_unlink(DepsNode::Relations *links, GSet *relations)
+{
+	links->erase(std::remove_if(links->begin(),
+	                            links->end(),
+	                            PointerInSet(relations)),
+	             links->end());
+}
+
+/* Removes relations from both nodes they connect, and frees them. */
+static void relations_remove(GSet *relations)
+{
+	GSet *nodes = BLI_gset_ptr_new("Depsgraph incremental nodes");
+	GSET_FOREACH_BEGIN(DepsRelation *, rel, relations)
+	{
+		BLI_gset_add(nodes, rel->from);
+		BLI_gset_add(nodes, rel->to);
+	}
+	GSET_FOREACH_END();
+	GSET_FOREACH_BEGIN(DepsNode *, node, nodes)
+	{
+		relations_unlink(&node->inlinks, relations);
+		relations_unlink(&node->outlinks, relations);
+	}
+	GSET_FOREACH_END();
+	GSET_FOREACH_BEGIN(DepsRelation *, rel, relations)
+	{
+		OBJECT_GUARDED_DELETE(rel, DepsRelation);
+	}
+	GSET_FOREACH_END();
+	BLI_gset_free(nodes, NULL);
+}
+
+static void object_customdata_mask_update(IDDepsNode *id_node)
+{
+	Object *object = (Object *)id_node->id;
+	object->customdata_mask = 0;
+	GHASH_FOREACH_BEGIN(ComponentDepsNode *, comp_node, id_node->components)
+	{
+		GHASH_FOREACH_BEGIN(OperationDepsNode *, op_node, comp_node->operations_map)
+		{
+			object->customdata_mask |= op_node->customdata_mask;
+		}
+		GHASH_FOREACH_END();
+	}
+	GHASH_FOREACH_END();
+}
+
+bool deg_graph_build_incremental(Depsgraph *graph, Main *bmain, Scene *scene)
+{
+	if (scene->set != NULL) {
+		/* Objects of the set are built for the set scene. */
+		return false;
+	}
+
+	/* Objects which nodes are rebuilt. */
+	vector<IDDepsNode *> rebuild_nodes;
+	/* IDs which incoming relations are rebuilt. */
+	GSet *rebuild_relations = BLI_gset_ptr_new("Depsgraph incremental IDs");
+	bool use_incremental = true;
+
+	GSET_FOREACH_BEGIN(ID *, id, graph->relations_tagged_ids)
+	{
+		IDDepsNode *id_node = graph->find_id_node(id);
+		if (id_node == NULL) {
+			continue;
+		}
+		if (GS(id->name) != ID_OB) {
+			use_incremental = false;
+			break;
+		}
+		rebuild_nodes.push_back(id_node);
+		BLI_gset_add(rebuild_relations, id);
+	}
+	GSET_FOREACH_END();
+
+	/* Direct dependents, their relations from the removed nodes are lost. */
+	foreach (IDDepsNode *id_node, rebuild_nodes) {
+		GHASH_FOREACH_BEGIN(ComponentDepsNode *, comp_node, id_node->components)
+		{
+			foreach (OperationDepsNode *op_node, comp_node->operations) {
+				foreach (DepsRelation *rel, op_node->outlinks) {
+					OperationDepsNode *to = (OperationDepsNode *)rel->to;
+					BLI_gset_add(rebuild_relations, to->owner->owner->id);
+				}
+			}
+		}
+		GHASH_FOREACH_END();
+	}
+
+	/* Object data is built together with the first object using it, so its
+	 * relations have to be rebuilt along with those of the objects.
+	 */
+	vector<Object *> objects;
+	GSET_FOREACH_BEGIN(ID *, id, rebuild_relations)
+	{
+		if (GS(id->name) != ID_OB) {
+			use_incremental = false;
+			break;
+		}
+		Object *object = (Object *)id;
+		if (!object_relations_are_local(object)) {
+			use_incremental = false;
+			break;
+		}
+		objects.push_back(object);
+	}
+	GSET_FOREACH_END();
+	if (use_incremental) {
+		foreach (Object *object, objects) {
+			if (object->data != NULL) {
+				BLI_gset_add(rebuild_relations, object->data);
+			}
+			Key *key = BKE_key_from_object(object);
+			if (key != NULL) {
+				BLI_gset_add(rebuild_relations, &key->id);
+			}
+		}
+	}
+
+	const unsigned int num_id_nodes = BLI_flathash_size(graph->id_hash);
+	if (!use_incremental ||
+	    BLI_gset_size(rebuild_relations) > num_id_nodes * DEG_INCREMENTAL_MAX_AFFECTED_RATIO)
+	{
+		BLI_gset_free(rebuild_relations, NULL);
+		return false;
+	}
+
+	DEG_DEBUG_PRINTF("Depsgraph incremental update of %d objects, %d of %d IDs affected\n",
+	                 (int)rebuild_nodes.size(),
+	                 (int)BLI_gset_size(rebuild_relations),
+	                 (int)num_id_nodes);
+
+	/* 1) Remove relations of the tagged objects and incoming relations of
+	 *    their dependents.
+	 */
+	GSet *relations = BLI_gset_ptr_new("Depsgraph incremental relations");
+	foreach (IDDepsNode *id_node, rebuild_nodes) {
+		id_node_relations_gather(id_node, true, relations);
+	}
+	GSET_FOREACH_BEGIN(ID *, id, rebuild_relations)
+	{
+		IDDepsNode *id_node = graph->find_id_node(id);
+		if (id_node != NULL) {
+			id_node_relations_gather(id_node, false, relations);
+		}
+	}
+	GSET_FOREACH_END();
+	relations_remove(relations);
+	BLI_gset_free(relations, NULL);
+
+	/* 2) Remove nodes of the tagged objects. */
+	GSet *operations = BLI_gset_ptr_new("Depsgraph incremental operations");
+	vector<Object *> rebuild_objects;
+	foreach (IDDepsNode *id_node, rebuild_nodes) {
+		GHASH_FOREACH_BEGIN(ComponentDepsNode *, comp_node, id_node->components)
+		{
+			foreach (OperationDepsNode *op_node, comp_node->operations) {
+				BLI_gset_add(operations, op_node);
+				BLI_gset_remove(graph->entry_tags, op_node, NULL);
+			}
+		}
+		GHASH_FOREACH_END();
+		rebuild_objects.push_back((Object *)id_node->id);
+		graph->remove_id_node(id_node->id);
+	}
+	graph->operations.erase(std::remove_if(graph->operations.begin(),
+	                                       graph->operations.end(),
+	                                       PointerInSet(operations)),
+	                        graph->operations.end());
+	BLI_gset_free(operations, NULL);
+	const size_t num_kept_operations = graph->operations.size();
+
+	/* IDs which keep their relations. */
+	vector<ID *> kept_ids;
+	FLATHASH_FOREACH_BEGIN(IDDepsNode *, id_node, graph->id_hash)
+	{
+		if (!BLI_gset_haskey(rebuild_relations, id_node->id)) {
+			kept_ids.push_back(id_node->id);
+		}
+	}
+	FLATHASH_FOREACH_END();
+
+	/* 3) Build nodes of the tagged objects, and of the IDs they started to
+	 *    use which were not in the graph yet.
+	 */
+	DepsgraphNodeBuilder node_builder(bmain, graph);
+	node_builder.begin_build(bmain);
+	FLATHASH_FOREACH_BEGIN(IDDepsNode *, id_node, graph->id_hash)
+	{
+		id_node->id->tag |= LIB_TAG_DOIT;
+	}
+	FLATHASH_FOREACH_END();
+	foreach (Object *object, rebuild_objects) {
+		node_builder.build_object(scene, object);
+	}
+
+	/* 4) Build relations of the affected and new IDs. */
+	DepsgraphRelationBuilder relation_builder(graph);
+	relation_builder.begin_build(bmain);
+	foreach (ID *id, kept_ids) {
+		id->tag |= LIB_TAG_DOIT;
+	}
+	foreach (Object *object, objects) {
+		relation_builder.build_object(bmain, scene, object);
+	}
+
+	/* Custom data masks are gathered from all operations of an object. */
+	GSet *mask_id_nodes = BLI_gset_ptr_new("Depsgraph incremental masks");
+	for (size_t i = num_kept_operations; i < graph->operations.size(); i++) {
+		BLI_gset_add(mask_id_nodes, graph->operations[i]->owner->owner);
+	}
+	foreach (Object *object, objects) {
+		BLI_gset_add(mask_id_nodes, graph->find_id_node(&object->id));
+	}
+	GSET_FOREACH_BEGIN(IDDepsNode *, id_node, mask_id_nodes)
+	{
+		if (GS(id_node->id->name) == ID_OB) {
+			object_customdata_mask_update(id_node);
+		}
+	}
+	GSET_FOREACH_END();
+	BLI_gset_free(mask_id_nodes, NULL);
+
+	/* Cycles are detected again for the whole graph, relations which were
+	 * part of a cycle might not be anymore.
+	 */
+	foreach (OperationDepsNode *op_node, graph->operations) {
+		foreach (DepsRelation *rel, op_node->inlinks) {
+			rel->flag &= ~DEPSREL_FLAG_CYCLIC;
+		}
+	}
+
+	BLI_gset_free(rebuild_relations, NULL);
+	return true;
+}
+
+}  // namespace DEG
@@ -31,6 +31,7 @@
  */
 
 #include "BLI_utildefines.h"
+#include "BLI_flathash.h"
 #include "BLI_ghash.h"
 
 extern "C" {
@@ -491,11 +492,11 @@ static void deg_debug_graphviz_graph_nodes(const DebugContext &ctx,
 	if (graph->root_node) {
 		deg_debug_graphviz_node(ctx, graph->root_node);
 	}
-	GHASH_FOREACH_BEGIN (DepsNode *, node, graph->id_hash)
+	FLATHASH_FOREACH_BEGIN (DepsNode *, node, graph->id_hash)
 	{
 		deg_debug_graphviz_node(ctx, node);
 	}
-	GHASH_FOREACH_END();
+	FLATHASH_FOREACH_END();
 	TimeSourceDepsNode *time_source = graph->find_time_source();
 	if (time_source != NULL) {
 		deg_debug_graphviz_node(ctx, time_source);
@@ -505,7 +506,7 @@ static void deg_debug_graphviz_graph_nodes(const DebugContext &ctx,
 static void deg_debug_graphviz_graph_relations(const DebugContext &ctx,
                                                const Depsgraph *graph)
 {
-	GHASH_FOREACH_BEGIN(IDDepsNode *, id_node, graph->id_hash)
+	FLATHASH_FOREACH_BEGIN(IDDepsNode *, id_node, graph->id_hash)
 	{
 		GHASH_FOREACH_BEGIN(ComponentDepsNode *, comp_node, id_node->components)
 		{
@@ -515,7 +516,7 @@ static void deg_debug_graphviz_graph_relations(const DebugContext &ctx,
 		}
 		GHASH_FOREACH_END();
 	}
-	GHASH_FOREACH_END();
+	FLATHASH_FOREACH_END();
 
 	TimeSourceDepsNode *time_source = graph->find_time_source();
 	if (time_source != NULL) {
@@ -35,6 +35,7 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_utildefines.h"
+#include "BLI_flathash.h"
 #include "BLI_ghash.h"
 #include "BLI_listbase.h"
 
@@ -68,19 +69,25 @@ static DEG_EditorUpdateScenePreCb deg_editor_update_scene_pre_cb = NULL;
 
 Depsgraph::Depsgraph()
   : root_node(NULL),
-    need_update(false)
+    need_update(false),
+    num_invalid_incremental_updates(0),
+    eval_wall_time(0.0),
+    eval_critical_path_time(0.0),
+    eval_operations_time(0.0)
 {
 	BLI_spin_init(&lock);
-	id_hash = BLI_ghash_ptr_new("Depsgraph id hash");
+	id_hash = BLI_flathash_ptr_new("Depsgraph id hash");
 	entry_tags = BLI_gset_ptr_new("Depsgraph entry_tags");
+	relations_tagged_ids = BLI_gset_ptr_new("Depsgraph relations_tagged_ids");
 }
 
 Depsgraph::~Depsgraph()
 {
 	/* Free root node - it won't have been freed yet... */
 	clear_id_nodes();
-	BLI_ghash_free(id_hash, NULL, NULL);
+	BLI_flathash_free(id_hash, NULL, NULL);
 	BLI_gset_free(entry_tags, NULL);
+	BLI_gset_free(relations_tagged_ids, NULL);
 	if (this->root_node != NULL) {
 		OBJECT_GUARDED_DELETE(this->root_node, RootDepsNode);
 	}
@@ -274,7 +281,7 @@ TimeSourceDepsNode *Depsgraph::find_time_source() const
 
 IDDepsNode *Depsgraph::find_id_node(const ID *id) const
 {
-	return reinterpret_cast<IDDepsNode *>(BLI_ghash_lookup(id_hash, id));
+	return reinterpret_cast<IDDepsNode *>(BLI_flathash_lookup(id_hash, id));
 }
 
 IDDepsNode *Depsgraph::add_id_node(ID *id, const char *name)
@@ -285,7 +292,7 @@ IDDepsNode *Depsgraph::add_id_node(ID *id, const char *name)
 		id_node = (IDDepsNode *)factory->create_node(id, "", name);
 		id->tag |= LIB_TAG_DOIT;
 		/* register */
-		BLI_ghash_insert(id_hash, id, id_node);
+		BLI_flathash_insert(id_hash, id, id_node);
 	}
 	return id_node;
 }
@@ -295,14 +302,14 @@ void Depsgraph::remove_id_node(const ID *id)
 	IDDepsNode *id_node = find_id_node(id);
 	if (id_node) {
 		/* unregister */
-		BLI_ghash_remove(id_hash, id, NULL, NULL);
+		BLI_flathash_remove(id_hash, id, NULL, NULL);
 		OBJECT_GUARDED_DELETE(id_node, IDDepsNode);
 	}
 }
 
 void Depsgraph::clear_id_nodes()
 {
-	BLI_ghash_clear(id_hash, NULL, id_node_deleter);
+	BLI_flathash_clear(id_hash, NULL, id_node_deleter);
 }
 
 /* Add new relationship between two nodes. */
@@ -409,7 +416,7 @@ void Depsgraph::add_entry_tag(OperationDepsNode *node)
 void Depsgraph::clear_all_nodes()
 {
 	clear_id_nodes();
-	BLI_ghash_clear(id_hash, NULL, NULL);
+	BLI_flathash_clear(id_hash, NULL, NULL);
 	if (this->root_node) {
 		OBJECT_GUARDED_DELETE(this->root_node, RootDepsNode);
 		root_node = NULL;
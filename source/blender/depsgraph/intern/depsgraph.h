@@ -41,6 +41,7 @@
 #include "intern/depsgraph_types.h"
 
 struct ID;
+struct FlatHash;
 struct GHash;
 struct GSet;
 struct PointerRNA;
@@ -137,7 +138,7 @@ struct Depsgraph {
 
 	/* <ID : IDDepsNode> mapping from ID blocks to nodes representing these blocks
 	 * (for quick lookups). */
-	GHash *id_hash;
+	FlatHash *id_hash;
 
 	/* "root" node - the one where all evaluation enters from. */
 	RootDepsNode *root_node;
@@ -145,6 +146,16 @@ struct Depsgraph {
 	/* Indicates whether relations needs to be updated. */
 	bool need_update;
 
+	/* IDs which relations are to be rebuilt, without rebuilding the whole
+	 * graph. Only used when need_update is not set.
+	 */
+	GSet *relations_tagged_ids;
+
+	/* Incremental relations updates which differed from a full rebuild,
+	 * only counted when validating them with debug value 801.
+	 */
+	int num_invalid_incremental_updates;
+
 	/* Quick-Access Temp Data ............. */
 
 	/* Nodes which have been tagged as "directly modified". */
@@ -161,6 +172,14 @@ struct Depsgraph {
 	 */
 	SpinLock lock;
 
+	/* Statistics of the last evaluation, in seconds. */
+	double eval_wall_time;
+	/* Longest chain of dependent operations, the lower bound of wall time
+	 * with unlimited threads. */
+	double eval_critical_path_time;
+	/* Sum of the evaluation time of all operations. */
+	double eval_operations_time;
+
 	// XXX: additional stuff like eval contexts, mempools for allocating nodes from, etc.
 
 	Scene *scene; /* XXX: We really shouldn't do that, but it's required for shader preview */
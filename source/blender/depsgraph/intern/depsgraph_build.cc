@@ -60,6 +60,8 @@ extern "C" {
 
 #include "builder/deg_builder.h"
 #include "builder/deg_builder_cycle.h"
+#include "builder/deg_builder_fusion.h"
+#include "builder/deg_builder_incremental.h"
 #include "builder/deg_builder_nodes.h"
 #include "builder/deg_builder_relations.h"
 #include "builder/deg_builder_transitive.h"
@@ -184,6 +186,41 @@ void DEG_add_special_eval_flag(Depsgraph *graph, ID *id, short flag)
 /* ******************** */
 /* Graph Building API's */
 
+/* Steps done once all nodes and relations are in the graph, for both full
+ * and incremental builds.
+ */
+static void deg_graph_build_complete(DEG::Depsgraph *deg_graph)
+{
+	/* Detect and solve cycles. */
+	DEG::deg_graph_detect_cycles(deg_graph);
+
+	/* 3) Simplify the graph by removing redundant relations (to optimize
+	 *    traversal later). */
+	/* TODO: it would be useful to have an option to disable this in cases where
+	 *       it is causing trouble.
+	 */
+	if (G.debug_value == 799) {
+		DEG::deg_graph_transitive_reduction(deg_graph);
+	}
+
+	/* Evaluate linear chains of operations as a single task, to reduce the
+	 * scheduling overhead. Debug value 800 disables this, for comparison.
+	 */
+	DEG::deg_graph_clear_operation_chains(deg_graph);
+	if (G.debug_value != 800) {
+		const int num_fused = DEG::deg_graph_fuse_operation_chains(deg_graph);
+		DEG_DEBUG_PRINTF("Depsgraph fused %d of %d operations into chains\n",
+		                 num_fused,
+		                 (int)deg_graph->operations.size());
+	}
+
+	/* Operations with the longest remaining path are scheduled first. */
+	DEG::deg_graph_calculate_eval_priority(deg_graph);
+
+	/* 4) Flush visibility layer and re-schedule nodes for update. */
+	DEG::deg_graph_build_finalize(deg_graph);
+}
+
 /* Build depsgraph for the given scene, and dump results in given
  * graph container.
  */
@@ -220,20 +257,7 @@ void DEG_graph_build_from_scene(Depsgraph *graph, Main *bmain, Scene *scene)
 	relation_builder.begin_build(bmain);
 	relation_builder.build_scene(bmain, scene);
 
-	/* Detect and solve cycles. */
-	DEG::deg_graph_detect_cycles(deg_graph);
-
-	/* 3) Simplify the graph by removing redundant relations (to optimize
-	 *    traversal later). */
-	/* TODO: it would be useful to have an option to disable this in cases where
-	 *       it is causing trouble.
-	 */
-	if (G.debug_value == 799) {
-		DEG::deg_graph_transitive_reduction(deg_graph);
-	}
-
-	/* 4) Flush visibility layer and re-schedule nodes for update. */
-	DEG::deg_graph_build_finalize(deg_graph);
+	deg_graph_build_complete(deg_graph);
 
 #if 0
 	if (!DEG_debug_consistency_check(deg_graph)) {
@@ -267,6 +291,39 @@ void DEG_relations_tag_update(Main *bmain)
 	}
 }
 
+/* Tag relations of a single ID for update. */
+void DEG_relations_tag_update_id(Main *bmain, ID *id)
+{
+	for (Scene *scene = (Scene *)bmain->scene.first;
+	     scene != NULL;
+	     scene = (Scene *)scene->id.next)
+	{
+		if (scene->depsgraph != NULL) {
+			DEG::Depsgraph *deg_graph =
+			        reinterpret_cast<DEG::Depsgraph *>(scene->depsgraph);
+			/* IDs which are not in the graph can only start being used
+			 * through a change of some ID which is.
+			 */
+			if (deg_graph->find_id_node(id) != NULL) {
+				BLI_gset_add(deg_graph->relations_tagged_ids, id);
+			}
+		}
+	}
+}
+
+/* Compare graph after an incremental update against a full rebuild. */
+static bool deg_graph_incremental_validate(DEG::Depsgraph *graph,
+                                           Main *bmain,
+                                           Scene *scene)
+{
+	Depsgraph *full_graph = DEG_graph_new();
+	DEG_graph_build_from_scene(full_graph, bmain, scene);
+	const bool valid = DEG_debug_compare(full_graph,
+	                                     reinterpret_cast< ::Depsgraph * >(graph));
+	DEG_graph_free(full_graph);
+	return valid;
+}
+
 /* Create new graph if didn't exist yet,
  * or update relations if graph was tagged for update.
  */
@@ -281,8 +338,30 @@ void DEG_scene_relations_update(Main *bmain, Scene *scene)
 
 	DEG::Depsgraph *graph = reinterpret_cast<DEG::Depsgraph *>(scene->depsgraph);
 	if (!graph->need_update) {
-		/* Graph is up to date, nothing to do. */
-		return;
+		if (BLI_gset_size(graph->relations_tagged_ids) == 0) {
+			/* Graph is up to date, nothing to do. */
+			return;
+		}
+
+		/* Only rebuild the part of the graph affected by the tagged IDs. */
+		bool updated = DEG::deg_graph_build_incremental(graph, bmain, scene);
+		if (updated) {
+			deg_graph_build_complete(graph);
+		}
+		/* Debug value 801 validates the result against a full rebuild, which
+		 * replaces the graph when they differ.
+		 */
+		if (updated && G.debug_value == 801 &&
+		    !deg_graph_incremental_validate(graph, bmain, scene))
+		{
+			fprintf(stderr, "Incremental depsgraph update differs from full rebuild!\n");
+			graph->num_invalid_incremental_updates++;
+			updated = false;
+		}
+		if (updated) {
+			BLI_gset_clear(graph->relations_tagged_ids, NULL);
+			return;
+		}
 	}
 
 	/* Clear all previous nodes and operations. */
@@ -296,6 +375,7 @@ void DEG_scene_relations_update(Main *bmain, Scene *scene)
 	                           scene);
 
 	graph->need_update = false;
+	BLI_gset_clear(graph->relations_tagged_ids, NULL);
 }
 
 /* Rebuild dependency graph only for a given scene. */
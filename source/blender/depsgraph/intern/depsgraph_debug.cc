@@ -30,7 +30,14 @@
  * Implementation of tools for debugging the depsgraph
  */
 
+#include <algorithm>
+#include <iterator>
+#include <set>
+#include <string>
+#include <vector>
+
 #include "BLI_utildefines.h"
+#include "BLI_flathash.h"
 #include "BLI_ghash.h"
 
 extern "C" {
@@ -65,6 +72,65 @@ DepsgraphStatsID *DEG_stats_id(ID *id)
 	return DEG::DepsgraphDebug::get_id_stats(id, false);
 }
 
+void DEG_debug_trace_begin(const char *filepath)
+{
+	DEG::DepsgraphDebug::trace_begin(filepath);
+}
+
+bool DEG_debug_trace_end(void)
+{
+	return DEG::DepsgraphDebug::trace_end();
+}
+
+static std::string deg_debug_node_identifier(const DEG::DepsNode *node)
+{
+	if (node->type == DEG::DEG_NODE_TYPE_OPERATION) {
+		const DEG::OperationDepsNode *op_node =
+		        static_cast<const DEG::OperationDepsNode *>(node);
+		return op_node->owner->identifier() + "." + op_node->identifier();
+	}
+	return node->identifier();
+}
+
+/* Identifiers of all operations and relations, which don't depend on the
+ * order nodes were built in. Duplicated relations only count once.
+ */
+static void deg_debug_graph_identifiers(const DEG::Depsgraph *graph,
+                                        std::set<std::string> *operations,
+                                        std::set<std::string> *relations)
+{
+	foreach (DEG::OperationDepsNode *node, graph->operations) {
+		const std::string node_id = deg_debug_node_identifier(node);
+		operations->insert(node_id);
+		foreach (DEG::DepsRelation *rel, node->inlinks) {
+			relations->insert(deg_debug_node_identifier(rel->from) + " -> " +
+			                  node_id + " (" + rel->name + ")");
+		}
+	}
+}
+
+static bool deg_debug_identifiers_compare(const std::set<std::string> &identifiers1,
+                                          const std::set<std::string> &identifiers2,
+                                          const char *what)
+{
+	std::vector<std::string> only1, only2;
+	std::set_difference(identifiers1.begin(), identifiers1.end(),
+	                    identifiers2.begin(), identifiers2.end(),
+	                    std::back_inserter(only1));
+	std::set_difference(identifiers2.begin(), identifiers2.end(),
+	                    identifiers1.begin(), identifiers1.end(),
+	                    std::back_inserter(only2));
+	/* Enough to see what went wrong, without flooding the console. */
+	const size_t max_print = 10;
+	for (size_t i = 0; i < only1.size() && i < max_print; i++) {
+		fprintf(stderr, "Depsgraph %s only in first graph: %s\n", what, only1[i].c_str());
+	}
+	for (size_t i = 0; i < only2.size() && i < max_print; i++) {
+		fprintf(stderr, "Depsgraph %s only in second graph: %s\n", what, only2[i].c_str());
+	}
+	return only1.empty() && only2.empty();
+}
+
 bool DEG_debug_compare(const struct Depsgraph *graph1,
                        const struct Depsgraph *graph2)
 {
@@ -73,16 +139,29 @@ bool DEG_debug_compare(const struct Depsgraph *graph1,
 	const DEG::Depsgraph *deg_graph1 = reinterpret_cast<const DEG::Depsgraph *>(graph1);
 	const DEG::Depsgraph *deg_graph2 = reinterpret_cast<const DEG::Depsgraph *>(graph2);
 	if (deg_graph1->operations.size() != deg_graph2->operations.size()) {
-		return false;
+		fprintf(stderr, "Depsgraph operations count differs: %d vs. %d\n",
+		        (int)deg_graph1->operations.size(),
+		        (int)deg_graph2->operations.size());
 	}
-	/* TODO(sergey): Currently we only do real stupid check,
-	 * which is fast but which isn't 100% reliable.
-	 *
-	 * Would be cool to make it more robust, but it's good enough
-	 * for now. Also, proper graph check is actually NP-complex
-	 * problem..
+	/* NOTE: Relations are compared by the identifiers of the nodes they
+	 * connect, which is not 100% reliable for operations with the same name,
+	 * but a proper graph isomorphism check is way too expensive.
 	 */
-	return true;
+	std::set<std::string> operations1, operations2, relations1, relations2;
+	deg_debug_graph_identifiers(deg_graph1, &operations1, &relations1);
+	deg_debug_graph_identifiers(deg_graph2, &operations2, &relations2);
+	const bool operations_match =
+	        deg_debug_identifiers_compare(operations1, operations2, "operation") &&
+	        deg_graph1->operations.size() == deg_graph2->operations.size();
+	const bool relations_match =
+	        deg_debug_identifiers_compare(relations1, relations2, "relation");
+	return operations_match && relations_match;
+}
+
+int DEG_debug_invalid_incremental_updates(const Depsgraph *graph)
+{
+	const DEG::Depsgraph *deg_graph = reinterpret_cast<const DEG::Depsgraph *>(graph);
+	return deg_graph->num_invalid_incremental_updates;
 }
 
 bool DEG_debug_scene_relations_validate(Main *bmain,
@@ -218,7 +297,7 @@ void DEG_stats_simple(const Depsgraph *graph, size_t *r_outer,
 		size_t tot_outer = 0;
 		size_t tot_rels = 0;
 
-		GHASH_FOREACH_BEGIN(DEG::IDDepsNode *, id_node, deg_graph->id_hash)
+		FLATHASH_FOREACH_BEGIN(DEG::IDDepsNode *, id_node, deg_graph->id_hash)
 		{
 			tot_outer++;
 			GHASH_FOREACH_BEGIN(DEG::ComponentDepsNode *, comp_node, id_node->components)
@@ -230,7 +309,7 @@ void DEG_stats_simple(const Depsgraph *graph, size_t *r_outer,
 			}
 			GHASH_FOREACH_END();
 		}
-		GHASH_FOREACH_END();
+		FLATHASH_FOREACH_END();
 
 		DEG::TimeSourceDepsNode *time_source = deg_graph->find_time_source();
 		if (time_source != NULL) {
@@ -241,3 +320,20 @@ void DEG_stats_simple(const Depsgraph *graph, size_t *r_outer,
 		if (r_outer)     *r_outer     = tot_outer;
 	}
 }
+
+/**
+ * Obtain timing statistics of the last evaluation of the depsgraph, in seconds
+ * \param[out] r_wall_time           Time the evaluation took
+ * \param[out] r_critical_path_time  Time of the longest chain of dependent operations,
+ *                                   evaluation can not be faster than this with any number of threads
+ * \param[out] r_operations_time     Sum of the time all operations took
+ */
+void DEG_stats_eval(const Depsgraph *graph, double *r_wall_time,
+                    double *r_critical_path_time, double *r_operations_time)
+{
+	const DEG::Depsgraph *deg_graph = reinterpret_cast<const DEG::Depsgraph *>(graph);
+
+	if (r_wall_time)          *r_wall_time          = deg_graph->eval_wall_time;
+	if (r_critical_path_time) *r_critical_path_time = deg_graph->eval_critical_path_time;
+	if (r_operations_time)    *r_operations_time    = deg_graph->eval_operations_time;
+}
@@ -36,6 +36,7 @@
 
 #include "BLI_utildefines.h"
 #include "BLI_task.h"
+#include "BLI_flathash.h"
 #include "BLI_listbase.h"
 
 extern "C" {
@@ -292,11 +293,11 @@ void DEG_graph_on_visible_update(Main *bmain, Scene *scene)
 {
 	(void) bmain;
 	DEG::Depsgraph *graph = reinterpret_cast<DEG::Depsgraph *>(scene->depsgraph);
-	GHASH_FOREACH_BEGIN(DEG::IDDepsNode *, id_node, graph->id_hash)
+	FLATHASH_FOREACH_BEGIN(DEG::IDDepsNode *, id_node, graph->id_hash)
 	{
 		id_node->tag_update(graph);
 	}
-	GHASH_FOREACH_END();
+	FLATHASH_FOREACH_END();
 }
 
 void DEG_on_visible_update(Main *bmain, const bool UNUSED(do_time))
@@ -34,7 +34,10 @@
 
 #include "PIL_time.h"
 
+#include <algorithm>
+
 #include "BLI_utildefines.h"
+#include "BLI_math_base.h"
 #include "BLI_task.h"
 #include "BLI_ghash.h"
 
@@ -51,38 +54,57 @@
 #include "intern/depsgraph_intern.h"
 #include "util/deg_util_foreach.h"
 
-/* Unfinished and unused, and takes quite some pre-processing time. */
-#undef USE_EVAL_PRIORITY
-
 /* Use integrated debugger to keep track how much each of the nodes was
  * evaluating.
  */
 #undef USE_DEBUGGER
 
+/* Weight of the last measured time in the running average of the cost. */
+#define DEG_EVAL_COST_WEIGHT 0.25f
+
 namespace DEG {
 
 /* ********************** */
 /* Evaluation Entrypoints */
 
+typedef vector<OperationDepsNode *> ReadyOperations;
+
 /* Forward declarations. */
-static void schedule_children(TaskPool *pool,
-                              Depsgraph *graph,
+static void schedule_children(Depsgraph *graph,
                               OperationDepsNode *node,
-                              const int thread_id);
+                              ReadyOperations *r_ready);
+static void push_ready_operations(TaskPool *pool,
+                                  const ReadyOperations& ready,
+                                  const int thread_id);
 
 struct DepsgraphEvalState {
 	EvaluationContext *eval_ctx;
 	Depsgraph *graph;
 };
 
-static void deg_task_run_func(TaskPool *pool,
-                              void *taskdata,
-                              int thread_id)
+/* Longest chain of operations which ended in one of the parents of the node,
+ * parents are all evaluated by the time the node gets scheduled.
+ */
+static double parents_path_time(const OperationDepsNode *node)
 {
-	DepsgraphEvalState *state =
-	        reinterpret_cast<DepsgraphEvalState *>(BLI_task_pool_userdata(pool));
-	OperationDepsNode *node = reinterpret_cast<OperationDepsNode *>(taskdata);
+	double path_time = 0.0;
+	foreach (DepsRelation *rel, node->inlinks) {
+		if (rel->from->type == DEG_NODE_TYPE_OPERATION &&
+		    (rel->flag & DEPSREL_FLAG_CYCLIC) == 0)
+		{
+			const OperationDepsNode *from = (const OperationDepsNode *)rel->from;
+			if ((from->flag & DEPSOP_FLAG_NEEDS_UPDATE) != 0) {
+				path_time = std::max(path_time, from->eval_path_time);
+			}
+		}
+	}
+	return path_time;
+}
 
+static void evaluate_operation(DepsgraphEvalState *state,
+                               OperationDepsNode *node,
+                               const int thread_id)
+{
 	BLI_assert(!node->is_noop() && "NOOP nodes should not actually be scheduled");
 
 	/* Should only be the case for NOOPs, which never get to this point. */
@@ -96,32 +118,59 @@ static void deg_task_run_func(TaskPool *pool,
 	/* ComponentDepsNode *comp = node->owner; */
 	BLI_assert(node->owner != NULL);
 
-	/* Since we're not leaving the thread for until the graph branches it is
-	 * possible to have NO-OP on the way. for which evaluate() will be NULL.
-	 * but that's all fine, we'll just scheduler it's children.
-	 */
-	if (node->evaluate) {
-			/* Take note of current time. */
+	/* Take note of current time. */
+	const double start_time = PIL_check_seconds_timer();
 #ifdef USE_DEBUGGER
-		double start_time = PIL_check_seconds_timer();
-		DepsgraphDebug::task_started(state->graph, node);
+	DepsgraphDebug::task_started(state->graph, node);
 #endif
 
-		/* Perform operation. */
-		node->evaluate(state->eval_ctx);
+	/* Perform operation. */
+	node->evaluate(state->eval_ctx);
 
-			/* Note how long this took. */
+	/* Note how long this took, and update the cost model. Only this thread
+	 * writes to the node while it is being evaluated.
+	 */
+	const double time = PIL_check_seconds_timer() - start_time;
+	node->eval_time = (float)time;
+	node->eval_cost = (node->eval_cost == 0.0f)
+	                          ? node->eval_time
+	                          : interpf(node->eval_time, node->eval_cost, DEG_EVAL_COST_WEIGHT);
+	node->eval_path_time = parents_path_time(node) + time;
+	DepsgraphDebug::trace_operation(state->graph, node, thread_id,
+	                                start_time, start_time + time);
 #ifdef USE_DEBUGGER
-		double end_time = PIL_check_seconds_timer();
-		DepsgraphDebug::task_completed(state->graph,
-		                               node,
-		                               end_time - start_time);
+	DepsgraphDebug::task_completed(state->graph, node, time);
 #endif
-	}
+}
+
+static void deg_task_run_func(TaskPool *pool,
+                              void *taskdata,
+                              int thread_id)
+{
+	DepsgraphEvalState *state =
+	        reinterpret_cast<DepsgraphEvalState *>(BLI_task_pool_userdata(pool));
+	OperationDepsNode *node = reinterpret_cast<OperationDepsNode *>(taskdata);
+	ReadyOperations ready;
+
+	/* Keep following the child with the longest remaining path on this
+	 * thread, other ready children are pushed for other threads to steal.
+	 */
+	while (node != NULL) {
+		evaluate_operation(state, node, thread_id);
+
+		ready.clear();
+		schedule_children(state->graph, node, &ready);
+		if (ready.empty()) {
+			break;
+		}
 
-	BLI_task_pool_delayed_push_begin(pool, thread_id);
-	schedule_children(pool, state->graph, node, thread_id);
-	BLI_task_pool_delayed_push_end(pool, thread_id);
+		node = ready[0];
+		ready.erase(ready.begin());
+
+		BLI_task_pool_delayed_push_begin(pool, thread_id);
+		push_ready_operations(pool, ready, thread_id);
+		BLI_task_pool_delayed_push_end(pool, thread_id);
+	}
 }
 
 typedef struct CalculatePengindData {
@@ -165,40 +214,55 @@ static void calculate_pending_parents(Depsgraph *graph)
 	                        do_threads);
 }
 
-#ifdef USE_EVAL_PRIORITY
-static void calculate_eval_priority(OperationDepsNode *node)
+static bool operation_priority_greater(const OperationDepsNode *a,
+                                       const OperationDepsNode *b)
 {
-	if (node->done) {
-		return;
+	return a->eval_priority > b->eval_priority;
+}
+
+/* Push operations in order of priority. Threads pop the most recently pushed
+ * task from their own queue but steal the oldest one, so the operation with
+ * the longest remaining path is pushed first, to be stolen first.
+ */
+static void push_ready_operations(TaskPool *pool,
+                                  const ReadyOperations& ready,
+                                  const int thread_id)
+{
+	foreach (OperationDepsNode *node, ready) {
+		BLI_task_pool_push_from_thread(pool,
+		                               deg_task_run_func,
+		                               node,
+		                               false,
+		                               TASK_PRIORITY_HIGH,
+		                               thread_id);
 	}
-	node->done = 1;
-
-	if (node->flag & DEPSOP_FLAG_NEEDS_UPDATE) {
-		/* XXX standard cost of a node, could be estimated somewhat later on */
-		const float cost = 1.0f;
-		/* NOOP nodes have no cost */
-		node->eval_priority = node->is_noop() ? cost : 0.0f;
-
-		foreach (DepsRelation *rel, node->outlinks) {
-			OperationDepsNode *to = (OperationDepsNode *)rel->to;
-			BLI_assert(to->type == DEG_NODE_TYPE_OPERATION);
-			calculate_eval_priority(to);
-			node->eval_priority += to->eval_priority;
-		}
+}
+
+/* Node has no pending parents left and was claimed for scheduling. */
+static void schedule_ready_node(Depsgraph *graph,
+                                OperationDepsNode *node,
+                                ReadyOperations *r_ready)
+{
+	if (node->is_noop()) {
+		/* skip NOOP node, schedule children right away */
+		node->eval_time = 0.0f;
+		node->eval_path_time = parents_path_time(node);
+		schedule_children(graph, node, r_ready);
 	}
 	else {
-		node->eval_priority = 0.0f;
+		/* children are scheduled once this task is completed */
+		r_ready->push_back(node);
 	}
 }
-#endif
 
 /* Schedule a node if it needs evaluation.
  *   dec_parents: Decrement pending parents count, true when child nodes are
  *                scheduled after a task has been completed.
+ * Operations which are ready to be evaluated are added to r_ready.
  */
-static void schedule_node(TaskPool *pool, Depsgraph *graph,
+static void schedule_node(Depsgraph *graph,
                           OperationDepsNode *node, bool dec_parents,
-                          const int thread_id)
+                          ReadyOperations *r_ready)
 {
 	if ((node->flag & DEPSOP_FLAG_NEEDS_UPDATE) != 0) {
 		if (dec_parents) {
@@ -210,19 +274,7 @@ static void schedule_node(TaskPool *pool, Depsgraph *graph,
 			bool is_scheduled = atomic_fetch_and_or_uint8(
 			        (uint8_t *)&node->scheduled, (uint8_t)true);
 			if (!is_scheduled) {
-				if (node->is_noop()) {
-					/* skip NOOP node, schedule children right away */
-					schedule_children(pool, graph, node, thread_id);
-				}
-				else {
-					/* children are scheduled once this task is completed */
-					BLI_task_pool_push_from_thread(pool,
-					                               deg_task_run_func,
-					                               node,
-					                               false,
-					                               TASK_PRIORITY_HIGH,
-					                               thread_id);
-				}
+				schedule_ready_node(graph, node, r_ready);
 			}
 		}
 	}
@@ -230,16 +282,38 @@ static void schedule_node(TaskPool *pool, Depsgraph *graph,
 
 static void schedule_graph(TaskPool *pool, Depsgraph *graph)
 {
+	ReadyOperations ready;
 	foreach (OperationDepsNode *node, graph->operations) {
-		schedule_node(pool, graph, node, false, 0);
+		schedule_node(graph, node, false, &ready);
 	}
+	std::sort(ready.begin(), ready.end(), operation_priority_greater);
+
+	/* The pool is suspended, its tasks are added to the head of a queue which
+	 * is executed from the head, so push the longest paths last.
+	 */
+	std::reverse(ready.begin(), ready.end());
+	push_ready_operations(pool, ready, 0);
 }
 
-static void schedule_children(TaskPool *pool,
-                              Depsgraph *graph,
+static void schedule_children(Depsgraph *graph,
                               OperationDepsNode *node,
-                              const int thread_id)
+                              ReadyOperations *r_ready)
 {
+	/* Next operation of a fused chain depends on this one only, so it is
+	 * ready now and nothing else can schedule it, no atomics needed.
+	 */
+	OperationDepsNode *chain_next = node->chain_next;
+	if (chain_next != NULL) {
+		if ((chain_next->flag & DEPSOP_FLAG_NEEDS_UPDATE) != 0) {
+			BLI_assert(chain_next->num_links_pending == 1);
+			BLI_assert(!chain_next->scheduled);
+			chain_next->scheduled = true;
+			schedule_ready_node(graph, chain_next, r_ready);
+		}
+		return;
+	}
+
+	const size_t num_ready = r_ready->size();
 	foreach (DepsRelation *rel, node->outlinks) {
 		OperationDepsNode *child = (OperationDepsNode *)rel->to;
 		BLI_assert(child->type == DEG_NODE_TYPE_OPERATION);
@@ -247,12 +321,37 @@ static void schedule_children(TaskPool *pool,
 			/* Happens when having cyclic dependencies. */
 			continue;
 		}
-		schedule_node(pool,
-		              graph,
+		schedule_node(graph,
 		              child,
 		              (rel->flag & DEPSREL_FLAG_CYCLIC) == 0,
-		              thread_id);
+		              r_ready);
 	}
+	std::sort(r_ready->begin() + num_ready, r_ready->end(), operation_priority_greater);
+}
+
+/* Gather statistics of the finished evaluation, before the tags are cleared. */
+static void calculate_eval_stats(Depsgraph *graph, double wall_time)
+{
+	double critical_path_time = 0.0;
+	double operations_time = 0.0;
+	foreach (OperationDepsNode *node, graph->operations) {
+		if ((node->flag & DEPSOP_FLAG_NEEDS_UPDATE) != 0 && node->scheduled) {
+			critical_path_time = std::max(critical_path_time, node->eval_path_time);
+			if (!node->is_noop()) {
+				operations_time += node->eval_time;
+			}
+		}
+	}
+
+	graph->eval_wall_time = wall_time;
+	graph->eval_critical_path_time = critical_path_time;
+	graph->eval_operations_time = operations_time;
+
+	DEG_DEBUG_PRINTF("Depsgraph evaluated in %.3f ms, critical path %.3f ms, "
+	                 "operations %.3f ms\n",
+	                 wall_time * 1000.0,
+	                 critical_path_time * 1000.0,
+	                 operations_time * 1000.0);
 }
 
 /**
@@ -298,25 +397,21 @@ void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
 
 	calculate_pending_parents(graph);
 
-	/* Clear tags. */
-	foreach (OperationDepsNode *node, graph->operations) {
-		node->done = 0;
-	}
+	DepsgraphDebug::eval_begin(eval_ctx);
 
-	/* Calculate priority for operation nodes. */
-#ifdef USE_EVAL_PRIORITY
-	foreach (OperationDepsNode *node, graph->operations) {
-		calculate_eval_priority(node);
-	}
-#endif
+	DepsgraphDebug::trace_eval_begin(graph, BLI_task_scheduler_num_threads(task_scheduler));
 
-	DepsgraphDebug::eval_begin(eval_ctx);
+	const double start_time = PIL_check_seconds_timer();
 
 	schedule_graph(task_pool, graph);
 
 	BLI_task_pool_work_and_wait(task_pool);
 	BLI_task_pool_free(task_pool);
 
+	DepsgraphDebug::trace_eval_end(graph);
+
+	calculate_eval_stats(graph, PIL_check_seconds_timer() - start_time);
+
 	DepsgraphDebug::eval_end(eval_ctx);
 
 	/* Clear any uncleared tags - just in case. */
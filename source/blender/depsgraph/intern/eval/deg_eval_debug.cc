@@ -32,10 +32,17 @@
 
 #include "intern/eval/deg_eval_debug.h"
 
+#include <algorithm>
+#include <cstdio>
 #include <cstring>  /* required for STREQ later on. */
+#include <map>
 
+#include "BLI_fileops.h"
 #include "BLI_listbase.h"
 #include "BLI_ghash.h"
+#include "BLI_threads.h"
+
+#include "PIL_time.h"
 
 extern "C" {
 #include "WM_api.h"
@@ -48,10 +55,12 @@ extern "C" {
 #include "intern/nodes/deg_node_component.h"
 #include "intern/nodes/deg_node_operation.h"
 #include "intern/depsgraph_intern.h"
+#include "util/deg_util_foreach.h"
 
 namespace DEG {
 
 DepsgraphStats *DepsgraphDebug::stats = NULL;
+DepsgraphTrace *DepsgraphDebug::trace = NULL;
 
 static string get_component_name(eDepsNode_Type type, const char *name = "")
 {
@@ -155,6 +164,254 @@ void DepsgraphDebug::task_completed(Depsgraph *graph,
 	}
 }
 
+/* ***** */
+/* Trace */
+
+struct DepsgraphTraceEval {
+	int graph_index;
+	int num_threads;
+	double start_time;
+	double end_time;
+};
+
+struct DepsgraphTraceOperation {
+	int eval_index;
+	int thread_id;
+	double start_time;
+	double end_time;
+	string id_name;
+	string component_name;
+	string name;
+};
+
+struct DepsgraphTrace {
+	string filepath;
+	double start_time;
+
+	/* Operations are recorded from all threads of all evaluating graphs. */
+	SpinLock lock;
+	std::map<const Depsgraph *, int> graph_indices;
+	std::map<const Depsgraph *, int> active_evals;
+	vector<DepsgraphTraceEval> evals;
+	vector<DepsgraphTraceOperation> operations;
+};
+
+/* Gaps shorter than this, in seconds, are not written as idle spans. */
+#define DEG_TRACE_IDLE_MIN_TIME 1e-6
+
+static bool trace_operation_earlier(const DepsgraphTraceOperation *a,
+                                    const DepsgraphTraceOperation *b)
+{
+	return a->start_time < b->start_time;
+}
+
+static void trace_write_string(FILE *f, const string &str)
+{
+	fputc('"', f);
+	for (size_t i = 0; i < str.size(); i++) {
+		const unsigned char c = str[i];
+		if (c == '"' || c == '\\') {
+			fprintf(f, "\\%c", c);
+		}
+		else if (c < 0x20) {
+			fprintf(f, "\\u%04x", c);
+		}
+		else {
+			fputc(c, f);
+		}
+	}
+	fputc('"', f);
+}
+
+static void trace_write_span(FILE *f, const char *name, const char *category,
+                             int pid, int tid, double start_time, double end_time,
+                             bool *first)
+{
+	fprintf(f, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+	        "\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d}",
+	        *first ? "" : ",", name, category,
+	        start_time * 1e6, (end_time - start_time) * 1e6, pid, tid);
+	*first = false;
+}
+
+static void trace_write_idle(FILE *f, int pid, int tid, double start_time, double end_time,
+                             bool *first)
+{
+	if (end_time - start_time >= DEG_TRACE_IDLE_MIN_TIME) {
+		trace_write_span(f, "Idle", "scheduler", pid, tid, start_time, end_time, first);
+	}
+}
+
+static void trace_write(DepsgraphTrace *trace, FILE *f)
+{
+	vector<vector<const DepsgraphTraceOperation *> > eval_operations(trace->evals.size());
+	bool first = true;
+
+	foreach (const DepsgraphTraceOperation &op, trace->operations) {
+		eval_operations[op.eval_index].push_back(&op);
+	}
+
+	fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+	/* Name processes after graphs and threads after scheduler threads. */
+	int max_threads = 0;
+	foreach (const DepsgraphTraceEval &eval, trace->evals) {
+		max_threads = std::max(max_threads, eval.num_threads);
+	}
+	for (int pid = 0; pid < (int)trace->graph_indices.size(); pid++) {
+		fprintf(f, "%s\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+		        "\"args\":{\"name\":\"Depsgraph %d\"}}",
+		        first ? "" : ",", pid, pid);
+		first = false;
+		for (int tid = 0; tid < max_threads; tid++) {
+			fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+			        "\"args\":{\"name\":\"Thread %d\"}}",
+			        pid, tid, tid);
+		}
+	}
+
+	for (int i = 0; i < (int)trace->evals.size(); i++) {
+		const DepsgraphTraceEval &eval = trace->evals[i];
+		vector<const DepsgraphTraceOperation *> &ops = eval_operations[i];
+		const int pid = eval.graph_index;
+
+		trace_write_span(f, "Evaluation", "evaluation", pid, 0,
+		                 eval.start_time, eval.end_time, &first);
+
+		foreach (const DepsgraphTraceOperation *op, ops) {
+			fprintf(f, ",\n{\"name\":");
+			trace_write_string(f, op->name);
+			fprintf(f, ",\"cat\":\"operation\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+			        "\"pid\":%d,\"tid\":%d,\"args\":{\"id\":",
+			        op->start_time * 1e6, (op->end_time - op->start_time) * 1e6,
+			        pid, op->thread_id);
+			trace_write_string(f, op->id_name);
+			fprintf(f, ",\"component\":");
+			trace_write_string(f, op->component_name);
+			fprintf(f, "}}");
+		}
+
+		/* Time each scheduler thread spent without an operation to evaluate. */
+		std::sort(ops.begin(), ops.end(), trace_operation_earlier);
+		for (int tid = 0; tid < eval.num_threads; tid++) {
+			double idle_start = eval.start_time;
+			foreach (const DepsgraphTraceOperation *op, ops) {
+				if (op->thread_id == tid) {
+					trace_write_idle(f, pid, tid, idle_start, op->start_time, &first);
+					idle_start = op->end_time;
+				}
+			}
+			trace_write_idle(f, pid, tid, idle_start, eval.end_time, &first);
+		}
+	}
+
+	fprintf(f, "\n]}\n");
+}
+
+void DepsgraphDebug::trace_begin(const char *filepath)
+{
+	if (trace) {
+		return;
+	}
+	trace = new DepsgraphTrace();
+	trace->filepath = filepath;
+	trace->start_time = PIL_check_seconds_timer();
+	BLI_spin_init(&trace->lock);
+}
+
+/* Write recorded events to the trace file and stop recording. */
+bool DepsgraphDebug::trace_end()
+{
+	if (!trace) {
+		return false;
+	}
+
+	FILE *f = BLI_fopen(trace->filepath.c_str(), "w");
+	if (f != NULL) {
+		trace_write(trace, f);
+		fclose(f);
+		printf("Depsgraph trace written to '%s'\n", trace->filepath.c_str());
+	}
+	else {
+		printf("Error: unable to write depsgraph trace to '%s'\n", trace->filepath.c_str());
+	}
+
+	BLI_spin_end(&trace->lock);
+	delete trace;
+	trace = NULL;
+
+	return f != NULL;
+}
+
+void DepsgraphDebug::trace_eval_begin(const Depsgraph *graph, int num_threads)
+{
+	if (!trace) {
+		return;
+	}
+
+	DepsgraphTraceEval eval;
+	eval.num_threads = num_threads;
+	eval.start_time = PIL_check_seconds_timer() - trace->start_time;
+	eval.end_time = eval.start_time;
+
+	BLI_spin_lock(&trace->lock);
+	std::map<const Depsgraph *, int>::iterator it = trace->graph_indices.find(graph);
+	if (it == trace->graph_indices.end()) {
+		it = trace->graph_indices.insert(std::make_pair(graph, (int)trace->graph_indices.size())).first;
+	}
+	eval.graph_index = it->second;
+	trace->active_evals[graph] = (int)trace->evals.size();
+	trace->evals.push_back(eval);
+	BLI_spin_unlock(&trace->lock);
+}
+
+void DepsgraphDebug::trace_eval_end(const Depsgraph *graph)
+{
+	if (!trace) {
+		return;
+	}
+
+	const double end_time = PIL_check_seconds_timer() - trace->start_time;
+
+	BLI_spin_lock(&trace->lock);
+	std::map<const Depsgraph *, int>::iterator it = trace->active_evals.find(graph);
+	if (it != trace->active_evals.end()) {
+		trace->evals[it->second].end_time = end_time;
+		trace->active_evals.erase(it);
+	}
+	BLI_spin_unlock(&trace->lock);
+}
+
+void DepsgraphDebug::trace_operation(const Depsgraph *graph,
+                                     const OperationDepsNode *node,
+                                     int thread_id,
+                                     double start_time,
+                                     double end_time)
+{
+	if (!trace) {
+		return;
+	}
+
+	const ComponentDepsNode *comp = node->owner;
+
+	/* Copy names, the graph may be gone by the time the trace is written. */
+	DepsgraphTraceOperation op;
+	op.thread_id = thread_id;
+	op.start_time = start_time - trace->start_time;
+	op.end_time = end_time - trace->start_time;
+	op.id_name = comp->owner->name;
+	op.component_name = comp->name;
+	op.name = node->full_identifier();
+
+	BLI_spin_lock(&trace->lock);
+	std::map<const Depsgraph *, int>::iterator it = trace->active_evals.find(graph);
+	if (it != trace->active_evals.end()) {
+		op.eval_index = it->second;
+		trace->operations.push_back(op);
+	}
+	BLI_spin_unlock(&trace->lock);
+}
+
 /* ********** */
 /* Statistics */
 
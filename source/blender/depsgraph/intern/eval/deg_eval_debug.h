@@ -43,10 +43,12 @@ namespace DEG {
 
 struct Depsgraph;
 struct DepsgraphSettings;
+struct DepsgraphTrace;
 struct OperationDepsNode;
 
 struct DepsgraphDebug {
 	static DepsgraphStats *stats;
+	static DepsgraphTrace *trace;
 
 	static void stats_init();
 	static void stats_free();
@@ -64,6 +66,18 @@ struct DepsgraphDebug {
 	                           const OperationDepsNode *node,
 	                           double time);
 
+	/* Timeline of evaluated operations, written as Chrome trace events. */
+	static void trace_begin(const char *filepath);
+	static bool trace_end();
+
+	static void trace_eval_begin(const Depsgraph *graph, int num_threads);
+	static void trace_eval_end(const Depsgraph *graph);
+	static void trace_operation(const Depsgraph *graph,
+	                            const OperationDepsNode *node,
+	                            int thread_id,
+	                            double start_time,
+	                            double end_time);
+
 	static DepsgraphStatsID *get_id_stats(ID *id, bool create);
 	static DepsgraphStatsComponent *get_component_stats(DepsgraphStatsID *id_stats,
 	                                                    const char *name,
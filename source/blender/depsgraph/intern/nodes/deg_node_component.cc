@@ -239,14 +239,12 @@ void ComponentDepsNode::set_exit_operation(OperationDepsNode *op_node)
 
 void ComponentDepsNode::clear_operations()
 {
+	/* Vector only references operations owned by the hash map. */
 	if (operations_map != NULL) {
 		BLI_ghash_clear(operations_map,
 		                comp_node_hash_key_free,
 		                comp_node_hash_value_free);
 	}
-	foreach (OperationDepsNode *op_node, operations) {
-		OBJECT_GUARDED_DELETE(op_node, OperationDepsNode);
-	}
 	operations.clear();
 }
 
@@ -260,7 +258,7 @@ void ComponentDepsNode::tag_update(Depsgraph *graph)
 		op_node->tag_update(graph);
 	}
 	// It is possible that tag happens before finalization.
-	if (operations_map != NULL) {
+	if (operations.empty() && operations_map != NULL) {
 		GHASH_FOREACH_BEGIN(OperationDepsNode *, op_node, operations_map)
 		{
 			op_node->tag_update(graph);
@@ -317,16 +315,14 @@ OperationDepsNode *ComponentDepsNode::get_exit_operation()
 
 void ComponentDepsNode::finalize_build()
 {
+	/* Might be finalized again after an incremental relations update. */
+	operations.clear();
 	operations.reserve(BLI_ghash_size(operations_map));
 	GHASH_FOREACH_BEGIN(OperationDepsNode *, op_node, operations_map)
 	{
 		operations.push_back(op_node);
 	}
 	GHASH_FOREACH_END();
-	BLI_ghash_free(operations_map,
-	               comp_node_hash_key_free,
-	               NULL);
-	operations_map = NULL;
 }
 
 /* Parameter Component Defines ============================ */
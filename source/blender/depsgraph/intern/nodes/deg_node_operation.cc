@@ -45,6 +45,10 @@ namespace DEG {
 
 OperationDepsNode::OperationDepsNode() :
     eval_priority(0.0f),
+    eval_cost(0.0f),
+    eval_time(0.0f),
+    eval_path_time(0.0),
+    chain_next(NULL),
     flag(0),
     customdata_mask(0)
 {
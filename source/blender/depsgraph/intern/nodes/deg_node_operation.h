@@ -79,9 +79,26 @@ struct OperationDepsNode : public DepsNode {
 
 	/* How many inlinks are we still waiting on before we can be evaluated. */
 	uint32_t num_links_pending;
+	/* Estimated time until all operations depending on this one are done,
+	 * operations with the longest remaining path are scheduled first.
+	 * Calculated when relations are built or updated. */
 	float eval_priority;
 	bool scheduled;
 
+	/* Cost model, running average of the measured evaluation time in seconds,
+	 * kept across evaluations. Zero when the operation was never evaluated. */
+	float eval_cost;
+	/* Time the last evaluation took, in seconds. */
+	float eval_time;
+	/* Length of the longest chain of operations which ended with this one
+	 * in the last evaluation, in seconds. */
+	double eval_path_time;
+
+	/* Next operation of a fused chain, the only operation depending on this
+	 * one, which depends on nothing else. It's evaluated by the same task
+	 * right after this one. See deg_builder_fusion.cc. */
+	OperationDepsNode *chain_next;
+
 	/* Identifier for the operation being performed. */
 	eDepsOperation_Code opcode;
 
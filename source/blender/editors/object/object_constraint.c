@@ -1223,7 +1223,7 @@ void ED_object_constraint_dependency_update(Main *bmain, Object *ob)
 	if (ob->pose) {
 		object_pose_tag_update(bmain, ob);
 	}
-	DEG_relations_tag_update(bmain);
+	DEG_relations_tag_update_id(bmain, &ob->id);
 }
 
 void ED_object_constraint_tag_update(Object *ob, bConstraint *con)
@@ -1247,7 +1247,7 @@ void ED_object_constraint_dependency_tag_update(Main *bmain, Object *ob, bConstr
 	if (ob->pose) {
 		object_pose_tag_update(bmain, ob);
 	}
-	DEG_relations_tag_update(bmain);
+	DEG_relations_tag_update_id(bmain, &ob->id);
 }
 
 static int constraint_poll(bContext *C)
@@ -48,7 +48,15 @@ typedef void  *(*MovieCacheGetPriorityDataFP) (void *userkey);
 typedef int    (*MovieCacheGetItemPriorityFP) (void *last_userkey, void *priority_data);
 typedef void   (*MovieCachePriorityDeleterFP) (void *priority_data);
 
-void IMB_moviecache_init(void);
+typedef struct MovieCacheStats {
+	/* lookups which found a buffer and which didn't */
+	size_t hits, misses;
+	/* buffers freed to stay within the memory limits */
+	size_t evictions, evicted_bytes;
+	/* buffers currently in the cache */
+	size_t items, bytes_in_use;
+} MovieCacheStats;
+
 void IMB_moviecache_destruct(void);
 
 struct MovieCache *IMB_moviecache_create(const char *name, int keysize, GHashHashFP hashfp, GHashCmpFP cmpfp);
@@ -57,7 +65,11 @@ void IMB_moviecache_set_priority_callback(struct MovieCache *cache, MovieCacheGe
                                           MovieCacheGetItemPriorityFP getitempriorityfp,
                                           MovieCachePriorityDeleterFP prioritydeleterfp);
 
+/* Caches with the same name share memory budget and statistics (e.g. all image caches). */
+void IMB_moviecache_set_budget(const char *name, size_t budget);
+
 void IMB_moviecache_put(struct MovieCache *cache, void *userkey, struct ImBuf *ibuf);
+void IMB_moviecache_put_ex(struct MovieCache *cache, void *userkey, struct ImBuf *ibuf, float cost);
 bool IMB_moviecache_put_if_possible(struct MovieCache *cache, void *userkey, struct ImBuf *ibuf);
 struct ImBuf *IMB_moviecache_get(struct MovieCache *cache, void *userkey);
 bool IMB_moviecache_has_frame(struct MovieCache *cache, void *userkey);
@@ -67,6 +79,10 @@ void IMB_moviecache_cleanup(struct MovieCache *cache,
                             bool (cleanup_check_cb) (struct ImBuf *ibuf, void *userkey, void *userdata),
                             void *userdata);
 
+void IMB_moviecache_get_stats(struct MovieCache *cache, MovieCacheStats *r_stats);
+bool IMB_moviecache_get_stats_by_name(const char *name, MovieCacheStats *r_stats);
+void IMB_moviecache_print_stats(void);
+
 void IMB_moviecache_get_cache_segments(struct MovieCache *cache, int proxy, int render_flags, int *totseg_r, int **points_r);
 
 struct MovieCacheIter;
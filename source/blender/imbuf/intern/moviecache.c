@@ -32,17 +32,23 @@
 #undef DEBUG_MESSAGES
 
 #include <stdlib.h> /* for qsort */
+#include <stdio.h>
 #include <memory.h>
 
 #include "MEM_guardedalloc.h"
 #include "MEM_CacheLimiterC-Api.h"
 
+#include "DNA_listBase.h"
+
+#include "BLI_listbase.h"
 #include "BLI_string.h"
 #include "BLI_utildefines.h"
 #include "BLI_ghash.h"
 #include "BLI_mempool.h"
 #include "BLI_threads.h"
 
+#include "atomic_ops.h"
+
 #include "IMB_moviecache.h"
 
 #include "IMB_imbuf_types.h"
@@ -58,12 +64,30 @@
 #  define PRINT(format, ...)
 #endif
 
-static MEM_CacheLimiterC *limitor = NULL;
-static pthread_mutex_t limitor_lock = BLI_MUTEX_INITIALIZER;
+/* All caches with the same name (e.g. the caches of all images) share a limiter,
+ * which has its own budget and lock. The global maximum of the cache limiter is
+ * still shared by all of them. */
+typedef struct MovieCacheShard {
+	struct MovieCacheShard *next, *prev;
+	char name[64];
+
+	MEM_CacheLimiterC *limitor;
+	ThreadMutex lock;
+
+	/* accumulated over all caches, including freed ones, items and bytes
+	 * in use are counted under the lock */
+	MovieCacheStats stats;
+} MovieCacheShard;
+
+static ListBase shards = {NULL, NULL};
+static ThreadMutex shards_lock = BLI_MUTEX_INITIALIZER;
 
 typedef struct MovieCache {
 	char name[64];
 
+	MovieCacheShard *shard;
+	MovieCacheStats stats;
+
 	GHash *hash;
 	GHashHashFP hashfp;
 	GHashCmpFP cmpfp;
@@ -95,6 +119,8 @@ typedef struct MovieCacheItem {
 	ImBuf *ibuf;
 	MEM_CacheLimiterHandleC *c_handle;
 	void *priority_data;
+	/* size counted in the statistics, the buffer may grow while cached */
+	size_t size;
 } MovieCacheItem;
 
 static unsigned int moviecache_hashhash(const void *keyv)
@@ -121,6 +147,30 @@ static void moviecache_keyfree(void *val)
 	BLI_mempool_free(key->cache_owner->keys_pool, key);
 }
 
+/* count buffers in the cache, shard has to be locked */
+static void moviecache_stats_item_add(MovieCacheItem *item)
+{
+	MovieCache *cache = item->cache_owner;
+
+	item->size = MEM_CacheLimiter_get_size(item->c_handle);
+
+	cache->stats.items++;
+	cache->stats.bytes_in_use += item->size;
+	cache->shard->stats.items++;
+	cache->shard->stats.bytes_in_use += item->size;
+}
+
+static void moviecache_stats_item_remove(MovieCacheItem *item)
+{
+	MovieCache *cache = item->cache_owner;
+
+	cache->stats.items--;
+	cache->stats.bytes_in_use -= item->size;
+	cache->shard->stats.items--;
+	cache->shard->stats.bytes_in_use -= item->size;
+}
+
+/* shard has to be locked, unless the item lost its buffer already */
 static void moviecache_valfree(void *val)
 {
 	MovieCacheItem *item = (MovieCacheItem *)val;
@@ -129,6 +179,7 @@ static void moviecache_valfree(void *val)
 	PRINT("%s: cache '%s' free item %p buffer %p\n", __func__, cache->name, item, item->ibuf);
 
 	if (item->ibuf) {
+		moviecache_stats_item_remove(item);
 		MEM_CacheLimiter_unmanage(item->c_handle);
 		IMB_freeImBuf(item->ibuf);
 	}
@@ -177,9 +228,16 @@ static void IMB_moviecache_destructor(void *p)
 
 	if (item && item->ibuf) {
 		MovieCache *cache = item->cache_owner;
+		const size_t size = MEM_CacheLimiter_get_size(item->c_handle);
 
 		PRINT("%s: cache '%s' destroy item %p buffer %p\n", __func__, cache->name, item, item->ibuf);
 
+		atomic_add_and_fetch_z(&cache->stats.evictions, 1);
+		atomic_add_and_fetch_z(&cache->stats.evicted_bytes, size);
+		atomic_add_and_fetch_z(&cache->shard->stats.evictions, 1);
+		atomic_add_and_fetch_z(&cache->shard->stats.evicted_bytes, size);
+		moviecache_stats_item_remove(item);
+
 		IMB_freeImBuf(item->ibuf);
 
 		item->ibuf = NULL;
@@ -281,18 +339,73 @@ static bool get_item_destroyable(void *item_v)
 	return true;
 }
 
-void IMB_moviecache_init(void)
+static MovieCacheShard *moviecache_shard_ensure(const char *name)
+{
+	MovieCacheShard *shard;
+
+	BLI_mutex_lock(&shards_lock);
+
+	shard = BLI_findstring(&shards, name, offsetof(MovieCacheShard, name));
+
+	if (shard == NULL) {
+		shard = MEM_callocN(sizeof(MovieCacheShard), "MovieCacheShard");
+		BLI_strncpy(shard->name, name, sizeof(shard->name));
+
+		shard->limitor = new_MEM_CacheLimiter(IMB_moviecache_destructor, get_item_size);
+		MEM_CacheLimiter_ItemDestroyable_Func_set(shard->limitor, get_item_destroyable);
+		BLI_mutex_init(&shard->lock);
+
+		BLI_addtail(&shards, shard);
+	}
+
+	BLI_mutex_unlock(&shards_lock);
+
+	return shard;
+}
+
+/* The cache putting an item frees its own items first to stay below the global
+ * maximum, if that's not enough items of other caches are freed too. */
+static void moviecache_enforce_global_limit(MovieCacheShard *shard_put)
 {
-	limitor = new_MEM_CacheLimiter(IMB_moviecache_destructor, get_item_size);
+	const size_t mem_limit = MEM_CacheLimiter_get_maximum();
+	MovieCacheShard *shard;
+
+	if (mem_limit == 0 || MEM_CacheLimiter_get_total_memory_in_use() <= mem_limit) {
+		return;
+	}
+
+	BLI_mutex_lock(&shards_lock);
 
-	MEM_CacheLimiter_ItemPriority_Func_set(limitor, get_item_priority);
-	MEM_CacheLimiter_ItemDestroyable_Func_set(limitor, get_item_destroyable);
+	for (shard = shards.first; shard; shard = shard->next) {
+		if (shard == shard_put) {
+			continue;
+		}
+
+		BLI_mutex_lock(&shard->lock);
+		MEM_CacheLimiter_enforce_limits(shard->limitor);
+		BLI_mutex_unlock(&shard->lock);
+
+		if (MEM_CacheLimiter_get_total_memory_in_use() <= mem_limit) {
+			break;
+		}
+	}
+
+	BLI_mutex_unlock(&shards_lock);
 }
 
 void IMB_moviecache_destruct(void)
 {
-	if (limitor)
-		delete_MEM_CacheLimiter(limitor);
+	MovieCacheShard *shard, *shard_next;
+
+	for (shard = shards.first; shard; shard = shard_next) {
+		shard_next = shard->next;
+
+		delete_MEM_CacheLimiter(shard->limitor);
+		BLI_mutex_end(&shard->lock);
+		MEM_freeN(shard);
+	}
+
+	BLI_listbase_clear(&shards);
 }
 
 MovieCache *IMB_moviecache_create(const char *name, int keysize, GHashHashFP hashfp, GHashCmpFP cmpfp)
@@ -315,6 +428,8 @@ MovieCache *IMB_moviecache_create(const char *name, int keysize, GHashHashFP has
 	cache->cmpfp = cmpfp;
 	cache->proxy = -1;
 
+	cache->shard = moviecache_shard_ensure(name);
+
 	return cache;
 }
 
@@ -332,16 +447,29 @@ void IMB_moviecache_set_priority_callback(struct MovieCache *cache, MovieCacheGe
 	cache->getprioritydatafp = getprioritydatafp;
 	cache->getitempriorityfp = getitempriorityfp;
 	cache->prioritydeleterfp = prioritydeleterfp;
+
+	/* other caches of the shard use default (least recently used) priority */
+	BLI_mutex_lock(&cache->shard->lock);
+	MEM_CacheLimiter_ItemPriority_Func_set(cache->shard->limitor, get_item_priority);
+	BLI_mutex_unlock(&cache->shard->lock);
 }
 
-static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, bool need_lock)
+void IMB_moviecache_set_budget(const char *name, size_t budget)
 {
+	MovieCacheShard *shard = moviecache_shard_ensure(name);
+
+	BLI_mutex_lock(&shard->lock);
+	MEM_CacheLimiter_set_budget(shard->limitor, budget);
+	MEM_CacheLimiter_enforce_limits(shard->limitor);
+	BLI_mutex_unlock(&shard->lock);
+}
+
+static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, float cost, bool need_lock)
+{
+	MovieCacheShard *shard = cache->shard;
 	MovieCacheKey *key;
 	MovieCacheItem *item;
 
-	if (!limitor)
-		IMB_moviecache_init();
-
 	IMB_refImBuf(ibuf);
 
 	key = BLI_mempool_alloc(cache->keys_pool);
@@ -357,28 +485,35 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
 	item->cache_owner = cache;
 	item->c_handle = NULL;
 	item->priority_data = NULL;
+	item->size = 0;
 
 	if (cache->getprioritydatafp) {
 		item->priority_data = cache->getprioritydatafp(userkey);
 	}
 
-	BLI_ghash_reinsert(cache->hash, key, item, moviecache_keyfree, moviecache_valfree);
-
 	if (cache->last_userkey) {
 		memcpy(cache->last_userkey, userkey, cache->keysize);
 	}
 
 	if (need_lock)
-		BLI_mutex_lock(&limitor_lock);
+		BLI_mutex_lock(&shard->lock);
+
+	/* frees the buffer previously cached for the key, if any */
+	BLI_ghash_reinsert(cache->hash, key, item, moviecache_keyfree, moviecache_valfree);
 
-	item->c_handle = MEM_CacheLimiter_insert(limitor, item);
+	item->c_handle = MEM_CacheLimiter_insert(shard->limitor, item);
+	MEM_CacheLimiter_set_cost(item->c_handle, cost);
+	moviecache_stats_item_add(item);
 
 	MEM_CacheLimiter_ref(item->c_handle);
-	MEM_CacheLimiter_enforce_limits(limitor);
+	MEM_CacheLimiter_enforce_limits(shard->limitor);
 	MEM_CacheLimiter_unref(item->c_handle);
 
-	if (need_lock)
-		BLI_mutex_unlock(&limitor_lock);
+	if (need_lock) {
+		BLI_mutex_unlock(&shard->lock);
+
+		moviecache_enforce_global_limit(shard);
+	}
 
 	/* cache limiter can't remove unused keys which points to destoryed values */
 	check_unused_keys(cache);
@@ -391,26 +526,37 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
 
 void IMB_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf)
 {
-	do_moviecache_put(cache, userkey, ibuf, true);
+	do_moviecache_put(cache, userkey, ibuf, 0.0f, true);
+}
+
+/* cost: time it took to create the buffer (any unit used consistently for the cache),
+ * among the least recently used buffers the ones cheapest to recreate are freed first. */
+void IMB_moviecache_put_ex(MovieCache *cache, void *userkey, ImBuf *ibuf, float cost)
+{
+	do_moviecache_put(cache, userkey, ibuf, cost, true);
 }
 
 bool IMB_moviecache_put_if_possible(MovieCache *cache, void *userkey, ImBuf *ibuf)
 {
-	size_t mem_in_use, mem_limit, elem_size;
+	MovieCacheShard *shard = cache->shard;
+	size_t mem_in_use, mem_limit, elem_size, budget;
 	bool result = false;
 
 	elem_size = IMB_get_size_in_memory(ibuf);
 	mem_limit = MEM_CacheLimiter_get_maximum();
 
-	BLI_mutex_lock(&limitor_lock);
-	mem_in_use = MEM_CacheLimiter_get_memory_in_use(limitor);
+	BLI_mutex_lock(&shard->lock);
+	mem_in_use = MEM_CacheLimiter_get_total_memory_in_use();
+	budget = MEM_CacheLimiter_get_budget(shard->limitor);
 
-	if (mem_in_use + elem_size <= mem_limit) {
-		do_moviecache_put(cache, userkey, ibuf, false);
+	if ((mem_in_use + elem_size <= mem_limit) &&
+	    (budget == 0 || MEM_CacheLimiter_get_memory_in_use(shard->limitor) + elem_size <= budget))
+	{
+		do_moviecache_put(cache, userkey, ibuf, 0.0f, false);
 		result = true;
 	}
 
-	BLI_mutex_unlock(&limitor_lock);
+	BLI_mutex_unlock(&shard->lock);
 
 	return result;
 }
@@ -426,16 +572,22 @@ ImBuf *IMB_moviecache_get(MovieCache *cache, void *userkey)
 
 	if (item) {
 		if (item->ibuf) {
-			BLI_mutex_lock(&limitor_lock);
+			BLI_mutex_lock(&cache->shard->lock);
 			MEM_CacheLimiter_touch(item->c_handle);
-			BLI_mutex_unlock(&limitor_lock);
+			BLI_mutex_unlock(&cache->shard->lock);
 
 			IMB_refImBuf(item->ibuf);
 
+			atomic_add_and_fetch_z(&cache->stats.hits, 1);
+			atomic_add_and_fetch_z(&cache->shard->stats.hits, 1);
+
 			return item->ibuf;
 		}
 	}
 
+	atomic_add_and_fetch_z(&cache->stats.misses, 1);
+	atomic_add_and_fetch_z(&cache->shard->stats.misses, 1);
+
 	return NULL;
 }
 
@@ -455,7 +607,9 @@ void IMB_moviecache_free(MovieCache *cache)
 {
 	PRINT("%s: cache '%s' free\n", __func__, cache->name);
 
+	BLI_mutex_lock(&cache->shard->lock);
 	BLI_ghash_free(cache->hash, moviecache_keyfree, moviecache_valfree);
+	BLI_mutex_unlock(&cache->shard->lock);
 
 	BLI_mempool_destroy(cache->keys_pool);
 	BLI_mempool_destroy(cache->items_pool);
@@ -476,6 +630,8 @@ void IMB_moviecache_cleanup(MovieCache *cache, bool (cleanup_check_cb) (ImBuf *i
 
 	check_unused_keys(cache);
 
+	BLI_mutex_lock(&cache->shard->lock);
+
 	BLI_ghashIterator_init(&gh_iter, cache->hash);
 
 	while (!BLI_ghashIterator_done(&gh_iter)) {
@@ -490,6 +646,70 @@ void IMB_moviecache_cleanup(MovieCache *cache, bool (cleanup_check_cb) (ImBuf *i
 			BLI_ghash_remove(cache->hash, key, moviecache_keyfree, moviecache_valfree);
 		}
 	}
+
+	BLI_mutex_unlock(&cache->shard->lock);
+}
+
+/* ************************ statistics ************************ */
+
+void IMB_moviecache_get_stats(MovieCache *cache, MovieCacheStats *r_stats)
+{
+	BLI_mutex_lock(&cache->shard->lock);
+	*r_stats = cache->stats;
+	BLI_mutex_unlock(&cache->shard->lock);
+}
+
+/* statistics of all caches with the given name, including freed ones */
+static void moviecache_shard_get_stats(MovieCacheShard *shard, MovieCacheStats *r_stats)
+{
+	BLI_mutex_lock(&shard->lock);
+	*r_stats = shard->stats;
+	BLI_mutex_unlock(&shard->lock);
+}
+
+bool IMB_moviecache_get_stats_by_name(const char *name, MovieCacheStats *r_stats)
+{
+	MovieCacheShard *shard;
+
+	BLI_mutex_lock(&shards_lock);
+
+	shard = BLI_findstring(&shards, name, offsetof(MovieCacheShard, name));
+	if (shard) {
+		moviecache_shard_get_stats(shard, r_stats);
+	}
+
+	BLI_mutex_unlock(&shards_lock);
+
+	return shard != NULL;
+}
+
+void IMB_moviecache_print_stats(void)
+{
+	MovieCacheShard *shard;
+
+	printf("\nmovie cache statistics: %u kb in use, %u kb maximum\n",
+	       (unsigned int)(MEM_CacheLimiter_get_total_memory_in_use() / 1024),
+	       (unsigned int)(MEM_CacheLimiter_get_maximum() / 1024));
+
+	BLI_mutex_lock(&shards_lock);
+
+	for (shard = shards.first; shard; shard = shard->next) {
+		MovieCacheStats stats;
+		size_t lookups;
+
+		moviecache_shard_get_stats(shard, &stats);
+		lookups = stats.hits + stats.misses;
+
+		printf("  %s: %u items, %u kb in use, %u kb budget\n",
+		       shard->name, (unsigned int)stats.items, (unsigned int)(stats.bytes_in_use / 1024),
+		       (unsigned int)(MEM_CacheLimiter_get_budget(shard->limitor) / 1024));
+		printf("    hits: %u, misses: %u (%.1f%% hit rate), evictions: %u (%u kb)\n",
+		       (unsigned int)stats.hits, (unsigned int)stats.misses,
+		       lookups ? 100.0 * (double)stats.hits / (double)lookups : 0.0,
+		       (unsigned int)stats.evictions, (unsigned int)(stats.evicted_bytes / 1024));
+	}
+
+	BLI_mutex_unlock(&shards_lock);
 }
 
 /* get segments of cached frames. useful for debugging cache policies */
@@ -410,6 +410,7 @@ typedef struct bNodeTree {
 #define NTREE_COM_GROUPNODE_BUFFER	8	/* use groupnode buffers */
 #define NTREE_VIEWER_BORDER			16	/* use a border for viewer nodes */
 #define NTREE_IS_LOCALIZED			32	/* tree is localized copy, free when deleting node groups */
+#define NTREE_COM_FULL_FRAME		64	/* compositor calculates full buffers per operation, instead of tiles */
 
 /* XXX not nice, but needed as a temporary flags
  * for group updates after library linking.
@@ -144,6 +144,7 @@ static void rna_Depsgraph_debug_rebuild(Depsgraph *UNUSED(graph), Main *bmain)
 static void rna_Depsgraph_debug_stats(Depsgraph *graph, ReportList *reports)
 {
 	size_t outer, ops, rels;
+	double wall_time, critical_path_time, operations_time;
 
 	DEG_stats_simple(graph, &outer, &ops, &rels);
 
@@ -153,6 +154,20 @@ static void rna_Depsgraph_debug_stats(Depsgraph *graph, ReportList *reports)
 
 	BKE_reportf(reports, RPT_WARNING, "Approx. %lu Operations, %lu Relations, %lu Outer Nodes",
 	            ops, rels, outer);
+
+	DEG_stats_eval(graph, &wall_time, &critical_path_time, &operations_time);
+
+	printf("Last evaluation %.3f ms, Critical Path %.3f ms, Operations %.3f ms\n",
+	       wall_time * 1000.0, critical_path_time * 1000.0, operations_time * 1000.0);
+
+	BKE_reportf(reports, RPT_WARNING, "Last evaluation %.3f ms, Critical Path %.3f ms, Operations %.3f ms",
+	            wall_time * 1000.0, critical_path_time * 1000.0, operations_time * 1000.0);
+}
+
+static int rna_Depsgraph_debug_invalid_incremental_updates_get(PointerRNA *ptr)
+{
+	Depsgraph *graph = (Depsgraph *)ptr->data;
+	return DEG_debug_invalid_incremental_updates(graph);
 }
 
 /* Iteration over objects, simple version */
@@ -308,6 +323,13 @@ static void rna_def_depsgraph(BlenderRNA *brna)
 	RNA_def_function_ui_description(func, "Report the number of elements in the Dependency Graph");
 	RNA_def_function_flag(func, FUNC_USE_REPORTS);
 
+	prop = RNA_def_property(srna, "debug_invalid_incremental_updates", PROP_INT, PROP_UNSIGNED);
+	RNA_def_property_clear_flag(prop, PROP_EDITABLE);
+	RNA_def_property_int_funcs(prop, "rna_Depsgraph_debug_invalid_incremental_updates_get", NULL, NULL);
+	RNA_def_property_ui_text(prop, "Invalid Incremental Updates",
+	                         "Number of incremental relations updates which differed from a full rebuild, "
+	                         "only counted with debug value 801");
+
 	prop = RNA_def_property(srna, "objects", PROP_COLLECTION, PROP_NONE);
 	RNA_def_property_struct_type(prop, "Object");
 	RNA_def_property_collection_funcs(prop,
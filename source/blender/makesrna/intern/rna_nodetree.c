@@ -101,6 +101,13 @@ static EnumPropertyItem node_chunksize_items[] = {
 	{NTREE_CHUNCKSIZE_1024, "1024",   0,    "1024x1024", "Chunksize of 1024x1024"},
 	{0, NULL, 0, NULL, NULL}
 };
+
+static EnumPropertyItem node_execution_mode_items[] = {
+	{0,                    "TILED",      0, "Tiled",      "Calculate the outputs tile by tile, evaluating the nodes per pixel"},
+	{NTREE_COM_FULL_FRAME, "FULL_FRAME", 0, "Full Frame", "Calculate whole buffers node by node, "
+	                                                      "faster for nodes supporting it but uses more memory"},
+	{0, NULL, 0, NULL, NULL}
+};
 #endif
 
 #define DEF_ICON_BLANK_SKIP
@@ -8269,6 +8276,11 @@ static void rna_def_composite_nodetree(BlenderRNA *brna)
 	RNA_def_property_ui_text(prop, "Chunksize", "Max size of a tile (smaller values gives better distribution "
 	                                            "of multiple threads, but more overhead)");
 
+	prop = RNA_def_property(srna, "execution_mode", PROP_ENUM, PROP_NONE);
+	RNA_def_property_enum_bitflag_sdna(prop, NULL, "flag");
+	RNA_def_property_enum_items(prop, node_execution_mode_items);
+	RNA_def_property_ui_text(prop, "Execution Mode", "How the compositor evaluates the node tree");
+
 	prop = RNA_def_property(srna, "use_opencl", PROP_BOOLEAN, PROP_NONE);
 	RNA_def_property_boolean_sdna(prop, NULL, "flag", NTREE_COM_OPENCL);
 	RNA_def_property_ui_text(prop, "OpenCL", "Enable GPU calculations");
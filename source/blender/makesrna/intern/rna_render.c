@@ -684,6 +684,12 @@ static void rna_def_render_engine(BlenderRNA *brna)
 	prop = RNA_def_property(srna, "is_preview", PROP_BOOLEAN, PROP_NONE);
 	RNA_def_property_boolean_sdna(prop, NULL, "flag", RE_ENGINE_PREVIEW);
 
+	prop = RNA_def_property(srna, "is_incremental_update", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "flag", RE_ENGINE_INCREMENTAL_UPDATE);
+	RNA_def_property_ui_text(prop, "Incremental Update",
+	                         "Persistent data of the previous animation frame is still valid, "
+	                         "only data-blocks tagged for recalculation changed since then");
+
 	prop = RNA_def_property(srna, "camera_override", PROP_POINTER, PROP_NONE);
 	RNA_def_property_pointer_funcs(prop, "rna_RenderEngine_camera_override_get", NULL, NULL, NULL);
 	RNA_def_property_struct_type(prop, "Object");
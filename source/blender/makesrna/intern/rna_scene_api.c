@@ -32,9 +32,12 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+#include "MEM_guardedalloc.h"
+
 #include "BLI_utildefines.h"
 #include "BLI_kdopbvh.h"
 #include "BLI_path_util.h"
+#include "BLI_threads.h"
 
 #include "RNA_define.h"
 #include "RNA_enum_types.h"
@@ -63,6 +66,7 @@ EnumPropertyItem rna_enum_abc_compression_items[] = {
 #include "BKE_editmesh.h"
 #include "BKE_global.h"
 #include "BKE_image.h"
+#include "BKE_main.h"
 #include "BKE_scene.h"
 #include "BKE_writeavi.h"
 
@@ -105,6 +109,83 @@ static void rna_Scene_frame_set(Scene *scene, int frame, float subframe)
 	}
 }
 
+typedef struct SceneMatrixWorldFrames {
+	const Object *ob;
+	float (*matrices)[4][4];
+	int index;
+} SceneMatrixWorldFrames;
+
+/* Frames may be evaluated on a copy of the database, look the object up by name and library. */
+static void rna_Scene_matrix_world_frame_evaluated(void *userdata, Main *bmain, Scene *UNUSED(scene), double UNUSED(frame))
+{
+	SceneMatrixWorldFrames *data = userdata;
+	const ID *id = &data->ob->id;
+	Object *ob;
+
+	for (ob = bmain->object.first; ob; ob = ob->id.next) {
+		if (STREQ(ob->id.name, id->name) &&
+		    ((ob->id.lib == NULL && id->lib == NULL) ||
+		     (ob->id.lib && id->lib && STREQ(ob->id.lib->name, id->lib->name))))
+		{
+			break;
+		}
+	}
+
+	if (ob) {
+		copy_m4_m4(data->matrices[data->index], ob->obmat);
+	}
+	else {
+		unit_m4(data->matrices[data->index]);
+	}
+	data->index++;
+}
+
+static void rna_Scene_evaluate_frames_matrix_world(
+        Scene *scene, Object *ob, int frames_len, float *frames, int copies,
+        int *r_matrices_len, float **r_matrices)
+{
+	SceneMatrixWorldFrames data = {NULL};
+	double *frames_eval = MEM_mallocN(sizeof(*frames_eval) * frames_len, __func__);
+	const int cfra = scene->r.cfra;
+	const float subframe = scene->r.subframe;
+	int i;
+
+	for (i = 0; i < frames_len; i++) {
+		frames_eval[i] = (double)frames[i];
+	}
+
+	data.ob = ob;
+	data.matrices = MEM_mallocN(sizeof(*data.matrices) * frames_len, __func__);
+
+#ifdef WITH_PYTHON
+	BPy_BEGIN_ALLOW_THREADS;
+#endif
+
+	BKE_scene_evaluate_frames(G.main, scene, frames_eval, frames_len, copies,
+	                          rna_Scene_matrix_world_frame_evaluated, &data);
+
+	/* frames evaluated on the scene itself leave it at the last one */
+	if (scene->r.cfra != cfra || scene->r.subframe != subframe) {
+		scene->r.cfra = cfra;
+		scene->r.subframe = subframe;
+		BKE_scene_update_for_newframe(G.main->eval_ctx, G.main, scene);
+	}
+
+#ifdef WITH_PYTHON
+	BPy_END_ALLOW_THREADS;
+#endif
+
+	/* cancelled evaluations leave the remaining matrices unset */
+	for (i = data.index; i < frames_len; i++) {
+		unit_m4(data.matrices[i]);
+	}
+
+	MEM_freeN(frames_eval);
+
+	*r_matrices_len = frames_len * 16;
+	*r_matrices = (float *)data.matrices;
+}
+
 static void rna_Scene_uvedit_aspect(Scene *scene, Object *ob, float *aspect)
 {
 	if ((ob->type == OB_MESH) && (ob->mode == OB_MODE_EDIT)) {
@@ -337,6 +418,23 @@ void RNA_api_scene(StructRNA *srna)
 	RNA_def_function_ui_description(func,
 	                                "Update data tagged to be updated from previous access to data or operators");
 
+	func = RNA_def_function(srna, "evaluate_frames_matrix_world", "rna_Scene_evaluate_frames_matrix_world");
+	RNA_def_function_ui_description(func,
+	                                "Evaluate the world matrix of an object for each of the given frames, "
+	                                "without simulations frames are evaluated in parallel on copies of the "
+	                                "file, the current frame is kept");
+	parm = RNA_def_pointer(func, "object", "Object", "", "Object");
+	RNA_def_parameter_flags(parm, PROP_NEVER_NULL, PARM_REQUIRED);
+	parm = RNA_def_float_array(func, "frames", 1, NULL, MINAFRAME, MAXFRAME, "", "Frames to evaluate, "
+	                           "including sub-frames", MINAFRAME, MAXFRAME);
+	RNA_def_parameter_flags(parm, PROP_DYNAMIC, PARM_REQUIRED);
+	RNA_def_int(func, "copies", 0, 0, BLENDER_MAX_THREADS, "",
+	            "Number of copies of the file evaluated at the same time, 0 for automatic, "
+	            "1 to evaluate frames on the scene itself", 0, BLENDER_MAX_THREADS);
+	parm = RNA_def_float_array(func, "matrices", 1, NULL, -FLT_MAX, FLT_MAX, "",
+	                           "4x4 matrices of the frames, flattened", -FLT_MAX, FLT_MAX);
+	RNA_def_parameter_flags(parm, PROP_DYNAMIC, PARM_OUTPUT);
+
 	func = RNA_def_function(srna, "uvedit_aspect", "rna_Scene_uvedit_aspect");
 	RNA_def_function_ui_description(func, "Get uv aspect for current object");
 	parm = RNA_def_pointer(func, "object", "Object", "", "Object");
@@ -76,6 +76,9 @@ struct BakePixel;
 #define RE_ENGINE_RENDERING		16
 #define RE_ENGINE_HIGHLIGHT_TILES	32
 #define RE_ENGINE_USED_FOR_VIEWPORT	64
+/* Persistent data of the previous animation frame can be updated, only data-blocks
+ * tagged for recalculation changed since then. */
+#define RE_ENGINE_INCREMENTAL_UPDATE	128
 
 /* RenderEngine.update_flag, used by internal now */
 #define RE_ENGINE_UPDATE_MA			1
@@ -564,6 +564,7 @@ bool RE_bake_engine(
 	RE_parts_init(re, false);
 	engine->tile_x = re->r.tilex;
 	engine->tile_y = re->r.tiley;
+	engine->flag &= ~RE_ENGINE_INCREMENTAL_UPDATE;
 
 	/* update is only called so we create the engine.session */
 	if (type->update)
@@ -633,6 +634,10 @@ int RE_engine_render(Render *re, int do_all)
 	RenderEngineType *type = RE_engines_find(re->r.engine);
 	RenderEngine *engine;
 	bool persistent_data = (re->r.mode & R_PERSISTENT_DATA) != 0;
+	/* With persistent data, frames of an animation after the first one only need
+	 * the data-blocks which changed since the previous frame to be synced again. */
+	const bool incremental_update = persistent_data && (re->flag & R_ANIMATION) &&
+	                                re->engine && (re->engine->flag & RE_ENGINE_ANIMATION);
 
 	/* verify if we can render */
 	if (!type->render_to_image)
@@ -652,7 +657,8 @@ int RE_engine_render(Render *re, int do_all)
 	/* update animation here so any render layer animation is applied before
 	 * creating the render result */
 	if ((re->r.scemode & (R_NO_FRAME_UPDATE | R_BUTS_PREVIEW)) == 0) {
-		BKE_scene_update_for_newframe(re->eval_ctx, re->main, re->scene);
+		/* keep recalc tags until the engine is updated, so it can see what changed */
+		BKE_scene_update_for_newframe_ex(re->eval_ctx, re->main, re->scene, !incremental_update);
 		render_update_anim_renderdata(re, &re->scene->r);
 	}
 
@@ -703,6 +709,10 @@ int RE_engine_render(Render *re, int do_all)
 
 	if (re->flag & R_ANIMATION)
 		engine->flag |= RE_ENGINE_ANIMATION;
+	if (incremental_update)
+		engine->flag |= RE_ENGINE_INCREMENTAL_UPDATE;
+	else
+		engine->flag &= ~RE_ENGINE_INCREMENTAL_UPDATE;
 	if (re->r.scemode & R_BUTS_PREVIEW)
 		engine->flag |= RE_ENGINE_PREVIEW;
 	engine->camera_override = re->camera_override;
@@ -722,6 +732,10 @@ int RE_engine_render(Render *re, int do_all)
 		type->update(engine, re->main, re->depsgraph, re->scene);
 	}
 
+	if (incremental_update) {
+		DEG_ids_clear_recalc(re->main);
+	}
+
 	/* Clear UI drawing locks. */
 	if (re->draw_lock) {
 		re->draw_lock(re->dlh, 0);
@@ -3645,8 +3645,10 @@ void RE_BlenderAnim(Render *re, Main *bmain, Scene *scene, Object *camera_overri
 			render_initialize_from_main(re, &rd, bmain, scene, NULL, camera_override, lay_override, 1, 0);
 
 			if (nfra != scene->r.cfra) {
-				/* Skip this frame, but update for physics and particles system. */
-				BKE_scene_update_for_newframe(re->eval_ctx, bmain, scene);
+				/* Skip this frame, but update for physics and particles system.
+				 * Recalc tags are kept for engines which sync persistent data incrementally. */
+				BKE_scene_update_for_newframe_ex(re->eval_ctx, bmain, scene,
+				                                 (scene->r.mode & R_PERSISTENT_DATA) == 0);
 				continue;
 			}
 			else
@@ -3785,6 +3787,11 @@ void RE_BlenderAnim(Render *re, Main *bmain, Scene *scene, Object *camera_overri
 
 	re->flag &= ~R_ANIMATION;
 
+	/* a persistent engine starts with a full update on the next render */
+	if (re->engine) {
+		re->engine->flag &= ~(RE_ENGINE_ANIMATION | RE_ENGINE_INCREMENTAL_UPDATE);
+	}
+
 	BLI_callback_exec(re->main, (ID *)scene, G.is_break ? BLI_CB_EVT_RENDER_CANCEL : BLI_CB_EVT_RENDER_COMPLETE);
 	BKE_sound_reset_scene_specs(scene);
 
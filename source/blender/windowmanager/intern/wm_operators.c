@@ -67,6 +67,7 @@
 #include "BLO_readfile.h"
 
 #include "BKE_appdir.h"
+#include "BKE_blender_undo.h"
 #include "BKE_blender_version.h"
 #include "BKE_brush.h"
 #include "BKE_context.h"
@@ -93,6 +94,7 @@
 
 #include "IMB_imbuf_types.h"
 #include "IMB_imbuf.h"
+#include "IMB_moviecache.h"
 
 #include "ED_numinput.h"
 #include "ED_screen.h"
@@ -3952,6 +3954,8 @@ static void WM_OT_redraw_timer(wmOperatorType *ot)
 static int memory_statistics_exec(bContext *UNUSED(C), wmOperator *UNUSED(op))
 {
 	MEM_printmemlist_stats();
+	BKE_undo_print_memory_stats();
+	IMB_moviecache_print_stats();
 	return OPERATOR_FINISHED;
 }
 
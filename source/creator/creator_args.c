@@ -55,6 +55,8 @@
 #include "BKE_sound.h"
 #include "BKE_image.h"
 
+#include "DEG_depsgraph_debug.h"
+
 #ifdef WITH_FFMPEG
 #include "IMB_imbuf.h"
 #endif
@@ -546,6 +548,7 @@ static int arg_handle_print_help(int UNUSED(argc), const char **UNUSED(argv), vo
 	BLI_argsPrintArgDoc(ba, "--debug-python");
 	BLI_argsPrintArgDoc(ba, "--debug-depsgraph");
 	BLI_argsPrintArgDoc(ba, "--debug-depsgraph-no-threads");
+	BLI_argsPrintArgDoc(ba, "--debug-depsgraph-trace");
 
 	BLI_argsPrintArgDoc(ba, "--debug-gpumem");
 	BLI_argsPrintArgDoc(ba, "--debug-wm");
@@ -804,6 +807,23 @@ static int arg_handle_debug_mode_memory_set(int UNUSED(argc), const char **UNUSE
 	return 0;
 }
 
+static const char arg_handle_debug_depsgraph_trace_set_doc[] =
+"<filepath>\n"
+"\tRecord timing of dependency graph evaluation and write it to <filepath> on exit,\n"
+"\tas Chrome trace events (view with chrome://tracing)\n"
+;
+static int arg_handle_debug_depsgraph_trace_set(int argc, const char **argv, void *UNUSED(data))
+{
+	if (argc > 1) {
+		DEG_debug_trace_begin(argv[1]);
+		return 1;
+	}
+	else {
+		printf("\nError: you must specify a path after '--debug-depsgraph-trace'.\n");
+		return 0;
+	}
+}
+
 static const char arg_handle_debug_value_set_doc[] =
 "<value>\n"
 "\tSet debug value of <value> on startup\n"
@@ -1803,6 +1823,8 @@ void main_args_setup(bContext *C, bArgs *ba, SYS_SystemHandle *syshandle)
 	            CB_EX(arg_handle_debug_mode_generic_set, depsgraph), (void *)G_DEBUG_DEPSGRAPH);
 	BLI_argsAdd(ba, 1, NULL, "--debug-depsgraph-no-threads",
 	            CB_EX(arg_handle_debug_mode_generic_set, depsgraph_no_threads), (void *)G_DEBUG_DEPSGRAPH_NO_THREADS);
+	BLI_argsAdd(ba, 1, NULL, "--debug-depsgraph-trace",
+	            CB(arg_handle_debug_depsgraph_trace_set), NULL);
 	BLI_argsAdd(ba, 1, NULL, "--debug-gpumem",
 	            CB_EX(arg_handle_debug_mode_generic_set, gpumem), (void *)G_DEBUG_GPU_MEM);
 
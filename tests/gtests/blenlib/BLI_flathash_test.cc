@@ -0,0 +1,143 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_flathash.h"
+#include "BLI_string.h"
+}
+
+#define TESTCASE_SIZE 10000
+
+/* Unique keys, spread over the whole integer range. */
+static unsigned int test_key(const unsigned int i)
+{
+	return i * 2654435761u;
+}
+
+/* Here we simply insert and then lookup all keys, ensuring we do get back the expected stored 'data'. */
+TEST(flathash, InsertLookup)
+{
+	FlatHash *fh = BLI_flathash_int_new(__func__);
+	unsigned int i;
+
+	for (i = 0; i < TESTCASE_SIZE; i++) {
+		BLI_flathash_insert(fh, SET_UINT_IN_POINTER(test_key(i)), SET_UINT_IN_POINTER(i));
+	}
+
+	EXPECT_EQ(BLI_flathash_size(fh), TESTCASE_SIZE);
+
+	for (i = 0; i < TESTCASE_SIZE; i++) {
+		void **v = BLI_flathash_lookup_p(fh, SET_UINT_IN_POINTER(test_key(i)));
+		ASSERT_TRUE(v != NULL);
+		EXPECT_EQ(GET_UINT_FROM_POINTER(*v), i);
+	}
+	EXPECT_FALSE(BLI_flathash_haskey(fh, SET_UINT_IN_POINTER(test_key(TESTCASE_SIZE))));
+
+	BLI_flathash_free(fh, NULL, NULL);
+}
+
+/* Remove every other key, ensure remaining ones are still found and removed slots can be re-used. */
+TEST(flathash, InsertRemove)
+{
+	FlatHash *fh = BLI_flathash_int_new(__func__);
+	unsigned int i;
+
+	for (i = 0; i < TESTCASE_SIZE; i++) {
+		BLI_flathash_insert(fh, SET_UINT_IN_POINTER(test_key(i)), SET_UINT_IN_POINTER(i));
+	}
+
+	for (i = 0; i < TESTCASE_SIZE; i += 2) {
+		EXPECT_TRUE(BLI_flathash_remove(fh, SET_UINT_IN_POINTER(test_key(i)), NULL, NULL));
+	}
+	EXPECT_FALSE(BLI_flathash_remove(fh, SET_UINT_IN_POINTER(test_key(0)), NULL, NULL));
+	EXPECT_EQ(BLI_flathash_size(fh), TESTCASE_SIZE / 2);
+
+	for (i = 0; i < TESTCASE_SIZE; i++) {
+		void *v = BLI_flathash_lookup_default(fh, SET_UINT_IN_POINTER(test_key(i)), SET_UINT_IN_POINTER(-1));
+		EXPECT_EQ(GET_UINT_FROM_POINTER(v), (i % 2) ? i : (unsigned int)-1);
+	}
+
+	/* Many insertions and removals, exercises re-use of deleted slots. */
+	for (int iteration = 0; iteration < 10; iteration++) {
+		for (i = 0; i < TESTCASE_SIZE; i += 2) {
+			BLI_flathash_insert(fh, SET_UINT_IN_POINTER(test_key(i)), SET_UINT_IN_POINTER(i));
+		}
+		for (i = 0; i < TESTCASE_SIZE; i += 2) {
+			EXPECT_TRUE(BLI_flathash_remove(fh, SET_UINT_IN_POINTER(test_key(i)), NULL, NULL));
+		}
+	}
+	EXPECT_EQ(BLI_flathash_size(fh), TESTCASE_SIZE / 2);
+
+	BLI_flathash_clear(fh, NULL, NULL);
+	EXPECT_EQ(BLI_flathash_size(fh), 0);
+	EXPECT_FALSE(BLI_flathash_haskey(fh, SET_UINT_IN_POINTER(test_key(1))));
+
+	BLI_flathash_free(fh, NULL, NULL);
+}
+
+TEST(flathash, EnsureReinsert)
+{
+	FlatHash *fh = BLI_flathash_ptr_new(__func__);
+	int data[3];
+	void **val;
+
+	EXPECT_FALSE(BLI_flathash_ensure_p(fh, &data[0], &val));
+	*val = SET_INT_IN_POINTER(1);
+	EXPECT_TRUE(BLI_flathash_ensure_p(fh, &data[0], &val));
+	EXPECT_EQ(GET_INT_FROM_POINTER(*val), 1);
+
+	EXPECT_TRUE(BLI_flathash_reinsert(fh, &data[1], SET_INT_IN_POINTER(2), NULL, NULL));
+	EXPECT_FALSE(BLI_flathash_reinsert(fh, &data[0], SET_INT_IN_POINTER(3), NULL, NULL));
+	EXPECT_EQ(GET_INT_FROM_POINTER(BLI_flathash_lookup(fh, &data[0])), 3);
+	EXPECT_EQ(GET_INT_FROM_POINTER(BLI_flathash_lookup(fh, &data[1])), 2);
+	EXPECT_EQ(BLI_flathash_lookup(fh, &data[2]), (void *)NULL);
+	EXPECT_EQ(BLI_flathash_size(fh), 2);
+
+	BLI_flathash_free(fh, NULL, NULL);
+}
+
+TEST(flathash, StringKeys)
+{
+	FlatHash *fh = BLI_flathash_str_new_ex(__func__, 4);
+	char key[32];
+	unsigned int i;
+
+	for (i = 0; i < TESTCASE_SIZE; i++) {
+		BLI_snprintf(key, sizeof(key), "OBCube.%u", i);
+		BLI_flathash_insert(fh, BLI_strdup(key), SET_UINT_IN_POINTER(i));
+	}
+
+	for (i = 0; i < TESTCASE_SIZE; i++) {
+		BLI_snprintf(key, sizeof(key), "OBCube.%u", i);
+		EXPECT_EQ(GET_UINT_FROM_POINTER(BLI_flathash_lookup(fh, key)), i);
+	}
+
+	BLI_flathash_free(fh, MEM_freeN, NULL);
+}
+
+/* Iteration must visit every entry exactly once. */
+TEST(flathash, Iterator)
+{
+	FlatHash *fh = BLI_flathash_int_new(__func__);
+	FlatHashIterator fh_iter;
+	unsigned int i, sum = 0, count = 0;
+
+	for (i = 0; i < TESTCASE_SIZE; i++) {
+		BLI_flathash_insert(fh, SET_UINT_IN_POINTER(test_key(i)), SET_UINT_IN_POINTER(i));
+	}
+
+	FLATHASH_ITER (fh_iter, fh) {
+		const unsigned int k = GET_UINT_FROM_POINTER(BLI_flathashIterator_getKey(&fh_iter));
+		const unsigned int v = GET_UINT_FROM_POINTER(BLI_flathashIterator_getValue(&fh_iter));
+		EXPECT_EQ(k, test_key(v));
+		sum += v;
+		count++;
+	}
+	EXPECT_EQ(count, TESTCASE_SIZE);
+	EXPECT_EQ(sum, TESTCASE_SIZE * (TESTCASE_SIZE - 1) / 2);
+
+	BLI_flathash_free(fh, NULL, NULL);
+}
@@ -9,6 +9,7 @@ extern "C" {
 #include "MEM_guardedalloc.h"
 #include "BLI_utildefines.h"
 #include "BLI_ghash.h"
+#include "BLI_flathash.h"
 #include "BLI_rand.h"
 #include "BLI_string.h"
 #include "PIL_time_utildefines.h"
@@ -534,3 +535,194 @@ TEST(ghash, MultiRandIntMurmur2a200000)
 
 	multi_small_ghash_tests(ghash, "MultiSmall RandIntGHash - Murmur2a - 200000", 200000);
 }
+
+
+/* FlatHash: same data as above, to compare open addressing with chained buckets. */
+
+static void str_flathash_tests(FlatHash *fh, const char *id)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	char *data = BLI_strdup(words10k);
+	char *data_w = BLI_strdup(data);
+	char *data_bis = BLI_strdup(data);
+
+	{
+		char *w, *c_w;
+
+		TIMEIT_START(string_insert);
+
+		for (w = c_w = data_w; *c_w; c_w++) {
+			if (ELEM(*c_w, '.', ' ')) {
+				*c_w = '\0';
+				if (!BLI_flathash_haskey(fh, w)) {
+					BLI_flathash_insert(fh, w, SET_INT_IN_POINTER(w[0]));
+				}
+				w = c_w + 1;
+			}
+		}
+
+		TIMEIT_END(string_insert);
+	}
+
+	{
+		char *w, *c;
+		void *v;
+
+		TIMEIT_START(string_lookup);
+
+		for (w = c = data_bis; *c; c++) {
+			if (ELEM(*c, '.', ' ')) {
+				*c = '\0';
+				v = BLI_flathash_lookup(fh, w);
+				EXPECT_EQ(GET_INT_FROM_POINTER(v), w[0]);
+				w = c + 1;
+			}
+		}
+
+		TIMEIT_END(string_lookup);
+	}
+
+	BLI_flathash_free(fh, NULL, NULL);
+	MEM_freeN(data);
+	MEM_freeN(data_w);
+	MEM_freeN(data_bis);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(ghash, TextFlatHash)
+{
+	FlatHash *fh = BLI_flathash_str_new(__func__);
+
+	str_flathash_tests(fh, "StrGHash - FlatHash");
+}
+
+static void int_flathash_tests(FlatHash *fh, const char *id, const unsigned int nbr)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	{
+		unsigned int i = nbr;
+
+		TIMEIT_START(int_insert);
+
+		while (i--) {
+			BLI_flathash_insert(fh, SET_UINT_IN_POINTER(i), SET_UINT_IN_POINTER(i));
+		}
+
+		TIMEIT_END(int_insert);
+	}
+
+	{
+		unsigned int i = nbr;
+
+		TIMEIT_START(int_lookup);
+
+		while (i--) {
+			void *v = BLI_flathash_lookup(fh, SET_UINT_IN_POINTER(i));
+			EXPECT_EQ(GET_UINT_FROM_POINTER(v), i);
+		}
+
+		TIMEIT_END(int_lookup);
+	}
+
+	{
+		unsigned int i = nbr;
+
+		TIMEIT_START(int_remove);
+
+		while (i--) {
+			EXPECT_TRUE(BLI_flathash_remove(fh, SET_UINT_IN_POINTER(i), NULL, NULL));
+		}
+
+		TIMEIT_END(int_remove);
+	}
+	EXPECT_EQ(BLI_flathash_size(fh), 0);
+
+	BLI_flathash_free(fh, NULL, NULL);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(ghash, IntFlatHash12000)
+{
+	FlatHash *fh = BLI_flathash_int_new(__func__);
+
+	int_flathash_tests(fh, "IntGHash - FlatHash - 12000", 12000);
+}
+
+#ifdef GHASH_RUN_BIG
+TEST(ghash, IntFlatHash100000000)
+{
+	FlatHash *fh = BLI_flathash_int_new(__func__);
+
+	int_flathash_tests(fh, "IntGHash - FlatHash - 100000000", 100000000);
+}
+#endif
+
+static void randint_flathash_tests(FlatHash *fh, const char *id, const unsigned int nbr)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	unsigned int *data = (unsigned int *)MEM_mallocN(sizeof(*data) * (size_t)nbr, __func__);
+	unsigned int *dt;
+	unsigned int i;
+
+	{
+		RNG *rng = BLI_rng_new(0);
+		for (i = nbr, dt = data; i--; dt++) {
+			*dt = BLI_rng_get_uint(rng);
+		}
+		BLI_rng_free(rng);
+	}
+
+	{
+		TIMEIT_START(int_insert);
+
+		for (i = nbr, dt = data; i--; dt++) {
+			BLI_flathash_insert(fh, SET_UINT_IN_POINTER(*dt), SET_UINT_IN_POINTER(*dt));
+		}
+
+		TIMEIT_END(int_insert);
+	}
+
+	{
+		TIMEIT_START(int_lookup);
+
+		for (i = nbr, dt = data; i--; dt++) {
+			void *v = BLI_flathash_lookup(fh, SET_UINT_IN_POINTER(*dt));
+			EXPECT_EQ(GET_UINT_FROM_POINTER(v), *dt);
+		}
+
+		TIMEIT_END(int_lookup);
+	}
+
+	BLI_flathash_free(fh, NULL, NULL);
+	MEM_freeN(data);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(ghash, IntRandFlatHash12000)
+{
+	FlatHash *fh = BLI_flathash_int_new(__func__);
+
+	randint_flathash_tests(fh, "RandIntGHash - FlatHash - 12000", 12000);
+}
+
+#ifdef GHASH_RUN_BIG
+TEST(ghash, IntRandFlatHash50000000)
+{
+	FlatHash *fh = BLI_flathash_int_new(__func__);
+
+	randint_flathash_tests(fh, "RandIntGHash - FlatHash - 50000000", 50000000);
+}
+#endif
+
+TEST(ghash, Int4NoHashFlatHash12000)
+{
+	FlatHash *fh = BLI_flathash_new(ghashutil_tests_nohash_p, ghashutil_tests_cmp_p, __func__);
+
+	randint_flathash_tests(fh, "RandIntGHash - FlatHash No Hash - 12000", 12000);
+}
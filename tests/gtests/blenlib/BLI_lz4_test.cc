@@ -0,0 +1,117 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_lz4.h"
+#include "BLI_rand.h"
+}
+
+static void lz4_roundtrip(const unsigned char *data, const size_t data_len, size_t *r_comp_len)
+{
+	const size_t comp_cap = BLI_lz4_compress_bound(data_len);
+	unsigned char *comp = (unsigned char *)MEM_mallocN(comp_cap, __func__);
+	unsigned char *decomp = (unsigned char *)MEM_mallocN(data_len + 1, __func__);
+
+	const size_t comp_len = BLI_lz4_compress(data, data_len, comp, comp_cap);
+	EXPECT_NE(0, comp_len);
+	EXPECT_LE(comp_len, comp_cap);
+
+	EXPECT_TRUE(BLI_lz4_decompress(comp, comp_len, decomp, data_len));
+	EXPECT_EQ(0, memcmp(data, decomp, data_len));
+
+	/* wrong sizes must fail */
+	if (data_len > 0) {
+		EXPECT_FALSE(BLI_lz4_decompress(comp, comp_len, decomp, data_len - 1));
+	}
+	EXPECT_FALSE(BLI_lz4_decompress(comp, comp_len, decomp, data_len + 1));
+
+	if (r_comp_len) {
+		*r_comp_len = comp_len;
+	}
+
+	MEM_freeN(comp);
+	MEM_freeN(decomp);
+}
+
+TEST(lz4, Empty)
+{
+	const unsigned char data[1] = {0};
+	lz4_roundtrip(data, 0, NULL);
+}
+
+TEST(lz4, Small)
+{
+	const unsigned char data[] = "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa";
+	for (size_t len = 1; len < sizeof(data); len++) {
+		lz4_roundtrip(data, len, NULL);
+	}
+}
+
+TEST(lz4, Repetitive)
+{
+	const size_t data_len = 1 << 20;
+	unsigned char *data = (unsigned char *)MEM_mallocN(data_len, __func__);
+	size_t comp_len;
+
+	for (size_t i = 0; i < data_len; i++) {
+		data[i] = (unsigned char)((i % 1000) < 500 ? (i % 7) : 0);
+	}
+	lz4_roundtrip(data, data_len, &comp_len);
+	EXPECT_LT(comp_len, data_len / 10);
+
+	memset(data, 0, data_len);
+	lz4_roundtrip(data, data_len, &comp_len);
+	EXPECT_LT(comp_len, data_len / 100);
+
+	MEM_freeN(data);
+}
+
+TEST(lz4, Random)
+{
+	const size_t data_len = (1 << 20) + 7;
+	unsigned char *data = (unsigned char *)MEM_mallocN(data_len, __func__);
+	RNG *rng = BLI_rng_new(1);
+
+	for (size_t i = 0; i < data_len; i++) {
+		data[i] = (unsigned char)(BLI_rng_get_uint(rng) & 0xff);
+	}
+	lz4_roundtrip(data, data_len, NULL);
+
+	/* mostly random with some repeated runs */
+	for (size_t i = 0; i + 64 < data_len; i += 256) {
+		memcpy(&data[i + 32], &data[i], 32);
+	}
+	lz4_roundtrip(data, data_len, NULL);
+
+	BLI_rng_free(rng);
+	MEM_freeN(data);
+}
+
+TEST(lz4, TooSmallOutput)
+{
+	const size_t data_len = 4096;
+	unsigned char data[data_len];
+	unsigned char comp[64];
+
+	for (size_t i = 0; i < data_len; i++) {
+		data[i] = (unsigned char)(i * 31);
+	}
+	EXPECT_EQ(0, BLI_lz4_compress(data, data_len, comp, sizeof(comp)));
+}
+
+TEST(lz4, Corrupt)
+{
+	const unsigned char data[] = "blender blender blender blender blender blender";
+	unsigned char comp[128];
+	unsigned char decomp[sizeof(data)];
+	const size_t comp_len = BLI_lz4_compress(data, sizeof(data), comp, sizeof(comp));
+	EXPECT_NE(0, comp_len);
+
+	/* truncated input */
+	for (size_t len = 0; len < comp_len; len++) {
+		EXPECT_FALSE(BLI_lz4_decompress(comp, len, decomp, sizeof(data)));
+	}
+}
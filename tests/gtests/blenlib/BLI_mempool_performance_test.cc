@@ -0,0 +1,133 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_mempool.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "PIL_time_utildefines.h"
+}
+
+/* Compares allocating and freeing many small elements from all threads using
+ * MEM_mallocN, a BLI_mempool guarded by a spin lock (what parallel code has to
+ * do without BLI_MEMPOOL_THREADSAFE) and a BLI_MEMPOOL_THREADSAFE pool. */
+
+#define NUM_BLOCKS 1024
+#define BLOCK_SIZE 1000
+#define NUM_RUNS 5
+#define ELEM_SIZE 32
+
+typedef enum MempoolPerfMode {
+	MEMPOOL_PERF_MALLOC,
+	MEMPOOL_PERF_LOCKED,
+	MEMPOOL_PERF_THREADSAFE,
+} MempoolPerfMode;
+
+typedef struct MempoolPerfData {
+	MempoolPerfMode mode;
+	BLI_mempool *pool;
+	SpinLock lock;
+	void **elems;
+} MempoolPerfData;
+
+static void *mempool_perf_alloc(MempoolPerfData *data)
+{
+	void *elem;
+	switch (data->mode) {
+		case MEMPOOL_PERF_MALLOC:
+			return MEM_mallocN(ELEM_SIZE, __func__);
+		case MEMPOOL_PERF_LOCKED:
+			BLI_spin_lock(&data->lock);
+			elem = BLI_mempool_alloc(data->pool);
+			BLI_spin_unlock(&data->lock);
+			return elem;
+		case MEMPOOL_PERF_THREADSAFE:
+			return BLI_mempool_alloc(data->pool);
+	}
+	return NULL;
+}
+
+static void mempool_perf_free(MempoolPerfData *data, void *elem)
+{
+	switch (data->mode) {
+		case MEMPOOL_PERF_MALLOC:
+			MEM_freeN(elem);
+			break;
+		case MEMPOOL_PERF_LOCKED:
+			BLI_spin_lock(&data->lock);
+			BLI_mempool_free(data->pool, elem);
+			BLI_spin_unlock(&data->lock);
+			break;
+		case MEMPOOL_PERF_THREADSAFE:
+			BLI_mempool_free(data->pool, elem);
+			break;
+	}
+}
+
+/* Allocate a block, free half of it and allocate it again (typical churn). */
+static void mempool_perf_alloc_func(void *userdata, const int block)
+{
+	MempoolPerfData *data = (MempoolPerfData *)userdata;
+	void **elems = &data->elems[block * BLOCK_SIZE];
+
+	for (int i = 0; i < BLOCK_SIZE; i++) {
+		elems[i] = mempool_perf_alloc(data);
+	}
+	for (int i = 0; i < BLOCK_SIZE; i += 2) {
+		mempool_perf_free(data, elems[i]);
+	}
+	for (int i = 0; i < BLOCK_SIZE; i += 2) {
+		elems[i] = mempool_perf_alloc(data);
+	}
+}
+
+static void mempool_perf_free_func(void *userdata, const int block)
+{
+	MempoolPerfData *data = (MempoolPerfData *)userdata;
+	void **elems = &data->elems[block * BLOCK_SIZE];
+
+	for (int i = 0; i < BLOCK_SIZE; i++) {
+		mempool_perf_free(data, elems[i]);
+	}
+}
+
+static void mempool_perf_run(MempoolPerfMode mode)
+{
+	MempoolPerfData data;
+	data.mode = mode;
+	data.elems = (void **)MEM_mallocN(sizeof(void *) * NUM_BLOCKS * BLOCK_SIZE, __func__);
+	BLI_spin_init(&data.lock);
+
+	for (int i = 0; i < NUM_RUNS; i++) {
+		data.pool = BLI_mempool_create(ELEM_SIZE, 0, 512,
+		                               (mode == MEMPOOL_PERF_THREADSAFE) ? BLI_MEMPOOL_THREADSAFE : BLI_MEMPOOL_NOP);
+		BLI_task_parallel_range(0, NUM_BLOCKS, &data, mempool_perf_alloc_func, true);
+		BLI_task_parallel_range(0, NUM_BLOCKS, &data, mempool_perf_free_func, true);
+		BLI_mempool_destroy(data.pool);
+	}
+
+	BLI_spin_end(&data.lock);
+	MEM_freeN(data.elems);
+}
+
+TEST(mempool, AllocFreeMultiThread)
+{
+	BLI_threadapi_init();
+
+	printf("\n========== %d threads ==========\n", BLI_system_thread_count());
+
+	TIMEIT_START(malloc);
+	mempool_perf_run(MEMPOOL_PERF_MALLOC);
+	TIMEIT_END(malloc);
+
+	TIMEIT_START(mempool_locked);
+	mempool_perf_run(MEMPOOL_PERF_LOCKED);
+	TIMEIT_END(mempool_locked);
+
+	TIMEIT_START(mempool_threadsafe);
+	mempool_perf_run(MEMPOOL_PERF_THREADSAFE);
+	TIMEIT_END(mempool_threadsafe);
+}
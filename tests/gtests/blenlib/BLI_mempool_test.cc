@@ -0,0 +1,116 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_mempool.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+}
+
+#define NUM_BLOCKS 256
+#define BLOCK_SIZE 100
+
+typedef struct MempoolTestElem {
+	int block;
+	int index;
+} MempoolTestElem;
+
+typedef struct MempoolTestData {
+	BLI_mempool *pool;
+	MempoolTestElem *elems[NUM_BLOCKS * BLOCK_SIZE];
+} MempoolTestData;
+
+static void mempool_test_alloc_func(void *userdata, const int block)
+{
+	MempoolTestData *data = (MempoolTestData *)userdata;
+
+	for (int i = 0; i < BLOCK_SIZE; i++) {
+		MempoolTestElem *elem = (MempoolTestElem *)BLI_mempool_alloc(data->pool);
+		elem->block = block;
+		elem->index = i;
+		data->elems[block * BLOCK_SIZE + i] = elem;
+	}
+}
+
+/* Free blocks in reverse order, so elements end up in the cache of a different thread. */
+static void mempool_test_free_func(void *userdata, const int block)
+{
+	MempoolTestData *data = (MempoolTestData *)userdata;
+	const int block_free = NUM_BLOCKS - 1 - block;
+
+	for (int i = 0; i < BLOCK_SIZE; i++) {
+		MempoolTestElem *elem = data->elems[block_free * BLOCK_SIZE + i];
+		EXPECT_EQ(block_free, elem->block);
+		EXPECT_EQ(i, elem->index);
+		BLI_mempool_free(data->pool, elem);
+	}
+}
+
+TEST(mempool, ThreadSafeSingleThread)
+{
+	BLI_mempool *pool = BLI_mempool_create(sizeof(MempoolTestElem), 0, 64,
+	                                       BLI_MEMPOOL_ALLOW_ITER | BLI_MEMPOOL_THREADSAFE);
+	MempoolTestElem *elems[1000];
+
+	for (int i = 0; i < 1000; i++) {
+		elems[i] = (MempoolTestElem *)BLI_mempool_alloc(pool);
+		elems[i]->index = i;
+	}
+	EXPECT_EQ(1000, BLI_mempool_count(pool));
+
+	/* free every other element */
+	for (int i = 0; i < 1000; i += 2) {
+		BLI_mempool_free(pool, elems[i]);
+	}
+	EXPECT_EQ(500, BLI_mempool_count(pool));
+
+	BLI_mempool_iter iter;
+	MempoolTestElem *elem;
+	int num_iter = 0;
+	BLI_mempool_iternew(pool, &iter);
+	while ((elem = (MempoolTestElem *)BLI_mempool_iterstep(&iter))) {
+		EXPECT_EQ(1, elem->index % 2);
+		num_iter++;
+	}
+	EXPECT_EQ(500, num_iter);
+
+	BLI_mempool_clear(pool);
+	EXPECT_EQ(0, BLI_mempool_count(pool));
+
+	BLI_mempool_destroy(pool);
+}
+
+TEST(mempool, ThreadSafeMultiThread)
+{
+	BLI_threadapi_init();
+
+	MempoolTestData *data = (MempoolTestData *)MEM_callocN(sizeof(*data), __func__);
+	data->pool = BLI_mempool_create(sizeof(MempoolTestElem), 0, 512,
+	                                BLI_MEMPOOL_ALLOW_ITER | BLI_MEMPOOL_THREADSAFE);
+
+	/* Run several times, so elements are re-used from the thread caches. */
+	for (int iteration = 0; iteration < 4; iteration++) {
+		BLI_task_parallel_range(0, NUM_BLOCKS, data, mempool_test_alloc_func, true);
+		EXPECT_EQ(NUM_BLOCKS * BLOCK_SIZE, BLI_mempool_count(data->pool));
+
+		/* all allocated elements are visible to iteration, cached ones are not */
+		BLI_mempool_iter iter;
+		MempoolTestElem *elem;
+		int num_iter = 0;
+		BLI_mempool_iternew(data->pool, &iter);
+		while ((elem = (MempoolTestElem *)BLI_mempool_iterstep(&iter))) {
+			EXPECT_EQ(elem, data->elems[elem->block * BLOCK_SIZE + elem->index]);
+			num_iter++;
+		}
+		EXPECT_EQ(NUM_BLOCKS * BLOCK_SIZE, num_iter);
+
+		BLI_task_parallel_range(0, NUM_BLOCKS, data, mempool_test_free_func, true);
+		EXPECT_EQ(0, BLI_mempool_count(data->pool));
+	}
+
+	BLI_mempool_destroy(data->pool);
+	MEM_freeN(data);
+}
@@ -0,0 +1,111 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "atomic_ops.h"
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "PIL_time_utildefines.h"
+}
+
+/* Compares throughput of the scheduler with per-thread work-stealing queues to
+ * the previous one (single global queue and one unstealable task per thread),
+ * for tiny tasks which are pushed from the main thread (as BLI_task_pool_push()
+ * does) and tiny tasks which are pushed from workers (as the depsgraph and
+ * nested parallel ranges do). */
+
+#define NUM_TASKS_GLOBAL 1000000
+#define SPAWN_DEPTH 19
+#define NUM_RUNS 5
+
+typedef struct TaskPerfData {
+	uint32_t num_done;
+	int depth;
+} TaskPerfData;
+
+static void task_perf_count_func(TaskPool *__restrict pool, void *UNUSED(taskdata), int UNUSED(thread_id))
+{
+	TaskPerfData *data = (TaskPerfData *)BLI_task_pool_userdata(pool);
+	atomic_add_and_fetch_uint32(&data->num_done, 1);
+}
+
+static void task_perf_spawn_func(TaskPool *__restrict pool, void *taskdata, int thread_id)
+{
+	TaskPerfData *data = (TaskPerfData *)BLI_task_pool_userdata(pool);
+	const int depth = GET_INT_FROM_POINTER(taskdata);
+
+	atomic_add_and_fetch_uint32(&data->num_done, 1);
+
+	if (depth < data->depth) {
+		for (int i = 0; i < 2; i++) {
+			BLI_task_pool_push_from_thread(pool, task_perf_spawn_func, SET_INT_IN_POINTER(depth + 1),
+			                               false, TASK_PRIORITY_HIGH, thread_id);
+		}
+	}
+}
+
+static void task_perf_global_queue(TaskScheduler *scheduler)
+{
+	TaskPerfData data = {0, 0};
+	TaskPool *pool = BLI_task_pool_create(scheduler, &data);
+
+	for (int i = 0; i < NUM_TASKS_GLOBAL; i++) {
+		BLI_task_pool_push(pool, task_perf_count_func, NULL, false, TASK_PRIORITY_HIGH);
+	}
+	BLI_task_pool_work_and_wait(pool);
+	EXPECT_EQ(NUM_TASKS_GLOBAL, data.num_done);
+
+	BLI_task_pool_free(pool);
+}
+
+static void task_perf_thread_queues(TaskScheduler *scheduler)
+{
+	TaskPerfData data = {0, SPAWN_DEPTH};
+	TaskPool *pool = BLI_task_pool_create(scheduler, &data);
+
+	BLI_task_pool_push(pool, task_perf_spawn_func, SET_INT_IN_POINTER(0), false, TASK_PRIORITY_HIGH);
+	BLI_task_pool_work_and_wait(pool);
+	EXPECT_EQ((1u << (SPAWN_DEPTH + 1)) - 1, data.num_done);
+
+	BLI_task_pool_free(pool);
+}
+
+static void task_perf_run(const int num_threads, const bool use_work_stealing)
+{
+	TaskScheduler *scheduler = BLI_task_scheduler_create_ex(num_threads, use_work_stealing);
+
+	printf("\n========== %d threads, %s ==========\n",
+	       BLI_task_scheduler_num_threads(scheduler),
+	       use_work_stealing ? "work stealing" : "global queue (previous scheduler)");
+
+	TIMEIT_START(push_from_main);
+	for (int i = 0; i < NUM_RUNS; i++) {
+		task_perf_global_queue(scheduler);
+	}
+	TIMEIT_END(push_from_main);
+
+	TIMEIT_START(push_from_workers);
+	for (int i = 0; i < NUM_RUNS; i++) {
+		task_perf_thread_queues(scheduler);
+	}
+	TIMEIT_END(push_from_workers);
+
+	BLI_task_scheduler_free(scheduler);
+}
+
+TEST(task, QueueThroughputSingleThread)
+{
+	BLI_threadapi_init();
+	task_perf_run(TASK_SCHEDULER_SINGLE_THREAD, false);
+	task_perf_run(TASK_SCHEDULER_SINGLE_THREAD, true);
+}
+
+TEST(task, QueueThroughputMultiThread)
+{
+	BLI_threadapi_init();
+	task_perf_run(TASK_SCHEDULER_AUTO_THREADS, false);
+	task_perf_run(TASK_SCHEDULER_AUTO_THREADS, true);
+}
@@ -0,0 +1,149 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "atomic_ops.h"
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+};
+
+#define NUM_ITEMS 10000
+
+/* Each task spawns two children until the depth is reached, this way most of
+ * the tasks are pushed from worker threads to their own queues. */
+#define SPAWN_DEPTH 12
+
+typedef struct TaskTestData {
+	uint32_t num_done;
+	int depth;
+} TaskTestData;
+
+static void task_spawn_func(TaskPool *__restrict pool, void *taskdata, int thread_id)
+{
+	TaskTestData *data = (TaskTestData *)BLI_task_pool_userdata(pool);
+	const int depth = GET_INT_FROM_POINTER(taskdata);
+
+	atomic_add_and_fetch_uint32(&data->num_done, 1);
+
+	if (depth < data->depth) {
+		for (int i = 0; i < 2; i++) {
+			BLI_task_pool_push_from_thread(pool, task_spawn_func, SET_INT_IN_POINTER(depth + 1),
+			                               false, TASK_PRIORITY_HIGH, thread_id);
+		}
+	}
+}
+
+static void task_count_func(TaskPool *__restrict pool, void *UNUSED(taskdata), int UNUSED(thread_id))
+{
+	TaskTestData *data = (TaskTestData *)BLI_task_pool_userdata(pool);
+	atomic_add_and_fetch_uint32(&data->num_done, 1);
+}
+
+static void task_test_spawn(const int num_threads)
+{
+	TaskScheduler *scheduler = BLI_task_scheduler_create(num_threads);
+	TaskTestData data = {0, SPAWN_DEPTH};
+
+	/* Run the pool several times, so tasks memory and queues are re-used. */
+	for (int iteration = 0; iteration < 4; iteration++) {
+		TaskPool *pool = BLI_task_pool_create(scheduler, &data);
+		data.num_done = 0;
+		BLI_task_pool_push(pool, task_spawn_func, SET_INT_IN_POINTER(0), false, TASK_PRIORITY_HIGH);
+		BLI_task_pool_work_and_wait(pool);
+		EXPECT_EQ((1u << (SPAWN_DEPTH + 1)) - 1, data.num_done);
+		BLI_task_pool_free(pool);
+	}
+
+	BLI_task_scheduler_free(scheduler);
+}
+
+static void task_test_global(const int num_threads)
+{
+	TaskScheduler *scheduler = BLI_task_scheduler_create(num_threads);
+	TaskTestData data = {0, 0};
+	TaskPool *pool = BLI_task_pool_create(scheduler, &data);
+
+	for (int i = 0; i < NUM_ITEMS; i++) {
+		BLI_task_pool_push(pool, task_count_func, NULL, false,
+		                   (i % 2) ? TASK_PRIORITY_HIGH : TASK_PRIORITY_LOW);
+	}
+	BLI_task_pool_work_and_wait(pool);
+	EXPECT_EQ(NUM_ITEMS, data.num_done);
+
+	BLI_task_pool_free(pool);
+	BLI_task_scheduler_free(scheduler);
+}
+
+TEST(task, SpawnSingleThread)
+{
+	BLI_threadapi_init();
+	task_test_spawn(TASK_SCHEDULER_SINGLE_THREAD);
+}
+
+TEST(task, SpawnMultiThread)
+{
+	BLI_threadapi_init();
+	task_test_spawn(8);
+}
+
+TEST(task, GlobalQueueSingleThread)
+{
+	BLI_threadapi_init();
+	task_test_global(TASK_SCHEDULER_SINGLE_THREAD);
+}
+
+TEST(task, GlobalQueueMultiThread)
+{
+	BLI_threadapi_init();
+	task_test_global(8);
+}
+
+TEST(task, SuspendedPool)
+{
+	BLI_threadapi_init();
+	TaskScheduler *scheduler = BLI_task_scheduler_create(8);
+	TaskTestData data = {0, 0};
+	TaskPool *pool = BLI_task_pool_create_suspended(scheduler, &data);
+
+	for (int i = 0; i < NUM_ITEMS; i++) {
+		BLI_task_pool_push(pool, task_count_func, NULL, false, TASK_PRIORITY_HIGH);
+	}
+	EXPECT_EQ(0, data.num_done);
+	BLI_task_pool_work_and_wait(pool);
+	EXPECT_EQ(NUM_ITEMS, data.num_done);
+
+	BLI_task_pool_free(pool);
+	BLI_task_scheduler_free(scheduler);
+}
+
+static void task_range_func(void *userdata, const int iter)
+{
+	uint32_t *sum = (uint32_t *)userdata;
+	atomic_add_and_fetch_uint32(sum, (uint32_t)iter);
+}
+
+static void task_nested_func(TaskPool *__restrict pool, void *UNUSED(taskdata), int UNUSED(thread_id))
+{
+	TaskTestData *data = (TaskTestData *)BLI_task_pool_userdata(pool);
+	uint32_t sum = 0;
+	BLI_task_parallel_range(0, 100, &sum, task_range_func, true);
+	atomic_add_and_fetch_uint32(&data->num_done, sum);
+}
+
+TEST(task, NestedParallelRange)
+{
+	BLI_threadapi_init();
+	TaskTestData data = {0, 0};
+	TaskPool *pool = BLI_task_pool_create(BLI_task_scheduler_get(), &data);
+
+	for (int i = 0; i < 64; i++) {
+		BLI_task_pool_push(pool, task_nested_func, NULL, false, TASK_PRIORITY_HIGH);
+	}
+	BLI_task_pool_work_and_wait(pool);
+	EXPECT_EQ(64 * (99 * 100 / 2), data.num_done);
+
+	BLI_task_pool_free(pool);
+}
@@ -0,0 +1,108 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+"""
+Times loading of a synthetic large .blend file.
+
+The file is created on first run (many meshes and objects), then loaded
+several times. Compare thread counts to see how reading scales, e.g:
+
+./blender.bin --background -noaudio --factory-startup -t 1 \
+    --python tests/python/bl_blendfile_load_benchmark.py -- \
+    --path=/tmp/load_benchmark.blend
+
+./blender.bin --background -noaudio --factory-startup -t 0 \
+    --python tests/python/bl_blendfile_load_benchmark.py -- \
+    --path=/tmp/load_benchmark.blend
+
+Options:
+
+--path:      file to create (when missing) and load.
+--objects:   number of mesh objects to create.
+--subdiv:    subdivisions of the grid mesh used by each object.
+--compress:  save the file compressed.
+--compress-fast: save the file compressed using LZ4.
+--runs:      number of times the file is loaded.
+"""
+
+import os
+import sys
+import time
+
+
+def create_file(filepath, objects, subdiv, compress, compress_fast):
+    import bpy
+
+    bpy.ops.wm.read_factory_settings(use_empty=True)
+    scene = bpy.context.scene
+
+    for i in range(objects):
+        bpy.ops.mesh.primitive_grid_add(x_subdivisions=subdiv, y_subdivisions=subdiv)
+        ob = bpy.context.active_object
+        ob.name = "Grid_%d" % i
+        ob.location = (i % 100, i // 100, 0.0)
+        # give each mesh some extra layers, so blocks are not trivially small
+        ob.data.uv_layers.new()
+        ob.data.vertex_colors.new()
+        ob.modifiers.new("Subsurf", 'SUBSURF')
+
+    scene.update()
+    t = time.time()
+    bpy.ops.wm.save_as_mainfile(filepath=filepath, compress=compress or compress_fast, compress_fast=compress_fast)
+    print("Saved in %.4f sec" % (time.time() - t))
+
+
+def load_file(filepath, runs):
+    import bpy
+
+    times = []
+    for _ in range(runs):
+        t = time.time()
+        bpy.ops.wm.open_mainfile(filepath=filepath, load_ui=False)
+        times.append(time.time() - t)
+
+    size = os.path.getsize(filepath)
+    print("File: %s (%.2f MB)" % (filepath, size / (1024.0 * 1024.0)))
+    print("Runs: %d, min: %.4f sec, avg: %.4f sec" % (runs, min(times), sum(times) / len(times)))
+
+
+def main():
+    import argparse
+
+    argv = sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else []
+
+    parser = argparse.ArgumentParser(description="Time loading of a synthetic .blend file")
+    parser.add_argument("--path", default="/tmp/load_benchmark.blend")
+    parser.add_argument("--objects", type=int, default=2000)
+    parser.add_argument("--subdiv", type=int, default=64)
+    parser.add_argument("--compress", action="store_true")
+    parser.add_argument("--compress-fast", action="store_true")
+    parser.add_argument("--runs", type=int, default=5)
+    args = parser.parse_args(argv)
+
+    if not os.path.exists(args.path):
+        print("Creating %s..." % args.path)
+        create_file(args.path, args.objects, args.subdiv, args.compress, args.compress_fast)
+
+    load_file(args.path, args.runs)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,137 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+"""
+Times the compositor on a stock node tree, using the tiled and the full frame
+execution modes, and checks both give the same result, e.g:
+
+./blender.bin --background -noaudio --factory-startup \
+    --python tests/python/bl_compositor_benchmark.py -- \
+    --size=3840x2160
+
+Options:
+
+--size:  resolution of the generated input image.
+--runs:  number of times the tree is executed per mode.
+"""
+
+import sys
+import time
+
+
+def build_tree(scene, width, height):
+    import bpy
+
+    image = bpy.data.images.new("BenchmarkInput", width, height, float_buffer=True)
+    image.generated_type = 'COLOR_GRID'
+
+    scene.use_nodes = True
+    tree = scene.node_tree
+    nodes = tree.nodes
+    links = tree.links
+    nodes.clear()
+
+    node_image = nodes.new("CompositorNodeImage")
+    node_image.image = image
+
+    node_bright = nodes.new("CompositorNodeBrightContrast")
+    node_bright.inputs["Bright"].default_value = 10.0
+    node_bright.inputs["Contrast"].default_value = 20.0
+
+    node_gamma = nodes.new("CompositorNodeGamma")
+    node_gamma.inputs["Gamma"].default_value = 1.5
+
+    node_mix = nodes.new("CompositorNodeMixRGB")
+    node_mix.blend_type = 'MULTIPLY'
+    node_mix.inputs["Fac"].default_value = 0.5
+
+    node_invert = nodes.new("CompositorNodeInvert")
+    node_invert.inputs["Fac"].default_value = 0.25
+
+    node_composite = nodes.new("CompositorNodeComposite")
+    node_viewer = nodes.new("CompositorNodeViewer")
+
+    links.new(node_image.outputs["Image"], node_bright.inputs["Image"])
+    links.new(node_bright.outputs["Image"], node_gamma.inputs["Image"])
+    links.new(node_gamma.outputs["Image"], node_mix.inputs[1])
+    links.new(node_image.outputs["Image"], node_mix.inputs[2])
+    links.new(node_mix.outputs["Image"], node_invert.inputs["Color"])
+    links.new(node_invert.outputs["Color"], node_composite.inputs["Image"])
+    links.new(node_invert.outputs["Color"], node_viewer.inputs["Image"])
+
+    scene.render.resolution_x = width
+    scene.render.resolution_y = height
+    scene.render.resolution_percentage = 100
+    return tree
+
+
+def viewer_pixels():
+    import bpy
+
+    return bpy.data.images["Viewer Node"].pixels[:]
+
+
+def run_mode(scene, tree, mode, runs):
+    import bpy
+
+    tree.execution_mode = mode
+    times = []
+    for _ in range(runs):
+        t = time.time()
+        bpy.ops.render.render(write_still=False)
+        times.append(time.time() - t)
+    print("%-10s runs: %d, min: %.4f sec, avg: %.4f sec" % (mode, runs, min(times), sum(times) / len(times)))
+    return viewer_pixels()
+
+
+def main():
+    import argparse
+    import bpy
+
+    argv = sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else []
+
+    parser = argparse.ArgumentParser(description="Time the compositor execution modes")
+    parser.add_argument("--size", default="3840x2160")
+    parser.add_argument("--runs", type=int, default=5)
+    args = parser.parse_args(argv)
+
+    width, height = (int(v) for v in args.size.split("x"))
+
+    bpy.ops.wm.read_factory_settings(use_empty=True)
+    scene = bpy.context.scene
+    # only composite, the render layer node is not used
+    scene.render.use_compositing = True
+    scene.render.use_sequencer = False
+    camera = bpy.data.objects.new("Camera", bpy.data.cameras.new("Camera"))
+    scene.objects.link(camera)
+    scene.camera = camera
+    tree = build_tree(scene, width, height)
+
+    pixels_tiled = run_mode(scene, tree, 'TILED', args.runs)
+    pixels_full_frame = run_mode(scene, tree, 'FULL_FRAME', args.runs)
+
+    error = max(abs(a - b) for a, b in zip(pixels_tiled, pixels_full_frame))
+    print("Max difference between modes: %g" % error)
+    if error > 1e-5:
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,130 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+"""
+Changes constraint targets in a scene with many objects, updating relations
+incrementally and by rebuilding the whole graph, and checks both evaluate to
+the same result, e.g:
+
+./blender.bin --background -noaudio --factory-startup \
+    --python tests/python/bl_depsgraph_relations_update_benchmark.py -- \
+    --objects=10000 --edits=50
+
+Options:
+
+--objects:  number of objects in the scene.
+--edits:    number of constraint targets changed per mode.
+--validate: compare every incremental update against a full rebuild,
+            differences are printed to the console and fail the test.
+"""
+
+import random
+import sys
+import time
+
+
+def build_scene(scene, num_objects):
+    import bpy
+
+    objects = []
+    for i in range(num_objects):
+        ob = bpy.data.objects.new("Object.%05d" % i, None)
+        ob.location = (i % 100, i // 100, 0.0)
+        scene.objects.link(ob)
+        objects.append(ob)
+
+    # Every object follows one created before it, so changing a target
+    # changes the relations of the object and of everything following it.
+    rng = random.Random(1)
+    for i, ob in enumerate(objects[1:], 1):
+        constraint = ob.constraints.new('COPY_LOCATION')
+        constraint.target = objects[rng.randrange(0, i)]
+        constraint.use_offset = True
+
+    scene.update()
+    return objects
+
+
+def evaluated_matrices(scene, objects):
+    # Evaluate every object, not only the ones tagged by the last edits.
+    for ob in objects:
+        ob.update_tag()
+    scene.update()
+    return [tuple(v for row in ob.matrix_world for v in row) for ob in objects]
+
+
+def run_mode(scene, objects, name, full_rebuild, num_edits):
+    rng = random.Random(0)
+    times = []
+    for _ in range(num_edits):
+        i = rng.randrange(1, len(objects))
+        t = time.time()
+        objects[i].constraints[0].target = objects[rng.randrange(0, i)]
+        if full_rebuild:
+            scene.depsgraph.debug_rebuild()
+        scene.update()
+        times.append(time.time() - t)
+    print("%-12s edits: %d, min: %.2f ms, avg: %.2f ms" %
+          (name, num_edits, min(times) * 1000.0, sum(times) / len(times) * 1000.0))
+
+
+def main():
+    import argparse
+    import bpy
+
+    argv = sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else []
+
+    parser = argparse.ArgumentParser(description="Time relations updates after changing constraint targets")
+    parser.add_argument("--objects", type=int, default=10000)
+    parser.add_argument("--edits", type=int, default=50)
+    parser.add_argument("--validate", action="store_true")
+    args = parser.parse_args(argv)
+
+    bpy.ops.wm.read_factory_settings(use_empty=True)
+    scene = bpy.context.scene
+    objects = build_scene(scene, args.objects)
+
+    run_mode(scene, objects, 'FULL', True, args.edits)
+
+    # Debug value 801 validates incremental updates against a full rebuild.
+    if args.validate:
+        bpy.app.debug_value = 801
+    run_mode(scene, objects, 'INCREMENTAL', False, args.edits)
+    bpy.app.debug_value = 0
+
+    num_invalid = scene.depsgraph.debug_invalid_incremental_updates
+    if num_invalid:
+        print("Incremental updates differing from full rebuild: %d" % num_invalid)
+        sys.exit(1)
+
+    matrices_incremental = evaluated_matrices(scene, objects)
+    scene.depsgraph.debug_rebuild()
+    matrices_full = evaluated_matrices(scene, objects)
+
+    error = max(abs(a - b)
+                for matrix_a, matrix_b in zip(matrices_incremental, matrices_full)
+                for a, b in zip(matrix_a, matrix_b))
+    print("Max difference between incremental and full update: %g" % error)
+    if error > 1e-6:
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,145 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+"""
+Plays back a generated rig with many bones, with and without fusing chains
+of depsgraph operations, and checks both give the same pose, e.g:
+
+./blender.bin --background -noaudio --factory-startup \
+    --python tests/python/bl_depsgraph_rig_benchmark.py -- \
+    --chains=16 --bones=32
+
+Options:
+
+--chains:  number of bone chains in the rig.
+--bones:   number of bones per chain.
+--frames:  number of frames played back per mode.
+--runs:    number of times the frames are played back per mode.
+--save:    write the generated rig to this .blend file.
+"""
+
+import sys
+import time
+
+
+def build_rig(scene, num_chains, num_bones, num_frames):
+    import bpy
+
+    arm = bpy.data.armatures.new("BenchmarkRig")
+    arm_ob = bpy.data.objects.new("BenchmarkRig", arm)
+    scene.objects.link(arm_ob)
+    scene.objects.active = arm_ob
+
+    bpy.ops.object.mode_set(mode='EDIT')
+    for chain in range(num_chains):
+        parent = arm.edit_bones.new("Control.%03d" % chain)
+        parent.head = (chain, 0.0, 0.0)
+        parent.tail = (chain, 0.0, 0.5)
+        for bone in range(num_bones):
+            edit_bone = arm.edit_bones.new("Bone.%03d.%03d" % (chain, bone))
+            edit_bone.head = parent.tail
+            edit_bone.tail = (chain, 0.0, parent.tail[2] + 0.5)
+            edit_bone.parent = parent
+            edit_bone.use_connect = True
+            parent = edit_bone
+    bpy.ops.object.mode_set(mode='OBJECT')
+
+    # Every bone follows the rotation of its control, so each chain is a
+    # long sequence of small operations.
+    for chain in range(num_chains):
+        control = "Control.%03d" % chain
+        for bone in range(num_bones):
+            pose_bone = arm_ob.pose.bones["Bone.%03d.%03d" % (chain, bone)]
+            constraint = pose_bone.constraints.new('COPY_ROTATION')
+            constraint.target = arm_ob
+            constraint.subtarget = control
+            constraint.influence = 0.1
+            constraint.use_offset = True
+
+        pose_bone = arm_ob.pose.bones[control]
+        pose_bone.rotation_mode = 'XYZ'
+        for frame in (1, num_frames // 2, num_frames):
+            pose_bone.rotation_euler = (0.0, 0.3 * chain * frame / num_frames, 0.0)
+            pose_bone.keyframe_insert("rotation_euler", frame=frame)
+
+    scene.frame_start = 1
+    scene.frame_end = num_frames
+    return arm_ob
+
+
+def pose_matrices(arm_ob):
+    return [tuple(v for row in pose_bone.matrix for v in row) for pose_bone in arm_ob.pose.bones]
+
+
+def run_mode(scene, arm_ob, name, debug_value, num_frames, runs):
+    import bpy
+
+    bpy.app.debug_value = debug_value
+    scene.depsgraph.debug_rebuild()
+
+    fps = []
+    for _ in range(runs):
+        scene.frame_set(1)
+        t = time.time()
+        for frame in range(1, num_frames + 1):
+            scene.frame_set(frame)
+        fps.append(num_frames / (time.time() - t))
+    print("%-10s runs: %d, max: %.2f fps, avg: %.2f fps" % (name, runs, max(fps), sum(fps) / len(fps)))
+
+    matrices = pose_matrices(arm_ob)
+    bpy.app.debug_value = 0
+    return matrices
+
+
+def main():
+    import argparse
+    import bpy
+
+    argv = sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else []
+
+    parser = argparse.ArgumentParser(description="Time rig playback with and without operation fusion")
+    parser.add_argument("--chains", type=int, default=16)
+    parser.add_argument("--bones", type=int, default=32)
+    parser.add_argument("--frames", type=int, default=100)
+    parser.add_argument("--runs", type=int, default=3)
+    parser.add_argument("--save", default="")
+    args = parser.parse_args(argv)
+
+    bpy.ops.wm.read_factory_settings(use_empty=True)
+    scene = bpy.context.scene
+    arm_ob = build_rig(scene, args.chains, args.bones, args.frames)
+
+    if args.save:
+        bpy.ops.wm.save_as_mainfile(filepath=args.save)
+
+    # Debug value 800 disables fusion of operation chains.
+    matrices_unfused = run_mode(scene, arm_ob, 'UNFUSED', 800, args.frames, args.runs)
+    matrices_fused = run_mode(scene, arm_ob, 'FUSED', 0, args.frames, args.runs)
+
+    error = max(abs(a - b)
+                for matrix_a, matrix_b in zip(matrices_unfused, matrices_fused)
+                for a, b in zip(matrix_a, matrix_b))
+    print("Max difference between modes: %g" % error)
+    if error > 1e-6:
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,61 @@
+# Apache License, Version 2.0
+
+# ./blender.bin --background -noaudio --factory-startup --python tests/python/bl_pyapi_scene_evaluate_frames.py -- --verbose
+import bpy
+import unittest
+
+
+class TestSceneEvaluateFrames(unittest.TestCase):
+    frames = [1.0, 2.5, 4.0, 7.0, 3.0, 10.0, 12.0]
+
+    @classmethod
+    def setUpClass(cls):
+        cls.scene = bpy.context.scene
+        cls.object = bpy.data.objects["Cube"]
+
+        ob = cls.object
+        for frame, value in ((1, 0.0), (10, 2.0)):
+            ob.location = (value, value * 0.5, -value)
+            ob.rotation_euler = (0.0, value, value * 0.25)
+            ob.keyframe_insert("location", frame=frame)
+            ob.keyframe_insert("rotation_euler", frame=frame)
+
+    def setUp(self):
+        self.scene.frame_set(5)
+
+    def expected_matrices(self):
+        scene = self.scene
+        frame_orig = scene.frame_current
+        matrices = []
+        for frame in self.frames:
+            scene.frame_set(int(frame), frame - int(frame))
+            matrices.append([value for col in self.object.matrix_world.col for value in col])
+        scene.frame_set(frame_orig)
+        return matrices
+
+    def evaluate(self, copies):
+        result = self.scene.evaluate_frames_matrix_world(self.object, self.frames, copies=copies)
+        self.assertEqual(len(result), len(self.frames) * 16)
+        self.assertEqual(self.scene.frame_current, 5)
+        return [result[i * 16:(i + 1) * 16] for i in range(len(self.frames))]
+
+    def assertMatricesEqual(self, matrices, expected):
+        self.assertEqual(len(matrices), len(expected))
+        for matrix, matrix_expected in zip(matrices, expected):
+            for value, value_expected in zip(matrix, matrix_expected):
+                self.assertAlmostEqual(value, value_expected, places=5)
+
+    def test_serial(self):
+        self.assertMatricesEqual(self.evaluate(1), self.expected_matrices())
+
+    def test_copies(self):
+        expected = self.expected_matrices()
+        for copies in (0, 2, 3, len(self.frames) + 1):
+            self.assertMatricesEqual(self.evaluate(copies), expected)
+
+
+if __name__ == '__main__':
+    import sys
+
+    sys.argv = [__file__] + (sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else [])
+    unittest.main()